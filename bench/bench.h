@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  bench.h
+ * @brief Helpers shared by the benchmark programs (see bench/README.md)
+ */
+
+#ifndef __bench_H_
+#define __bench_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* --------------------------------------------------------------------------------- */
+/* Monotonic time in nanoseconds */
+static inline uint64_t bench_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Print one result line: time per operation and operations per second */
+static inline void bench_report(const char* name, uint64_t nb_ops, uint64_t elapsed_ns) {
+	double ns = (nb_ops) ? (double) elapsed_ns / (double) nb_ops : 0.0;
+	printf("%-44s %10.1f ns/op %12.0f op/s\n", name, ns, (ns > 0.0) ? 1e9 / ns : 0.0);
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Number of iterations: first argument of the program, or the default value */
+static inline uint32_t bench_iterations(int argc, char* argv[], uint32_t def) {
+	if (argc > 1) {
+		long n = strtol(argv[1], NULL, 10);
+		if (n > 0) {
+			return (uint32_t) n;
+		}
+	}
+	return def;
+}
+
+/* Keep a result alive, so that the compiler does not remove the measured code */
+#define BENCH_KEEP(x)    __asm__ __volatile__("" : : "g"(x) : "memory")
+
+#endif /* __bench_H_ */
@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  broker.h
+ * @brief Stand-in of the MQTT server for the benchmark programs (see bench/README.md)
+ *
+ * A thread accepts one connection (plain TCP, 127.0.0.1, port chosen by the system) and
+ * answers the MQTT 3.1.1 packets of the client: CONNACK, SUBACK, UNSUBACK, PINGRESP and
+ * PUBACK (for a QoS 1 PUBLISH). The PUBACK are sent 'puback_delay_ms' after the PUBLISH
+ * is received, without blocking the reception of the next packets: this gives the round
+ * trip time of the network. After the SUBACK of the first subscription, 'src_nb' PUBLISH
+ * packets (QoS 0, 'src_topic', 'src_len' bytes of payload) are sent to the client, as fast
+ * as possible.
+ *
+ * The connection ends when the client disconnects (DISCONNECT or closed socket).
+ */
+
+#ifndef __bench_broker_H_
+#define __bench_broker_H_
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "bench.h"
+
+#define BENCH_BROKER_BUF_SZ     (64 * 1024)
+#define BENCH_BROKER_ACK_MAX    4096
+
+typedef struct {
+	/* Parameters, set before bench_broker_start() */
+	uint32_t puback_delay_ms;       /*!< Delay of the PUBACK (round trip time) */
+	uint32_t src_nb;                /*!< Number of PUBLISH packets sent to the client after the SUBACK */
+	uint32_t src_len;               /*!< Payload length of these packets */
+	const char* src_topic;          /*!< Topic of these packets */
+
+	/* Results */
+	uint16_t port;                  /*!< Listening port */
+	volatile uint32_t nb_reads;     /*!< Number of reads of the socket (i.e. of received segments, about) */
+	volatile uint64_t nb_bytes;     /*!< Number of received bytes */
+	volatile uint32_t nb_publish;   /*!< Number of received PUBLISH packets */
+
+	/* Internal */
+	int listen_fd;
+	pthread_t thread;
+	uint32_t ack_head;
+	uint32_t ack_tail;
+	uint64_t ack_due[BENCH_BROKER_ACK_MAX];
+	uint16_t ack_id[BENCH_BROKER_ACK_MAX];
+	unsigned char rcv_buf[BENCH_BROKER_BUF_SZ];
+	unsigned char snd_buf[BENCH_BROKER_BUF_SZ];
+} BenchBroker_t;
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_broker_send(int fd, const unsigned char* p, uint32_t len) {
+	while (len > 0) {
+		ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		p += n;
+		len -= (uint32_t) n;
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Send the PUBLISH packets to the client, by writes of BENCH_BROKER_BUF_SZ bytes max */
+static int bench_broker_source(BenchBroker_t* b, int fd) {
+	uint32_t tlen = (uint32_t) strlen(b->src_topic);
+	uint32_t rem = 2 + tlen + b->src_len;
+	uint32_t len = 0;
+	uint32_t i;
+
+	for (i = 0; i < b->src_nb; i++) {
+		unsigned char* p;
+		uint32_t r = rem;
+		if (len + 5 + rem > sizeof(b->snd_buf)) {
+			if ((len == 0) || (bench_broker_send(fd, b->snd_buf, len))) {
+				return -1;
+			}
+			len = 0;
+		}
+		p = b->snd_buf + len;
+		*p++ = 0x30;
+		do {
+			*p = (unsigned char) (r % 128);
+			r /= 128;
+			if (r > 0) {
+				*p |= 0x80;
+			}
+			p++;
+		} while (r > 0);
+		*p++ = (unsigned char) (tlen >> 8);
+		*p++ = (unsigned char) tlen;
+		memcpy(p, b->src_topic, tlen);
+		p += tlen;
+		memset(p, 'x', b->src_len);
+		p += b->src_len;
+		len = (uint32_t) (p - b->snd_buf);
+	}
+	return (len) ? bench_broker_send(fd, b->snd_buf, len) : 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Remaining length of the packet at p, and length of its fixed header (hlen), or -1 if incomplete */
+static int32_t bench_broker_length(const unsigned char* p, uint32_t avail, uint32_t* hlen) {
+	int32_t rem = 0;
+	int32_t mul = 1;
+	uint32_t i;
+	for (i = 1; (i < avail) && (i < 5); i++) {
+		rem += (p[i] & 127) * mul;
+		mul *= 128;
+		if ((p[i] & 128) == 0) {
+			*hlen = i + 1;
+			return rem;
+		}
+	}
+	return -1;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Process one packet (type and flags, remaining bytes), return 1 at the end of the connection */
+static int bench_broker_packet(BenchBroker_t* b, int fd, unsigned char hdr, const unsigned char* p, uint32_t rem) {
+	unsigned char ack[8];
+	switch (hdr >> 4) {
+	case 1: /* CONNECT */
+		ack[0] = 0x20;
+		ack[1] = 2;
+		ack[2] = 0;
+		ack[3] = 0;
+		return bench_broker_send(fd, ack, 4);
+	case 3: /* PUBLISH */
+		b->nb_publish++;
+		if (((hdr >> 1) & 3) == 1) {
+			uint32_t tlen = ((uint32_t) p[0] << 8) | p[1];
+			uint16_t id = (uint16_t) (((uint32_t) p[2 + tlen] << 8) | p[3 + tlen]);
+			if (b->puback_delay_ms == 0) {
+				ack[0] = 0x40;
+				ack[1] = 2;
+				ack[2] = (unsigned char) (id >> 8);
+				ack[3] = (unsigned char) id;
+				return bench_broker_send(fd, ack, 4);
+			}
+			if (b->ack_tail - b->ack_head >= BENCH_BROKER_ACK_MAX) {
+				return -1;
+			}
+			b->ack_due[b->ack_tail % BENCH_BROKER_ACK_MAX] = bench_now_ns() + (uint64_t) b->puback_delay_ms * 1000000;
+			b->ack_id[b->ack_tail % BENCH_BROKER_ACK_MAX] = id;
+			b->ack_tail++;
+		}
+		return 0;
+	case 8: /* SUBSCRIBE: one return code (QoS 0) per topic filter */
+	{
+		uint32_t n = 0;
+		uint32_t i = 2;
+		int rc;
+		while (i + 2 < rem) {
+			i += 2 + (((uint32_t) p[i] << 8) | p[i + 1]) + 1;
+			n++;
+		}
+		b->snd_buf[0] = 0x90;
+		b->snd_buf[1] = (unsigned char) (2 + n);
+		b->snd_buf[2] = p[0];
+		b->snd_buf[3] = p[1];
+		memset(b->snd_buf + 4, 0, n);
+		rc = bench_broker_send(fd, b->snd_buf, 4 + n);
+		if ((rc == 0) && (b->src_nb)) {
+			rc = bench_broker_source(b, fd);
+			b->src_nb = 0;
+		}
+		return rc;
+	}
+	case 10: /* UNSUBSCRIBE */
+		ack[0] = 0xB0;
+		ack[1] = 2;
+		ack[2] = p[0];
+		ack[3] = p[1];
+		return bench_broker_send(fd, ack, 4);
+	case 12: /* PINGREQ */
+		ack[0] = 0xD0;
+		ack[1] = 0;
+		return bench_broker_send(fd, ack, 2);
+	case 14: /* DISCONNECT */
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Send the PUBACK which are due, return the time (ms) to wait for the next one, or -1 */
+static int bench_broker_acks(BenchBroker_t* b, int fd) {
+	uint64_t now = bench_now_ns();
+	uint32_t len = 0;
+	int tmo = -1;
+	while (b->ack_head != b->ack_tail) {
+		uint32_t k = b->ack_head % BENCH_BROKER_ACK_MAX;
+		if (b->ack_due[k] > now) {
+			tmo = (int) ((b->ack_due[k] - now + 999999) / 1000000);
+			break;
+		}
+		b->snd_buf[len++] = 0x40;
+		b->snd_buf[len++] = 2;
+		b->snd_buf[len++] = (unsigned char) (b->ack_id[k] >> 8);
+		b->snd_buf[len++] = (unsigned char) b->ack_id[k];
+		b->ack_head++;
+		if (len + 4 > sizeof(b->snd_buf)) {
+			break;
+		}
+	}
+	if ((len) && (bench_broker_send(fd, b->snd_buf, len))) {
+		return -2;
+	}
+	return (b->ack_head != b->ack_tail) ? ((tmo < 0) ? 0 : tmo) : -1;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void* bench_broker_run(void* arg) {
+	BenchBroker_t* b = (BenchBroker_t*) arg;
+	uint32_t len = 0;
+	int one = 1;
+	int fd;
+
+	fd = accept(b->listen_fd, NULL, NULL);
+	if (fd < 0) {
+		return NULL;
+	}
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	for (;;) {
+		struct pollfd pfd;
+		uint32_t pos = 0;
+		ssize_t n;
+		int tmo = bench_broker_acks(b, fd);
+		if (tmo < -1) {
+			break;
+		}
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, tmo) <= 0) {
+			continue;
+		}
+		n = recv(fd, b->rcv_buf + len, sizeof(b->rcv_buf) - len, 0);
+		if (n <= 0) {
+			break;
+		}
+		b->nb_reads++;
+		b->nb_bytes += (uint64_t) n;
+		len += (uint32_t) n;
+
+		/* Complete packets */
+		for (;;) {
+			uint32_t hlen;
+			int32_t rem = bench_broker_length(b->rcv_buf + pos, len - pos, &hlen);
+			int rc;
+			if ((rem < 0) || (pos + hlen + (uint32_t) rem > len)) {
+				break;
+			}
+			rc = bench_broker_packet(b, fd, b->rcv_buf[pos], b->rcv_buf + pos + hlen, (uint32_t) rem);
+			pos += hlen + (uint32_t) rem;
+			if (rc) {
+				goto end;
+			}
+		}
+		if (len - pos + 1 >= sizeof(b->rcv_buf)) {
+			break;  /* Packet too long for the stand-in */
+		}
+		memmove(b->rcv_buf, b->rcv_buf + pos, len - pos);
+		len -= pos;
+	}
+end:
+	close(fd);
+	return NULL;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Listen on 127.0.0.1 (b->port), and start the thread. Return 0 if successful */
+static int bench_broker_start(BenchBroker_t* b) {
+	struct sockaddr_in a;
+	socklen_t alen = sizeof(a);
+
+	b->nb_reads = 0;
+	b->nb_bytes = 0;
+	b->nb_publish = 0;
+	b->ack_head = b->ack_tail = 0;
+	b->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (b->listen_fd < 0) {
+		return -1;
+	}
+	memset(&a, 0, sizeof(a));
+	a.sin_family = AF_INET;
+	a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if ((bind(b->listen_fd, (struct sockaddr*) &a, sizeof(a))) || (listen(b->listen_fd, 1))
+			|| (getsockname(b->listen_fd, (struct sockaddr*) &a, &alen))) {
+		close(b->listen_fd);
+		return -1;
+	}
+	b->port = ntohs(a.sin_port);
+	if (pthread_create(&b->thread, NULL, bench_broker_run, b)) {
+		close(b->listen_fd);
+		return -1;
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Wait for the end of the connection (the client must be disconnected) */
+static void bench_broker_stop(BenchBroker_t* b) {
+	pthread_join(b->thread, NULL);
+	close(b->listen_fd);
+}
+
+#endif /* __bench_broker_H_ */
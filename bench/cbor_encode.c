@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  cbor_encode.c
+ * @brief Size and encoding time of a 'collected data' message, in CBOR and in JSON
+ *
+ * Three data sets: an array of 64 floats, an array of 64 int16, and 12 values of
+ * the usual types. Each one is encoded by LO_msg_encode_data() with the JSON encoder
+ * and with the CBOR encoder, in a local buffer. The size and the time are given per
+ * sample (value), the size of the message header (stream-id, timestamp) included.
+ *
+ * Needs LOC_FEATURE_CBOR=1 (-DLOC_FEATURE_CBOR=1 if the configuration does not set it).
+ */
+
+#include "bench.h"
+
+#include <string.h>
+
+#include "iotsoftbox-core/loc_msg.h"
+
+#if !LOC_FEATURE_CBOR
+#error "LOC_FEATURE_CBOR must be set"
+#endif
+
+#define BENCH_DIM   64
+
+static float    _bench_float[BENCH_DIM];
+static int16_t  _bench_int16[BENCH_DIM];
+
+static int32_t  _bench_counter = 123456789;
+static int32_t  _bench_delta = -42;
+static int16_t  _bench_temp = -125;
+static uint16_t _bench_hum = 5120;
+static uint8_t  _bench_level = 87;
+static uint32_t _bench_uptime = 3600123;
+static uint8_t  _bench_alarm = 1;
+static float    _bench_voltage = 3.3125f;
+static float    _bench_current = 0.0425f;
+static double   _bench_energy = 12345.6789;
+static char     _bench_state[] = "running";
+static char     _bench_fw[] = "v2.1.4-rc3";
+
+static const LiveObjectsD_Data_t _bench_data_float[] = {
+	{ LOD_TYPE_FLOAT, "samples", _bench_float, BENCH_DIM },
+};
+
+static const LiveObjectsD_Data_t _bench_data_int16[] = {
+	{ LOD_TYPE_INT16, "samples", _bench_int16, BENCH_DIM },
+};
+
+static const LiveObjectsD_Data_t _bench_data_mixed[] = {
+	{ LOD_TYPE_INT32,    "counter",  &_bench_counter, 1 },
+	{ LOD_TYPE_INT32,    "delta",    &_bench_delta,   1 },
+	{ LOD_TYPE_INT16,    "temp",     &_bench_temp,    1 },
+	{ LOD_TYPE_UINT16,   "hum",      &_bench_hum,     1 },
+	{ LOD_TYPE_UINT8,    "level",    &_bench_level,   1 },
+	{ LOD_TYPE_UINT32,   "uptime",   &_bench_uptime,  1 },
+	{ LOD_TYPE_BOOL,     "alarm",    &_bench_alarm,   1 },
+	{ LOD_TYPE_FLOAT,    "voltage",  &_bench_voltage, 1 },
+	{ LOD_TYPE_FLOAT,    "current",  &_bench_current, 1 },
+	{ LOD_TYPE_DOUBLE,   "energy",   &_bench_energy,  1 },
+	{ LOD_TYPE_STRING_C, "state",    _bench_state,    1 },
+	{ LOD_TYPE_STRING_C, "firmware", _bench_fw,       1 },
+};
+
+static char _bench_buf[LOM_JSON_BUF_USER_SZ + 1];
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_run(const char* set_name, const LiveObjectsD_Data_t* data, int data_nb, uint32_t nb_samples,
+		const LOMEncoder_t* enc, const char* enc_name, uint32_t nb) {
+	LOMSetOfData_t set;
+	const char* p_msg;
+	uint32_t len = 0;
+	uint64_t t0;
+	uint32_t i;
+	char name[64];
+
+	memset(&set, 0, sizeof(set));
+	set.data_set.data_ptr = data;
+	set.data_set.data_nb = data_nb;
+	strcpy(set.stream_id, "urn:lo:nsid:bench:0001!measures");
+	strcpy(set.timestamp, "2016-11-25T10:20:30Z");
+
+	t0 = bench_now_ns();
+	for (i = 0; i < nb; i++) {
+		p_msg = LO_msg_encode_data(0, _bench_buf, sizeof(_bench_buf), NULL, enc, &set, &len);
+		BENCH_KEEP(p_msg);
+	}
+	if (p_msg == NULL) {
+		printf("ERROR - %s %s\n", enc_name, set_name);
+		return -1;
+	}
+	snprintf(name, sizeof(name), "%-4s %-10s %5.2f bytes/sample (%u)", enc_name, set_name,
+			(double) len / (double) nb_samples, (unsigned) len);
+	bench_report(name, (uint64_t) nb * nb_samples, bench_now_ns() - t0);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int main(int argc, char* argv[]) {
+	uint32_t nb = bench_iterations(argc, argv, 100000);
+	int i;
+	int rc = 0;
+
+	for (i = 0; i < BENCH_DIM; i++) {
+		_bench_float[i] = 20.0f + (float) ((i * 7919) % 1000) / 64.0f;
+		_bench_int16[i] = (int16_t) ((i * 7919) % 20000 - 10000);
+	}
+
+	rc |= bench_run("float[64]", _bench_data_float, 1, BENCH_DIM, &LO_msg_enc_json, "JSON", nb);
+	rc |= bench_run("float[64]", _bench_data_float, 1, BENCH_DIM, &LO_msg_enc_cbor, "CBOR", nb);
+	rc |= bench_run("int16[64]", _bench_data_int16, 1, BENCH_DIM, &LO_msg_enc_json, "JSON", nb);
+	rc |= bench_run("int16[64]", _bench_data_int16, 1, BENCH_DIM, &LO_msg_enc_cbor, "CBOR", nb);
+	rc |= bench_run("mixed[12]", _bench_data_mixed, 12, 12, &LO_msg_enc_json, "JSON", nb);
+	rc |= bench_run("mixed[12]", _bench_data_mixed, 12, 12, &LO_msg_enc_cbor, "CBOR", nb);
+	return (rc) ? 1 : 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  client.h
+ * @brief Client instance of the benchmark programs connected to the stand-in of the MQTT server
+ *
+ * To be included after iotsoftbox-core/loc_core.c (static functions of the core).
+ */
+
+#ifndef __bench_client_H_
+#define __bench_client_H_
+
+#include "broker.h"
+
+/* --------------------------------------------------------------------------------- */
+/* Create and initialize a client instance. The calling thread is the LiveObjects Client thread */
+static LiveObjectsClient_Ctx* bench_client_create(void) {
+	LiveObjectsClient_Ctx* ctx;
+
+	LO_sys_init();
+	LO_sys_threadRun();
+	ctx = LiveObjectsClient_CtxCreate();
+	if ((ctx == NULL) || (LiveObjectsClient_InitEx(ctx, NULL, 0x0123456789abcdefULL, 0xfedcba9876543210ULL))
+			|| (LiveObjectsClient_SetDevIdEx(ctx, "bench"))) {
+		printf("ERROR - client init\n");
+		return NULL;
+	}
+	return ctx;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Connect to the stand-in of the MQTT server (plain TCP), as LiveObjectsClient_ConnectEx() */
+static int bench_client_connect(LiveObjectsClient_Ctx* ctx, const BenchBroker_t* b) {
+	LiveObjectsNetConnectParams_t params;
+
+	params.RemoteHostAddress = "127.0.0.1";
+	params.RemoteHostPort = b->port;
+	params.TimeoutMs = LOC_SERV_TIMEOUT;
+
+	ctx->netw.tls_enabled = 0;
+	LOCC_connectInit(ctx, 0);
+	if ((netw_connect(&ctx->netw, &params)) || (LOCC_connectMqtt(ctx, 1))) {
+		printf("ERROR - connection to 127.0.0.1:%u\n", (unsigned) b->port);
+		return -1;
+	}
+	LOCC_connectOK(ctx);
+	return 0;
+}
+
+#endif /* __bench_client_H_ */
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  coalesce.c
+ * @brief Writes to the network per burst of pending QoS 0 messages, with and without coalescing
+ *
+ * The client is connected to the stand-in of the MQTT server (broker.h). Bursts of 1, 4, 16 and 64
+ * small messages are queued with LiveObjectsClient_PublishEx(), then sent by LOCC_processPendingMesssage()
+ * as in a cycle of the LiveObjects Client thread, until all are received by the server.
+ * The writes of the MQTT client (mqttwrite and mqttwritev hooks) are counted: each one is a SSL/TLS
+ * record with the security enabled.
+ *
+ * Built twice to compare:
+ *   -DLOC_MQTT_COALESCE=1   and   -DLOC_MQTT_COALESCE=0
+ *
+ * The core is included to reach its static functions.
+ */
+
+#include "bench.h"
+
+#include <sched.h>
+
+#include "../iotsoftbox-core/loc_core.c"
+
+#include "client.h"
+
+/* Overhead of a SSL/TLS record with AES-GCM: header (5), explicit nonce (8), tag (16) */
+#define BENCH_TLS_RECORD_OVERHEAD   29
+
+static uint32_t _bench_writes;
+
+/* --------------------------------------------------------------------------------- */
+/* Count the writes of the MQTT client */
+static int bench_mqtt_write(Network* n, unsigned char* buf, int len, int timeout_ms) {
+	_bench_writes++;
+	return netw_mqtt_write(n, buf, len, timeout_ms);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_mqtt_writev(Network* n, MQTTIoVec* iov, int iovcnt, int timeout_ms) {
+	_bench_writes++;
+	return netw_mqtt_writev(n, iov, iovcnt, timeout_ms);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_run(LiveObjectsClient_Ctx* ctx, uint32_t burst, uint32_t nb_bursts) {
+	static BenchBroker_t broker;
+	char payload[64];
+	char name[64];
+	uint64_t t0, dt;
+	uint64_t bytes;
+	uint32_t i, j;
+
+	memset(&broker, 0, sizeof(broker));
+	if (bench_broker_start(&broker)) {
+		printf("ERROR - server start\n");
+		return -1;
+	}
+	if (bench_client_connect(ctx, &broker)) {
+		return -1;
+	}
+	ctx->netw.net.mqttwrite = bench_mqtt_write;
+	ctx->mqtt_ctx.mqttwritev = bench_mqtt_writev;
+
+	_bench_writes = 0;
+	bytes = broker.nb_bytes;
+	t0 = bench_now_ns();
+	for (i = 0; i < nb_bursts; i++) {
+		for (j = 0; j < burst; j++) {
+			snprintf(payload, sizeof(payload), "{\"s\":\"bench\",\"v\":{\"seq\":%"PRIu32",\"temp\":21.5}}", j);
+			if (LiveObjectsClient_PublishEx(ctx, "dev/data", payload)) {
+				printf("ERROR - queue full, burst %"PRIu32"\n", burst);
+				return -1;
+			}
+		}
+		LOCC_processPendingMesssage(ctx);
+	}
+	while (broker.nb_publish < burst * nb_bursts) {
+		sched_yield();
+	}
+	dt = bench_now_ns() - t0;
+	bytes = broker.nb_bytes - bytes;
+
+	LiveObjectsClient_DisconnectEx(ctx);
+	bench_broker_stop(&broker);
+
+	snprintf(name, sizeof(name), "burst %2"PRIu32", %5.2f writes, %4.0f B, TLS +%4.0f B",
+			burst, (double) _bench_writes / nb_bursts, (double) bytes / nb_bursts,
+			(double) _bench_writes * BENCH_TLS_RECORD_OVERHEAD / nb_bursts);
+	bench_report(name, nb_bursts, dt);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int main(int argc, char* argv[]) {
+	uint32_t nb = bench_iterations(argc, argv, 20000);
+	LiveObjectsClient_Ctx* ctx;
+	uint32_t burst;
+
+	ctx = bench_client_create();
+	if ((ctx == NULL) || (LiveObjectsClient_SetQueueEx(ctx, 64, MQ_POLICY_REJECT, 0))) {
+		printf("ERROR - client init\n");
+		return 1;
+	}
+	printf("LOC_MQTT_COALESCE=%d\n", LOC_MQTT_COALESCE);
+	for (burst = 1; burst <= 64; burst <<= 2) {
+		if (bench_run(ctx, burst, nb)) {
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  inflight_window.c
+ * @brief Throughput of the QoS 1 publications, versus the size of the in-flight window
+ *
+ * The client is connected to the stand-in of the MQTT server (broker.h), which sends the
+ * PUBACK after a delay: the round trip time (second argument, in ms, default 2).
+ * The LiveObjects Client thread publishes messages of 100 bytes with QoS 1
+ * (LiveObjectsClient_PublishBinEx), until all are acknowledged:
+ * - without window: each publication waits for its PUBACK,
+ * - with a window of 1, 4, 16 and 64 messages (LiveObjectsClient_SetPublishWindowEx).
+ *
+ * Needs LOC_MQTT_INFLIGHT=1. The core is included to reach its static functions.
+ */
+
+#include "bench.h"
+
+#include "../iotsoftbox-core/loc_core.c"
+
+#include "client.h"
+
+#if !LOC_MQTT_INFLIGHT
+#error "LOC_MQTT_INFLIGHT must be set"
+#endif
+
+static uint32_t _bench_acked;
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void bench_published(const char* topic, const void* payload, uint32_t payload_len, int status,
+		void* user_ctx) {
+	(void) topic;
+	(void) payload;
+	(void) payload_len;
+	(void) user_ctx;
+	if (status == 0) {
+		_bench_acked++;
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_run(LiveObjectsClient_Ctx* ctx, uint32_t window, uint32_t rtt_ms, uint32_t nb) {
+	static BenchBroker_t broker;
+	char payload[100];
+	char name[64];
+	uint64_t t0, dt;
+	uint32_t i;
+
+	memset(payload, 'x', sizeof(payload));
+	broker.puback_delay_ms = rtt_ms;
+	broker.src_nb = 0;
+	if (bench_broker_start(&broker)) {
+		printf("ERROR - server start\n");
+		return -1;
+	}
+	if ((LiveObjectsClient_SetPublishWindowEx(ctx, window, 64 * 1024, bench_published, NULL))
+			|| (bench_client_connect(ctx, &broker))) {
+		return -1;
+	}
+
+	_bench_acked = 0;
+	t0 = bench_now_ns();
+	for (i = 0; i < nb; i++) {
+		if (LiveObjectsClient_PublishBinEx(ctx, "dev/data", payload, sizeof(payload), 1)) {
+			printf("ERROR - publication %u\n", (unsigned) i);
+			return -1;
+		}
+	}
+	while ((window) && (_bench_acked < nb)) {
+		if (MQTTYield(&ctx->mqtt_ctx, 10) == FAILURE) {
+			printf("ERROR - %u/%u messages acknowledged\n", (unsigned) _bench_acked, (unsigned) nb);
+			return -1;
+		}
+	}
+	dt = bench_now_ns() - t0;
+
+	LiveObjectsClient_DisconnectEx(ctx);
+	bench_broker_stop(&broker);
+	if (broker.nb_publish != nb) {
+		printf("ERROR - %u/%u messages received\n", (unsigned) broker.nb_publish, (unsigned) nb);
+		return -1;
+	}
+
+	if (window) {
+		snprintf(name, sizeof(name), "QoS 1, window %2u, RTT %u ms", (unsigned) window, (unsigned) rtt_ms);
+	}
+	else {
+		snprintf(name, sizeof(name), "QoS 1, no window, RTT %u ms", (unsigned) rtt_ms);
+	}
+	bench_report(name, nb, dt);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int main(int argc, char* argv[]) {
+	static const uint32_t windows[] = { 0, 1, 4, 16, 64 };
+	uint32_t nb = bench_iterations(argc, argv, 1000);
+	uint32_t rtt_ms = (argc > 2) ? (uint32_t) strtoul(argv[2], NULL, 10) : 2;
+	LiveObjectsClient_Ctx* ctx;
+	unsigned k;
+
+	ctx = bench_client_create();
+	if (ctx == NULL) {
+		return 1;
+	}
+	for (k = 0; k < sizeof(windows) / sizeof(windows[0]); k++) {
+		if (bench_run(ctx, windows[k], rtt_ms, (windows[k]) ? nb : nb / 10)) {
+			return 1;
+		}
+	}
+	return 0;
+}
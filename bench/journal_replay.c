@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  journal_replay.c
+ * @brief Append and replay throughput of the persistent journal, with 100k queued messages
+ *
+ * The messages ('collected data' of about 100 bytes, the message number in the first bytes)
+ * are appended to an empty journal, as while disconnected. They are then replayed by bursts of
+ * LOC_JOURNAL_REPLAY_BURST records, as after the reconnection, and checked in order:
+ * - acknowledged in the publish function (PUBACK received during the publication),
+ * - acknowledged before the next burst (PUBACK received during the next cycle of the client),
+ * - with a rewind every 64 bursts, the records of the last burst sent again (session lost).
+ *
+ * The journal is created in the directory given as second argument (default: lo_bench_journal),
+ * which is removed at the beginning and at the end. With LOC_FEATURE_LZ4, the sealed segments are compressed.
+ */
+
+#include "bench.h"
+
+#include <dirent.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "iotsoftbox-core/loc_journal.h"
+
+#if !LOC_FEATURE_JOURNAL
+#error "LOC_FEATURE_JOURNAL must be set"
+#endif
+
+#define BENCH_SEGMENT_SZ    (256 * 1024)
+#define BENCH_QUOTA         (256ULL * 1024 * 1024)
+
+typedef enum {
+	BENCH_ACK_NOW = 0,
+	BENCH_ACK_NEXT,
+	BENCH_ACK_REWIND
+} BenchAck_t;
+
+static LOJournal_t* _bench_journal;
+static uint64_t _bench_tokens[LOC_JOURNAL_REPLAY_BURST];
+static uint32_t _bench_tokens_nb;
+static uint32_t _bench_next;
+static uint32_t _bench_errors;
+static BenchAck_t _bench_ack;
+
+/* --------------------------------------------------------------------------------- */
+/* The messages are checked in order: the next one, or an already sent one after a rewind */
+static int bench_publish(void* user, const char* topic, const char* payload, uint32_t len, uint64_t token) {
+	uint32_t n;
+	(void) user;
+	(void) topic;
+	memcpy(&n, payload, sizeof(n));
+	if ((len < sizeof(n)) || (n > _bench_next)) {
+		if (_bench_errors++ < 5) {
+			printf("ERROR - message %u received, %u expected\n", (unsigned) n, (unsigned) _bench_next);
+		}
+	}
+	else if (n == _bench_next) {
+		_bench_next++;
+	}
+	if (_bench_ack == BENCH_ACK_NOW) {
+		LO_journal_ack(_bench_journal, token);
+	}
+	else if (_bench_tokens_nb < LOC_JOURNAL_REPLAY_BURST) {
+		_bench_tokens[_bench_tokens_nb++] = token;
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void bench_ack_pending(void) {
+	uint32_t i;
+	for (i = 0; i < _bench_tokens_nb; i++) {
+		LO_journal_ack(_bench_journal, _bench_tokens[i]);
+	}
+	_bench_tokens_nb = 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_run(const char* dir, uint32_t nb, BenchAck_t ack, const char* ack_name) {
+	char payload[100];
+	char name[64];
+	uint64_t sent = 0;
+	uint64_t t0;
+	uint32_t bursts = 0;
+	uint32_t i;
+
+	_bench_journal = LO_journal_open(dir, BENCH_SEGMENT_SZ, BENCH_QUOTA, LOC_FEATURE_LZ4);
+	if (_bench_journal == NULL) {
+		printf("ERROR - LO_journal_open(%s)\n", dir);
+		return -1;
+	}
+	memset(payload, 0, sizeof(payload));
+	snprintf(payload + 4, sizeof(payload) - 4, "{\"s\":\"bench\",\"v\":{\"temp\":21.5,\"hum\":48,\"door\":false}}");
+
+	t0 = bench_now_ns();
+	for (i = 0; i < nb; i++) {
+		memcpy(payload, &i, sizeof(i));
+		if (LO_journal_append(_bench_journal, "dev/data", payload, sizeof(payload))) {
+			printf("ERROR - LO_journal_append %u\n", (unsigned) i);
+			LO_journal_close(_bench_journal);
+			return -1;
+		}
+	}
+	snprintf(name, sizeof(name), "append, %u messages", (unsigned) nb);
+	bench_report(name, nb, bench_now_ns() - t0);
+
+	_bench_next = 0;
+	_bench_errors = 0;
+	_bench_tokens_nb = 0;
+	_bench_ack = ack;
+	t0 = bench_now_ns();
+	while ((LO_journal_pending(_bench_journal)) || (_bench_tokens_nb)) {
+		int rc;
+		if ((ack == BENCH_ACK_REWIND) && ((++bursts % 64) == 0)) {
+			_bench_tokens_nb = 0;
+			LO_journal_rewind(_bench_journal);
+		}
+		else {
+			bench_ack_pending();
+		}
+		rc = LO_journal_replay(_bench_journal, LOC_JOURNAL_REPLAY_BURST, bench_publish, NULL);
+		if (rc < 0) {
+			printf("ERROR - LO_journal_replay\n");
+			break;
+		}
+		sent += rc;
+	}
+	snprintf(name, sizeof(name), "replay, %s (%.3f sent/msg)", ack_name, (double) sent / (double) nb);
+	bench_report(name, nb, bench_now_ns() - t0);
+	LO_journal_close(_bench_journal);
+
+	if ((_bench_errors) || (_bench_next != nb)) {
+		printf("ERROR - %u error(s), %u/%u messages\n", (unsigned) _bench_errors, (unsigned) _bench_next,
+				(unsigned) nb);
+		return -1;
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Remove the journal: the segments left (the active one), then the directory */
+static void bench_remove(const char* dir) {
+	char path[256];
+	struct dirent* ent;
+	DIR* d = opendir(dir);
+	if (d == NULL) {
+		return;
+	}
+	while ((ent = readdir(d)) != NULL) {
+		if (ent->d_name[0] != '.') {
+			snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+			unlink(path);
+		}
+	}
+	closedir(d);
+	rmdir(dir);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int main(int argc, char* argv[]) {
+	uint32_t nb = bench_iterations(argc, argv, 100000);
+	const char* dir = (argc > 2) ? argv[2] : "lo_bench_journal";
+	int rc = 0;
+
+	bench_remove(dir);
+	rc |= bench_run(dir, nb, BENCH_ACK_NOW, "ack in publish");
+	rc |= bench_run(dir, nb, BENCH_ACK_NEXT, "ack next burst");
+	rc |= bench_run(dir, nb, BENCH_ACK_REWIND, "rewind /64 bursts");
+	bench_remove(dir);
+	return (rc) ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  json_writer.c
+ * @brief Encoding time of a 'collected data' message of about 1 KB, in JSON
+ *
+ * The data set holds the usual value types (integers, floats, strings, boolean)
+ * and two arrays of 64 int16 values. The message is encoded by the LiveObjects Client
+ * thread path of LO_msg_encode_data(), in a local buffer (no message ring).
+ *
+ * BENCH_ENCODE_DATA(buf, sz, p) can be redefined on the command line to build this
+ * program against another version of the encoder.
+ */
+
+#include "bench.h"
+
+#include <string.h>
+
+#include "iotsoftbox-core/loc_msg.h"
+
+#ifndef BENCH_ENCODE_DATA
+#define BENCH_ENCODE_DATA(buf, sz, p)   LO_msg_encode_data(0, (buf), (sz), NULL, &LO_msg_enc_json, (p), NULL)
+#endif
+
+static int32_t  _bench_counter = 123456789;
+static int32_t  _bench_delta = -42;
+static int16_t  _bench_temp = -125;
+static uint16_t _bench_hum = 5120;
+static uint8_t  _bench_level = 87;
+static uint32_t _bench_uptime = 3600123;
+static uint8_t  _bench_alarm = 1;
+static float    _bench_voltage = 3.3125f;
+static float    _bench_current = 0.0425f;
+static double   _bench_energy = 12345.6789;
+static char     _bench_state[] = "running";
+static char     _bench_fw[] = "v2.1.4-rc3";
+static int16_t  _bench_samples[64];
+static int16_t  _bench_peaks[64];
+
+static const LiveObjectsD_Data_t _bench_data[] = {
+	{ LOD_TYPE_INT32,    "counter",  &_bench_counter, 1 },
+	{ LOD_TYPE_INT32,    "delta",    &_bench_delta,   1 },
+	{ LOD_TYPE_INT16,    "temp",     &_bench_temp,    1 },
+	{ LOD_TYPE_UINT16,   "hum",      &_bench_hum,     1 },
+	{ LOD_TYPE_UINT8,    "level",    &_bench_level,   1 },
+	{ LOD_TYPE_UINT32,   "uptime",   &_bench_uptime,  1 },
+	{ LOD_TYPE_BOOL,     "alarm",    &_bench_alarm,   1 },
+	{ LOD_TYPE_FLOAT,    "voltage",  &_bench_voltage, 1 },
+	{ LOD_TYPE_FLOAT,    "current",  &_bench_current, 1 },
+	{ LOD_TYPE_DOUBLE,   "energy",   &_bench_energy,  1 },
+	{ LOD_TYPE_STRING_C, "state",    _bench_state,    1 },
+	{ LOD_TYPE_STRING_C, "firmware", _bench_fw,       1 },
+	{ LOD_TYPE_INT16,    "samples",  _bench_samples,  64 },
+	{ LOD_TYPE_INT16,    "peaks",    _bench_peaks,    64 },
+};
+
+static LOMSetOfData_t _bench_set;
+static char _bench_buf[LOM_JSON_BUF_USER_SZ + 1];
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int main(int argc, char* argv[]) {
+	uint32_t nb = bench_iterations(argc, argv, 200000);
+	const char* p_msg;
+	uint64_t t0;
+	uint32_t i;
+	char name[64];
+
+	for (i = 0; i < 64; i++) {
+		_bench_samples[i] = (int16_t) ((i * 7919) % 20000 - 10000);
+		_bench_peaks[i] = (int16_t) ((i * 104729) % 30000);
+	}
+	memset(&_bench_set, 0, sizeof(_bench_set));
+	_bench_set.data_set.data_ptr = _bench_data;
+	_bench_set.data_set.data_nb = sizeof(_bench_data) / sizeof(_bench_data[0]);
+	strcpy(_bench_set.stream_id, "urn:lo:nsid:bench:0001!measures");
+	strcpy(_bench_set.timestamp, "2016-11-25T10:20:30Z");
+
+	p_msg = BENCH_ENCODE_DATA(_bench_buf, sizeof(_bench_buf), &_bench_set);
+	if (p_msg == NULL) {
+		printf("ERROR - encode (LOM_JSON_BUF_USER_SZ=%d)\n", LOM_JSON_BUF_USER_SZ);
+		return 1;
+	}
+	if ((argc > 2) && (!strcmp(argv[2], "-v"))) {
+		printf("%s\n", p_msg);
+	}
+
+	t0 = bench_now_ns();
+	for (i = 0; i < nb; i++) {
+		p_msg = BENCH_ENCODE_DATA(_bench_buf, sizeof(_bench_buf), &_bench_set);
+		BENCH_KEEP(p_msg);
+	}
+	snprintf(name, sizeof(name), "JSON data message, %u bytes", (unsigned) strlen(_bench_buf));
+	bench_report(name, nb, bench_now_ns() - t0);
+	return 0;
+}
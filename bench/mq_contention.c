@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  mq_contention.c
+ * @brief Throughput of the queue of pending messages with concurrent producers
+ *
+ * 1, 2, 4 and 8 producer threads put messages with LOCC_mqPut() while the main thread,
+ * as the LiveObjects Client thread, takes them with LOCC_mqGet(). The queue is used
+ * alone: the messages are tagged pointers (producer, sequence), checked in FIFO order
+ * per producer, and never freed (MQ_POLICY_REJECT, a producer retries when it is full).
+ *
+ * Built twice to compare the lock-free queue and the MQ_MUTEX queue:
+ *   -DLOM_MQUEUE_LOCKFREE=1   and   -DLOM_MQUEUE_LOCKFREE=0
+ *
+ * The core is included to reach its static functions (platform build, see README.md).
+ */
+
+#include "bench.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "../iotsoftbox-core/loc_core.c"
+
+#define BENCH_MQ_SIZE           256
+#define BENCH_MQ_MAX_PRODUCERS  8
+
+static LiveObjectsClient_Ctx* _bench_ctx;
+static uint32_t _bench_per_producer;
+static volatile uint32_t _bench_rejected;
+
+/* --------------------------------------------------------------------------------- */
+/* Message: producer number in the high bits, sequence number (from 1) in the low bits */
+static void* bench_producer(void* arg) {
+	uintptr_t id = (uintptr_t) arg;
+	uint32_t rejected = 0;
+	uint32_t i = 1;
+	while (i <= _bench_per_producer) {
+		const char* p_msg = (const char*) ((id << 24) | i);
+		if (LOCC_mqPut(_bench_ctx, p_msg) == 0) {
+			i++;
+		}
+		else {
+			rejected++;
+			sched_yield();
+		}
+	}
+	__atomic_add_fetch(&_bench_rejected, rejected, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_run(int nb_producers) {
+	pthread_t th[BENCH_MQ_MAX_PRODUCERS];
+	uint32_t last[BENCH_MQ_MAX_PRODUCERS];
+	uint64_t total = (uint64_t) nb_producers * _bench_per_producer;
+	uint64_t got = 0;
+	uint64_t t0;
+	uint64_t dt;
+	char name[64];
+	int i;
+
+	memset(last, 0, sizeof(last));
+	_bench_rejected = 0;
+	t0 = bench_now_ns();
+	for (i = 0; i < nb_producers; i++) {
+		pthread_create(&th[i], NULL, bench_producer, (void*) (uintptr_t) (i + 1));
+	}
+	while (got < total) {
+		const char* p_msg = LOCC_mqGet(_bench_ctx);
+		uintptr_t v;
+		uint32_t id;
+		if (p_msg == NULL) {
+			sched_yield();
+			continue;
+		}
+		v = (uintptr_t) p_msg;
+		id = (uint32_t) (v >> 24) - 1;
+		if ((id >= (uint32_t) nb_producers) || ((v & 0xFFFFFF) != last[id] + 1)) {
+			printf("ERROR - message %p out of order\n", p_msg);
+			return -1;
+		}
+		last[id]++;
+		got++;
+	}
+	for (i = 0; i < nb_producers; i++) {
+		pthread_join(th[i], NULL);
+	}
+	dt = bench_now_ns() - t0;
+	snprintf(name, sizeof(name), "%s, %d producer(s), %.3f full/msg", (LOM_MQUEUE_LOCKFREE) ? "lock-free" : "MQ_MUTEX",
+			nb_producers, (double) _bench_rejected / (double) total);
+	bench_report(name, total, dt);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int main(int argc, char* argv[]) {
+	int nb;
+
+	_bench_per_producer = bench_iterations(argc, argv, 1000000);
+	if (_bench_per_producer >= (1U << 24)) {
+		_bench_per_producer = (1U << 24) - 1;
+	}
+	LO_sys_init();
+	_bench_ctx = LiveObjectsClient_CtxCreate();
+	if ((_bench_ctx == NULL) || (LOCC_mqInit(_bench_ctx))
+			|| (LiveObjectsClient_SetQueueEx(_bench_ctx, BENCH_MQ_SIZE, MQ_POLICY_REJECT, 0))) {
+		printf("ERROR - queue init\n");
+		return 1;
+	}
+	for (nb = 1; nb <= BENCH_MQ_MAX_PRODUCERS; nb <<= 1) {
+		if (bench_run(nb)) {
+			return 1;
+		}
+	}
+	LOCC_mqRelease(_bench_ctx);
+	return 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  mqtt_read.c
+ * @brief Inbound MQTT packets per second on a loopback stream, and reads of the socket per packet
+ *
+ * The client is connected to the stand-in of the MQTT server (broker.h), and subscribes to a topic.
+ * The server then sends PUBLISH packets (QoS 0) as fast as possible, with payloads of 16 and 200
+ * bytes, read by the MQTT client (MQTTYield) until all are received.
+ *
+ * Built twice to compare the network receive buffer and the direct reads:
+ *   -DLOC_NETW_RCV_BUF_SZ=1024   and   -DLOC_NETW_RCV_BUF_SZ=0
+ * and linked with -Wl,--wrap=f_netw_sock_recv_timeout (GNU ld) to count the reads of the socket.
+ *
+ * The core is included to reach its static functions.
+ */
+
+#include "bench.h"
+
+#include "../iotsoftbox-core/loc_core.c"
+
+#include "client.h"
+
+static uint32_t _bench_received;
+static uint32_t _bench_reads;
+
+int __real_f_netw_sock_recv_timeout(void *pNetwork, unsigned char *buf, size_t len, uint32_t tmo);
+
+/* --------------------------------------------------------------------------------- */
+/* Count the reads of the socket */
+int __wrap_f_netw_sock_recv_timeout(void *pNetwork, unsigned char *buf, size_t len, uint32_t tmo) {
+	_bench_reads++;
+	return __real_f_netw_sock_recv_timeout(pNetwork, buf, len, tmo);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void bench_message(MessageData* md) {
+	(void) md;
+	_bench_received++;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_run(LiveObjectsClient_Ctx* ctx, uint32_t payload_len, uint32_t nb) {
+	static BenchBroker_t broker;
+	char name[64];
+	uint64_t t0, dt;
+	uint32_t reads;
+
+	broker.puback_delay_ms = 0;
+	broker.src_nb = nb;
+	broker.src_len = payload_len;
+	broker.src_topic = "bench/in";
+	if (bench_broker_start(&broker)) {
+		printf("ERROR - server start\n");
+		return -1;
+	}
+	if (bench_client_connect(ctx, &broker)) {
+		return -1;
+	}
+
+	_bench_received = 0;
+	_bench_reads = 0;
+	t0 = bench_now_ns();
+	if (MQTTSubscribe(&ctx->mqtt_ctx, "bench/in", QOS0, bench_message)) {
+		printf("ERROR - subscription\n");
+		return -1;
+	}
+	while (_bench_received < nb) {
+		if (MQTTYield(&ctx->mqtt_ctx, 10) == FAILURE) {
+			printf("ERROR - %u/%u messages received\n", (unsigned) _bench_received, (unsigned) nb);
+			return -1;
+		}
+	}
+	dt = bench_now_ns() - t0;
+	reads = _bench_reads;
+
+	LiveObjectsClient_DisconnectEx(ctx);
+	bench_broker_stop(&broker);
+
+	snprintf(name, sizeof(name), "buffer %4d, %3u bytes, %.3f reads/packet", LOC_NETW_RCV_BUF_SZ,
+			(unsigned) payload_len, (double) reads / (double) nb);
+	bench_report(name, nb, dt);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int main(int argc, char* argv[]) {
+	uint32_t nb = bench_iterations(argc, argv, 100000);
+	LiveObjectsClient_Ctx* ctx;
+
+	ctx = bench_client_create();
+	if ((ctx == NULL) || (bench_run(ctx, 16, nb)) || (bench_run(ctx, 200, nb))) {
+		return 1;
+	}
+	return 0;
+}
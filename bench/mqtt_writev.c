@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  mqtt_writev.c
+ * @brief Publication with the payload copied in the send buffer, and with the scatter-gather write
+ *
+ * The client is connected to the stand-in of the MQTT server (broker.h), and publishes messages (QoS 0)
+ * with MQTTPublish() (copy of the payload in the send buffer of the MQTT client) and MQTTPublishVec()
+ * (payload given to the network wrapper with the header, netw_mqtt_writev()), until all are received
+ * by the server. The payloads larger than the send buffer (LOC_MQTT_DEF_SND_SZ) are only published
+ * with MQTTPublishVec().
+ *
+ * Linked with -Wl,--wrap=f_netw_sock_send,--wrap=writev (GNU ld) to count the writes to the socket
+ * (writev() is used by netw_mqtt_writev() with LOC_FEATURE_EVLOOP or LOC_FEATURE_WAKEUP).
+ *
+ * The core is included to reach its static functions.
+ */
+
+#include "bench.h"
+
+#include <sched.h>
+#include <sys/uio.h>
+
+#include "../iotsoftbox-core/loc_core.c"
+
+#include "client.h"
+
+static uint32_t _bench_writes;
+
+int __real_f_netw_sock_send(void *pNetwork, const unsigned char *buf, size_t len);
+ssize_t __real_writev(int fd, const struct iovec *iov, int iovcnt);
+
+/* --------------------------------------------------------------------------------- */
+/* Count the writes to the socket */
+int __wrap_f_netw_sock_send(void *pNetwork, const unsigned char *buf, size_t len) {
+	_bench_writes++;
+	return __real_f_netw_sock_send(pNetwork, buf, len);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+ssize_t __wrap_writev(int fd, const struct iovec *iov, int iovcnt) {
+	_bench_writes++;
+	return __real_writev(fd, iov, iovcnt);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_run(LiveObjectsClient_Ctx* ctx, const unsigned char* payload, uint32_t payload_len, int vec,
+		uint32_t nb) {
+	static BenchBroker_t broker;
+	MQTTMessage msg;
+	char name[64];
+	uint64_t t0, dt;
+	uint32_t i;
+
+	memset(&broker, 0, sizeof(broker));
+	if (bench_broker_start(&broker)) {
+		printf("ERROR - server start\n");
+		return -1;
+	}
+	if (bench_client_connect(ctx, &broker)) {
+		return -1;
+	}
+
+	_bench_writes = 0;
+	t0 = bench_now_ns();
+	for (i = 0; i < nb; i++) {
+		int rc;
+		msg.qos = QOS0;
+		msg.retained = 0;
+		msg.dup = 0;
+		msg.id = 0;
+		msg.payload = (void*) payload;
+		msg.payloadlen = payload_len;
+		rc = (vec) ? MQTTPublishVec(&ctx->mqtt_ctx, "dev/data/bench", &msg) :
+				MQTTPublish(&ctx->mqtt_ctx, "dev/data/bench", &msg);
+		if (rc) {
+			printf("ERROR - publication %u, rc=%d\n", (unsigned) i, rc);
+			return -1;
+		}
+	}
+	while (broker.nb_publish < nb) {
+		sched_yield();
+	}
+	dt = bench_now_ns() - t0;
+
+	LiveObjectsClient_DisconnectEx(ctx);
+	bench_broker_stop(&broker);
+
+	snprintf(name, sizeof(name), "%s %5u B, %.2f writes, %6.1f MB/s", (vec) ? "Vec " : "Copy",
+			(unsigned) payload_len, (double) _bench_writes / (double) nb,
+			(double) payload_len * nb * 1000.0 / (double) dt);
+	bench_report(name, nb, dt);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int main(int argc, char* argv[]) {
+	static const uint32_t sizes[] = { 64, 512, 1900, 16384, 61440 };
+	static unsigned char payload[61440];
+	uint32_t nb = bench_iterations(argc, argv, 100000);
+	LiveObjectsClient_Ctx* ctx;
+	unsigned int i;
+
+	memset(payload, 'x', sizeof(payload));
+	ctx = bench_client_create();
+	if (ctx == NULL) {
+		return 1;
+	}
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		uint32_t n = (sizes[i] > LOC_MQTT_DEF_SND_SZ) ? nb / 10 : nb;
+		if ((sizes[i] < LOC_MQTT_DEF_SND_SZ) && (bench_run(ctx, payload, sizes[i], 0, n))) {
+			return 1;
+		}
+		if (bench_run(ctx, payload, sizes[i], 1, n)) {
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  name_index.c
+ * @brief Decoding time of a command and of a config update, versus the number of attached names
+ *
+ * 4 to 1024 commands and configuration parameters are attached (names "device_setting_<n>").
+ * For each table size, a command request (the last command) and a config update (4 parameters
+ * spread in the table) are decoded by LO_msg_decode_cmd_req() and LO_msg_decode_params_req(),
+ * without index (linear search) and with the hash index built by LO_msg_index_build().
+ * Below LOM_NAME_INDEX_MIN names, no index is built: both lines are linear.
+ */
+
+#include "bench.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iotsoftbox-core/loc_msg.h"
+
+#define BENCH_MAX_NAMES     1024
+
+static char _bench_names[BENCH_MAX_NAMES][24];
+static uint32_t _bench_values[BENCH_MAX_NAMES];
+static LiveObjectsD_Command_t _bench_cmds[BENCH_MAX_NAMES];
+static LiveObjectsD_Param_t _bench_params[BENCH_MAX_NAMES];
+static const LiveObjectsD_Param_t* _bench_updated[BENCH_MAX_NAMES];
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_cmd_cb(LiveObjectsD_CommandRequestBlock_t* pCmdReqBlk) {
+	(void) pCmdReqBlk;
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_cfg_cb(const LiveObjectsD_Param_t* param_ptr, const void* val_ptr, int val_len) {
+	(void) param_ptr;
+	(void) val_ptr;
+	(void) val_len;
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_run(uint32_t nb_names, uint8_t indexed, uint32_t nb) {
+	LOMSetofCommands_t set_cmd;
+	LOMSetOfParams_t set_cfg;
+	LOMSetofUpdatedParams_t updated;
+	char req_cmd[128];
+	char req_cfg[512];
+	uint32_t len_cmd, len_cfg;
+	int32_t cid;
+	uint64_t t0, t1;
+	uint32_t i;
+	int rc_cmd, rc_cfg;
+	char name[64];
+	int k;
+
+	memset(&set_cmd, 0, sizeof(set_cmd));
+	set_cmd.cmd_enable = 1;
+	set_cmd.cmd_ptr = _bench_cmds;
+	set_cmd.cmd_nb = nb_names;
+	set_cmd.cmd_callback = bench_cmd_cb;
+
+	memset(&set_cfg, 0, sizeof(set_cfg));
+	set_cfg.param_set.param_ptr = _bench_params;
+	set_cfg.param_set.param_nb = nb_names;
+	set_cfg.param_callback = bench_cfg_cb;
+
+	memset(&updated, 0, sizeof(updated));
+	updated.max_of_params = nb_names;
+	updated.tab_of_param_ptr = _bench_updated;
+
+	if (indexed) {
+		LO_msg_index_build(&set_cmd.cmd_index, _bench_cmds, nb_names, sizeof(LiveObjectsD_Command_t),
+				offsetof(LiveObjectsD_Command_t, cmd_name));
+		LO_msg_index_build(&set_cfg.param_index, _bench_params, nb_names, sizeof(LiveObjectsD_Param_t),
+				offsetof(LiveObjectsD_Param_t, parm_data.data_name));
+	}
+
+	len_cmd = snprintf(req_cmd, sizeof(req_cmd), "{\"req\":\"%s\",\"cid\":7}", _bench_names[nb_names - 1]);
+	k = snprintf(req_cfg, sizeof(req_cfg), "{\"cid\":8,\"cfg\":{");
+	for (i = 0; i < 4; i++) {
+		k += snprintf(req_cfg + k, sizeof(req_cfg) - k, "%s\"%s\":{\"t\":\"u32\",\"v\":%u}", (i) ? "," : "",
+				_bench_names[nb_names - 1 - i * (nb_names / 4)], (unsigned) i);
+	}
+	k += snprintf(req_cfg + k, sizeof(req_cfg) - k, "}}");
+	len_cfg = k;
+
+	rc_cmd = LO_msg_decode_cmd_req(req_cmd, len_cmd, &set_cmd, &cid);
+	t0 = bench_now_ns();
+	for (i = 0; i < nb; i++) {
+		LO_msg_decode_cmd_req(req_cmd, len_cmd, &set_cmd, &cid);
+	}
+	t1 = bench_now_ns();
+	snprintf(name, sizeof(name), "%4u names, %s, command", (unsigned) nb_names,
+			(set_cmd.cmd_index.slot) ? "hashed" : "linear");
+	bench_report(name, nb, t1 - t0);
+
+	rc_cfg = LO_msg_decode_params_req(req_cfg, len_cfg, &set_cfg, &updated);
+	if (updated.nb_of_params != 4) {
+		rc_cfg = -1;
+	}
+	t0 = bench_now_ns();
+	for (i = 0; i < nb; i++) {
+		LO_msg_decode_params_req(req_cfg, len_cfg, &set_cfg, &updated);
+	}
+	t1 = bench_now_ns();
+	snprintf(name, sizeof(name), "%4u names, %s, config (4 params)", (unsigned) nb_names,
+			(set_cfg.param_index.slot) ? "hashed" : "linear");
+	bench_report(name, nb, t1 - t0);
+
+	LO_msg_index_free(&set_cmd.cmd_index);
+	LO_msg_index_free(&set_cfg.param_index);
+
+	if ((rc_cmd < 0) || (rc_cfg < 0)) {
+		printf("ERROR - decode, cmd=%d cfg=%d\n", rc_cmd, rc_cfg);
+		return -1;
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int main(int argc, char* argv[]) {
+	uint32_t nb = bench_iterations(argc, argv, 100000);
+	uint32_t nb_names;
+	uint32_t i;
+
+	for (i = 0; i < BENCH_MAX_NAMES; i++) {
+		snprintf(_bench_names[i], sizeof(_bench_names[i]), "device_setting_%u", (unsigned) i);
+		_bench_cmds[i].cmd_uref = i;
+		_bench_cmds[i].cmd_name = _bench_names[i];
+		_bench_params[i].parm_uref = i;
+		_bench_params[i].parm_data.data_type = LOD_TYPE_UINT32;
+		_bench_params[i].parm_data.data_name = _bench_names[i];
+		_bench_params[i].parm_data.data_value = &_bench_values[i];
+		_bench_params[i].parm_data.data_dim = 1;
+	}
+
+	for (nb_names = 4; nb_names <= BENCH_MAX_NAMES; nb_names <<= 2) {
+		if ((bench_run(nb_names, 0, nb)) || (bench_run(nb_names, 1, nb))) {
+			return 1;
+		}
+	}
+	return 0;
+}
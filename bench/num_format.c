@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  num_format.c
+ * @brief Formatting of the JSON numbers, per LiveObjectsD_Type_t, against snprintf
+ *
+ * For each numeric type, an array of 64 values is written by LO_json_add_item(),
+ * then by a loop of snprintf() with the format of the previous version of the writer
+ * ("%"PRIi32, "%f", "%lf", ...). The time is given per value.
+ *
+ * The float and double texts of LO_json_ftoa() and LO_json_dtoa() are also read back
+ * with strtof() and strtod(), to check that they give the same values.
+ */
+
+#include "bench.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "iotsoftbox-core/loc_json_api.h"
+
+#define BENCH_DIM   64
+
+static union {
+	int32_t  i32[BENCH_DIM];
+	int16_t  i16[BENCH_DIM];
+	int8_t   i8[BENCH_DIM];
+	uint32_t u32[BENCH_DIM];
+	uint16_t u16[BENCH_DIM];
+	uint8_t  u8[BENCH_DIM];
+	float    f[BENCH_DIM];
+	double   d[BENCH_DIM];
+} _bench_val;
+
+static char _bench_buf[BENCH_DIM * LO_JSON_NUM_SZ + 64];
+
+/* --------------------------------------------------------------------------------- */
+/* Same values for each run of a type: pseudo-random, over the whole range of the type */
+static void bench_fill(LiveObjectsD_Type_t type) {
+	uint32_t x = 2463534242U;
+	int i;
+	for (i = 0; i < BENCH_DIM; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		switch (type) {
+		case LOD_TYPE_INT32:  _bench_val.i32[i] = (int32_t) x; break;
+		case LOD_TYPE_INT16:  _bench_val.i16[i] = (int16_t) x; break;
+		case LOD_TYPE_INT8:   _bench_val.i8[i] = (int8_t) x; break;
+		case LOD_TYPE_UINT32: _bench_val.u32[i] = x; break;
+		case LOD_TYPE_UINT16: _bench_val.u16[i] = (uint16_t) x; break;
+		case LOD_TYPE_UINT8:  _bench_val.u8[i] = (uint8_t) x; break;
+		case LOD_TYPE_FLOAT:  _bench_val.f[i] = (float) ((int32_t) x) / 65536.0f; break;
+		case LOD_TYPE_DOUBLE: _bench_val.d[i] = (double) ((int32_t) x) / 3.0; break;
+		default: break;
+		}
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Previous version: one snprintf per value */
+static uint32_t bench_snprintf(LiveObjectsD_Type_t type) {
+	uint32_t len = 0;
+	int i;
+	for (i = 0; i < BENCH_DIM; i++) {
+		char* p = _bench_buf + len;
+		uint32_t sz = sizeof(_bench_buf) - len;
+		int rc = 0;
+		switch (type) {
+		case LOD_TYPE_INT32:  rc = snprintf(p, sz, "%"PRIi32",", _bench_val.i32[i]); break;
+		case LOD_TYPE_INT16:  rc = snprintf(p, sz, "%"PRIi16",", _bench_val.i16[i]); break;
+		case LOD_TYPE_INT8:   rc = snprintf(p, sz, "%"PRIi8",", _bench_val.i8[i]); break;
+		case LOD_TYPE_UINT32: rc = snprintf(p, sz, "%"PRIu32",", _bench_val.u32[i]); break;
+		case LOD_TYPE_UINT16: rc = snprintf(p, sz, "%"PRIu16",", _bench_val.u16[i]); break;
+		case LOD_TYPE_UINT8:  rc = snprintf(p, sz, "%"PRIu8",", _bench_val.u8[i]); break;
+		case LOD_TYPE_FLOAT:  rc = snprintf(p, sz, "%f,", _bench_val.f[i]); break;
+		case LOD_TYPE_DOUBLE: rc = snprintf(p, sz, "%lf,", _bench_val.d[i]); break;
+		default: break;
+		}
+		len += rc;
+	}
+	return len;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static uint32_t bench_writer(const LiveObjectsD_Data_t* p) {
+	LOJsonWriter_t w;
+	LO_json_init(&w, _bench_buf, sizeof(_bench_buf));
+	LO_json_add_item(&w, p);
+	return (LO_json_result(&w)) ? w.len : 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Read back the float and double texts */
+static uint32_t bench_check(void) {
+	char buf[LO_JSON_NUM_SZ];
+	uint32_t bad = 0;
+	uint32_t x = 88172645U;
+	uint32_t i;
+	for (i = 0; i < 1000000; i++) {
+		float f;
+		double d;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		memcpy(&f, &x, sizeof(f));
+		if ((f == f) && (f - f == 0.0f)) {
+			buf[LO_json_ftoa(buf, f)] = 0;
+			if (strtof(buf, NULL) != f) {
+				if (bad++ < 5) {
+					printf("ERROR - float %.9g -> %s\n", f, buf);
+				}
+			}
+		}
+		d = (double) f * (1.0 + (double) x / 4294967296.0);
+		if ((d == d) && (d - d == 0.0)) {
+			buf[LO_json_dtoa(buf, d)] = 0;
+			if (strtod(buf, NULL) != d) {
+				if (bad++ < 5) {
+					printf("ERROR - double %.17g -> %s\n", d, buf);
+				}
+			}
+		}
+	}
+	return bad;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int main(int argc, char* argv[]) {
+	static const LiveObjectsD_Type_t types[] = {
+		LOD_TYPE_INT32, LOD_TYPE_INT16, LOD_TYPE_INT8,
+		LOD_TYPE_UINT32, LOD_TYPE_UINT16, LOD_TYPE_UINT8,
+		LOD_TYPE_FLOAT, LOD_TYPE_DOUBLE
+	};
+	uint32_t nb = bench_iterations(argc, argv, 20000);
+	uint32_t bad;
+	unsigned k;
+
+	for (k = 0; k < sizeof(types) / sizeof(types[0]); k++) {
+		LiveObjectsD_Data_t data = { types[k], "v", &_bench_val, BENCH_DIM };
+		uint32_t len = 0;
+		uint64_t t0;
+		uint32_t i;
+		char name[64];
+
+		bench_fill(types[k]);
+
+		t0 = bench_now_ns();
+		for (i = 0; i < nb; i++) {
+			len = bench_snprintf(types[k]);
+			BENCH_KEEP(len);
+		}
+		snprintf(name, sizeof(name), "snprintf %-6s (%4u bytes / %d values)", LO_getDataTypeToStr(types[k]),
+				(unsigned) len, BENCH_DIM);
+		bench_report(name, (uint64_t) nb * BENCH_DIM, bench_now_ns() - t0);
+
+		t0 = bench_now_ns();
+		for (i = 0; i < nb; i++) {
+			len = bench_writer(&data);
+			BENCH_KEEP(len);
+		}
+		if (len == 0) {
+			printf("ERROR - LO_json_add_item %s\n", LO_getDataTypeToStr(types[k]));
+			return 1;
+		}
+		snprintf(name, sizeof(name), "LO_json %-6s (%4u bytes / %d values)", LO_getDataTypeToStr(types[k]),
+				(unsigned) len, BENCH_DIM);
+		bench_report(name, (uint64_t) nb * BENCH_DIM, bench_now_ns() - t0);
+	}
+
+	bad = bench_check();
+	printf("float/double read back: %u error(s)\n", (unsigned) bad);
+	return (bad) ? 1 : 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  num_parse.c
+ * @brief Parsing of the received numbers: LO_json_atoi/atou/atof/atod against sscanf
+ *
+ * The corpus is 4096 config updates of one value, for each type (i32, u32, f64 and double):
+ *   { "cid": <n>, "cfg": { "setpoint": { "t": "<type>", "v": <value> } } }
+ * The numbers are read in place in the payload by sscanf(), as the previous version of the decoder
+ * did, and by the parser of the library (not NUL terminated). The time is given per value.
+ * The results are compared: the floating point numbers must be the same (correctly rounded).
+ */
+
+#include "bench.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "iotsoftbox-core/loc_json_api.h"
+
+#define BENCH_NB_VALUES     4096
+#define BENCH_PAYLOAD_SZ    96
+
+typedef enum {
+	BENCH_I32 = 0,
+	BENCH_U32,
+	BENCH_F32,
+	BENCH_F64
+} BenchType_t;
+
+static const char* _bench_type_name[] = { "i32", "u32", "f64", "double" };
+
+static char _bench_payload[BENCH_NB_VALUES][BENCH_PAYLOAD_SZ];
+static uint32_t _bench_pos[BENCH_NB_VALUES];
+static uint32_t _bench_len[BENCH_NB_VALUES];
+
+static union {
+	int32_t i32[BENCH_NB_VALUES];
+	uint32_t u32[BENCH_NB_VALUES];
+	float f32[BENCH_NB_VALUES];
+	double f64[BENCH_NB_VALUES];
+} _bench_ref, _bench_res;
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static uint32_t bench_rand(void) {
+	static uint32_t x = 2463534242U;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return x;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* BENCH_NB_VALUES config updates of one value of the type: the usual values of the devices
+ * (small integers, decimal values) and values over the whole range */
+static void bench_corpus(BenchType_t type) {
+	static const char* decimals[] = { "21.5", "-40.25", "0.001", "3.3125", "1e-3", "100", "0.1", "-0.5" };
+	uint32_t i;
+
+	for (i = 0; i < BENCH_NB_VALUES; i++) {
+		uint32_t r = bench_rand();
+		char* p = _bench_payload[i];
+		char v[40];
+		int len;
+		switch (type) {
+		case BENCH_I32:
+			snprintf(v, sizeof(v), "%"PRIi32, (i & 1) ? (int32_t) r : (int32_t) (r % 2000) - 1000);
+			break;
+		case BENCH_U32:
+			snprintf(v, sizeof(v), "%"PRIu32, (i & 1) ? r : r % 3600);
+			break;
+		case BENCH_F32:
+			if (i & 1) {
+				snprintf(v, sizeof(v), "%.9g", (double) ((int32_t) r) / 65536.0);
+			}
+			else {
+				snprintf(v, sizeof(v), "%s", decimals[r % 8]);
+			}
+			break;
+		case BENCH_F64:
+			if (i & 1) {
+				snprintf(v, sizeof(v), "%.17g", (double) ((int32_t) r) * (double) bench_rand() / 3e9);
+			}
+			else {
+				snprintf(v, sizeof(v), "%s", decimals[r % 8]);
+			}
+			break;
+		}
+		len = snprintf(p, BENCH_PAYLOAD_SZ, "{\"cid\":%u,\"cfg\":{\"setpoint\":{\"t\":\"%s\",\"v\":",
+				(unsigned) i, _bench_type_name[type]);
+		_bench_pos[i] = len;
+		_bench_len[i] = strlen(v);
+		snprintf(p + len, BENCH_PAYLOAD_SZ - len, "%s}}}", v);
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Previous version of the decoder */
+static void bench_sscanf(BenchType_t type) {
+	uint32_t i;
+	for (i = 0; i < BENCH_NB_VALUES; i++) {
+		const char* p = _bench_payload[i] + _bench_pos[i];
+		switch (type) {
+		case BENCH_I32: sscanf(p, "%"SCNi32, &_bench_ref.i32[i]); break;
+		case BENCH_U32: sscanf(p, "%"SCNu32, &_bench_ref.u32[i]); break;
+		case BENCH_F32: sscanf(p, "%f", &_bench_ref.f32[i]); break;
+		case BENCH_F64: sscanf(p, "%lf", &_bench_ref.f64[i]); break;
+		}
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_parse(BenchType_t type) {
+	int rc = 0;
+	uint32_t i;
+	for (i = 0; i < BENCH_NB_VALUES; i++) {
+		const char* p = _bench_payload[i] + _bench_pos[i];
+		switch (type) {
+		case BENCH_I32: rc |= LO_json_atoi(p, _bench_len[i], &_bench_res.i32[i]); break;
+		case BENCH_U32: rc |= LO_json_atou(p, _bench_len[i], &_bench_res.u32[i]); break;
+		case BENCH_F32: rc |= LO_json_atof(p, _bench_len[i], &_bench_res.f32[i]); break;
+		case BENCH_F64: rc |= LO_json_atod(p, _bench_len[i], &_bench_res.f64[i]); break;
+		}
+	}
+	return rc;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int main(int argc, char* argv[]) {
+	uint32_t nb = bench_iterations(argc, argv, 1000);
+	int errors = 0;
+	int type;
+
+	for (type = BENCH_I32; type <= BENCH_F64; type++) {
+		uint64_t t0;
+		uint32_t i;
+		int rc = 0;
+		char name[64];
+
+		bench_corpus((BenchType_t) type);
+
+		t0 = bench_now_ns();
+		for (i = 0; i < nb; i++) {
+			bench_sscanf((BenchType_t) type);
+		}
+		snprintf(name, sizeof(name), "sscanf  %s", _bench_type_name[type]);
+		bench_report(name, (uint64_t) nb * BENCH_NB_VALUES, bench_now_ns() - t0);
+
+		t0 = bench_now_ns();
+		for (i = 0; i < nb; i++) {
+			rc |= bench_parse((BenchType_t) type);
+		}
+		snprintf(name, sizeof(name), "LO_json %s", _bench_type_name[type]);
+		bench_report(name, (uint64_t) nb * BENCH_NB_VALUES, bench_now_ns() - t0);
+
+		if (rc) {
+			printf("ERROR - %s: value rejected\n", _bench_type_name[type]);
+			errors++;
+		}
+		if (memcmp(&_bench_ref, &_bench_res, sizeof(_bench_ref))) {
+			printf("ERROR - %s: values differ from sscanf\n", _bench_type_name[type]);
+			errors++;
+		}
+	}
+	return (errors) ? 1 : 0;
+}
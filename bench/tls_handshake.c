@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  tls_handshake.c
+ * @brief Connection of many network contexts from one thread: blocking and stepped SSL/TLS handshakes
+ *
+ * 1, 8 and 32 network contexts connect to the stand-in of the SSL/TLS server (tls_server.h, full
+ * handshakes), from the calling thread:
+ * - blocking: netw_connect() of each context, one after the other,
+ * - stepped: netw_connectStart() of all the contexts (non-blocking TCP connection and handshake), then
+ *   netw_connectStep() of the contexts whose socket is ready (poll), as the event loop does.
+ * Then all the contexts disconnect. Gives the time to connect all the contexts, and the handshakes per second.
+ *
+ * Built with -DLOC_FEATURE_MBEDTLS=1 (and LOC_FEATURE_EVLOOP). The files of the certificates are in the
+ * current directory (see README.md).
+ */
+
+#include "bench.h"
+
+#include <poll.h>
+
+#include "iotsoftbox-core/loc_sys.h"
+
+#include "iotsoftbox-core/netw_wrapper.h"
+
+#include "tls_server.h"
+
+#if !LOC_FEATURE_MBEDTLS || !LOC_FEATURE_EVLOOP
+#error "Built with -DLOC_FEATURE_MBEDTLS=1 and LOC_FEATURE_EVLOOP"
+#endif
+
+#define BENCH_CTX_MAX   32
+
+static const LiveObjectsSecurityParams_t _bench_security = {
+	{ 1, "bench_ca.pem" },
+	{ 0, NULL },
+	{ 0, NULL },
+	"localhost",
+	2
+};
+
+static LiveObjectsNetCtx_t _bench_netw[BENCH_CTX_MAX];
+
+/* --------------------------------------------------------------------------------- */
+/* Connect the contexts one after the other */
+static int bench_blocking(const LiveObjectsNetConnectParams_t* params, int nb_ctx) {
+	int i;
+	for (i = 0; i < nb_ctx; i++) {
+		int ret = netw_connect(&_bench_netw[i], params);
+		if (ret) {
+			printf("ERROR - connection %d, ret=%d\n", i, ret);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Start the handshakes of all the contexts, and step them when their socket is ready */
+static int bench_stepped(const LiveObjectsNetConnectParams_t* params, int nb_ctx) {
+	struct pollfd pfd[BENCH_CTX_MAX];
+	int state[BENCH_CTX_MAX];
+	int pending = 0;
+	int i;
+
+	for (i = 0; i < nb_ctx; i++) {
+		state[i] = netw_connectStart(&_bench_netw[i], params, 1);
+		if (state[i] < 0) {
+			printf("ERROR - connection %d, ret=%d\n", i, state[i]);
+			return -1;
+		}
+		if (state[i]) {
+			pending++;
+		}
+	}
+	while (pending) {
+		int n = 0;
+		for (i = 0; i < nb_ctx; i++) {
+			if (state[i] == 0) {
+				continue;
+			}
+			pfd[n].fd = netw_getFd(&_bench_netw[i]);
+			pfd[n].events = (state[i] == NETW_CONN_WANT_WRITE) ? POLLOUT : POLLIN;
+			pfd[n].revents = 0;
+			n++;
+		}
+		if (poll(pfd, (nfds_t) n, 10000) <= 0) {
+			printf("ERROR - handshake timeout (%d pending)\n", pending);
+			return -1;
+		}
+		n = 0;
+		for (i = 0; i < nb_ctx; i++) {
+			if (state[i] == 0) {
+				continue;
+			}
+			if (pfd[n++].revents) {
+				state[i] = netw_connectStep(&_bench_netw[i]);
+				if (state[i] < 0) {
+					printf("ERROR - connection %d, ret=%d\n", i, state[i]);
+					return -1;
+				}
+				if (state[i] == 0) {
+					pending--;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_run(int stepped, int nb_ctx, uint32_t rtt_ms, uint32_t nb) {
+	static BenchTlsServer_t server;
+	LiveObjectsNetConnectParams_t params;
+	uint64_t dt = 0;
+	char name[64];
+	uint32_t r;
+	int i;
+
+	server.crt_file = "bench_srv.pem";
+	server.key_file = "bench_srv.key";
+	server.delay_ms = rtt_ms;
+	server.resume = BENCH_TLS_RESUME_NONE;
+	if (bench_tls_server_start(&server)) {
+		printf("ERROR - server start\n");
+		return -1;
+	}
+	for (i = 0; i < nb_ctx; i++) {
+		memset(&_bench_netw[i], 0, sizeof(LiveObjectsNetCtx_t));
+		if ((netw_init(&_bench_netw[i], NULL)) || (netw_setSecurity(&_bench_netw[i], &_bench_security))) {
+			printf("ERROR - client init\n");
+			return -1;
+		}
+	}
+	params.RemoteHostAddress = "127.0.0.1";
+	params.RemoteHostPort = server.port;
+	params.TimeoutMs = 10000;
+
+	for (r = 0; r < nb; r++) {
+		uint64_t t0 = bench_now_ns();
+		if ((stepped) ? bench_stepped(&params, nb_ctx) : bench_blocking(&params, nb_ctx)) {
+			return -1;
+		}
+		dt += bench_now_ns() - t0;
+		for (i = 0; i < nb_ctx; i++) {
+			netw_disconnect(&_bench_netw[i], 0);
+		}
+	}
+
+	bench_tls_server_stop(&server);
+	for (i = 0; i < nb_ctx; i++) {
+		netw_tls_destroy(&_bench_netw[i]);
+	}
+
+	snprintf(name, sizeof(name), "%s, %2d contexts, %6.1f ms/round", (stepped) ? "stepped " : "blocking",
+			nb_ctx, dt / 1e6 / nb);
+	bench_report(name, (uint64_t) nb * nb_ctx, dt);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int main(int argc, char* argv[]) {
+	uint32_t nb = bench_iterations(argc, argv, 20);
+	uint32_t rtt_ms = (argc > 2) ? (uint32_t) strtoul(argv[2], NULL, 10) : 2;
+	static const int nb_ctx[] = { 1, 8, BENCH_CTX_MAX };
+	unsigned int i;
+
+	LO_sys_init();
+	printf("RTT %u ms\n", (unsigned) rtt_ms);
+	for (i = 0; i < sizeof(nb_ctx) / sizeof(nb_ctx[0]); i++) {
+		if ((bench_run(0, nb_ctx[i], rtt_ms, nb)) || (bench_run(1, nb_ctx[i], rtt_ms, nb))) {
+			return 1;
+		}
+	}
+	return 0;
+}
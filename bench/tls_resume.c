@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  tls_resume.c
+ * @brief Latency and CPU time of the SSL/TLS connection, with and without session resumption
+ *
+ * A network context connects (netw_connect) to the stand-in of the SSL/TLS server (tls_server.h),
+ * and disconnects, in a loop. The server does not resume the sessions, then resumes them with its
+ * session cache (session ID), then with session tickets. The first connection of each case is a
+ * full handshake, not measured.
+ *
+ * Gives the time of netw_connect(), the share of resumed sessions, and the CPU time of the client
+ * and of the server per connection.
+ *
+ * Built with -DLOC_FEATURE_MBEDTLS=1. The files of the certificates are in the current directory
+ * (see README.md).
+ */
+
+#include "bench.h"
+
+#include "iotsoftbox-core/loc_sys.h"
+
+#include "iotsoftbox-core/netw_wrapper.h"
+
+#include "tls_server.h"
+
+#if !LOC_FEATURE_MBEDTLS
+#error "Built with -DLOC_FEATURE_MBEDTLS=1"
+#endif
+
+static const LiveObjectsSecurityParams_t _bench_security = {
+	{ 1, "bench_ca.pem" },
+	{ 0, NULL },
+	{ 0, NULL },
+	"localhost",
+	2
+};
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int bench_run(int resume, uint32_t rtt_ms, uint32_t nb) {
+	static const char* const names[] = { "full", "cache", "ticket" };
+	static BenchTlsServer_t server;
+	static LiveObjectsNetCtx_t netw;
+	LiveObjectsNetConnectParams_t params;
+	unsigned char master[48];
+	uint8_t saved;
+	uint32_t resumed = 0;
+	uint64_t dt = 0;
+	uint64_t cpu = 0;
+	char name[64];
+	uint32_t i;
+
+	server.crt_file = "bench_srv.pem";
+	server.key_file = "bench_srv.key";
+	server.delay_ms = rtt_ms;
+	server.resume = resume;
+	if (bench_tls_server_start(&server)) {
+		printf("ERROR - server start\n");
+		return -1;
+	}
+
+	memset(&netw, 0, sizeof(netw));
+	if ((netw_init(&netw, NULL)) || (netw_setSecurity(&netw, &_bench_security))) {
+		printf("ERROR - client init\n");
+		return -1;
+	}
+	params.RemoteHostAddress = "127.0.0.1";
+	params.RemoteHostPort = server.port;
+	params.TimeoutMs = 10000;
+
+	for (i = 0; i <= nb; i++) {
+		uint64_t t0, c0;
+		int ret;
+
+		/* Resumed: same master secret as the saved session (see netw_sessionSave) */
+		saved = netw.session_ok;
+		memcpy(master, netw.session.master, sizeof(master));
+		t0 = bench_now_ns();
+		c0 = bench_cpu_ns();
+		ret = netw_connect(&netw, &params);
+		if (ret) {
+			printf("ERROR - connection %u, ret=%d\n", (unsigned) i, ret);
+			return -1;
+		}
+		if (i > 0) {
+			/* Not the first (full) handshake */
+			cpu += bench_cpu_ns() - c0;
+			dt += bench_now_ns() - t0;
+			if ((saved) && (memcmp(master, netw.session.master, sizeof(master)) == 0)) {
+				resumed++;
+			}
+		}
+		netw_disconnect(&netw, 0);
+	}
+
+	bench_tls_server_stop(&server);
+	netw_tls_destroy(&netw);
+
+	snprintf(name, sizeof(name), "%-6s %3.0f%% resumed, CPU %5.0f+%5.0f us", names[resume],
+			100.0 * resumed / nb, cpu / 1000.0 / nb, server.cpu_ns / 1000.0 / (nb + 1));
+	bench_report(name, nb, dt);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int main(int argc, char* argv[]) {
+	uint32_t nb = bench_iterations(argc, argv, 200);
+	uint32_t rtt_ms = (argc > 2) ? (uint32_t) strtoul(argv[2], NULL, 10) : 2;
+	int resume;
+
+	LO_sys_init();
+	printf("RTT %u ms\n", (unsigned) rtt_ms);
+	for (resume = BENCH_TLS_RESUME_NONE; resume <= BENCH_TLS_RESUME_TICKET; resume++) {
+		if (bench_run(resume, rtt_ms, nb)) {
+			return 1;
+		}
+	}
+	return 0;
+}
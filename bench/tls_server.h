@@ -0,0 +1,398 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  tls_server.h
+ * @brief Stand-in of the SSL/TLS server (mbedtls) for the benchmark programs (see bench/README.md)
+ *
+ * A thread listens on 127.0.0.1 (port chosen by the system), and runs the SSL/TLS handshake of
+ * up to BENCH_TLS_CONN_MAX concurrent connections (non-blocking sockets, one poll() loop).
+ * Once established, a connection reads and drops the received data until the client closes it.
+ *
+ * The data received from a client are processed 'delay_ms' after they are readable: this gives
+ * the round trip time of the network (one per flight of the handshake).
+ *
+ * 'resume' selects the session resumption offered to the clients: none (full handshakes),
+ * session cache (session ID) or session tickets.
+ *
+ * The certificate of the server and its private key are read from files
+ * (see bench/README.md to generate them).
+ */
+
+#ifndef __bench_tls_server_H_
+#define __bench_tls_server_H_
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "mbedtls/config.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ssl.h"
+#if defined(MBEDTLS_SSL_CACHE_C)
+#include "mbedtls/ssl_cache.h"
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+#include "mbedtls/ssl_ticket.h"
+#endif
+#include "mbedtls/x509_crt.h"
+
+#include "bench.h"
+
+#define BENCH_TLS_CONN_MAX      64
+
+#define BENCH_TLS_RESUME_NONE   0   /* Full handshakes */
+#define BENCH_TLS_RESUME_CACHE  1   /* Session cache of the server (session ID) */
+#define BENCH_TLS_RESUME_TICKET 2   /* Session tickets */
+
+typedef struct {
+	int fd;                         /* -1: free */
+	uint8_t established;            /* Handshake done */
+	uint8_t want_write;             /* Blocked on a write */
+	uint64_t due;                   /* Received data processed at this time (ns), 0: none */
+	mbedtls_ssl_context ssl;
+} BenchTlsConn_t;
+
+typedef struct {
+	/* Parameters, set before bench_tls_server_start() */
+	const char* crt_file;           /*!< Certificate of the server (CN: localhost) */
+	const char* key_file;           /*!< Private key of the server */
+	uint32_t delay_ms;              /*!< Delay of the processing of the received data (round trip time) */
+	int resume;                     /*!< BENCH_TLS_RESUME_xxx */
+
+	/* Results */
+	uint16_t port;                  /*!< Listening port */
+	volatile uint32_t nb_handshakes;/*!< Number of completed handshakes */
+	volatile uint32_t nb_errors;    /*!< Number of failed handshakes */
+	uint64_t cpu_ns;                /*!< CPU time of the server thread, set by bench_tls_server_stop() */
+
+	/* Internal */
+	int listen_fd;
+	volatile int stop;
+	pthread_t thread;
+	mbedtls_entropy_context entropy;
+	mbedtls_ctr_drbg_context ctr_drbg;
+	mbedtls_x509_crt crt;
+	mbedtls_pk_context key;
+	mbedtls_ssl_config conf;
+#if defined(MBEDTLS_SSL_CACHE_C)
+	mbedtls_ssl_cache_context cache;
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+	mbedtls_ssl_ticket_context ticket;
+#endif
+	BenchTlsConn_t conn[BENCH_TLS_CONN_MAX];
+	unsigned char rcv_buf[4096];
+} BenchTlsServer_t;
+
+/* --------------------------------------------------------------------------------- */
+/* CPU time of the calling thread (ns) */
+static uint64_t bench_cpu_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Send callback of the SSL/TLS layer (non-blocking socket) */
+static int bench_tls_send(void* ctx, const unsigned char* buf, size_t len) {
+	BenchTlsConn_t* c = (BenchTlsConn_t*) ctx;
+	ssize_t n;
+	while (((n = send(c->fd, buf, len, MSG_NOSIGNAL)) < 0) && (errno == EINTR)) {
+	}
+	if (n < 0) {
+		if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+			c->want_write = 1;
+			return MBEDTLS_ERR_SSL_WANT_WRITE;
+		}
+		return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+	}
+	return (int) n;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Receive callback of the SSL/TLS layer (non-blocking socket) */
+static int bench_tls_recv(void* ctx, unsigned char* buf, size_t len) {
+	BenchTlsConn_t* c = (BenchTlsConn_t*) ctx;
+	ssize_t n;
+	while (((n = recv(c->fd, buf, len, 0)) < 0) && (errno == EINTR)) {
+	}
+	if (n < 0) {
+		if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+			return MBEDTLS_ERR_SSL_WANT_READ;
+		}
+		return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+	}
+	return (int) n;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void bench_tls_close(BenchTlsConn_t* c) {
+	close(c->fd);
+	c->fd = -1;
+	c->established = 0;
+	c->want_write = 0;
+	c->due = 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Accept a connection in a free slot */
+static void bench_tls_accept(BenchTlsServer_t* s) {
+	BenchTlsConn_t* c = NULL;
+	int one = 1;
+	int fd;
+	int i;
+
+	fd = accept(s->listen_fd, NULL, NULL);
+	if (fd < 0) {
+		return;
+	}
+	for (i = 0; i < BENCH_TLS_CONN_MAX; i++) {
+		if (s->conn[i].fd < 0) {
+			c = &s->conn[i];
+			break;
+		}
+	}
+	if ((c == NULL) || (mbedtls_ssl_session_reset(&c->ssl))) {
+		close(fd);
+		return;
+	}
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+	c->fd = fd;
+	mbedtls_ssl_set_bio(&c->ssl, c, bench_tls_send, bench_tls_recv, NULL);
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Continue the handshake, or read and drop the received data */
+static void bench_tls_process(BenchTlsServer_t* s, BenchTlsConn_t* c) {
+	int ret;
+
+	c->want_write = 0;
+	if (!c->established) {
+		ret = mbedtls_ssl_handshake(&c->ssl);
+		if (ret == 0) {
+			c->established = 1;
+			s->nb_handshakes++;
+		}
+		else if ((ret != MBEDTLS_ERR_SSL_WANT_READ) && (ret != MBEDTLS_ERR_SSL_WANT_WRITE)) {
+			s->nb_errors++;
+			bench_tls_close(c);
+			return;
+		}
+	}
+	if (c->established) {
+		while ((ret = mbedtls_ssl_read(&c->ssl, s->rcv_buf, sizeof(s->rcv_buf))) > 0) {
+		}
+		if ((ret != MBEDTLS_ERR_SSL_WANT_READ) && (ret != MBEDTLS_ERR_SSL_WANT_WRITE)) {
+			/* Closed by the client (close_notify or end of the connection) */
+			bench_tls_close(c);
+		}
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void* bench_tls_server_run(void* arg) {
+	BenchTlsServer_t* s = (BenchTlsServer_t*) arg;
+	struct pollfd pfd[1 + BENCH_TLS_CONN_MAX];
+	BenchTlsConn_t* pc[1 + BENCH_TLS_CONN_MAX];
+	int i;
+
+	while (!s->stop) {
+		uint64_t now = bench_now_ns();
+		int tmo = 10;
+		int n = 1;
+
+		/* Process the data received delay_ms ago */
+		for (i = 0; i < BENCH_TLS_CONN_MAX; i++) {
+			BenchTlsConn_t* c = &s->conn[i];
+			if ((c->fd >= 0) && (c->due) && (c->due <= now)) {
+				c->due = 0;
+				bench_tls_process(s, c);
+			}
+		}
+
+		pfd[0].fd = s->listen_fd;
+		pfd[0].events = POLLIN;
+		pfd[0].revents = 0;
+		now = bench_now_ns();
+		for (i = 0; i < BENCH_TLS_CONN_MAX; i++) {
+			BenchTlsConn_t* c = &s->conn[i];
+			if (c->fd < 0) {
+				continue;
+			}
+			if (c->due) {
+				int t = (int) ((c->due - now + 999999) / 1000000);
+				if (t < tmo) {
+					tmo = t;
+				}
+				continue;
+			}
+			pfd[n].fd = c->fd;
+			pfd[n].events = (c->want_write) ? POLLOUT : POLLIN;
+			pfd[n].revents = 0;
+			pc[n] = c;
+			n++;
+		}
+		if (poll(pfd, (nfds_t) n, tmo) <= 0) {
+			continue;
+		}
+		if (pfd[0].revents & POLLIN) {
+			bench_tls_accept(s);
+		}
+		now = bench_now_ns();
+		for (i = 1; i < n; i++) {
+			if (pfd[i].revents == 0) {
+				continue;
+			}
+			if ((pfd[i].revents & POLLOUT) || (s->delay_ms == 0)) {
+				bench_tls_process(s, pc[i]);
+			}
+			else {
+				pc[i]->due = now + (uint64_t) s->delay_ms * 1000000;
+			}
+		}
+	}
+	for (i = 0; i < BENCH_TLS_CONN_MAX; i++) {
+		if (s->conn[i].fd >= 0) {
+			bench_tls_close(&s->conn[i]);
+		}
+	}
+	s->cpu_ns = bench_cpu_ns();
+	return NULL;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Load the certificate and the key, listen on 127.0.0.1 (s->port), and start the thread.
+ * Return 0 if successful */
+static int bench_tls_server_start(BenchTlsServer_t* s) {
+	const char* pers = "bench_tls_server";
+	struct sockaddr_in a;
+	socklen_t alen = sizeof(a);
+	int ret;
+	int i;
+
+	s->nb_handshakes = 0;
+	s->nb_errors = 0;
+	s->cpu_ns = 0;
+	s->stop = 0;
+	mbedtls_entropy_init(&s->entropy);
+	mbedtls_ctr_drbg_init(&s->ctr_drbg);
+	mbedtls_x509_crt_init(&s->crt);
+	mbedtls_pk_init(&s->key);
+	mbedtls_ssl_config_init(&s->conf);
+#if defined(MBEDTLS_SSL_CACHE_C)
+	mbedtls_ssl_cache_init(&s->cache);
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+	mbedtls_ssl_ticket_init(&s->ticket);
+#endif
+
+	if (((ret = mbedtls_ctr_drbg_seed(&s->ctr_drbg, mbedtls_entropy_func, &s->entropy, (const unsigned char*) pers,
+			strlen(pers))) != 0)
+			|| ((ret = mbedtls_x509_crt_parse_file(&s->crt, s->crt_file)) != 0)
+			|| ((ret = mbedtls_pk_parse_keyfile(&s->key, s->key_file, NULL)) != 0)
+			|| ((ret = mbedtls_ssl_config_defaults(&s->conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM,
+					MBEDTLS_SSL_PRESET_DEFAULT)) != 0)
+			|| ((ret = mbedtls_ssl_conf_own_cert(&s->conf, &s->crt, &s->key)) != 0)) {
+		printf("ERROR - server setup, mbedtls error -0x%04X\n", (unsigned) -ret);
+		return -1;
+	}
+	mbedtls_ssl_conf_rng(&s->conf, mbedtls_ctr_drbg_random, &s->ctr_drbg);
+	mbedtls_ssl_conf_authmode(&s->conf, MBEDTLS_SSL_VERIFY_NONE);
+	if (s->resume == BENCH_TLS_RESUME_CACHE) {
+#if defined(MBEDTLS_SSL_CACHE_C)
+		mbedtls_ssl_conf_session_cache(&s->conf, &s->cache, mbedtls_ssl_cache_get, mbedtls_ssl_cache_set);
+#else
+		printf("ERROR - session cache not supported (MBEDTLS_SSL_CACHE_C)\n");
+		return -1;
+#endif
+	}
+	else if (s->resume == BENCH_TLS_RESUME_TICKET) {
+#if defined(MBEDTLS_SSL_TICKET_C)
+		if ((ret = mbedtls_ssl_ticket_setup(&s->ticket, mbedtls_ctr_drbg_random, &s->ctr_drbg,
+				MBEDTLS_CIPHER_AES_256_GCM, 86400)) != 0) {
+			printf("ERROR - session tickets, mbedtls error -0x%04X\n", (unsigned) -ret);
+			return -1;
+		}
+		mbedtls_ssl_conf_session_tickets_cb(&s->conf, mbedtls_ssl_ticket_write, mbedtls_ssl_ticket_parse,
+				&s->ticket);
+#else
+		printf("ERROR - session tickets not supported (MBEDTLS_SSL_TICKET_C)\n");
+		return -1;
+#endif
+	}
+	for (i = 0; i < BENCH_TLS_CONN_MAX; i++) {
+		s->conn[i].fd = -1;
+		s->conn[i].established = 0;
+		s->conn[i].want_write = 0;
+		s->conn[i].due = 0;
+		mbedtls_ssl_init(&s->conn[i].ssl);
+		if (mbedtls_ssl_setup(&s->conn[i].ssl, &s->conf)) {
+			return -1;
+		}
+	}
+
+	s->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (s->listen_fd < 0) {
+		return -1;
+	}
+	memset(&a, 0, sizeof(a));
+	a.sin_family = AF_INET;
+	a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if ((bind(s->listen_fd, (struct sockaddr*) &a, sizeof(a))) || (listen(s->listen_fd, BENCH_TLS_CONN_MAX))
+			|| (getsockname(s->listen_fd, (struct sockaddr*) &a, &alen))) {
+		close(s->listen_fd);
+		return -1;
+	}
+	s->port = ntohs(a.sin_port);
+	if (pthread_create(&s->thread, NULL, bench_tls_server_run, s)) {
+		close(s->listen_fd);
+		return -1;
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Stop the thread (the open connections are closed), and free the server */
+static void bench_tls_server_stop(BenchTlsServer_t* s) {
+	int i;
+
+	s->stop = 1;
+	pthread_join(s->thread, NULL);
+	close(s->listen_fd);
+	for (i = 0; i < BENCH_TLS_CONN_MAX; i++) {
+		mbedtls_ssl_free(&s->conn[i].ssl);
+	}
+#if defined(MBEDTLS_SSL_TICKET_C)
+	mbedtls_ssl_ticket_free(&s->ticket);
+#endif
+#if defined(MBEDTLS_SSL_CACHE_C)
+	mbedtls_ssl_cache_free(&s->cache);
+#endif
+	mbedtls_ssl_config_free(&s->conf);
+	mbedtls_pk_free(&s->key);
+	mbedtls_x509_crt_free(&s->crt);
+	mbedtls_ctr_drbg_free(&s->ctr_drbg);
+	mbedtls_entropy_free(&s->entropy);
+}
+
+#endif /* __bench_tls_server_H_ */
@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  loc_cbor_api.c
+ * @brief Basic CBOR (RFC 7049) functions
+ *
+ * The messages have the same structure as the JSON messages:
+ * - an object (section) is a map of indefinite length (0xBF ... 0xFF), because
+ *   the number of its members is not known when it is started,
+ * - an array of values (data_dim > 1) is an array of definite length,
+ * - the integers use the shortest head, a float is a single precision float (0xFA),
+ *   a double is a double precision float (0xFB), a string is a text string.
+ */
+
+#include "liveobjects-client/LiveObjectsClient_Config.h"
+
+#if LOC_FEATURE_CBOR
+
+#include "loc_cbor_api.h"
+
+#ifndef TRACE_GROUP
+#define TRACE_GROUP "CBOR"
+#endif
+#include "liveobjects-sys/loc_trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "liveobjects-sys/LiveObjectsClient_Platform.h"
+#include "platform_default.h"
+
+#define LO_CBOR_MAJOR_UINT      0x00
+#define LO_CBOR_MAJOR_NINT      0x20
+#define LO_CBOR_MAJOR_TEXT      0x60
+#define LO_CBOR_MAJOR_ARRAY     0x80
+#define LO_CBOR_MAP_BEGIN       0xBF    /* Map of indefinite length */
+#define LO_CBOR_ARRAY_BEGIN     0x9F    /* Array of indefinite length */
+#define LO_CBOR_FALSE           0xF4
+#define LO_CBOR_TRUE            0xF5
+#define LO_CBOR_NULL            0xF6
+#define LO_CBOR_FLOAT32         0xFA
+#define LO_CBOR_FLOAT64         0xFB
+#define LO_CBOR_BREAK           0xFF
+
+/* --------------------------------------------------------------------------------- */
+/* Append n bytes, or set the overflow flag if they do not fit */
+static void LO_cbor_put(LOJsonWriter_t* w, const void* p, uint32_t n) {
+	if (w->overflow) {
+		return;
+	}
+	if (n > w->size - w->len) {
+		w->overflow = 1;
+		return;
+	}
+	memcpy(w->buf + w->len, p, n);
+	w->len += n;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LO_cbor_put_byte(LOJsonWriter_t* w, uint8_t b) {
+	LO_cbor_put(w, &b, 1);
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Head of a data item: major type and argument, in the shortest form */
+static void LO_cbor_put_head(LOJsonWriter_t* w, uint8_t major, uint32_t value) {
+	uint8_t b[5];
+	uint32_t n;
+	if (value < 24) {
+		b[0] = major | (uint8_t) value;
+		n = 1;
+	}
+	else if (value <= 0xFF) {
+		b[0] = major | 24;
+		b[1] = (uint8_t) value;
+		n = 2;
+	}
+	else if (value <= 0xFFFF) {
+		b[0] = major | 25;
+		b[1] = (uint8_t) (value >> 8);
+		b[2] = (uint8_t) value;
+		n = 3;
+	}
+	else {
+		b[0] = major | 26;
+		b[1] = (uint8_t) (value >> 24);
+		b[2] = (uint8_t) (value >> 16);
+		b[3] = (uint8_t) (value >> 8);
+		b[4] = (uint8_t) value;
+		n = 5;
+	}
+	LO_cbor_put(w, b, n);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LO_cbor_put_int(LOJsonWriter_t* w, int32_t value) {
+	if (value < 0) {
+		LO_cbor_put_head(w, LO_CBOR_MAJOR_NINT, (uint32_t) (-1 - value));
+	}
+	else {
+		LO_cbor_put_head(w, LO_CBOR_MAJOR_UINT, (uint32_t) value);
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LO_cbor_put_float(LOJsonWriter_t* w, float value) {
+	uint8_t b[5];
+	uint32_t u;
+	memcpy(&u, &value, 4);
+	b[0] = LO_CBOR_FLOAT32;
+	b[1] = (uint8_t) (u >> 24);
+	b[2] = (uint8_t) (u >> 16);
+	b[3] = (uint8_t) (u >> 8);
+	b[4] = (uint8_t) u;
+	LO_cbor_put(w, b, 5);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LO_cbor_put_double(LOJsonWriter_t* w, double value) {
+	uint8_t b[9];
+	uint64_t u;
+	int i;
+	memcpy(&u, &value, 8);
+	b[0] = LO_CBOR_FLOAT64;
+	for (i = 8; i > 0; i--) {
+		b[i] = (uint8_t) u;
+		u >>= 8;
+	}
+	LO_cbor_put(w, b, 9);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LO_cbor_put_text(LOJsonWriter_t* w, const char* p, uint32_t len) {
+	LO_cbor_put_head(w, LO_CBOR_MAJOR_TEXT, len);
+	LO_cbor_put(w, p, len);
+}
+
+#define LO_cbor_put_str(w, s)   LO_cbor_put_text((w), (s), strlen(s))
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+const char* LO_cbor_result(LOJsonWriter_t* w) {
+	if (w->overflow) {
+		LOTRACE_ERR("failed, buffer too short (size=%"PRIu32" len=%"PRIu32")", w->size, w->len);
+		return NULL;
+	}
+	return w->buf;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_cbor_begin(LOJsonWriter_t* w) {
+	LO_cbor_put_byte(w, LO_CBOR_MAP_BEGIN);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_cbor_end(LOJsonWriter_t* w) {
+	LO_cbor_put_byte(w, LO_CBOR_BREAK);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_cbor_begin_section(LOJsonWriter_t* w, const char* name) {
+	LO_cbor_begin(w);
+	LO_cbor_add_section_start(w, name);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_cbor_end_section(LOJsonWriter_t* w) {
+	LO_cbor_put_byte(w, LO_CBOR_BREAK);
+	LO_cbor_put_byte(w, LO_CBOR_BREAK);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_cbor_add_section_start(LOJsonWriter_t* w, const char* section_name) {
+	LO_cbor_put_str(w, section_name);
+	LO_cbor_put_byte(w, LO_CBOR_MAP_BEGIN);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_cbor_add_section_end(LOJsonWriter_t* w) {
+	LO_cbor_put_byte(w, LO_CBOR_BREAK);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_cbor_add_name_int(LOJsonWriter_t* w, const char* name, int32_t value) {
+	LO_cbor_put_str(w, name);
+	LO_cbor_put_int(w, value);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_cbor_add_name_str(LOJsonWriter_t* w, const char* name, const char* value) {
+	LO_cbor_put_str(w, name);
+	LO_cbor_put_str(w, value);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_cbor_add_name_array(LOJsonWriter_t* w, const char* name, const char* array) {
+	const char* p = array;
+
+	LO_cbor_put_str(w, name);
+	LO_cbor_put_byte(w, LO_CBOR_ARRAY_BEGIN);
+	while (*p) {
+		if ((*p == ' ') || (*p == ',')) {
+			p++;
+		}
+		else if (*p == '"') {
+			const char* end = strchr(++p, '"');
+			if (end == NULL) {
+				break;
+			}
+			LO_cbor_put_text(w, p, end - p);
+			p = end + 1;
+		}
+		else if (!strncmp(p, "true", 4)) {
+			LO_cbor_put_byte(w, LO_CBOR_TRUE);
+			p += 4;
+		}
+		else if (!strncmp(p, "false", 5)) {
+			LO_cbor_put_byte(w, LO_CBOR_FALSE);
+			p += 5;
+		}
+		else if (!strncmp(p, "null", 4)) {
+			LO_cbor_put_byte(w, LO_CBOR_NULL);
+			p += 4;
+		}
+		else {
+			char* end;
+			double d = strtod(p, &end);
+			if (end == p) {
+				break;
+			}
+			if ((d >= -2147483648.0) && (d <= 2147483647.0) && (d == (double) (int32_t) d)) {
+				LO_cbor_put_int(w, (int32_t) d);
+			}
+			else {
+				LO_cbor_put_double(w, d);
+			}
+			p = end;
+		}
+	}
+	if (*p) {
+		LOTRACE_WARN("%s: invalid array, ignored from '%s'", name, p);
+	}
+	LO_cbor_put_byte(w, LO_CBOR_BREAK);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_cbor_add_name_loc(LOJsonWriter_t* w, const char* name, double lat, double lon) {
+	LO_cbor_put_str(w, name);
+	LO_cbor_put_head(w, LO_CBOR_MAJOR_ARRAY, 2);
+	LO_cbor_put_double(w, lat);
+	LO_cbor_put_double(w, lon);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_cbor_add_item(LOJsonWriter_t* w, const LiveObjectsD_Data_t* data_ptr) {
+	short i;
+	short dim;
+	const char* data_value_ptr;
+
+	if (data_ptr == NULL) {
+		LOTRACE_ERR("Invalid Arguments - data_ptr = NULL ");
+		return -1;
+	}
+	if ((data_ptr->data_name == NULL) || (data_ptr->data_value == NULL) || (data_ptr->data_dim <= 0)) {
+		LOTRACE_ERR("Invalid DataDef - name=%p value=%p dim=%d", data_ptr->data_name, data_ptr->data_value,
+				data_ptr->data_dim);
+		return -1;
+	}
+
+	LO_cbor_put_str(w, data_ptr->data_name);
+
+	dim = data_ptr->data_dim;
+	if (dim > 1) {
+		LO_cbor_put_head(w, LO_CBOR_MAJOR_ARRAY, (uint32_t) dim);
+	}
+
+	data_value_ptr = (const char*) data_ptr->data_value;
+	for (i = 0; i < dim; i++) {
+		switch (data_ptr->data_type) {
+		case LOD_TYPE_INT32:
+			LO_cbor_put_int(w, *((const int32_t*) data_value_ptr));
+			data_value_ptr += sizeof(int32_t);
+			break;
+		case LOD_TYPE_INT16:
+			LO_cbor_put_int(w, *((const int16_t*) data_value_ptr));
+			data_value_ptr += sizeof(int16_t);
+			break;
+		case LOD_TYPE_INT8:
+			LO_cbor_put_int(w, *((const int8_t*) data_value_ptr));
+			data_value_ptr += sizeof(int8_t);
+			break;
+		case LOD_TYPE_UINT32:
+			LO_cbor_put_head(w, LO_CBOR_MAJOR_UINT, *((const uint32_t*) data_value_ptr));
+			data_value_ptr += sizeof(uint32_t);
+			break;
+		case LOD_TYPE_UINT16:
+			LO_cbor_put_head(w, LO_CBOR_MAJOR_UINT, *((const uint16_t*) data_value_ptr));
+			data_value_ptr += sizeof(uint16_t);
+			break;
+		case LOD_TYPE_UINT8:
+			LO_cbor_put_head(w, LO_CBOR_MAJOR_UINT, *((const uint8_t*) data_value_ptr));
+			data_value_ptr += sizeof(uint8_t);
+			break;
+		case LOD_TYPE_FLOAT:
+			LO_cbor_put_float(w, *((const float*) data_value_ptr));
+			data_value_ptr += sizeof(float);
+			break;
+		case LOD_TYPE_DOUBLE:
+			LO_cbor_put_double(w, *((const double*) data_value_ptr));
+			data_value_ptr += sizeof(double);
+			break;
+		case LOD_TYPE_BOOL:
+			LO_cbor_put_byte(w, (*((const uint8_t*) data_value_ptr)) ? LO_CBOR_TRUE : LO_CBOR_FALSE);
+			data_value_ptr += sizeof(uint8_t);
+			break;
+		case LOD_TYPE_STRING_C:
+			/* A single string is the data value, an array of strings is an array of pointers */
+			LO_cbor_put_str(w, (dim > 1) ? *((const char* const *) data_value_ptr) : data_value_ptr);
+			data_value_ptr += sizeof(char*);
+			break;
+		default:
+			LOTRACE_ERR("failed  - unknown type %d", data_ptr->data_type);
+			return -1;
+		}
+	}
+	LOTRACE_DBG1("OK - type=%d=%s name=%s", data_ptr->data_type, LO_getDataTypeToStr(data_ptr->data_type),
+			data_ptr->data_name);
+	return 0;
+}
+
+#endif /* LOC_FEATURE_CBOR */
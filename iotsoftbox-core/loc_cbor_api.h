@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file   loc_cbor_api.h
+ * @brief  CBOR (RFC 7049) interface: same operations as the JSON writer (loc_json_api.h),
+ *         on the same writer structure, to build the same messages in binary form.
+ *
+ */
+
+#ifndef __loc_cbor_api_H_
+#define __loc_cbor_api_H_
+
+#include "liveobjects-client/LiveObjectsClient_Defs.h"
+
+#include "loc_json_api.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* Return the CBOR message (length: w->len), or NULL if the buffer was too short */
+const char* LO_cbor_result(LOJsonWriter_t* w);
+
+void LO_cbor_begin(LOJsonWriter_t* w);
+
+void LO_cbor_end(LOJsonWriter_t* w);
+
+void LO_cbor_begin_section(LOJsonWriter_t* w, const char* name);
+
+void LO_cbor_end_section(LOJsonWriter_t* w);
+
+void LO_cbor_add_section_start(LOJsonWriter_t* w, const char* section_name);
+
+void LO_cbor_add_section_end(LOJsonWriter_t* w);
+
+void LO_cbor_add_name_int(LOJsonWriter_t* w, const char* name, int32_t value);
+
+void LO_cbor_add_name_str(LOJsonWriter_t* w, const char* name, const char* value);
+
+/* The array is given in JSON format (as for LO_json_add_name_array): a list of strings
+ * and numbers, encoded as CBOR text strings and numbers */
+void LO_cbor_add_name_array(LOJsonWriter_t* w, const char* name, const char* array);
+
+/* GPS position: array of two doubles */
+void LO_cbor_add_name_loc(LOJsonWriter_t* w, const char* name, double lat, double lon);
+
+int LO_cbor_add_item(LOJsonWriter_t* w, const LiveObjectsD_Data_t* p);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __loc_cbor_api_H_ */
@@ -21,17 +21,27 @@
 
 #include "paho-mqttclient-embedded-c/MQTTClient.h"
 
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "liveobjects-client/LiveObjectsClient_Config.h"
 
+#if LOC_FEATURE_WAKEUP
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#endif
+
 #include "liveobjects-client/LiveObjectsClient_Core.h"
 #include "liveobjects-client/LiveObjectsClient_Security.h"
 #include "liveobjects-client/LiveObjectsClient_Toolbox.h"
 
 #include "netw_wrapper.h"
 
+#include "loc_core.h"
+#include "loc_journal.h"
 #include "loc_json_api.h"
 #include "loc_msg.h"
 #include "loc_wget.h"
@@ -47,7 +57,34 @@
  * -----------
  */
 
-#define LOC_MQTT_USER_NAME            "json+device"
+/* Message ring given to the encoders, for the messages built by the other threads */
+#if LOM_MQUEUE
+#define LOCC_RING(ctx)                (&(ctx)->ring)
+#else
+#define LOCC_RING(ctx)                NULL
+#endif
+
+/* No coalescing of the QoS 0 messages with the in-flight window: they are published with QoS 1 through it */
+#if LOC_MQTT_INFLIGHT
+#define LOCC_COALESCE_OFF(ctx)        ((ctx)->inflight.window)
+#else
+#define LOCC_COALESCE_OFF(ctx)        0
+#endif
+
+/* Period to check the requests of the other threads, when the wakeup is not available */
+#define LOCC_POLL_PERIOD_MS           100
+
+/* Max time to read the rest of an MQTT packet, once its first byte is received */
+#define LOCC_PACKET_TMO_MS            500
+
+/* Max time between two checks of a producer waiting for room (MQ_POLICY_BLOCK) */
+#define LOCC_MQ_WAIT_MS               10
+
+/* Size of the message ring of a queue of 'size' messages:
+ * LOM_MQUEUE_RING_SZ for LOC_MQTT_DEF_PENDING_MSG_MAX messages, and in proportion for a larger queue */
+#define LOCC_MQ_RING_SZ(size)         (((size) <= LOC_MQTT_DEF_PENDING_MSG_MAX) ? (uint32_t) LOM_MQUEUE_RING_SZ \
+		: (uint32_t) (((uint64_t) LOM_MQUEUE_RING_SZ * ((size) + 1)) / (LOC_MQTT_DEF_PENDING_MSG_MAX + 1)))
+
 
 #ifndef LOC_SERV_HOST_NAME
 #define LOC_SERV_HOST_NAME           "mqtt.liveobjects.orange-business.com"
@@ -83,6 +120,7 @@
 	}
 
 #define MTYPE_PUB_USR_MSG        0x11
+#define MTYPE_PUB_USR_BIN        0x12
 
 #define MTYPE_PUB_STATUS         0x21
 #define MTYPE_PUB_DATA           0x22
@@ -101,45 +139,191 @@
  */
 
 typedef struct {
-	uint8_t subscribed;
 	char topicName[LOC_MQTT_DEF_TOPIC_NAME_SZ];
 	messageHandler callback;
 } LOMTopicSub_t;
 
-/* --------------------------------------------------------------------------------- */
-/* Local variables
- * ---------------
+#if LOM_MQUEUE && LOM_MQUEUE_LOCKFREE
+typedef struct {
+	uint32_t seq;        /* Sequence number: position + 1 when filled, next round position when free */
+	const char* msg;
+} LOCCMqCell_t;
+#endif
+
+#if LOM_DATA_BATCH && LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
+typedef struct {
+	unsigned char* buf[2];     /* Two buffers: the samples are captured in buf[cur] while the other one is sent */
+	uint32_t size;             /* Size of one buffer (byte budget of a batch) */
+	uint32_t len;              /* Length of the PUBLISH packets in buf[cur] */
+	uint16_t nb;               /* Number of samples in buf[cur] */
+	uint16_t max_samples;      /* Max number of samples in a batch (0: batching disabled) */
+	uint32_t max_latency_ms;   /* Max time between the capture of the first sample and the flush */
+	uint8_t cur;
+	uint8_t flush;             /* Flush requested by a producer (max samples or byte budget reached) */
+	Timer deadline;            /* Flush deadline of the first sample */
+} LOCCBatch_t;
+#endif
+
+#if LOC_MQTT_INFLIGHT
+typedef struct {
+	char* pkt;                 /* Serialized PUBLISH packet, in the ring of the window (NULL: free slot) */
+	uint32_t len;              /* Length of the packet */
+	uint32_t seq;              /* Send order, for the retransmission after a reconnection */
+	uint16_t id;               /* MQTT packet id */
+#if LOC_FEATURE_JOURNAL
+	uint64_t token;            /* Record of the journal, done when acknowledged (0: none) */
+#endif
+} LOCCInflight_t;
+
+typedef struct {
+	LOCCInflight_t* slot;      /* 'window' slots */
+	uint16_t window;           /* Max number of unacknowledged messages (0: disabled, messages published with QoS 0) */
+	uint16_t nb;               /* Number of unacknowledged messages */
+	uint32_t seq;              /* Sequence number of the next message */
+	LOMRing_t ring;            /* The messages are kept until their acknowledge */
+	LiveObjectsD_CallbackPublished_t cb;
+	void* user_ctx;
+} LOCCWindow_t;
+#endif
+
+/**
+ * @brief Context of one LiveObjects Client instance (device)
+ *
+ * All the state of a device session: identity, network/TLS contexts,
+ * MQTT client and buffers, message queue and the attached sets of user data.
  */
+struct LiveObjectsClient_Ctx {
+	char dev_id[LOC_MQTT_DEF_DEV_ID_SZ];                  /*!< Device identifier */
+	char dev_name_space[LOC_MQTT_DEF_NAME_SPACE_SZ];      /*!< Name space */
 
-static char _LOClient_dev_id[LOC_MQTT_DEF_DEV_ID_SZ] = "";
-static char _LOClient_dev_name_space[LOC_MQTT_DEF_NAME_SPACE_SZ] = "";
+	unsigned long long apikey_p1;                         /*!< Api Key (first part) */
+	unsigned long long apikey_p2;                         /*!< Api Key (second part) */
 
-static unsigned long long apikey_p1 = 0;
-static unsigned long long apikey_p2 = 0;
+	LiveObjectsNetCtx_t netw;                             /*!< Network (and TLS) context */
+
+	volatile int8_t  state_run;                           /*!< State of LiveObjectsClient_RunEx() */
+	volatile uint8_t state_connected;                     /*!< Connected to the LiveObjects platform */
+#if LOC_FEATURE_EVLOOP
+	uint8_t connack_wait;                                 /*!< CONNECT sent, waiting for the CONNACK (event loop) */
+#endif
 
-static Network _LOClient_MQTTClient_network;
+#if LOC_FEATURE_WAKEUP
+	int wakeup_fd;                                        /*!< eventfd signalled when there is something to publish */
+	int space_fd;                                         /*!< eventfd signalled by the client thread when a queued message
+	                                                           is released, if producers are waiting (MQ_POLICY_BLOCK) */
+	uint32_t space_waiters;                               /*!< Number of producers waiting for room */
+	uint8_t wakeup_ok;                                    /*!< wakeup_fd and space_fd are created */
+#endif
 
-static volatile int8_t  _LOClient_state_run = 0;
-static volatile uint8_t _LOClient_state_connected = 0;
+	int8_t  cfg_first;
+	uint8_t topic_subscribed[3];                          /*!< Subscribed flags (see _LOClient_TopicSub) */
+	uint8_t allocated;                                    /*!< Created by LiveObjectsClient_CtxCreate() */
 
-static int8_t _LOClient_cfg_first;
+	MQTTClient mqtt_ctx;                                  /*!< MQTT client */
 
-static MQTTClient _LOClient_mqtt_ctx;
+	unsigned char mqtt_buffer_snd[LOC_MQTT_DEF_SND_SZ + 10];
+	unsigned char mqtt_buffer_rcv[LOC_MQTT_DEF_RCV_SZ + 10];
 
-static unsigned char _LOClient_mqtt_buffer_snd[LOC_MQTT_DEF_SND_SZ + 10];
-static unsigned char _LOClient_mqtt_buffer_rcv[LOC_MQTT_DEF_RCV_SZ + 10];
+	char msg_buf[LOM_JSON_BUF_SZ];                        /*!< JSON buffer used by the client thread when not connected
+	                                                           (otherwise built in place in mqtt_buffer_snd) */
+	const LOMEncoder_t* encoder;                          /*!< Encoder of the 'status' and 'collected data' (NULL: JSON) */
 
 #if LOM_MQUEUE
-static struct {
-	int iwrite;
-	int iread;
-	const char* msg[LOC_MQTT_DEF_PENDING_MSG_MAX];
-} _LOClient_queue;
+	struct {
+#if LOM_MQUEUE_LOCKFREE
+		/* Bounded multi-producer/single-consumer queue (Vyukov): each cell has a sequence number
+		 * telling if it is free for the producer at this position, or filled for the consumer.
+		 * Producers and consumer positions are in separate cache lines. */
+		char pad0[LOC_CACHE_LINE_SZ];
+		uint32_t ienq;                    /* Enqueue position (producers, CAS) */
+		char pad1[LOC_CACHE_LINE_SZ - sizeof(uint32_t)];
+		uint32_t ideq;                    /* Dequeue position (client thread, CAS with MQ_POLICY_DROP_OLDEST) */
+		char pad2[LOC_CACHE_LINE_SZ - sizeof(uint32_t)];
+		uint32_t count;                   /* Number of messages (reserved places) */
+		char pad3[LOC_CACHE_LINE_SZ - sizeof(uint32_t)];
+		LOCCMqCell_t* cell;               /* Cells: size rounded up to a power of 2 */
+		uint32_t mask;                    /* Number of cells - 1 */
+#else
+		uint32_t iwrite;
+		uint32_t iread;
+		uint32_t count;                   /* Number of messages */
+		const char** msg;                 /* Array of 'size' messages */
+#endif
+		uint32_t size;                    /* Max number of messages */
+		uint32_t block_ms;                /* Max time to wait for a free place (MQ_POLICY_BLOCK) */
+		uint8_t policy;                   /* LiveObjectsD_QueuePolicy_t */
+		uint8_t above_high;               /* High watermark is notified, waiting for the low watermark */
+		uint32_t wm_high;                 /* High watermark (0: disabled) */
+		uint32_t wm_low;                  /* Low watermark */
+		LiveObjectsD_CallbackQueueLevel_t wm_cb;
+		void* wm_user;
+	} queue;                                              /*!< Queue of messages built by other threads */
+
+	LOMRing_t ring;                                       /*!< Messages of the queue, built in place (sized with the queue) */
 #endif /* LOM_MQUEUE */
 
+#if LOC_MQTT_INFLIGHT
+	LOCCWindow_t inflight;                                /*!< QoS 1 messages waiting for their PUBACK */
+#endif
+
+#if LOC_FEATURE_JOURNAL
+	LOJournal_t* journal;                                 /*!< Messages published while disconnected (NULL: not used) */
+	uint32_t journal_rate;                                /*!< Max replayed messages per second (0: no pacing) */
+	Timer journal_timer;                                  /*!< Next replay slice */
+	uint64_t journal_token;                               /*!< Record of the journal being published (see LOCC_inflightPublish) */
+#endif
+
+	LiveObjectsD_ReconnectPolicy_t reconnect;             /*!< Delays between the connection attempts */
+	LiveObjectsD_ReconnectInfo_t reconnect_info;          /*!< Error of the last attempt, delay before the next one */
+	Timer reconnect_stable;                               /*!< Expired when the current session is stable */
+	uint32_t reconnect_rnd;                               /*!< State of the jitter generator (xorshift32, 0: not seeded) */
+
+#if LOC_FEATURE_LO_STATUS  && (LOC_MAX_OF_DATA_SET > 0)
+	LOMSetOfStatus_t           set_status[LOC_MAX_OF_STATUS_SET];
+#endif
+#if LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
+	LOMSetOfData_t             set_data[LOC_MAX_OF_DATA_SET];
+#if LOM_DATA_BATCH
+	LOCCBatch_t                batch[LOC_MAX_OF_DATA_SET];   /*!< Batching of the 'collected data' */
+#endif
+#endif
+#if LOC_FEATURE_LO_PARAMS
+	LOMSetOfParams_t           set_params;
+	LOMSetofUpdatedParams_t    set_updated_params;
+#endif
+#if LOC_FEATURE_LO_COMMANDS
+	LOMSetofCommands_t         set_cmd;
+#endif
+#if LOC_FEATURE_LO_RESOURCES
+	LOMSetOfResources_t        set_rsc;
+	LOMSetOfUpdatedResource_t  set_updated_rsc;
+#endif
+};
+
+/* Get the client context from the MQTT client given in a received message */
+#define LOCC_CTX_OF_MSG(msg)          LOCC_CTX_OF_CLIENT((msg)->client)
+
+#define LOCC_CTX_OF_CLIENT(c) \
+	((LiveObjectsClient_Ctx*) ((char*) (c) - offsetof(LiveObjectsClient_Ctx, mqtt_ctx)))
+
+/* --------------------------------------------------------------------------------- */
+/* Local variables
+ * ---------------
+ */
+
+/* Default instance, used by the LiveObjectsClient_xxx() functions (without context) */
+static LiveObjectsClient_Ctx _LOClient_ctx;
+
+static uint8_t _LOClient_sys_init_done = 0;
+
+#if LOC_FEATURE_LO_RESOURCES
+/* Only one resource download (HTTP GET) at a time : instance using the wget module */
+static LiveObjectsClient_Ctx* _LOClient_wget_owner = NULL;
+#endif
+
 #if SECURITY_ENABLED
 
-static LiveObjectsSecurityParams_t _LOClient_params_security = {
+static const LiveObjectsSecurityParams_t _LOClient_params_security = {
 		{ 0, SERVER_CERT },
 		{ 0, CLIENT_CERT },
 		{ 0, CLIENT_PKEY },
@@ -149,7 +333,7 @@ static LiveObjectsSecurityParams_t _LOClient_params_security = {
 
 #endif
 
-static LiveObjectsNetConnectParams_t _LOClient_params_connect = {
+static const LiveObjectsNetConnectParams_t _LOClient_params_connect = {
 		LOC_SERV_IP_ADDRESS,
 		LOC_SERV_PORT,
 		LOC_SERV_TIMEOUT
@@ -180,31 +364,17 @@ static void LOCC_ntfDevRscUpd(MessageData* msg);
 #define TOPIC_COMMAND  1
 #define TOPIC_RSC_UPD  2
 
-LOMTopicSub_t _LOClient_TopicSub[3] = {
-		{ 0, "dev/cfg/upd", LOCC_NTFDEVCFGUDP },
-		{ 0, "dev/cmd", LOCC_NTFDEVCMD },
-		{ 0, "dev/rsc/upd", LOCC_NTFDEVRSCUDP }
+static const LOMTopicSub_t _LOClient_TopicSub[3] = {
+		{ "dev/cfg/upd", LOCC_NTFDEVCFGUDP },
+		{ "dev/cmd", LOCC_NTFDEVCMD },
+		{ "dev/rsc/upd", LOCC_NTFDEVRSCUDP }
 };
 
-#if LOC_FEATURE_LO_STATUS  && (LOC_MAX_OF_DATA_SET > 0)
-static LOMSetOfStatus_t          _LOClient_Set_Status[LOC_MAX_OF_STATUS_SET];
-#endif
-#if LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
-static LOMSetOfData_t             _LOClient_Set_Data[LOC_MAX_OF_DATA_SET];
-#endif
-#if LOC_FEATURE_LO_PARAMS
-static LOMSetOfParams_t           _LOClient_Set_Params;
-static LOMSetofUpdatedParams_t    _LOClient_Set_UpdatedParams;
-#endif
-#if LOC_FEATURE_LO_COMMANDS
-static LOMSetofCommands_t         _LOClient_Set_Cmd;
-#endif
-#if LOC_FEATURE_LO_RESOURCES
-static LOMSetOfResources_t        _LOClient_Set_Rsc;
-static LOMSetOfUpdatedResource_t  _LOClient_Set_UpdatedRsc;
-#endif
+static char* LOCC_MqttPublishBegin(LiveObjectsClient_Ctx* ctx, enum QoS qos, const char* topic_name,
+		uint32_t* len);
 
-static int LOCC_MqttPublish(enum QoS qos, const char* topic_name, const char* payload_data);
+static int LOCC_MqttPublishEndBin(LiveObjectsClient_Ctx* ctx, enum QoS qos, const char* topic_name,
+		const char* payload_data, uint32_t payload_len);
 
 #if LOC_MQTT_DUMP_MSG
 
@@ -215,9 +385,9 @@ static uint16_t _LOClient_dump_mqtt_publish = 0;
  * -----------------
  */
 
-static int apikeyconv(char * apikey, int size) {
+static int apikeyconv(const LiveObjectsClient_Ctx* ctx, char * apikey, int size) {
 	if (size == APIKEY_LENGTH) {
-		snprintf(apikey, size, "%016llx%016llx", apikey_p1, apikey_p2);
+		snprintf(apikey, size, "%016llx%016llx", ctx->apikey_p1, ctx->apikey_p2);
 		return 0;
 	}
 	return -1;
@@ -305,761 +475,2484 @@ void LOCC_mqtt_dump_msg(const unsigned char* p_buf) {
 #endif /* LOC_MQTT_DUMP_MSG */
 
 /* ================================================================================= */
-/* Messages Queue
+/* Wakeup of the client loop
+ * Signalled by the other threads when there is something to publish,
+ * so that the client loop waits for network data without periodic polling.
  */
 /* --------------------------------------------------------------------------------- */
 /*  */
-static int LOCC_mqInit(void) {
-#if LOM_MQUEUE
-	memset(&_LOClient_queue, 0, sizeof(_LOClient_queue));
-#endif /* LOM_MQUEUE */
-	return 0;
+static void LOCC_wakeupInit(LiveObjectsClient_Ctx* ctx) {
+#if LOC_FEATURE_WAKEUP
+	if (!ctx->wakeup_ok) {
+		ctx->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (ctx->wakeup_fd < 0) {
+			LOTRACE_WARN("eventfd failed, errno=%d => polling mode", errno);
+			return;
+		}
+		ctx->space_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (ctx->space_fd < 0) {
+			LOTRACE_WARN("eventfd failed, errno=%d => polling mode", errno);
+			close(ctx->wakeup_fd);
+			ctx->wakeup_fd = -1;
+			return;
+		}
+		ctx->space_waiters = 0;
+		ctx->wakeup_ok = 1;
+	}
+#else
+	(void)ctx;
+#endif
 }
 
-#if LOM_MQUEUE
 /* --------------------------------------------------------------------------------- */
 /*  */
-static int LOCC_mqPut(const char* p_msg) {
-	int ret = -1;
-	/* lock */
-	if (MQ_MUTEX_LOCK()) {
-		LOTRACE_WARN("Error to lock mutex");
-		return ret;
-	}
-	if (_LOClient_queue.msg[_LOClient_queue.iwrite] == NULL) {
-		_LOClient_queue.msg[_LOClient_queue.iwrite] = p_msg;
-		if (++_LOClient_queue.iwrite == LOC_MQTT_DEF_PENDING_MSG_MAX)
-			_LOClient_queue.iwrite = 0;
-		ret = 0;
+static void LOCC_wakeupClose(LiveObjectsClient_Ctx* ctx) {
+#if LOC_FEATURE_WAKEUP
+	if (ctx->wakeup_ok) {
+		close(ctx->wakeup_fd);
+		close(ctx->space_fd);
+		ctx->wakeup_fd = -1;
+		ctx->space_fd = -1;
+		ctx->wakeup_ok = 0;
 	}
-	else {
-		/*TODO: queue overflow -> release the oldest message ? */
-		;
-	}
-	/* unlock */
-	MQ_MUTEX_UNLOCK();
-	return ret;
+#else
+	(void)ctx;
+#endif
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-static const char* LOCC_mqGet() {
-	const char* p_msg = NULL;
-	/* lock */
-	if (MQ_MUTEX_LOCK()) {
-		LOTRACE_WARN("Error to lock mutex");
-		return p_msg;
-	}
-	if (_LOClient_queue.iread != _LOClient_queue.iwrite) {
-		p_msg = _LOClient_queue.msg[_LOClient_queue.iread];
-		_LOClient_queue.msg[_LOClient_queue.iread] = NULL;
-		if (++_LOClient_queue.iread == LOC_MQTT_DEF_PENDING_MSG_MAX) {
-			_LOClient_queue.iread = 0;
+static void LOCC_wakeup(LiveObjectsClient_Ctx* ctx) {
+#if LOC_FEATURE_WAKEUP
+	if (ctx->wakeup_ok) {
+		uint64_t one = 1;
+		/* EAGAIN: counter is saturated, so the loop is already woken up */
+		if ((write(ctx->wakeup_fd, &one, sizeof(one)) < 0) && (errno != EAGAIN)) {
+			LOTRACE_WARN("write eventfd failed, errno=%d", errno);
 		}
-
 	}
-	/* unlock */
-	MQ_MUTEX_UNLOCK();
-	return p_msg;
+#else
+	(void)ctx;
+#endif
 }
 
+#if LOC_FEATURE_WAKEUP
 /* --------------------------------------------------------------------------------- */
 /*  */
-static void LOCC_mqPurge(void) {
-	if (MQ_MUTEX_LOCK()) {
-		LOTRACE_ERR("Error to lock mutex");
-		return;
-	}
-	while (_LOClient_queue.iread != _LOClient_queue.iwrite) {
-		const char* p_msg = _LOClient_queue.msg[_LOClient_queue.iread];
-		if (p_msg) {
-			LOTRACE_DBG1("MEM_FREE msg[%d]=%p x%x", _LOClient_queue.iread, p_msg, *p_msg);
-			MEM_FREE(p_msg);
-		}
-		else {
-			LOTRACE_ERR("msg[%d]=NULL !!", _LOClient_queue.iread);
-		}
-		_LOClient_queue.msg[_LOClient_queue.iread] = NULL;
-		if (++_LOClient_queue.iread == LOC_MQTT_DEF_PENDING_MSG_MAX) {
-			_LOClient_queue.iread = 0;
-		}
+static void LOCC_wakeupDrain(LiveObjectsClient_Ctx* ctx) {
+	uint64_t cnt;
+	if ((ctx->wakeup_ok) && (read(ctx->wakeup_fd, &cnt, sizeof(cnt)) < 0) && (errno != EAGAIN)) {
+		LOTRACE_WARN("read eventfd failed, errno=%d", errno);
 	}
-	_LOClient_queue.iread = _LOClient_queue.iwrite = 0;
-	memset(_LOClient_queue.msg, 0, sizeof(_LOClient_queue.msg));
-	MQ_MUTEX_UNLOCK();
 }
-#endif /* LOM_MQUEUE */
+#endif
 
 /* ================================================================================= */
-/* Callback functions called by MQTT (linked to subscribed topics)
+/* Messages Queue
  */
-/* --------------------------------------------------------------------------------- */
-/*  */
-#if LOC_FEATURE_LO_PARAMS
-static void LOCC_ntfDevCfgUpd(MessageData* msg) {
-	int ret;
-	LOTRACE_INF("topicName='%s' '%.*s'", (msg->topicName->cstring) ? msg->topicName->cstring : "" , msg->topicName->lenstring.len,
-			msg->topicName->lenstring.data);
-	LOTRACE_INF("msg: id=%d qos=%d '%.*s'", msg->message->id, msg->message->qos, msg->message->payloadlen,
-			(const char*) msg->message->payload);
+#if LOM_MQUEUE
+static int LOCC_ringFull(LOMRing_t* ring, uint32_t len, void* user);
 
-	ret = LO_msg_decode_params_req((const char*) msg->message->payload, msg->message->payloadlen, &_LOClient_Set_Params,
-			&_LOClient_Set_UpdatedParams);
-	if (ret) {
-		LOTRACE_ERR("failed, rc= %d", ret);
-	}
-}
+/* --------------------------------------------------------------------------------- */
+/* A producer starts to wait for room: from now on, the client thread signals the released messages */
+static void LOCC_mqWaitBegin(LiveObjectsClient_Ctx* ctx) {
+#if LOC_FEATURE_WAKEUP
+	__atomic_add_fetch(&ctx->space_waiters, 1, __ATOMIC_SEQ_CST);
+#else
+	(void)ctx;
 #endif
+}
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-#if LOC_FEATURE_LO_RESOURCES
-static void LOCC_ntfDevRscUpd(MessageData* msg) {
-	LiveObjectsD_ResourceRespCode_t rsc_result;
-	const char* pMsg;
-	int32_t cid = 0;
-	LOTRACE_INF("topicName='%s' '%.*s'", msg->topicName->cstring, msg->topicName->lenstring.len,
-			msg->topicName->lenstring.data);
-	LOTRACE_INF("msg: id=%d qos=%d '%.*s'", msg->message->id, msg->message->qos, msg->message->payloadlen,
-			(const char*) msg->message->payload);
+static void LOCC_mqWaitEnd(LiveObjectsClient_Ctx* ctx) {
+#if LOC_FEATURE_WAKEUP
+	__atomic_sub_fetch(&ctx->space_waiters, 1, __ATOMIC_SEQ_CST);
+#else
+	(void)ctx;
+#endif
+}
 
-	rsc_result = LO_msg_decode_rsc_req((const char*) msg->message->payload, msg->message->payloadlen, &_LOClient_Set_Rsc,
-			&_LOClient_Set_UpdatedRsc, &cid);
-	if (cid == 0) {
-		LOTRACE_ERR("failed, NO CID !!  ret=%d", rsc_result);
+/* --------------------------------------------------------------------------------- */
+/* Wait (between LOCC_mqWaitBegin and LOCC_mqWaitEnd) until the client thread releases a message,
+ * or until the deadline. The caller checks again for room: an other producer may have taken the signal,
+ * so that the wait is also limited to LOCC_MQ_WAIT_MS. */
+static void LOCC_mqWait(LiveObjectsClient_Ctx* ctx, Timer* deadline) {
+	int tmo = TimerLeftMS(deadline);
+	if (tmo <= 0) {
 		return;
 	}
-
-	pMsg = LO_msg_encode_rsc_result(cid, rsc_result);
-	if (pMsg) {
-		LOTRACE_DBG1("Publish rsc response, cid=%"PRIi32" with ret=%d ...", cid, rsc_result);
-		LOCC_MqttPublish(QOS0, "dev/rsc/upd/res", pMsg);
+	if (tmo > LOCC_MQ_WAIT_MS) {
+		tmo = LOCC_MQ_WAIT_MS;
 	}
-	else {
-		LOTRACE_PRINTF("ERROR to build rsc response, cid=%"PRIi32" with ret=%d", cid, rsc_result);
+#if LOC_FEATURE_WAKEUP
+	if (ctx->wakeup_ok) {
+		struct pollfd fds;
+		uint64_t cnt;
+		fds.fd = ctx->space_fd;
+		fds.events = POLLIN;
+		fds.revents = 0;
+		if ((poll(&fds, 1, tmo) > 0) && (read(ctx->space_fd, &cnt, sizeof(cnt)) < 0) && (errno != EAGAIN)) {
+			LOTRACE_WARN("read eventfd failed, errno=%d", errno);
+		}
+		return;
 	}
-}
+#else
+	(void)ctx;
 #endif
+	WAIT_MS(tmo);
+}
 
 /* --------------------------------------------------------------------------------- */
-/*  */
-#if LOC_FEATURE_LO_COMMANDS
-static void LOCC_ntfDevCmd(MessageData* msg) {
-	int ret;
-	int32_t cid = 0;
-	LOTRACE_INF("topicName='%s' '%.*s'", msg->topicName->cstring, msg->topicName->lenstring.len,
-			msg->topicName->lenstring.data);
-	LOTRACE_INF("msg: id=%d qos=%d '%.*s'", msg->message->id, msg->message->qos, msg->message->payloadlen,
-			(const char*) msg->message->payload);
-
-	ret = LO_msg_decode_cmd_req((const char*) msg->message->payload, msg->message->payloadlen, &_LOClient_Set_Cmd,
-			&cid);
-	if (ret < 0) {
-		LOTRACE_ERR("failed, rc= %d, cid=%"PRIi32, ret, cid);
-	}
-
-	if ((cid) &&(ret)) {
-		const char* pMsg;
-		/* send immediately a command response */
-		LOTRACE_INF("Send command response cid=%"PRIi32" ret= %d", cid, ret);
-		pMsg = LO_msg_encode_cmd_result(cid, ret);
-		if (pMsg) {
-			LOCC_MqttPublish(QOS0, "dev/cmd/res", pMsg);
+/* Called by the client thread when it has released queued messages: wake up the waiting producers */
+static void LOCC_mqSignal(LiveObjectsClient_Ctx* ctx) {
+#if LOC_FEATURE_WAKEUP
+	/* The release of the messages is ordered before the read of space_waiters */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if ((ctx->wakeup_ok) && (__atomic_load_n(&ctx->space_waiters, __ATOMIC_RELAXED))) {
+		uint64_t one = 1;
+		if ((write(ctx->space_fd, &one, sizeof(one)) < 0) && (errno != EAGAIN)) {
+			LOTRACE_WARN("write eventfd failed, errno=%d", errno);
 		}
 	}
-	else {
-		LOTRACE_NOTICE("!! DELAYED CMD RESPONSE (ret=%d) - cid=%"PRIi32, ret, cid);
-	}
-}
+#else
+	(void)ctx;
 #endif
-
-/* ================================================================================= */
-
-/* --------------------------------------------------------------------------------- */
-/*  */
-#if SECURITY_ENABLED
-static int LOCC_EnableTLS(void) {
-	int rc;
-	rc = netw_setSecurity(&_LOClient_MQTTClient_network, &_LOClient_params_security);
-	return rc;
 }
-#endif
 
 /* --------------------------------------------------------------------------------- */
-/*  */
-static int LOCC_MqttConnect() {
-	int ret;
-	char mqtt_client_id[14+LOC_MQTT_DEF_NAME_SPACE_SZ+LOC_MQTT_DEF_DEV_ID_SZ+2];
-
-	MQTTPacket_connectData connectData = MQTTPacket_connectData_initializer;
-
-
-	ret = snprintf(mqtt_client_id, sizeof(mqtt_client_id), "urn:lo:nsid:%s:%s", _LOClient_dev_name_space,
-			_LOClient_dev_id);
-	mqtt_client_id[sizeof(mqtt_client_id)-1] = 0;
-
-	LOTRACE_DBG1("MQTT Connecting (%s) ...", mqtt_client_id);
-
-	connectData.MQTTVersion = (unsigned char) (4);
-	connectData.clientID.cstring = mqtt_client_id;
-	connectData.username.cstring = LOC_MQTT_USER_NAME;
-	char password[APIKEY_LENGTH];
-	ret = apikeyconv(password, APIKEY_LENGTH);
-	if (ret == 0) {
-		connectData.password.cstring = password;
-	} else {
-		LOTRACE_ERR("Apikeyconv failed, ret= %d", ret);
+/* Allocate the storage of the queue for 'size' messages, and its message ring.
+ * The queue must be empty. */
+static int LOCC_mqAlloc(LiveObjectsClient_Ctx* ctx, uint32_t size) {
+	uint32_t ring_sz = LOCC_MQ_RING_SZ(size);
+	char* ring_buf;
+#if LOM_MQUEUE_LOCKFREE
+	LOCCMqCell_t* cell;
+	uint32_t ring = 2;
+	while (ring < size) {
+		ring <<= 1;
 	}
-
-#if 0
-	connectData.will.topicName.cstring = ...;
-	connectData.will.message.cstring = ...;
-	connectData.will.qos = ...;
-	connectData.will.retained = ...;
-#endif
-
-	connectData.keepAliveInterval = LOC_MQTT_API_KEEPALIVEINTERVAL_SEC;
-
-	ret = MQTTConnect(&_LOClient_mqtt_ctx, &connectData);
-	if (ret) {
-		LOTRACE_ERR("MQTTConnect failed, rc= %d", ret);
-		LOTRACE_ERR("You might need to check your APIKEY\n");
-		netw_disconnect(&_LOClient_MQTTClient_network, 1);
+	cell = (LOCCMqCell_t*) MEM_ALLOC(ring * sizeof(LOCCMqCell_t));
+	ring_buf = (cell) ? (char*) MEM_ALLOC(ring_sz) : NULL;
+	if (ring_buf == NULL) {
+		LOTRACE_ERR("MEM_ALLOC ERROR (%"PRIu32" messages, ring %"PRIu32" bytes)", size, ring_sz);
+		if (cell) {
+			MEM_FREE(cell);
+		}
 		return -1;
 	}
-	LOTRACE_INF("MQTT Connected : OK %d", ret);
-	_LOClient_state_connected = 1;
+	if (ctx->queue.cell) {
+		MEM_FREE(ctx->queue.cell);
+	}
+	ctx->queue.cell = cell;
+	ctx->queue.mask = ring - 1;
+#else
+	const char** msg = (const char**) MEM_ALLOC(size * sizeof(const char*));
+	ring_buf = (msg) ? (char*) MEM_ALLOC(ring_sz) : NULL;
+	if (ring_buf == NULL) {
+		LOTRACE_ERR("MEM_ALLOC ERROR (%"PRIu32" messages, ring %"PRIu32" bytes)", size, ring_sz);
+		if (msg) {
+			MEM_FREE(msg);
+		}
+		return -1;
+	}
+	if (ctx->queue.msg) {
+		MEM_FREE(ctx->queue.msg);
+	}
+	ctx->queue.msg = msg;
+#endif
+	if (ctx->ring.buf) {
+		MEM_FREE(ctx->ring.buf);
+	}
+	LO_msg_ring_init(&ctx->ring, ring_buf, ring_sz);
+	ctx->ring.full = LOCC_ringFull;
+	ctx->ring.full_user = ctx;
+	ctx->queue.size = size;
 	return 0;
 }
 
 /* --------------------------------------------------------------------------------- */
-/*  */
-static int LOCC_MqttPublish(enum QoS qos, const char* topic_name, const char* payload_data) {
-	int rc;
-	MQTTMessage mqtt_msg;
-
-	mqtt_msg.qos = qos;
-	mqtt_msg.retained = 0;
-	mqtt_msg.dup = 0;
-	mqtt_msg.id = 0;
-	mqtt_msg.payload = (void*) payload_data;
-	mqtt_msg.payloadlen = strlen(payload_data);
-
-	LOTRACE_DBG1("MQTTPublish len=%d ....", mqtt_msg.payloadlen);
-	rc = MQTTPublish(&_LOClient_mqtt_ctx, topic_name, &mqtt_msg);
-	if (rc) {
-		LOTRACE_ERR("MQTTPublish failed, rc=%d", rc);
+/* Reset the positions of an empty queue */
+static void LOCC_mqReset(LiveObjectsClient_Ctx* ctx) {
+#if LOM_MQUEUE_LOCKFREE
+	uint32_t i;
+	for (i = 0; i <= ctx->queue.mask; i++) {
+		ctx->queue.cell[i].seq = i;
+		ctx->queue.cell[i].msg = NULL;
 	}
+	ctx->queue.ienq = ctx->queue.ideq = 0;
+#else
+	memset(ctx->queue.msg, 0, ctx->queue.size * sizeof(const char*));
+	ctx->queue.iwrite = ctx->queue.iread = 0;
+#endif
+	ctx->queue.count = 0;
+	ctx->queue.above_high = 0;
+}
 
-#if (LOC_MQTT_DUMP_MSG & 0x01)
-	if (_LOClient_dump_mqtt_publish & 0x04) {
-		mqtt_dump_msg(_LOClient_mqtt_buffer_snd);
+/* --------------------------------------------------------------------------------- */
+/* Notify the user when the high watermark is reached (put=1), and then the low watermark (put=0).
+ * put=2: a new message is refused because the message ring is full, notified as the high watermark. */
+static void LOCC_mqLevel(LiveObjectsClient_Ctx* ctx, uint32_t count, uint8_t put) {
+	uint8_t high;
+	if ((ctx->queue.wm_cb == NULL) || (ctx->queue.wm_high == 0)) {
+		return;
+	}
+	if (put) {
+		if ((count < ctx->queue.wm_high) && (put == 1)) {
+			return;
+		}
+		high = 1;
+	}
+	else {
+		if (count > ctx->queue.wm_low) {
+			return;
+		}
+		high = 0;
+	}
+	/* Only on a state change */
+#if LOM_MQUEUE_LOCKFREE
+	if (__atomic_exchange_n(&ctx->queue.above_high, high, __ATOMIC_ACQ_REL) == high) {
+		return;
+	}
+#else
+	if (MQ_MUTEX_LOCK()) {
+		return;
+	}
+	if (ctx->queue.above_high == high) {
+		MQ_MUTEX_UNLOCK();
+		return;
 	}
+	ctx->queue.above_high = high;
+	MQ_MUTEX_UNLOCK();
 #endif
-
-	return rc;
+	LOTRACE_INF("%s watermark, %"PRIu32" messages in queue", high ? "HIGH" : "LOW", count);
+	ctx->queue.wm_cb(high, count, ctx->queue.wm_user);
 }
+#endif /* LOM_MQUEUE */
 
+#if LOM_MQUEUE && LOM_MQUEUE_LOCKFREE
 /* --------------------------------------------------------------------------------- */
-/*  */
-static int LOCC_SubscibeTopic(int i) {
-	int rc;
-	if ((i >= 0) && (i < 3)) {
-		if (_LOClient_TopicSub[i].subscribed) {
-			LOTRACE_WARN("Subscribe[%d] %s already done", i, _LOClient_TopicSub[i].topicName);
-			return 0;
-		}
-		if (_LOClient_TopicSub[i].callback == NULL) {
-			LOTRACE_WARN("Subscribe[%d] %s  - NO CALLBACK FUNCTION !!", i, _LOClient_TopicSub[i].topicName);
-			return 0;
-		}
-		LOTRACE_NOTICE("Subscribe[%d] '%s' , granted_qos=%d .... ", i, _LOClient_TopicSub[i].topicName, QOS0);
-		rc = MQTTSubscribe(&_LOClient_mqtt_ctx, _LOClient_TopicSub[i].topicName, QOS0, _LOClient_TopicSub[i].callback);
-		if ((rc < 0) || (rc == 0x80)) {
-			LOTRACE_ERR("Subscribe[%d] %s failed, rc=%d", i, _LOClient_TopicSub[i].topicName, rc);
-		}
-		else {
-			LOTRACE_NOTICE("Subscribe[%d] %s, qos=%d (granted_qos=%d)", i, _LOClient_TopicSub[i].topicName, rc, QOS0);
-			_LOClient_TopicSub[i].subscribed = 1;
+/* Called by any thread (and by the producers with the MQ_POLICY_DROP_OLDEST policy).
+ * Wait-free when only the client thread dequeues. */
+static const char* LOCC_mqGet(LiveObjectsClient_Ctx* ctx) {
+	LOCCMqCell_t* cell;
+	const char* p_msg;
+	uint32_t pos;
+
+	if (ctx->queue.policy == MQ_POLICY_DROP_OLDEST) {
+		/* Producers can also dequeue (to drop the oldest message): take the position with a CAS */
+		pos = __atomic_load_n(&ctx->queue.ideq, __ATOMIC_RELAXED);
+		for (;;) {
+			int32_t dif;
+			cell = &ctx->queue.cell[pos & ctx->queue.mask];
+			dif = (int32_t) (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+			if (dif == 0) {
+				if (__atomic_compare_exchange_n(&ctx->queue.ideq, &pos, pos + 1, 1,
+						__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+					break;
+				}
+			}
+			else if (dif < 0) {
+				return NULL;
+			}
+			else {
+				pos = __atomic_load_n(&ctx->queue.ideq, __ATOMIC_RELAXED);
+			}
 		}
 	}
 	else {
-		LOTRACE_WARN("Subscribe[%d]: ERROR, bad number [0,2]", i);
+		pos = ctx->queue.ideq;
+		cell = &ctx->queue.cell[pos & ctx->queue.mask];
+		if (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+			/* Empty, or the producer of this position has not yet finished */
+			return NULL;
+		}
+		ctx->queue.ideq = pos + 1;
 	}
-	return 0;
+	p_msg = cell->msg;
+	cell->msg = NULL;
+	/* Release the cell for the producers of the next round */
+	__atomic_store_n(&cell->seq, pos + ctx->queue.mask + 1, __ATOMIC_RELEASE);
+
+	LOCC_mqLevel(ctx, __atomic_sub_fetch(&ctx->queue.count, 1, __ATOMIC_ACQ_REL), 0);
+	return p_msg;
 }
 
 /* --------------------------------------------------------------------------------- */
-/*  */
-static int LOCC_UnsubscibeTopic(int i) {
-	int rc;
-	if ((i >= 0) && (i < 3)) {
-		if (!_LOClient_TopicSub[i].subscribed) {
-			LOTRACE_WARN("Unsubscribe[%d] %s already done", i, _LOClient_TopicSub[i].topicName);
+/* Called by any thread. Lock-free: an atomic counter to reserve a place, then a CAS on the
+ * enqueue position. */
+static int LOCC_mqPut(LiveObjectsClient_Ctx* ctx, const char* p_msg) {
+	LOCCMqCell_t* cell;
+	Timer deadline;
+	uint8_t waiting = 0;
+	uint32_t pos;
+	uint32_t n;
+
+	/* Reserve a place */
+	while ((n = __atomic_fetch_add(&ctx->queue.count, 1, __ATOMIC_ACQ_REL)) >= ctx->queue.size) {
+		__atomic_fetch_sub(&ctx->queue.count, 1, __ATOMIC_ACQ_REL);
+
+		if (ctx->queue.policy == MQ_POLICY_DROP_NEWEST) {
+			LOTRACE_WARN("Queue full - drop the new msg %p x%x", p_msg, *p_msg);
+			LO_msg_free(p_msg);
 			return 0;
 		}
-		LOTRACE_NOTICE("Unsubscribe[%d] %s .... ", i, _LOClient_TopicSub[i].topicName);
-		rc = MQTTUnsubscribe(&_LOClient_mqtt_ctx, _LOClient_TopicSub[i].topicName);
-		if (rc == 0) {
-			LOTRACE_NOTICE("Unsubscribe[%d] %s", i, _LOClient_TopicSub[i].topicName);
-			_LOClient_TopicSub[i].subscribed = 0;
+		if (ctx->queue.policy == MQ_POLICY_DROP_OLDEST) {
+			const char* p_old = LOCC_mqGet(ctx);
+			if (p_old) {
+				LOTRACE_WARN("Queue full - drop the oldest msg %p x%x", p_old, *p_old);
+				LO_msg_free(p_old);
+			}
+			continue;
 		}
-		else {
-			LOTRACE_ERR("Unsubscribe[%d] %s failed, rc=%d", i, _LOClient_TopicSub[i].topicName, rc);
+		if ((ctx->queue.policy != MQ_POLICY_BLOCK) || (LO_sys_threadIsLiveObjectsClient())
+				|| ((waiting) && (TimerIsExpired(&deadline)))) {
+			/* MQ_POLICY_REJECT, or timeout. The client thread never waits for itself. */
+			if (waiting) {
+				LOCC_mqWaitEnd(ctx);
+			}
+			return -1;
 		}
+		if (!waiting) {
+			/* Check again once the client thread knows that a producer is waiting */
+			TimerInit(&deadline);
+			TimerCountdownMS(&deadline, ctx->queue.block_ms);
+			LOCC_mqWaitBegin(ctx);
+			waiting = 1;
+			continue;
+		}
+		LOCC_mqWait(ctx, &deadline);
 	}
-	else {
-		LOTRACE_WARN("Unsubscribe[%d]: ERROR, bad number [0,2]", i);
+	if (waiting) {
+		LOCC_mqWaitEnd(ctx);
 	}
-	return 0;
-}
 
-/* --------------------------------------------------------------------------------- */
-/*  */
-#if LOC_FEATURE_LO_STATUS  && (LOC_MAX_OF_DATA_SET > 0)
-static int LOCC_processStatus(uint8_t force) {
-	int rc = 0;
-	int status_hdl;
-	for (status_hdl = 0; status_hdl < LOC_MAX_OF_STATUS_SET; status_hdl++) {
-		LOMSetOfStatus_t* p_satusSet = &_LOClient_Set_Status[status_hdl];
-		if ((p_satusSet->data_set.data_ptr) && (p_satusSet->data_set.data_nb)
-				&& ((force)
-#if LOM_PUSH_FLAG
-						|| (p_satusSet->pushtoLOServer)
-#endif
-						)) {
-			const char* pMsg;
-#if LOM_PUSH_FLAG
-			LOTRACE_INF("force=%d  push=%d => PUBLISH STATUS ...", force,
-					p_satusSet->pushtoLOServer);
-			p_satusSet->pushtoLOServer = 1;
-#else
-			LOTRACE_INF("force=%d  => PUBLISH STATUS ...", force);
-#endif
-			pMsg = LO_msg_encode_status(0, &p_satusSet->data_set);
-			if (pMsg) {
-				rc = LOCC_MqttPublish(QOS0, "dev/info", pMsg);
-				if (rc == 0) {
-#if LOM_PUSH_FLAG
-					p_satusSet->pushtoLOServer = 0;
-#endif
-				}
+	/* Take a position. The place is reserved, so the cell is free
+	 * (or just being released by the consumer) */
+	pos = __atomic_load_n(&ctx->queue.ienq, __ATOMIC_RELAXED);
+	for (;;) {
+		int32_t dif;
+		cell = &ctx->queue.cell[pos & ctx->queue.mask];
+		dif = (int32_t) (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos);
+		if (dif == 0) {
+			if (__atomic_compare_exchange_n(&ctx->queue.ienq, &pos, pos + 1, 1,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
 			}
+			/* pos is updated by the failed CAS */
+		}
+		else {
+			pos = __atomic_load_n(&ctx->queue.ienq, __ATOMIC_RELAXED);
 		}
 	}
-	return rc;
+	cell->msg = p_msg;
+	/* Publish the message to the consumer */
+	__atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+
+	LOCC_wakeup(ctx);
+	LOCC_mqLevel(ctx, n + 1, 1);
+	return 0;
 }
-#endif
 
+#elif LOM_MQUEUE
 /* --------------------------------------------------------------------------------- */
 /*  */
-#if LOC_FEATURE_LO_RESOURCES
-
-static int LOCC_processResources(uint8_t force) {
-	int rc = 0;
-	if ((_LOClient_Set_Rsc.rsc_ptr) &&
-			((force) || (_LOClient_Set_Rsc.pushtoLOServer))) {
-		const char* pMsg;
-		LOTRACE_INF("force=%d  push=%d => PUBLISH RESOURCES ...", force,
-				_LOClient_Set_Rsc.pushtoLOServer);
-		_LOClient_Set_Rsc.pushtoLOServer = 1;
-		pMsg = LO_msg_encode_resources(0, &_LOClient_Set_Rsc);
-		if (pMsg) {
-			rc = LOCC_MqttPublish(QOS0, "dev/rsc", pMsg);
-			if (rc == 0) {
-				_LOClient_Set_Rsc.pushtoLOServer = 0;
-			}
+static const char* LOCC_mqGet(LiveObjectsClient_Ctx* ctx) {
+	const char* p_msg = NULL;
+	uint32_t count = 0;
+	/* lock */
+	if (MQ_MUTEX_LOCK()) {
+		LOTRACE_WARN("Error to lock mutex");
+		return p_msg;
+	}
+	if (ctx->queue.count) {
+		p_msg = ctx->queue.msg[ctx->queue.iread];
+		ctx->queue.msg[ctx->queue.iread] = NULL;
+		if (++ctx->queue.iread == ctx->queue.size) {
+			ctx->queue.iread = 0;
 		}
+		count = --ctx->queue.count;
 	}
-	return rc;
+	/* unlock */
+	MQ_MUTEX_UNLOCK();
+	if (p_msg) {
+		LOCC_mqLevel(ctx, count, 0);
+	}
+	return p_msg;
 }
-#endif
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-#if LOC_FEATURE_LO_RESOURCES
-static int LOCC_processGetRsc(void) {
-	int rc = 0;
-	if ((_LOClient_Set_UpdatedRsc.ursc_cid) && (_LOClient_Set_UpdatedRsc.ursc_obj_ptr)) {
-		if (_LOClient_Set_Rsc.rsc_cb_data) {
-			if (_LOClient_Set_UpdatedRsc.ursc_connected) {
-				rc = _LOClient_Set_Rsc.rsc_cb_data(_LOClient_Set_UpdatedRsc.ursc_obj_ptr,
-						_LOClient_Set_UpdatedRsc.ursc_offset);
-				if (rc < 0) {
-					LOTRACE_INF("ERROR returned by User callback function");
-					rc = -1;
-				}
-				else if (rc == 0) {
-					LOTRACE_INF("0 byte => ERROR !! offset=%"PRIu32"/%"PRIu32,
-							_LOClient_Set_UpdatedRsc.ursc_offset, _LOClient_Set_UpdatedRsc.ursc_size);
-					rc = -50;
-				}
-
-				if (_LOClient_Set_UpdatedRsc.ursc_offset == _LOClient_Set_UpdatedRsc.ursc_size) {
-					int i;
-					unsigned char output[16];
-					memset(output, 0, 16);
-#if LOC_FEATURE_MBEDTLS
-					mbedtls_md5_finish(&_LOClient_Set_UpdatedRsc.md5_ctx, output);
-#endif /* LOC_FEATURE_MBEDTLS */
-					/* TODO: Check md5 value with the value given by the LO server */
-					for (i = 0; i < sizeof(output); i++) {
-						if (output[i] != _LOClient_Set_UpdatedRsc.ursc_md5[i]) {
-							LOTRACE_INF(
-									"Computed MD5  %02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
-									output[0], output[1], output[2], output[3], output[4], output[5], output[6],
-									output[7], output[8], output[9], output[10], output[11], output[12], output[13],
-									output[14], output[15]);
-							LOTRACE_INF(
-									"LO Server MD5  %02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
-									_LOClient_Set_UpdatedRsc.ursc_md5[0], _LOClient_Set_UpdatedRsc.ursc_md5[1],
-									_LOClient_Set_UpdatedRsc.ursc_md5[2], _LOClient_Set_UpdatedRsc.ursc_md5[3],
-									_LOClient_Set_UpdatedRsc.ursc_md5[4], _LOClient_Set_UpdatedRsc.ursc_md5[5],
-									_LOClient_Set_UpdatedRsc.ursc_md5[6], _LOClient_Set_UpdatedRsc.ursc_md5[7],
-									_LOClient_Set_UpdatedRsc.ursc_md5[8], _LOClient_Set_UpdatedRsc.ursc_md5[9],
-									_LOClient_Set_UpdatedRsc.ursc_md5[10], _LOClient_Set_UpdatedRsc.ursc_md5[11],
-									_LOClient_Set_UpdatedRsc.ursc_md5[12], _LOClient_Set_UpdatedRsc.ursc_md5[13],
-									_LOClient_Set_UpdatedRsc.ursc_md5[14], _LOClient_Set_UpdatedRsc.ursc_md5[15]);
-							LOTRACE_ERR("MD5 ERROR - [%d] x%x != x%x", i, output[i],
-									_LOClient_Set_UpdatedRsc.ursc_md5[i]);
-							break;
-						}
-					}
-#if !LOC_FEATURE_MBEDTLS
-					LOTRACE_WARN("MD5 WARNING: Not implemented => Force OK");
-					i = sizeof(output);
-#endif
-					if (_LOClient_Set_Rsc.rsc_cb_ntfy) {
-						_LOClient_Set_Rsc.rsc_cb_ntfy((i == sizeof(output)) ? 1 : 2,
-								_LOClient_Set_UpdatedRsc.ursc_obj_ptr, _LOClient_Set_UpdatedRsc.ursc_vers_old,
-								_LOClient_Set_UpdatedRsc.ursc_vers_new, _LOClient_Set_UpdatedRsc.ursc_size);
-					}
-					rc = -1;
-				}
+static int LOCC_mqPut(LiveObjectsClient_Ctx* ctx, const char* p_msg) {
+	const char* p_old = NULL;
+	Timer deadline;
+	uint8_t waiting = 0;
+	uint32_t count;
+	/* lock */
+	if (MQ_MUTEX_LOCK()) {
+		LOTRACE_WARN("Error to lock mutex");
+		return -1;
+	}
+	while (ctx->queue.count >= ctx->queue.size) {
+		if (ctx->queue.policy == MQ_POLICY_DROP_NEWEST) {
+			MQ_MUTEX_UNLOCK();
+			LOTRACE_WARN("Queue full - drop the new msg %p x%x", p_msg, *p_msg);
+			LO_msg_free(p_msg);
+			return 0;
+		}
+		if (ctx->queue.policy == MQ_POLICY_DROP_OLDEST) {
+			p_old = ctx->queue.msg[ctx->queue.iread];
+			ctx->queue.msg[ctx->queue.iread] = NULL;
+			if (++ctx->queue.iread == ctx->queue.size) {
+				ctx->queue.iread = 0;
 			}
-			else {
-				LOTRACE_INF(
-						"PROCESS PENDING RESOURCE %s - cid=%"PRIi32" retry=%d offset=%"PRIu32" => connect to %s ...",
-						_LOClient_Set_UpdatedRsc.ursc_obj_ptr->rsc_name, _LOClient_Set_UpdatedRsc.ursc_cid,
-						_LOClient_Set_UpdatedRsc.ursc_retry, _LOClient_Set_UpdatedRsc.ursc_offset,
-						_LOClient_Set_UpdatedRsc.ursc_uri);
-				rc = LO_wget_start(_LOClient_Set_UpdatedRsc.ursc_uri, _LOClient_Set_UpdatedRsc.ursc_size,
-						_LOClient_Set_UpdatedRsc.ursc_offset);
-				if (rc == 0) {
-					LOTRACE_NOTICE("PROCESS RESOURCE %s - cid=%"PRIi32"  uri='%s'",
-							_LOClient_Set_UpdatedRsc.ursc_obj_ptr->rsc_name, _LOClient_Set_UpdatedRsc.ursc_cid,
-							_LOClient_Set_UpdatedRsc.ursc_uri);
-					_LOClient_Set_UpdatedRsc.ursc_connected = 1;
-					if (_LOClient_Set_UpdatedRsc.ursc_offset == 0) {
-#if LOC_FEATURE_MBEDTLS
-						mbedtls_md5_init(&_LOClient_Set_UpdatedRsc.md5_ctx);
-						mbedtls_md5_starts(&_LOClient_Set_UpdatedRsc.md5_ctx);
-#else
-						memset(&_LOClient_Set_UpdatedRsc.md5_ctx,0,sizeof(_LOClient_Set_UpdatedRsc.md5_ctx));
-#endif
-					}
-				}
+			ctx->queue.count--;
+			break;
+		}
+		MQ_MUTEX_UNLOCK();
+		if ((ctx->queue.policy != MQ_POLICY_BLOCK) || (LO_sys_threadIsLiveObjectsClient())
+				|| ((waiting) && (TimerIsExpired(&deadline)))) {
+			/* MQ_POLICY_REJECT, or timeout. The client thread never waits for itself. */
+			if (waiting) {
+				LOCC_mqWaitEnd(ctx);
 			}
+			return -1;
+		}
+		if (!waiting) {
+			/* Check again once the client thread knows that a producer is waiting */
+			TimerInit(&deadline);
+			TimerCountdownMS(&deadline, ctx->queue.block_ms);
+			LOCC_mqWaitBegin(ctx);
+			waiting = 1;
 		}
 		else {
-			LOTRACE_NOTICE(
-					"PROCESS PENDING RESOURCE cid=%"PRIi32" - %s => NO USER Callback => ABORT !!",
-					_LOClient_Set_UpdatedRsc.ursc_cid, _LOClient_Set_UpdatedRsc.ursc_obj_ptr->rsc_name);
+			LOCC_mqWait(ctx, &deadline);
 		}
-
-		if (rc < 0) {
-			if (_LOClient_Set_UpdatedRsc.ursc_connected) {
-				LOTRACE_DBG1("close TCP connection used for HTTP GET");
-				LO_wget_close();
-				if ((rc == -50) && (_LOClient_Set_UpdatedRsc.ursc_retry < 4)) {
-					_LOClient_Set_UpdatedRsc.ursc_retry++;
-					_LOClient_Set_UpdatedRsc.ursc_connected = 0;
-					LOTRACE_NOTICE("retry=%u => partial content from %"PRIu32,
-							_LOClient_Set_UpdatedRsc.ursc_retry, _LOClient_Set_UpdatedRsc.ursc_offset);
-					return 0;
-				}
-#if LOC_FEATURE_MBEDTLS
-				LOTRACE_DBG1("Free MD5 Context");
-				mbedtls_md5_free(&_LOClient_Set_UpdatedRsc.md5_ctx);
-#endif
-			}
-
-			_LOClient_Set_UpdatedRsc.ursc_cid = 0;
-			_LOClient_Set_UpdatedRsc.ursc_obj_ptr = NULL;
-			_LOClient_Set_UpdatedRsc.ursc_connected = 0;
-			_LOClient_Set_UpdatedRsc.ursc_retry = 0;
-
-			_LOClient_Set_Rsc.pushtoLOServer = 1;
+		if (MQ_MUTEX_LOCK()) {
+			LOTRACE_WARN("Error to lock mutex");
+			LOCC_mqWaitEnd(ctx);
+			return -1;
 		}
 	}
+	if (waiting) {
+		LOCC_mqWaitEnd(ctx);
+	}
+	ctx->queue.msg[ctx->queue.iwrite] = p_msg;
+	if (++ctx->queue.iwrite == ctx->queue.size) {
+		ctx->queue.iwrite = 0;
+	}
+	count = ++ctx->queue.count;
+	/* unlock */
+	MQ_MUTEX_UNLOCK();
 
-	return rc;
+	if (p_old) {
+		LOTRACE_WARN("Queue full - drop the oldest msg %p x%x", p_old, *p_old);
+		LO_msg_free(p_old);
+	}
+	LOCC_wakeup(ctx);
+	LOCC_mqLevel(ctx, count, 1);
+	return 0;
 }
 #endif
 
+#if LOM_MQUEUE
 /* --------------------------------------------------------------------------------- */
 /*  */
-#if LOC_FEATURE_LO_PARAMS
-static int LOCC_processConfig(void) {
-	int rc = 0;
-
-	if (_LOClient_Set_Params.param_set.param_ptr) {
-		const char* pMsg;
+static void LOCC_mqPurge(LiveObjectsClient_Ctx* ctx) {
+	const char* p_msg;
+	while ((p_msg = LOCC_mqGet(ctx)) != NULL) {
+		LOTRACE_DBG1("Free msg=%p x%x", p_msg, *p_msg);
+		LO_msg_free(p_msg);
+	}
+	LOCC_mqSignal(ctx);
+}
 
-		if (_LOClient_Set_UpdatedParams.cid) {
-			if ((_LOClient_Set_UpdatedParams.nb_of_params) && (_LOClient_Set_UpdatedParams.tab_of_param_ptr[0])) {
-				LOTRACE_INF("cid=%"PRIi32" => PUBLISH CFG_UPDATE response...",
-						_LOClient_Set_UpdatedParams.cid);
-				pMsg = LO_msg_encode_params_update(&_LOClient_Set_UpdatedParams);
-				if (pMsg) {
-					rc = LOCC_MqttPublish(QOS0, "dev/cfg", pMsg);
-					if (rc == 0) {
-						_LOClient_Set_UpdatedParams.cid = 0;
-					}
-				}
-				else {
-					_LOClient_Set_UpdatedParams.cid = 0;
-				}
-			}
-			else {
-				LOTRACE_INF("EMPTY => PUBLISH all CFG parameters with cid=%"PRIi32" ...",
-						_LOClient_Set_UpdatedParams.cid);
-				pMsg = LO_msg_encode_params_all(0, &_LOClient_Set_Params.param_set, _LOClient_Set_UpdatedParams.cid);
-				if (pMsg) {
-					rc = LOCC_MqttPublish(QOS0, "dev/cfg", pMsg);
-					if (rc == 0) {
-						_LOClient_Set_UpdatedParams.cid = 0;
-					}
-				}
-				else {
-					_LOClient_Set_UpdatedParams.cid = 0;
-				}
-			}
+/* --------------------------------------------------------------------------------- */
+/* Called when the message ring has no room for a new message (MSG_MUTEX locked): the overflow policy
+ * of the queue is applied, as when the queue is full. Return 0 to retry the reservation. */
+static int LOCC_ringFull(LOMRing_t* ring, uint32_t len, void* user) {
+	LiveObjectsClient_Ctx* ctx = (LiveObjectsClient_Ctx*) user;
+	uint32_t count;
+
+	if (ctx->queue.policy == MQ_POLICY_DROP_OLDEST) {
+		const char* p_old = LOCC_mqGet(ctx);
+		if (p_old) {
+			LOTRACE_WARN("Ring full - drop the oldest msg %p x%x", p_old, *p_old);
+			LO_msg_free(p_old);
+			return 0;
 		}
-
-		if ((_LOClient_cfg_first)
-#if LOM_PUSH_FLAG
-				|| (_LOClient_Set_Params.pushtoLOServer)
-#endif
-				) {
-#if LOM_PUSH_FLAG
-			LOTRACE_INF("first=%d  push=%d => PUBLISH CFG parameters ...", _LOClient_cfg_first,
-					_LOClient_Set_Params.pushtoLOServer);
-#endif
-			pMsg = LO_msg_encode_params_all(0, &_LOClient_Set_Params.param_set, 0);
-			if (pMsg) {
-				rc = LOCC_MqttPublish(QOS0, "dev/cfg", pMsg);
-				if (rc == 0) {
-#if LOM_PUSH_FLAG
-					_LOClient_Set_Params.pushtoLOServer = 0;
+	}
+	else if ((ctx->queue.policy == MQ_POLICY_BLOCK) && (!LO_sys_threadIsLiveObjectsClient())) {
+		Timer deadline;
+		int ok = 0;
+		TimerInit(&deadline);
+		TimerCountdownMS(&deadline, ctx->queue.block_ms);
+		LOCC_mqWaitBegin(ctx);
+		/* MSG_MUTEX is released while waiting (also locked by the client thread) */
+		do {
+			MSG_MUTEX_UNLOCK();
+			LOCC_mqWait(ctx, &deadline);
+			MSG_MUTEX_LOCK();
+			ok = LO_msg_ring_room(ring, len);
+		} while ((!ok) && (!TimerIsExpired(&deadline)));
+		LOCC_mqWaitEnd(ctx);
+		if (ok) {
+			return 0;
+		}
+	}
+	/* MQ_POLICY_REJECT, MQ_POLICY_DROP_NEWEST, or timeout */
+#if LOM_MQUEUE_LOCKFREE
+	count = __atomic_load_n(&ctx->queue.count, __ATOMIC_RELAXED);
+#else
+	count = ctx->queue.count;
 #endif
-					if (_LOClient_cfg_first) {
-#if 1
-						rc = LOCC_SubscibeTopic(TOPIC_CFG_UPD);
-						if (rc == 0) {
-							_LOClient_cfg_first = 0;
-						}
+	LOCC_mqLevel(ctx, count, 2);
+	return -1;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOCC_mqRelease(LiveObjectsClient_Ctx* ctx) {
+	LOCC_mqPurge(ctx);
+#if LOM_MQUEUE_LOCKFREE
+	if (ctx->queue.cell) {
+		MEM_FREE(ctx->queue.cell);
+		ctx->queue.cell = NULL;
+	}
 #else
-						_LOClient_cfg_first = 0;
+	if (ctx->queue.msg) {
+		MEM_FREE(ctx->queue.msg);
+		ctx->queue.msg = NULL;
+	}
 #endif
-					}
-				}
-			}
-		}
+	if (ctx->ring.buf) {
+		MEM_FREE(ctx->ring.buf);
 	}
-	return rc;
+	memset(&ctx->ring, 0, sizeof(ctx->ring));
+	ctx->queue.size = 0;
 }
-#endif
+
+/* --------------------------------------------------------------------------------- */
+/* Get the topic, the QoS and the payload of a queued message. Return the payload, or NULL if unknown. */
+static const char* LOCC_mqDecode(const char* p_msg, const char** topic, enum QoS* qos, uint32_t* len) {
+	*qos = QOS0;
+	if (*p_msg & LOM_MSG_BIN) {
+		/* Binary 'status' or 'collected data' (see LO_msg_encode_xxx) */
+		*topic = ((*p_msg & ~LOM_MSG_BIN) == MTYPE_PUB_STATUS) ? "dev/info" : "dev/data";
+		memcpy((char*) len, p_msg + 1, 4);
+		return p_msg + 5;
+	}
+	if (*p_msg == MTYPE_PUB_DATA) {
+		*topic = "dev/data";
+	}
+	else if (*p_msg == MTYPE_PUB_CMD_RSP) {
+		*topic = "dev/cmd/res";
+	}
+	else if (*p_msg == MTYPE_PUB_STATUS) {
+		*topic = "dev/info";
+	}
+	else if (*p_msg == MTYPE_PUB_PARAM) {
+		*topic = "dev/cfg";
+	}
+	else if (*p_msg == MTYPE_PUB_RSC) {
+		*topic = "dev/rsc";
+	}
+	else if (*p_msg == MTYPE_PUB_USR_MSG) {
+		short tlen;
+		memcpy((char*) &tlen, p_msg + 1, 2);
+		if (tlen <= 0) {
+			return NULL;
+		}
+		*topic = p_msg + 3;
+		*len = strlen(p_msg + 3 + tlen + 1);
+		return p_msg + 3 + tlen + 1;
+	}
+	else if (*p_msg == MTYPE_PUB_USR_BIN) {
+		short tlen;
+		*qos = (enum QoS) p_msg[1];
+		memcpy((char*) &tlen, p_msg + 2, 2);
+		*topic = p_msg + 4;
+		memcpy((char*) len, p_msg + 4 + tlen + 1, 4);
+		return p_msg + 4 + tlen + 1 + 4;
+	}
+	else {
+		return NULL;
+	}
+	*len = strlen(p_msg + 1);
+	return p_msg + 1;
+}
+#endif /* LOM_MQUEUE */
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-#if LOM_PUSH_ASYNC &&  LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
-static int LOCC_processData(uint8_t force)
-{
-	int rc = 0;
-	int data_hdl;
-	for (data_hdl=0; data_hdl < LOC_MAX_OF_DATA_SET; data_hdl++) {
-		LOMSetOfData_t* p_dataSet = &_LOClient_Set_Data[data_hdl];
-		if ((p_dataSet->data_set.data_ptr) && ((force) || p_dataSet->pushtoLOServer)) {
-			const char* pMsg;
-			p_dataSet->pushtoLOServer = 1;
-			LOTRACE_INF("LOCC_processData: force=%d  pushtoLom=%d => PUBLISH DATA ...", force , p_dataSet->pushtoLOServer);
-			/* TODO: set timestamp only tif the board has the good date/time  !
-			 * tbx_GetDateTimeStr(_LOClient_Set_Data.timestamp, sizeof(_LOClient_Set_Data.timestamp));
-			 */
-			pMsg = LO_msg_encode_data(0, p_dataSet);
-			if (pMsg) {
-				rc = LOCC_MqttPublish(QOS0, "dev/data", pMsg);
-				if (rc == 0) {
-					p_dataSet->pushtoLOServer = 0;
-				}
+static int LOCC_mqInit(LiveObjectsClient_Ctx* ctx) {
+#if LOM_MQUEUE
+	if (ctx->queue.size == 0) {
+		/* First init: default queue */
+		ctx->queue.policy = MQ_POLICY_REJECT;
+		if (LOCC_mqAlloc(ctx, LOC_MQTT_DEF_PENDING_MSG_MAX)) {
+			return -1;
+		}
+	}
+	else {
+		LOCC_mqPurge(ctx);
+	}
+	LOCC_mqReset(ctx);
+#endif /* LOM_MQUEUE */
+	return 0;
+}
+
+/* ================================================================================= */
+/* Callback functions called by MQTT (linked to subscribed topics)
+ */
+/* --------------------------------------------------------------------------------- */
+/* Size the set of updated parameters with the attached table. Only the client thread
+ * uses this set (decoder and response), so it is never freed while it is read. */
+#if LOC_FEATURE_LO_PARAMS
+static int LOCC_paramsRoom(LiveObjectsClient_Ctx* ctx) {
+	LOMSetofUpdatedParams_t* up = &ctx->set_updated_params;
+	int32_t nb;
+
+	MSG_MUTEX_LOCK();
+	nb = ctx->set_params.param_set.param_nb;
+	MSG_MUTEX_UNLOCK();
+
+	if (nb > up->max_of_params) {
+		const LiveObjectsD_Param_t** tab;
+		tab = (const LiveObjectsD_Param_t**) MEM_ALLOC(nb * sizeof(const LiveObjectsD_Param_t*));
+		if (tab == NULL) {
+			LOTRACE_ERR("MEM_ALLOC ERROR (%"PRIi32" parameters)", nb);
+			return -1;
+		}
+		if (up->tab_of_param_ptr) {
+			MEM_FREE(up->tab_of_param_ptr);
+		}
+		up->tab_of_param_ptr = tab;
+		up->max_of_params = nb;
+		up->nb_of_params = 0;
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOCC_ntfDevCfgUpd(MessageData* msg) {
+	LiveObjectsClient_Ctx* ctx = LOCC_CTX_OF_MSG(msg);
+	int ret;
+	LOTRACE_INF("topicName='%s' '%.*s'", (msg->topicName->cstring) ? msg->topicName->cstring : "" , msg->topicName->lenstring.len,
+			msg->topicName->lenstring.data);
+	LOTRACE_INF("msg: id=%d qos=%d '%.*s'", msg->message->id, msg->message->qos, msg->message->payloadlen,
+			(const char*) msg->message->payload);
+
+	if (LOCC_paramsRoom(ctx)) {
+		return;
+	}
+	ret = LO_msg_decode_params_req((const char*) msg->message->payload, msg->message->payloadlen,
+			&ctx->set_params, &ctx->set_updated_params);
+	if (ret) {
+		LOTRACE_ERR("failed, rc= %d", ret);
+	}
+}
+#endif
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+#if LOC_FEATURE_LO_RESOURCES
+static void LOCC_ntfDevRscUpd(MessageData* msg) {
+	LiveObjectsClient_Ctx* ctx = LOCC_CTX_OF_MSG(msg);
+	LiveObjectsD_ResourceRespCode_t rsc_result;
+	const char* pMsg;
+	char* pBuf;
+	uint32_t buf_len;
+	uint32_t len = 0;
+	int32_t cid = 0;
+	LOTRACE_INF("topicName='%s' '%.*s'", msg->topicName->cstring, msg->topicName->lenstring.len,
+			msg->topicName->lenstring.data);
+	LOTRACE_INF("msg: id=%d qos=%d '%.*s'", msg->message->id, msg->message->qos, msg->message->payloadlen,
+			(const char*) msg->message->payload);
+
+	rsc_result = LO_msg_decode_rsc_req((const char*) msg->message->payload, msg->message->payloadlen,
+			&ctx->set_rsc, &ctx->set_updated_rsc, &cid);
+	if (cid == 0) {
+		LOTRACE_ERR("failed, NO CID !!  ret=%d", rsc_result);
+		return;
+	}
+
+	pBuf = LOCC_MqttPublishBegin(ctx, QOS0, "dev/rsc/upd/res", &buf_len);
+	if (pBuf == NULL) {
+		return;
+	}
+	pMsg = LO_msg_encode_rsc_result(pBuf, buf_len, cid, rsc_result, &len);
+	if (pMsg) {
+		LOTRACE_DBG1("Publish rsc response, cid=%"PRIi32" with ret=%d ...", cid, rsc_result);
+		LOCC_MqttPublishEndBin(ctx, QOS0, "dev/rsc/upd/res", pMsg, len);
+	}
+	else {
+		LOTRACE_PRINTF("ERROR to build rsc response, cid=%"PRIi32" with ret=%d", cid, rsc_result);
+	}
+}
+#endif
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+#if LOC_FEATURE_LO_COMMANDS
+static void LOCC_ntfDevCmd(MessageData* msg) {
+	LiveObjectsClient_Ctx* ctx = LOCC_CTX_OF_MSG(msg);
+	int ret;
+	int32_t cid = 0;
+	LOTRACE_INF("topicName='%s' '%.*s'", msg->topicName->cstring, msg->topicName->lenstring.len,
+			msg->topicName->lenstring.data);
+	LOTRACE_INF("msg: id=%d qos=%d '%.*s'", msg->message->id, msg->message->qos, msg->message->payloadlen,
+			(const char*) msg->message->payload);
+
+	ret = LO_msg_decode_cmd_req((const char*) msg->message->payload, msg->message->payloadlen,
+			&ctx->set_cmd, &cid);
+	if (ret < 0) {
+		LOTRACE_ERR("failed, rc= %d, cid=%"PRIi32, ret, cid);
+	}
+
+	if ((cid) &&(ret)) {
+		const char* pMsg;
+		char* pBuf;
+		uint32_t buf_len;
+		uint32_t len = 0;
+		/* send immediately a command response */
+		LOTRACE_INF("Send command response cid=%"PRIi32" ret= %d", cid, ret);
+		pBuf = LOCC_MqttPublishBegin(ctx, QOS0, "dev/cmd/res", &buf_len);
+		pMsg = (pBuf) ? LO_msg_encode_cmd_result(pBuf, buf_len, cid, ret, &len) : NULL;
+		if (pMsg) {
+			LOCC_MqttPublishEndBin(ctx, QOS0, "dev/cmd/res", pMsg, len);
+		}
+	}
+	else {
+		LOTRACE_NOTICE("!! DELAYED CMD RESPONSE (ret=%d) - cid=%"PRIi32, ret, cid);
+	}
+}
+#endif
+
+/* ================================================================================= */
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+#if SECURITY_ENABLED
+static int LOCC_EnableTLS(LiveObjectsClient_Ctx* ctx) {
+	int rc;
+	rc = netw_setSecurity(&ctx->netw, &_LOClient_params_security);
+	return rc;
+}
+#endif
+
+/* --------------------------------------------------------------------------------- */
+/* Result of the MQTT connection: 0 (connected), the CONNACK return code if refused, or -1 */
+static int LOCC_MqttConnectResult(LiveObjectsClient_Ctx* ctx, int ret) {
+	if (ret) {
+		LOTRACE_ERR("MQTTConnect failed, rc= %d", ret);
+		LOTRACE_ERR("You might need to check your APIKEY\n");
+		netw_disconnect(&ctx->netw, 1);
+		return (ret > 0) ? ret : -1;
+	}
+	LOTRACE_INF("MQTT Connected : OK %d", ret);
+	ctx->state_connected = 1;
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Send the CONNECT packet and wait for the CONNACK, or only send it (wait = 0): the CONNACK is then
+ * read by LOCC_MqttConnack() */
+static int LOCC_MqttConnect(LiveObjectsClient_Ctx* ctx, uint8_t wait) {
+	int ret;
+	char mqtt_client_id[14+LOC_MQTT_DEF_NAME_SPACE_SZ+LOC_MQTT_DEF_DEV_ID_SZ+2];
+
+	MQTTPacket_connectData connectData = MQTTPacket_connectData_initializer;
+
+
+	ret = snprintf(mqtt_client_id, sizeof(mqtt_client_id), "urn:lo:nsid:%s:%s", ctx->dev_name_space,
+			ctx->dev_id);
+	mqtt_client_id[sizeof(mqtt_client_id)-1] = 0;
+
+	LOTRACE_DBG1("MQTT Connecting (%s) ...", mqtt_client_id);
+
+	connectData.MQTTVersion = (unsigned char) (4);
+	connectData.clientID.cstring = mqtt_client_id;
+	connectData.username.cstring = (char*) ((ctx->encoder) ? ctx->encoder : &LO_msg_enc_json)->mqtt_user;
+	char password[APIKEY_LENGTH];
+	ret = apikeyconv(ctx, password, APIKEY_LENGTH);
+	if (ret == 0) {
+		connectData.password.cstring = password;
+	} else {
+		LOTRACE_ERR("Apikeyconv failed, ret= %d", ret);
+	}
+
+#if 0
+	connectData.will.topicName.cstring = ...;
+	connectData.will.message.cstring = ...;
+	connectData.will.qos = ...;
+	connectData.will.retained = ...;
+#endif
+
+	connectData.keepAliveInterval = LOC_MQTT_API_KEEPALIVEINTERVAL_SEC;
+
+	/* Return the CONNACK return code when the connection is refused */
+	ret = (wait) ? MQTTConnect(&ctx->mqtt_ctx, &connectData) : MQTTConnectSend(&ctx->mqtt_ctx, &connectData);
+	if ((ret == 0) && (!wait)) {
+		LOTRACE_DBG1("MQTT CONNECT sent");
+		return 0;
+	}
+	return LOCC_MqttConnectResult(ctx, ret);
+}
+
+#if LOC_FEATURE_EVLOOP
+/* --------------------------------------------------------------------------------- */
+/* Read the CONNACK of the CONNECT packet sent by LOCC_MqttConnect(ctx, 0) */
+static int LOCC_MqttConnack(LiveObjectsClient_Ctx* ctx) {
+	return LOCC_MqttConnectResult(ctx, MQTTConnackRead(&ctx->mqtt_ctx, LOCC_PACKET_TMO_MS));
+}
+#endif
+
+#if LOC_MQTT_INFLIGHT
+/* QoS 1 in-flight window: the PUBLISH packets are serialized in the ring of the window, sent
+ * without waiting for their PUBACK (up to 'window' unacknowledged messages), and kept until
+ * their PUBACK is received (cycle of the MQTT client), or retransmitted (DUP) after a reconnection. */
+
+/* --------------------------------------------------------------------------------- */
+/* Release a message of the window, and notify the user */
+static void LOCC_inflightDone(LiveObjectsClient_Ctx* ctx, LOCCInflight_t* s, int status) {
+	LOCCWindow_t* w = &ctx->inflight;
+	if (w->cb) {
+		unsigned char dup, retained;
+		unsigned short id;
+		int qos, payload_len;
+		unsigned char* payload;
+		MQTTString topic = MQTTString_initializer;
+		if (MQTTDeserialize_publish(&dup, &qos, &retained, &id, &topic, &payload, &payload_len,
+				(unsigned char*) s->pkt, (int) s->len) == 1) {
+			char topic_name[LOC_MQTT_DEF_TOPIC_NAME_SZ];
+			int tlen = (topic.lenstring.len < (int) sizeof(topic_name)) ? topic.lenstring.len : (int) sizeof(topic_name) - 1;
+			memcpy(topic_name, topic.lenstring.data, tlen);
+			topic_name[tlen] = 0;
+			w->cb(topic_name, payload, (uint32_t) payload_len, status, w->user_ctx);
+		}
+	}
+#if LOC_FEATURE_JOURNAL
+	if ((s->token) && (ctx->journal)) {
+		if (status == 0) {
+			LO_journal_ack(ctx->journal, s->token);
+		}
+		else {
+			/* Not acknowledged: replayed again */
+			LO_journal_rewind(ctx->journal);
+		}
+	}
+#endif
+	LO_msg_free(s->pkt);
+	s->pkt = NULL;
+	w->nb--;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* PUBACK received, called by the MQTT client (cycle) */
+static void LOCC_inflightAck(MQTTClient* c, unsigned short id) {
+	LiveObjectsClient_Ctx* ctx = LOCC_CTX_OF_CLIENT(c);
+	LOCCWindow_t* w = &ctx->inflight;
+	int i;
+	for (i = 0; i < w->window; i++) {
+		if ((w->slot[i].pkt) && (w->slot[i].id == id)) {
+			LOCC_inflightDone(ctx, &w->slot[i], 0);
+			LOTRACE_DBG1("PUBACK id=%u, %u in flight", id, w->nb);
+			return;
+		}
+	}
+	LOTRACE_DBG1("PUBACK id=%u, not in flight", id);
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Wait for a free slot of the window and for room for a packet of max_len bytes in its ring
+ * (max LOC_MQTT_DEF_COMMAND_TIMEOUT). The incoming messages are processed meanwhile, by MQTT cycles
+ * of 1 ms: MQTTYield() does not return before its timeout, a PUBACK must not wait for the end of a long one. */
+static int LOCC_inflightWait(LiveObjectsClient_Ctx* ctx, uint32_t max_len) {
+	LOCCWindow_t* w = &ctx->inflight;
+	Timer timer;
+
+	TimerInit(&timer);
+	TimerCountdownMS(&timer, LOC_MQTT_DEF_COMMAND_TIMEOUT);
+	while ((w->nb >= w->window) || (!LO_msg_ring_room(&w->ring, max_len))) {
+		if ((!ctx->mqtt_ctx.isconnected) || (TimerIsExpired(&timer))
+				|| (MQTTYield(&ctx->mqtt_ctx, 1) == FAILURE)) {
+			LOTRACE_ERR("In-flight window full (%u messages)", w->nb);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Publish a QoS 1 message without waiting for its PUBACK.
+ * When the window (or its ring) is full, wait for acknowledges (max LOC_MQTT_DEF_COMMAND_TIMEOUT),
+ * except for a payload built in the JSON buffer (see LOCC_MqttPublishBegin) */
+static int LOCC_inflightPublish(LiveObjectsClient_Ctx* ctx, const char* topic_name,
+		const void* payload_data, uint32_t payload_len) {
+	LOCCWindow_t* w = &ctx->inflight;
+	uint32_t max_len = 1 + 4 + 2 + strlen(topic_name) + 2 + payload_len;
+	MQTTString topic = MQTTString_initializer;
+	LOCCInflight_t* s;
+	char* pkt;
+	int len;
+#if LOC_FEATURE_JOURNAL
+	/* Taken now: the messages published while waiting for room are not from the journal */
+	uint64_t token = ctx->journal_token;
+	ctx->journal_token = 0;
+#endif
+
+	if (!ctx->mqtt_ctx.isconnected) {
+		LOTRACE_ERR("Not connected");
+		return -1;
+	}
+	if (max_len + 16 > w->ring.size) {
+		LOTRACE_ERR("Message too long (%"PRIu32" bytes) for the in-flight window (%"PRIu32" bytes)",
+				max_len, w->ring.size);
+		return -1;
+	}
+
+	if (((const char*) payload_data >= ctx->msg_buf)
+			&& ((const char*) payload_data < ctx->msg_buf + sizeof(ctx->msg_buf))) {
+		/* The JSON buffer is also used by the incoming messages: no MQTT cycle before the copy */
+		if ((w->nb >= w->window) || (!LO_msg_ring_room(&w->ring, max_len))) {
+			LOTRACE_ERR("In-flight window full (%u messages)", w->nb);
+			return -1;
+		}
+	}
+	else if (LOCC_inflightWait(ctx, max_len)) {
+		return -1;
+	}
+	pkt = LO_msg_ring_reserve(&w->ring, max_len);
+	if (pkt == NULL) {
+		return -1;
+	}
+
+	for (s = w->slot; s->pkt; s++) {
+		;
+	}
+	s->id = (uint16_t) MQTTGetNextPacketId(&ctx->mqtt_ctx);
+	topic.cstring = (char*) topic_name;
+	len = MQTTSerialize_publish((unsigned char*) pkt, (int) max_len, 0, QOS1, 0, s->id, topic,
+			(unsigned char*) payload_data, (int) payload_len);
+	if (len <= 0) {
+		LOTRACE_ERR("MQTTSerialize_publish failed, rc=%d", len);
+		return -1;
+	}
+	LO_msg_ring_commit(&w->ring, pkt, (uint32_t) len);
+	s->pkt = pkt;
+	s->len = (uint32_t) len;
+	s->seq = w->seq++;
+#if LOC_FEATURE_JOURNAL
+	s->token = token;
+#endif
+	w->nb++;
+
+	LOTRACE_DBG1("MQTTPublishPackets id=%u len=%d, %u in flight", s->id, len, w->nb);
+	if (MQTTPublishPackets(&ctx->mqtt_ctx, (unsigned char*) pkt, len)) {
+		/* Kept in the window, retransmitted after the reconnection */
+		LOTRACE_ERR("MQTTPublishPackets failed, id=%u", s->id);
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Retransmit the unacknowledged messages (DUP flag set), in their send order, after a reconnection */
+static void LOCC_inflightResend(LiveObjectsClient_Ctx* ctx) {
+	LOCCWindow_t* w = &ctx->inflight;
+	LOCCInflight_t* last = NULL;
+	int n, i;
+
+	for (n = 0; n < w->nb; n++) {
+		LOCCInflight_t* s = NULL;
+		for (i = 0; i < w->window; i++) {
+			LOCCInflight_t* p = &w->slot[i];
+			if ((p->pkt) && ((last == NULL) || ((int32_t) (p->seq - last->seq) > 0))
+					&& ((s == NULL) || ((int32_t) (p->seq - s->seq) < 0))) {
+				s = p;
 			}
 		}
+		if (s == NULL) {
+			break;
+		}
+		{
+			MQTTHeader header;
+			header.byte = (unsigned char) s->pkt[0];
+			header.bits.dup = 1;
+			s->pkt[0] = (char) header.byte;
+		}
+		LOTRACE_INF("Retransmit id=%u len=%"PRIu32, s->id, s->len);
+		if (MQTTPublishPackets(&ctx->mqtt_ctx, (unsigned char*) s->pkt, (int) s->len)) {
+			LOTRACE_ERR("MQTTPublishPackets failed, id=%u", s->id);
+			break;
+		}
+		last = s;
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOCC_inflightRelease(LiveObjectsClient_Ctx* ctx) {
+	LOCCWindow_t* w = &ctx->inflight;
+	int i;
+	for (i = 0; i < w->window; i++) {
+		if (w->slot[i].pkt) {
+			LOCC_inflightDone(ctx, &w->slot[i], -1);
+		}
+	}
+	if (w->slot) {
+		MEM_FREE(w->slot);
+	}
+	memset(w, 0, sizeof(LOCCWindow_t));
+	ctx->mqtt_ctx.pubackHandler = NULL;
+}
+#endif /* LOC_MQTT_INFLIGHT */
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int LOCC_MqttPublishBin(LiveObjectsClient_Ctx* ctx, enum QoS qos, const char* topic_name,
+		const void* payload_data, uint32_t payload_len) {
+	int rc;
+	MQTTMessage mqtt_msg;
+
+#if LOC_MQTT_INFLIGHT
+	if ((ctx->inflight.window) && (qos != QOS2)) {
+		return LOCC_inflightPublish(ctx, topic_name, payload_data, payload_len);
+	}
+#endif
+
+	mqtt_msg.qos = qos;
+	mqtt_msg.retained = 0;
+	mqtt_msg.dup = 0;
+	mqtt_msg.id = 0;
+	mqtt_msg.payload = (void*) payload_data;
+	mqtt_msg.payloadlen = payload_len;
+
+#if (LOC_MQTT_DUMP_MSG & 0x01)
+	if (_LOClient_dump_mqtt_publish & 0x04) {
+		/* Dumped from the send buffer: the payload is copied in it */
+		LOTRACE_DBG1("MQTTPublish len=%d ....", mqtt_msg.payloadlen);
+		rc = MQTTPublish(&ctx->mqtt_ctx, topic_name, &mqtt_msg);
+		if (rc) {
+			LOTRACE_ERR("MQTTPublish failed, rc=%d", rc);
+		}
+		mqtt_dump_msg(ctx->mqtt_buffer_snd);
+		return rc;
+	}
+#endif
+
+	/* Message in the send buffer (fixed header, topic, packet id): one contiguous write costs less
+	 * than a vectored one. Larger payloads are sent from where they are, not copied (scatter-gather) */
+	if (payload_len + strlen(topic_name) + 9 <= LOC_MQTT_DEF_SND_SZ) {
+		LOTRACE_DBG1("MQTTPublish len=%d ....", mqtt_msg.payloadlen);
+		rc = MQTTPublish(&ctx->mqtt_ctx, topic_name, &mqtt_msg);
+		if (rc) {
+			LOTRACE_ERR("MQTTPublish failed, rc=%d", rc);
+		}
+		return rc;
+	}
+
+	LOTRACE_DBG1("MQTTPublishVec len=%d ....", mqtt_msg.payloadlen);
+	rc = MQTTPublishVec(&ctx->mqtt_ctx, topic_name, &mqtt_msg);
+	if (rc) {
+		LOTRACE_ERR("MQTTPublishVec failed, rc=%d", rc);
+	}
+
+	return rc;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Zero-copy publish: return where the payload is to be built, in place in the MQTT send buffer
+ * (just after the topic), or in the JSON buffer of the instance if the client is not connected.
+ * Return NULL if the in-flight window is full. */
+static char* LOCC_MqttPublishBegin(LiveObjectsClient_Ctx* ctx, enum QoS qos, const char* topic_name,
+		uint32_t* len) {
+	int maxlen;
+	char* p;
+#if LOC_MQTT_INFLIGHT
+	if ((ctx->inflight.window) && (qos != QOS2)) {
+		/* Built in the JSON buffer, and then copied in the ring of the window. Never wait for room
+		 * here (MQTT cycle): also called by the handlers of the incoming messages, within a cycle. */
+		LOCCWindow_t* w = &ctx->inflight;
+		uint32_t hdr_len = 1 + 4 + 2 + strlen(topic_name) + 2 + 16;
+		*len = sizeof(ctx->msg_buf);
+		if (hdr_len + *len > w->ring.size) {
+			*len = (w->ring.size > hdr_len) ? w->ring.size - hdr_len : 0;
+		}
+		if ((w->nb >= w->window) || (!LO_msg_ring_room(&w->ring, hdr_len - 16 + *len))) {
+			LOTRACE_ERR("In-flight window full (%u messages)", w->nb);
+			*len = 0;
+			return NULL;
+		}
+		return ctx->msg_buf;
+	}
+#endif
+	p = (char*) MQTTPublishBegin(&ctx->mqtt_ctx, topic_name, qos, &maxlen);
+	if (p) {
+		*len = (uint32_t) maxlen;
+		return p;
+	}
+	*len = sizeof(ctx->msg_buf);
+	return ctx->msg_buf;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Publish the payload (payload_len bytes) built at the place given by LOCC_MqttPublishBegin() */
+static int LOCC_MqttPublishEndBin(LiveObjectsClient_Ctx* ctx, enum QoS qos, const char* topic_name,
+		const char* payload_data, uint32_t payload_len) {
+	int rc;
+	MQTTMessage mqtt_msg;
+
+	if ((payload_data < (const char*) ctx->mqtt_buffer_snd)
+			|| (payload_data >= (const char*) ctx->mqtt_buffer_snd + sizeof(ctx->mqtt_buffer_snd))) {
+		return LOCC_MqttPublishBin(ctx, qos, topic_name, payload_data, payload_len);
+	}
+
+	mqtt_msg.qos = qos;
+	mqtt_msg.retained = 0;
+	mqtt_msg.dup = 0;
+	mqtt_msg.id = 0;
+	mqtt_msg.payload = (void*) payload_data;
+	mqtt_msg.payloadlen = payload_len;
+
+	/* Not dumped (LOC_MQTT_DUMP_MSG): the packet does not start at the beginning of the buffer */
+	LOTRACE_DBG1("MQTTPublishEnd len=%d ....", mqtt_msg.payloadlen);
+	rc = MQTTPublishEnd(&ctx->mqtt_ctx, topic_name, &mqtt_msg);
+	if (rc) {
+		LOTRACE_ERR("MQTTPublishEnd failed, rc=%d", rc);
+	}
+	return rc;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int LOCC_SubscibeTopic(LiveObjectsClient_Ctx* ctx, int i) {
+	int rc;
+	if ((i >= 0) && (i < 3)) {
+		if (ctx->topic_subscribed[i]) {
+			LOTRACE_WARN("Subscribe[%d] %s already done", i, _LOClient_TopicSub[i].topicName);
+			return 0;
+		}
+		if (_LOClient_TopicSub[i].callback == NULL) {
+			LOTRACE_WARN("Subscribe[%d] %s  - NO CALLBACK FUNCTION !!", i, _LOClient_TopicSub[i].topicName);
+			return 0;
+		}
+		LOTRACE_NOTICE("Subscribe[%d] '%s' , granted_qos=%d .... ", i, _LOClient_TopicSub[i].topicName, QOS0);
+		rc = MQTTSubscribe(&ctx->mqtt_ctx, _LOClient_TopicSub[i].topicName, QOS0, _LOClient_TopicSub[i].callback);
+		if ((rc < 0) || (rc == 0x80)) {
+			LOTRACE_ERR("Subscribe[%d] %s failed, rc=%d", i, _LOClient_TopicSub[i].topicName, rc);
+		}
+		else {
+			LOTRACE_NOTICE("Subscribe[%d] %s, qos=%d (granted_qos=%d)", i, _LOClient_TopicSub[i].topicName, rc, QOS0);
+			ctx->topic_subscribed[i] = 1;
+		}
+	}
+	else {
+		LOTRACE_WARN("Subscribe[%d]: ERROR, bad number [0,2]", i);
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int LOCC_UnsubscibeTopic(LiveObjectsClient_Ctx* ctx, int i) {
+	int rc;
+	if ((i >= 0) && (i < 3)) {
+		if (!ctx->topic_subscribed[i]) {
+			LOTRACE_WARN("Unsubscribe[%d] %s already done", i, _LOClient_TopicSub[i].topicName);
+			return 0;
+		}
+		LOTRACE_NOTICE("Unsubscribe[%d] %s .... ", i, _LOClient_TopicSub[i].topicName);
+		rc = MQTTUnsubscribe(&ctx->mqtt_ctx, _LOClient_TopicSub[i].topicName);
+		if (rc == 0) {
+			LOTRACE_NOTICE("Unsubscribe[%d] %s", i, _LOClient_TopicSub[i].topicName);
+			ctx->topic_subscribed[i] = 0;
+		}
+		else {
+			LOTRACE_ERR("Unsubscribe[%d] %s failed, rc=%d", i, _LOClient_TopicSub[i].topicName, rc);
+		}
+	}
+	else {
+		LOTRACE_WARN("Unsubscribe[%d]: ERROR, bad number [0,2]", i);
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+#if LOC_FEATURE_LO_STATUS  && (LOC_MAX_OF_DATA_SET > 0)
+static int LOCC_processStatus(LiveObjectsClient_Ctx* ctx, uint8_t force) {
+	int rc = 0;
+	int status_hdl;
+	for (status_hdl = 0; status_hdl < LOC_MAX_OF_STATUS_SET; status_hdl++) {
+		LOMSetOfStatus_t* p_satusSet = &ctx->set_status[status_hdl];
+		if ((p_satusSet->data_set.data_ptr) && (p_satusSet->data_set.data_nb)
+				&& ((force)
+#if LOM_PUSH_FLAG
+						|| (p_satusSet->pushtoLOServer)
+#endif
+						)) {
+			const char* pMsg;
+			char* pBuf;
+			uint32_t buf_len;
+			uint32_t len = 0;
+#if LOM_STATUS_DELTA
+			/* Full publication on (re)connection and every LOM_STATUS_DELTA_REFRESH publications,
+			 * otherwise only the elements changed since the last publication */
+			uint32_t hash[LOM_STATUS_DELTA_NB];
+			uint8_t full = (force) || (!p_satusSet->delta_valid)
+					|| ((LOM_STATUS_DELTA_REFRESH > 0) && (p_satusSet->delta_cnt >= LOM_STATUS_DELTA_REFRESH));
+			const uint32_t* shadow = (full) ? NULL : p_satusSet->delta_shadow;
+
+			if (LO_msg_status_delta(&p_satusSet->data_set, shadow, hash) == 0) {
+				LOTRACE_DBG1("status %d: no change", status_hdl);
+				p_satusSet->pushtoLOServer = 0;
+				continue;
+			}
+#endif
+#if LOM_PUSH_FLAG
+			LOTRACE_INF("force=%d  push=%d => PUBLISH STATUS ...", force,
+					p_satusSet->pushtoLOServer);
+			p_satusSet->pushtoLOServer = 1;
+#else
+			LOTRACE_INF("force=%d  => PUBLISH STATUS ...", force);
+#endif
+			pBuf = LOCC_MqttPublishBegin(ctx, QOS0, "dev/info", &buf_len);
+			if (pBuf == NULL) {
+				return -1;
+			}
+#if LOM_STATUS_DELTA
+			pMsg = LO_msg_encode_status_delta(pBuf, buf_len, ctx->encoder, &p_satusSet->data_set, shadow, hash,
+					&len);
+#else
+			pMsg = LO_msg_encode_status(0, pBuf, buf_len, NULL, ctx->encoder, &p_satusSet->data_set, &len);
+#endif
+			if (pMsg) {
+				rc = LOCC_MqttPublishEndBin(ctx, QOS0, "dev/info", pMsg, len);
+				if (rc == 0) {
+#if LOM_PUSH_FLAG
+					p_satusSet->pushtoLOServer = 0;
+#endif
+#if LOM_STATUS_DELTA
+					memcpy(p_satusSet->delta_shadow, hash, sizeof(hash));
+					p_satusSet->delta_valid = 1;
+					p_satusSet->delta_cnt = (full) ? 0 : p_satusSet->delta_cnt + 1;
+#endif
+				}
+			}
+		}
+	}
+	return rc;
+}
+#endif
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+#if LOC_FEATURE_LO_RESOURCES
+
+static int LOCC_processResources(LiveObjectsClient_Ctx* ctx, uint8_t force) {
+	int rc = 0;
+	if ((ctx->set_rsc.rsc_ptr) &&
+			((force) || (ctx->set_rsc.pushtoLOServer))) {
+		const char* pMsg;
+		char* pBuf;
+		uint32_t buf_len;
+		uint32_t len = 0;
+		LOTRACE_INF("force=%d  push=%d => PUBLISH RESOURCES ...", force,
+				ctx->set_rsc.pushtoLOServer);
+		ctx->set_rsc.pushtoLOServer = 1;
+		pBuf = LOCC_MqttPublishBegin(ctx, QOS0, "dev/rsc", &buf_len);
+		if (pBuf == NULL) {
+			return -1;
+		}
+		pMsg = LO_msg_encode_resources(0, pBuf, buf_len, NULL, &ctx->set_rsc, &len);
+		if (pMsg) {
+			rc = LOCC_MqttPublishEndBin(ctx, QOS0, "dev/rsc", pMsg, len);
+			if (rc == 0) {
+				ctx->set_rsc.pushtoLOServer = 0;
+			}
+		}
+	}
+	return rc;
+}
+#endif
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+#if LOC_FEATURE_LO_RESOURCES
+static int LOCC_processGetRsc(LiveObjectsClient_Ctx* ctx) {
+	int rc = 0;
+	if ((ctx->set_updated_rsc.ursc_cid) && (ctx->set_updated_rsc.ursc_obj_ptr)) {
+		if (ctx->set_rsc.rsc_cb_data) {
+			if (ctx->set_updated_rsc.ursc_connected) {
+				rc = ctx->set_rsc.rsc_cb_data(ctx->set_updated_rsc.ursc_obj_ptr,
+						ctx->set_updated_rsc.ursc_offset);
+				if (rc < 0) {
+					LOTRACE_INF("ERROR returned by User callback function");
+					rc = -1;
+				}
+				else if (rc == 0) {
+					LOTRACE_INF("0 byte => ERROR !! offset=%"PRIu32"/%"PRIu32,
+							ctx->set_updated_rsc.ursc_offset, ctx->set_updated_rsc.ursc_size);
+					rc = -50;
+				}
+
+				if (ctx->set_updated_rsc.ursc_offset == ctx->set_updated_rsc.ursc_size) {
+					int i;
+					unsigned char output[16];
+					memset(output, 0, 16);
+#if LOC_FEATURE_MBEDTLS
+					mbedtls_md5_finish(&ctx->set_updated_rsc.md5_ctx, output);
+#endif /* LOC_FEATURE_MBEDTLS */
+					/* TODO: Check md5 value with the value given by the LO server */
+					for (i = 0; i < sizeof(output); i++) {
+						if (output[i] != ctx->set_updated_rsc.ursc_md5[i]) {
+							LOTRACE_INF(
+									"Computed MD5  %02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
+									output[0], output[1], output[2], output[3], output[4], output[5], output[6],
+									output[7], output[8], output[9], output[10], output[11], output[12], output[13],
+									output[14], output[15]);
+							LOTRACE_INF(
+									"LO Server MD5  %02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
+									ctx->set_updated_rsc.ursc_md5[0], ctx->set_updated_rsc.ursc_md5[1],
+									ctx->set_updated_rsc.ursc_md5[2], ctx->set_updated_rsc.ursc_md5[3],
+									ctx->set_updated_rsc.ursc_md5[4], ctx->set_updated_rsc.ursc_md5[5],
+									ctx->set_updated_rsc.ursc_md5[6], ctx->set_updated_rsc.ursc_md5[7],
+									ctx->set_updated_rsc.ursc_md5[8], ctx->set_updated_rsc.ursc_md5[9],
+									ctx->set_updated_rsc.ursc_md5[10], ctx->set_updated_rsc.ursc_md5[11],
+									ctx->set_updated_rsc.ursc_md5[12], ctx->set_updated_rsc.ursc_md5[13],
+									ctx->set_updated_rsc.ursc_md5[14], ctx->set_updated_rsc.ursc_md5[15]);
+							LOTRACE_ERR("MD5 ERROR - [%d] x%x != x%x", i, output[i],
+									ctx->set_updated_rsc.ursc_md5[i]);
+							break;
+						}
+					}
+#if !LOC_FEATURE_MBEDTLS
+					LOTRACE_WARN("MD5 WARNING: Not implemented => Force OK");
+					i = sizeof(output);
+#endif
+					if (ctx->set_rsc.rsc_cb_ntfy) {
+						ctx->set_rsc.rsc_cb_ntfy((i == sizeof(output)) ? 1 : 2,
+								ctx->set_updated_rsc.ursc_obj_ptr, ctx->set_updated_rsc.ursc_vers_old,
+								ctx->set_updated_rsc.ursc_vers_new, ctx->set_updated_rsc.ursc_size);
+					}
+					rc = -1;
+				}
+			}
+			else if ((_LOClient_wget_owner) && (_LOClient_wget_owner != ctx)) {
+				/* HTTP GET in progress for another instance: wait for the next cycle */
+				LOTRACE_DBG1("PROCESS PENDING RESOURCE %s - cid=%"PRIi32" => wget busy",
+						ctx->set_updated_rsc.ursc_obj_ptr->rsc_name, ctx->set_updated_rsc.ursc_cid);
+			}
+			else {
+				LOTRACE_INF(
+						"PROCESS PENDING RESOURCE %s - cid=%"PRIi32" retry=%d offset=%"PRIu32" => connect to %s ...",
+						ctx->set_updated_rsc.ursc_obj_ptr->rsc_name, ctx->set_updated_rsc.ursc_cid,
+						ctx->set_updated_rsc.ursc_retry, ctx->set_updated_rsc.ursc_offset,
+						ctx->set_updated_rsc.ursc_uri);
+				rc = LO_wget_start(ctx->set_updated_rsc.ursc_uri, ctx->set_updated_rsc.ursc_size,
+						ctx->set_updated_rsc.ursc_offset);
+				if (rc == 0) {
+					LOTRACE_NOTICE("PROCESS RESOURCE %s - cid=%"PRIi32"  uri='%s'",
+							ctx->set_updated_rsc.ursc_obj_ptr->rsc_name, ctx->set_updated_rsc.ursc_cid,
+							ctx->set_updated_rsc.ursc_uri);
+					ctx->set_updated_rsc.ursc_connected = 1;
+					_LOClient_wget_owner = ctx;
+					if (ctx->set_updated_rsc.ursc_offset == 0) {
+#if LOC_FEATURE_MBEDTLS
+						mbedtls_md5_init(&ctx->set_updated_rsc.md5_ctx);
+						mbedtls_md5_starts(&ctx->set_updated_rsc.md5_ctx);
+#else
+						memset(&ctx->set_updated_rsc.md5_ctx,0,sizeof(ctx->set_updated_rsc.md5_ctx));
+#endif
+					}
+				}
+			}
+		}
+		else {
+			LOTRACE_NOTICE(
+					"PROCESS PENDING RESOURCE cid=%"PRIi32" - %s => NO USER Callback => ABORT !!",
+					ctx->set_updated_rsc.ursc_cid, ctx->set_updated_rsc.ursc_obj_ptr->rsc_name);
+		}
+
+		if (rc < 0) {
+			if (ctx->set_updated_rsc.ursc_connected) {
+				LOTRACE_DBG1("close TCP connection used for HTTP GET");
+				LO_wget_close();
+				_LOClient_wget_owner = NULL;
+				if ((rc == -50) && (ctx->set_updated_rsc.ursc_retry < 4)) {
+					ctx->set_updated_rsc.ursc_retry++;
+					ctx->set_updated_rsc.ursc_connected = 0;
+					LOTRACE_NOTICE("retry=%u => partial content from %"PRIu32,
+							ctx->set_updated_rsc.ursc_retry, ctx->set_updated_rsc.ursc_offset);
+					return 0;
+				}
+#if LOC_FEATURE_MBEDTLS
+				LOTRACE_DBG1("Free MD5 Context");
+				mbedtls_md5_free(&ctx->set_updated_rsc.md5_ctx);
+#endif
+			}
+
+			ctx->set_updated_rsc.ursc_cid = 0;
+			ctx->set_updated_rsc.ursc_obj_ptr = NULL;
+			ctx->set_updated_rsc.ursc_connected = 0;
+			ctx->set_updated_rsc.ursc_retry = 0;
+
+			ctx->set_rsc.pushtoLOServer = 1;
+		}
+	}
+
+	return rc;
+}
+#endif
+
+/* --------------------------------------------------------------------------------- */
+/* Free the name index of the configuration parameters and the set of updated parameters */
+#if LOC_FEATURE_LO_PARAMS
+static void LOCC_paramsFree(LiveObjectsClient_Ctx* ctx) {
+	LO_msg_index_free(&ctx->set_params.param_index);
+	if (ctx->set_updated_params.tab_of_param_ptr) {
+		MEM_FREE(ctx->set_updated_params.tab_of_param_ptr);
+		ctx->set_updated_params.tab_of_param_ptr = NULL;
+	}
+	ctx->set_updated_params.nb_of_params = 0;
+	ctx->set_updated_params.max_of_params = 0;
+}
+#endif
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+#if LOC_FEATURE_LO_PARAMS
+static int LOCC_processConfig(LiveObjectsClient_Ctx* ctx) {
+	int rc = 0;
+
+	if (ctx->set_params.param_set.param_ptr) {
+		const char* pMsg;
+		char* pBuf;
+		uint32_t buf_len;
+		uint32_t len = 0;
+
+		if (ctx->set_updated_params.cid) {
+			if ((ctx->set_updated_params.nb_of_params) && (ctx->set_updated_params.tab_of_param_ptr[0])) {
+				LOTRACE_INF("cid=%"PRIi32" => PUBLISH CFG_UPDATE response...",
+						ctx->set_updated_params.cid);
+				pBuf = LOCC_MqttPublishBegin(ctx, QOS0, "dev/cfg", &buf_len);
+				if (pBuf == NULL) {
+					return -1;
+				}
+				pMsg = LO_msg_encode_params_update(pBuf, buf_len, &ctx->set_updated_params, &len);
+				if (pMsg) {
+					rc = LOCC_MqttPublishEndBin(ctx, QOS0, "dev/cfg", pMsg, len);
+					if (rc == 0) {
+						ctx->set_updated_params.cid = 0;
+					}
+				}
+				else {
+					ctx->set_updated_params.cid = 0;
+				}
+			}
+			else {
+				LOTRACE_INF("EMPTY => PUBLISH all CFG parameters with cid=%"PRIi32" ...",
+						ctx->set_updated_params.cid);
+				pBuf = LOCC_MqttPublishBegin(ctx, QOS0, "dev/cfg", &buf_len);
+				if (pBuf == NULL) {
+					return -1;
+				}
+				pMsg = LO_msg_encode_params_all(0, pBuf, buf_len, NULL, &ctx->set_params.param_set,
+						ctx->set_updated_params.cid, &len);
+				if (pMsg) {
+					rc = LOCC_MqttPublishEndBin(ctx, QOS0, "dev/cfg", pMsg, len);
+					if (rc == 0) {
+						ctx->set_updated_params.cid = 0;
+					}
+				}
+				else {
+					ctx->set_updated_params.cid = 0;
+				}
+			}
+		}
+
+		if ((ctx->cfg_first)
+#if LOM_PUSH_FLAG
+				|| (ctx->set_params.pushtoLOServer)
+#endif
+				) {
+#if LOM_PUSH_FLAG
+			LOTRACE_INF("first=%d  push=%d => PUBLISH CFG parameters ...", ctx->cfg_first,
+					ctx->set_params.pushtoLOServer);
+#endif
+			pBuf = LOCC_MqttPublishBegin(ctx, QOS0, "dev/cfg", &buf_len);
+			if (pBuf == NULL) {
+				return -1;
+			}
+			pMsg = LO_msg_encode_params_all(0, pBuf, buf_len, NULL, &ctx->set_params.param_set, 0, &len);
+			if (pMsg) {
+				rc = LOCC_MqttPublishEndBin(ctx, QOS0, "dev/cfg", pMsg, len);
+				if (rc == 0) {
+#if LOM_PUSH_FLAG
+					ctx->set_params.pushtoLOServer = 0;
+#endif
+					if (ctx->cfg_first) {
+#if 1
+						rc = LOCC_SubscibeTopic(ctx, TOPIC_CFG_UPD);
+						if (rc == 0) {
+							ctx->cfg_first = 0;
+						}
+#else
+						ctx->cfg_first = 0;
+#endif
+					}
+				}
+			}
+		}
+	}
+	return rc;
+}
+#endif
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+#if LOM_PUSH_ASYNC &&  LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
+static int LOCC_processData(LiveObjectsClient_Ctx* ctx, uint8_t force)
+{
+	int rc = 0;
+	int data_hdl;
+	for (data_hdl=0; data_hdl < LOC_MAX_OF_DATA_SET; data_hdl++) {
+		LOMSetOfData_t* p_dataSet = &ctx->set_data[data_hdl];
+		if ((p_dataSet->data_set.data_ptr) && ((force) || p_dataSet->pushtoLOServer)) {
+			const char* pMsg;
+			char* pBuf;
+			uint32_t buf_len;
+			uint32_t len = 0;
+			p_dataSet->pushtoLOServer = 1;
+			LOTRACE_INF("LOCC_processData: force=%d  pushtoLom=%d => PUBLISH DATA ...", force , p_dataSet->pushtoLOServer);
+			/* TODO: set timestamp only tif the board has the good date/time  !
+			 * tbx_GetDateTimeStr(ctx->set_data.timestamp, sizeof(ctx->set_data.timestamp));
+			 */
+			pBuf = LOCC_MqttPublishBegin(ctx, QOS0, "dev/data", &buf_len);
+			if (pBuf == NULL) {
+				return -1;
+			}
+			pMsg = LO_msg_encode_data(0, pBuf, buf_len, NULL, ctx->encoder, p_dataSet, &len);
+			if (pMsg) {
+				rc = LOCC_MqttPublishEndBin(ctx, QOS0, "dev/data", pMsg, len);
+				if (rc == 0) {
+					p_dataSet->pushtoLOServer = 0;
+				}
+			}
+		}
+	}
+	return rc;
+}
+#endif
+
+#if LOM_DATA_BATCH && LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
+/* Batching of 'collected data': each pushed sample of a data set is timestamped and captured
+ * as a complete MQTT PUBLISH packet (QoS0, "dev/data"), just after the previous one, in the
+ * buffer of the data set. The whole buffer is sent in one write when the max number of samples,
+ * the byte budget or the max latency of the first sample is reached. */
+#define LOCC_BATCH_TOPIC           "dev/data"
+#define LOCC_BATCH_HDR_MAX         5      /* Fixed header: 1 byte + max 4 bytes of remaining length */
+#define LOCC_BATCH_PAYLOAD_OFFSET  (LOCC_BATCH_HDR_MAX + 2 + sizeof(LOCC_BATCH_TOPIC) - 1)
+
+/* --------------------------------------------------------------------------------- */
+/* Capture one sample of the data set (any thread) */
+static int LOCC_batchCapture(LiveObjectsClient_Ctx* ctx, int data_hdl) {
+	LOCCBatch_t* b = &ctx->batch[data_hdl];
+	LOMSetOfData_t* p_dataSet = &ctx->set_data[data_hdl];
+	const char* pMsg = NULL;
+	uint32_t len = 0;
+	unsigned char* p;
+	uint8_t notify;
+	int ret = -1;
+
+	MSG_MUTEX_LOCK();
+	p = b->buf[b->cur] + b->len;
+	if (b->len + LOCC_BATCH_PAYLOAD_OFFSET < b->size) {
+		if (tbx_GetDateTimeStr(p_dataSet->timestamp, sizeof(p_dataSet->timestamp)) < 0) {
+			p_dataSet->timestamp[0] = 0;
+		}
+		pMsg = LO_msg_encode_data(0, (char*) p + LOCC_BATCH_PAYLOAD_OFFSET,
+				b->size - b->len - LOCC_BATCH_PAYLOAD_OFFSET, NULL, ctx->encoder, p_dataSet, &len);
+		p_dataSet->timestamp[0] = 0;
+	}
+	if (pMsg) {
+		/* Topic and fixed header just before the payload, then the packet is moved
+		 * just after the previous one (the remaining length is 1 to 4 bytes) */
+		int rem_len = (int) (LOCC_BATCH_PAYLOAD_OFFSET - LOCC_BATCH_HDR_MAX + len);
+		unsigned char* ptr = p + LOCC_BATCH_HDR_MAX;
+		MQTTString topic = MQTTString_initializer;
+		MQTTHeader header = { 0 };
+		unsigned char rem_buf[4];
+		int n = MQTTPacket_encode(rem_buf, rem_len);
+
+		topic.cstring = (char*) LOCC_BATCH_TOPIC;
+		writeMQTTString(&ptr, topic);
+		header.bits.type = PUBLISH;
+		ptr = p + LOCC_BATCH_HDR_MAX - 1 - n;
+		*ptr = header.byte;
+		memcpy(ptr + 1, rem_buf, n);
+		if (ptr != p) {
+			memmove(p, ptr, 1 + n + rem_len);
+		}
+
+		if (b->nb == 0) {
+			TimerInit(&b->deadline);
+			TimerCountdownMS(&b->deadline, b->max_latency_ms);
+		}
+		b->len += 1 + n + rem_len;
+		b->nb++;
+		/* Flush if the max number of samples is reached, or if a next sample of the same size does not fit */
+		if ((b->nb >= b->max_samples) || (b->size - b->len <= LOCC_BATCH_PAYLOAD_OFFSET + rem_len)) {
+			b->flush = 1;
+		}
+		notify = (b->nb == 1) || (b->flush);
+		ret = 0;
+	}
+	else {
+		LOTRACE_WARN("data_hdl=%d: batch full (%u samples, %"PRIu32" bytes), sample dropped", data_hdl, b->nb,
+				b->len);
+		b->flush = (b->nb) ? 1 : 0;
+		notify = b->flush;
+	}
+	MSG_MUTEX_UNLOCK();
+
+	if (notify) {
+		/* Flush, or new deadline to be taken into account */
+		LOCC_wakeup(ctx);
+	}
+	return ret;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Send the batch of the data set if a flush is requested or the deadline is reached */
+static int LOCC_batchFlush(LiveObjectsClient_Ctx* ctx, int data_hdl) {
+	LOCCBatch_t* b = &ctx->batch[data_hdl];
+	const unsigned char* buf = NULL;
+	uint32_t len = 0;
+	uint16_t nb = 0;
+	int rc;
+
+	MSG_MUTEX_LOCK();
+	if ((b->nb) && ((b->flush) || (TimerIsExpired(&b->deadline)))) {
+		/* Next samples in the other buffer */
+		buf = b->buf[b->cur];
+		len = b->len;
+		nb = b->nb;
+		b->cur ^= 1;
+		b->len = 0;
+		b->nb = 0;
+		b->flush = 0;
+	}
+	MSG_MUTEX_UNLOCK();
+
+	if (nb == 0) {
+		return 0;
+	}
+	LOTRACE_DBG1("data_hdl=%d: MQTTPublishPackets nb=%u len=%"PRIu32" ....", data_hdl, nb, len);
+	rc = MQTTPublishPackets(&ctx->mqtt_ctx, buf, (int) len);
+	if (rc) {
+		LOTRACE_ERR("data_hdl=%d: MQTTPublishPackets failed, rc=%d (%u samples lost)", data_hdl, rc, nb);
+	}
+	return rc;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOCC_processBatch(LiveObjectsClient_Ctx* ctx) {
+	int data_hdl;
+	for (data_hdl = 0; data_hdl < LOC_MAX_OF_DATA_SET; data_hdl++) {
+		if (ctx->batch[data_hdl].max_samples) {
+			LOCC_batchFlush(ctx, data_hdl);
+		}
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Return the min of left (-1: infinite) and the time before the next batch deadline */
+static int LOCC_batchTimeoutMs(LiveObjectsClient_Ctx* ctx, int left) {
+	int data_hdl;
+	for (data_hdl = 0; data_hdl < LOC_MAX_OF_DATA_SET; data_hdl++) {
+		LOCCBatch_t* b = &ctx->batch[data_hdl];
+		if (b->max_samples) {
+			int tmo = -1;
+			MSG_MUTEX_LOCK();
+			if (b->nb) {
+				tmo = (b->flush) ? 0 : TimerLeftMS(&b->deadline);
+				if (tmo < 0) {
+					tmo = 0;
+				}
+			}
+			MSG_MUTEX_UNLOCK();
+			if ((tmo >= 0) && ((left < 0) || (tmo < left))) {
+				left = tmo;
+			}
+		}
+	}
+	return left;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOCC_batchRelease(LOCCBatch_t* b) {
+	if (b->buf[0]) {
+		MEM_FREE(b->buf[0]);
+	}
+	memset(b, 0, sizeof(LOCCBatch_t));
+}
+#endif /* LOM_DATA_BATCH */
+
+#if LOM_MQUEUE
+#if LOC_MQTT_COALESCE
+/* Coalescing of the pending QoS 0 messages: the PUBLISH packets are serialized back-to-back
+ * in the MQTT send buffer (idle between two publications), and sent in one write, i.e. one
+ * SSL/TLS record and (mostly) one TCP segment instead of one per message. */
+typedef struct {
+	int len;                          /* Length of the serialized packets */
+	uint16_t nb;                      /* Number of packets */
+} LOCCCoalesce_t;
+
+/* --------------------------------------------------------------------------------- */
+/* Send the coalesced packets */
+static void LOCC_coalesceFlush(LiveObjectsClient_Ctx* ctx, LOCCCoalesce_t* co) {
+	if (co->nb == 0) {
+		return;
+	}
+	LOTRACE_DBG1("MQTTPublishPackets nb=%u len=%d ....", co->nb, co->len);
+	if (MQTTPublishPackets(&ctx->mqtt_ctx, ctx->mqtt_buffer_snd, co->len)) {
+		LOTRACE_ERR("MQTTPublishPackets failed (%u messages lost)", co->nb);
+	}
+	co->len = 0;
+	co->nb = 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Serialize a QoS 0 message after the coalesced packets (sent first if there is not enough room).
+ * Return -1 if the message is too large to be coalesced. */
+static int LOCC_coalesceAdd(LiveObjectsClient_Ctx* ctx, LOCCCoalesce_t* co, const char* topic_name,
+		const char* payload, uint32_t len) {
+	MQTTString topic = MQTTString_initializer;
+	int n;
+
+	topic.cstring = (char*) topic_name;
+	n = MQTTSerialize_publish(ctx->mqtt_buffer_snd + co->len, LOC_MQTT_DEF_SND_SZ - co->len, 0, QOS0, 0, 0,
+			topic, (unsigned char*) payload, (int) len);
+	if ((n <= 0) && (co->nb)) {
+		LOCC_coalesceFlush(ctx, co);
+		n = MQTTSerialize_publish(ctx->mqtt_buffer_snd, LOC_MQTT_DEF_SND_SZ, 0, QOS0, 0, 0,
+				topic, (unsigned char*) payload, (int) len);
+	}
+	if (n <= 0) {
+		return -1;
+	}
+	co->len += n;
+	co->nb++;
+	return 0;
+}
+#endif
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOCC_processPendingMesssage(LiveObjectsClient_Ctx* ctx) {
+	const char* p_msg;
+#if LOC_MQTT_COALESCE
+	LOCCCoalesce_t co = { 0, 0 };
+#endif
+	while ((p_msg = LOCC_mqGet(ctx)) != NULL) {
+		const char* topic;
+		const char* payload;
+		enum QoS qos;
+		uint32_t len;
+		payload = LOCC_mqDecode(p_msg, &topic, &qos, &len);
+		if (payload) {
+			LOTRACE_DBG1("Publish x%x t=%s qos=%d len=%"PRIu32" %p...", *p_msg, topic, qos, len, p_msg);
+#if LOC_MQTT_COALESCE
+			if ((qos != QOS0) || (LOCC_COALESCE_OFF(ctx)) || (LOCC_coalesceAdd(ctx, &co, topic, payload, len))) {
+				/* Sent after the coalesced packets (order kept) */
+				LOCC_coalesceFlush(ctx, &co);
+				LOCC_MqttPublishBin(ctx, qos, topic, payload, len);
+			}
+#else
+			LOCC_MqttPublishBin(ctx, qos, topic, payload, len);
+#endif
+		}
+		else {
+			LOTRACE_ERR("ERROR -  UNKNOW msg %p x%x", p_msg, *p_msg);
+		}
+		LOTRACE_DBG1("Free msg %p x%x", p_msg, *p_msg);
+		LO_msg_free(p_msg);
+		LOCC_mqSignal(ctx);
+	}
+#if LOC_MQTT_COALESCE
+	LOCC_coalesceFlush(ctx, &co);
+#endif
+}
+#endif
+
+#if LOC_FEATURE_JOURNAL
+/* --------------------------------------------------------------------------------- */
+/* Keep in the journal the 'collected data' published while disconnected */
+static int LOCC_journalData(LiveObjectsClient_Ctx* ctx, int data_hdl) {
+	const char* p_msg;
+	uint32_t len = 0;
+	char* buf = LO_journal_reserve(ctx->journal, "dev/data", LOM_JSON_BUF_SZ);
+	if (buf == NULL) {
+		return -1;
+	}
+	p_msg = LO_msg_encode_data(0, buf, LOM_JSON_BUF_SZ, NULL, ctx->encoder, &ctx->set_data[data_hdl], &len);
+	if (p_msg == NULL) {
+		LO_journal_commit(ctx->journal, NULL, 0);
+		LOTRACE_ERR("ERROR to encode data_hdl=%d", data_hdl);
+		return -1;
+	}
+	if (p_msg != buf) {
+		memmove(buf, p_msg, len);
+	}
+	LO_journal_commit(ctx->journal, buf, len);
+	LOTRACE_DBG1("data_hdl=%d: %"PRIu32" bytes kept in the journal", data_hdl, len);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Move the queued 'collected data' and user messages to the journal (not dropped on reconnection) */
+static void LOCC_journalSpill(LiveObjectsClient_Ctx* ctx) {
+#if LOM_MQUEUE
+	const char* p_msg;
+	while ((p_msg = LOCC_mqGet(ctx)) != NULL) {
+		const char* topic;
+		const char* payload;
+		enum QoS qos;
+		uint32_t len;
+		uint8_t type = *p_msg & ~LOM_MSG_BIN;
+		payload = LOCC_mqDecode(p_msg, &topic, &qos, &len);
+		if ((payload) && ((type == MTYPE_PUB_DATA) || (type == MTYPE_PUB_USR_MSG) || (type == MTYPE_PUB_USR_BIN))) {
+			if (LO_journal_append(ctx->journal, topic, payload, len)) {
+				LOTRACE_ERR("ERROR to keep msg %p x%x in the journal", p_msg, *p_msg);
+			}
+		}
+		LO_msg_free(p_msg);
+	}
+#endif
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Publish a message of the journal with QoS 1 (called by LO_journal_replay).
+ * The record is done when its PUBACK is received: now, or later with the in-flight window. */
+static int LOCC_journalPublish(void* user, const char* topic, const char* payload, uint32_t len, uint64_t token) {
+	LiveObjectsClient_Ctx* ctx = (LiveObjectsClient_Ctx*) user;
+	if (!ctx->state_connected) {
+		return -1;
+	}
+#if LOC_MQTT_INFLIGHT
+	if (ctx->inflight.window) {
+		ctx->journal_token = token;
+		return LOCC_inflightPublish(ctx, topic, payload, len);
+	}
+#endif
+	if (LOCC_MqttPublishBin(ctx, QOS1, topic, payload, len)) {
+		return -1;
+	}
+	LO_journal_ack(ctx->journal, token);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Replay the next messages of the journal: max LOC_JOURNAL_REPLAY_BURST messages,
+ * then wait to respect the max rate (if any) */
+static void LOCC_journalReplay(LiveObjectsClient_Ctx* ctx) {
+	uint32_t max_nb = LOC_JOURNAL_REPLAY_BURST;
+	int n;
+	if ((ctx->journal == NULL) || (!TimerIsExpired(&ctx->journal_timer))) {
+		return;
+	}
+	if ((ctx->journal_rate) && (ctx->journal_rate < max_nb)) {
+		max_nb = ctx->journal_rate;
+	}
+	n = LO_journal_replay(ctx->journal, max_nb, LOCC_journalPublish, ctx);
+	if (n > 0) {
+		LOTRACE_DBG1("%d messages of the journal replayed", n);
+		if (ctx->journal_rate) {
+			TimerCountdownMS(&ctx->journal_timer, (uint32_t) n * 1000 / ctx->journal_rate);
+		}
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Return the min of 'left' and the time (ms) before the next replay of the journal */
+static int LOCC_journalTimeoutMs(LiveObjectsClient_Ctx* ctx, int left) {
+	if ((ctx->journal) && (LO_journal_pending(ctx->journal))) {
+		int tmo = TimerLeftMS(&ctx->journal_timer);
+		if (tmo < 0) {
+			tmo = 0;
+		}
+		if ((left < 0) || (tmo < left)) {
+			left = tmo;
+		}
+	}
+	return left;
+}
+#endif /* LOC_FEATURE_JOURNAL */
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int LOCC_setStreamId(const LiveObjectsClient_Ctx* ctx, uint8_t stream_prefix, LOMSetOfData_t* p_dataSet,
+		const char* stream_id) {
+	if (stream_prefix == 1) {
+		int len = snprintf(p_dataSet->stream_id, sizeof(p_dataSet->stream_id) - 1, "urn:lo:nsid:%s:%s!%s",
+				ctx->dev_name_space, ctx->dev_id, stream_id);
+		if (len > 0) {
+			p_dataSet->stream_id[len] = 0;
+		}
+	}
+	else if (stream_prefix == 2) {
+		int len = snprintf(p_dataSet->stream_id, sizeof(p_dataSet->stream_id) - 1, "%s:%s!%s", ctx->dev_name_space,
+				ctx->dev_id, stream_id);
+		if (len > 0)
+			p_dataSet->stream_id[len] = 0;
+	}
+	else {
+		size_t len = strlen(stream_id);
+		memset(p_dataSet->stream_id, 0, sizeof(p_dataSet->stream_id));
+		memcpy(p_dataSet->stream_id, stream_id,
+				len < sizeof(p_dataSet->stream_id) ? len : sizeof(p_dataSet->stream_id));
+		p_dataSet->stream_id[sizeof(p_dataSet->stream_id) - 1] = 0;
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOCC_controlFeature(LiveObjectsClient_Ctx* ctx, uint8_t* enable_ptr, int topic_num) {
+	int ret;
+	if (*enable_ptr == 0x01) {
+		LOTRACE_INF("LOCC_controlFeature: ENABLE topic_num=%d", topic_num);
+		ret = LOCC_SubscibeTopic(ctx, topic_num);
+		if (ret == 0) {
+			LOTRACE_NOTICE("LOCC_controlFeature: OK to enable topic_num=%d", topic_num);
+			*enable_ptr = 0x11;
+		}
+	}
+	else if (*enable_ptr == 0x10) {
+		LOTRACE_NOTICE("LOCC_controlFeature: DISABLE topic_num=%d", topic_num);
+		ret = LOCC_UnsubscibeTopic(ctx, topic_num);
+		if (ret == 0) {
+			*enable_ptr = 0x00;
+		}
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOCC_connectInit(LiveObjectsClient_Ctx* ctx, uint8_t mode) {
+	ctx->cfg_first = 1;
+	if (mode == 0) {
+		ctx->topic_subscribed[TOPIC_CFG_UPD] = 0;
+		ctx->topic_subscribed[TOPIC_COMMAND] = 0;
+		ctx->topic_subscribed[TOPIC_RSC_UPD] = 0;
+
+#if LOC_FEATURE_LO_PARAMS
+		ctx->set_updated_params.cid = 0;
+		ctx->set_updated_params.nb_of_params = 0;
+#endif
+#if LOC_FEATURE_JOURNAL
+		if (ctx->journal) {
+			LOCC_journalSpill(ctx);
+		}
+#endif
+#if LOM_MQUEUE
+		LOCC_mqPurge(ctx);
+#endif /* LOM_MQUEUE */
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Random number for the jitter of the reconnection delays (xorshift32) */
+static uint32_t LOCC_reconnectRandom(LiveObjectsClient_Ctx* ctx) {
+	uint32_t x = ctx->reconnect_rnd;
+	if (x == 0) {
+		/* Seeded by the device identity, so that the devices don't draw the same delays */
+		const char* p;
+		x = 2166136261U;
+		for (p = ctx->dev_id; *p; p++) {
+			x = (x ^ (uint8_t) *p) * 16777619U;
+		}
+		x ^= (uint32_t) ctx->apikey_p2 ^ (uint32_t) (uintptr_t) ctx;
+		if (x == 0) {
+			x = 1;
+		}
+	}
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	ctx->reconnect_rnd = x;
+	return x;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Compute the delay before the next connection attempt, according to the reconnection policy
+ * and to the error of the last attempt. No error: the session has been lost. Only the first retry
+ * after a stable session is not delayed by the backoff, a short session counts as a failed attempt. */
+static uint32_t LOCC_reconnectDelay(LiveObjectsClient_Ctx* ctx) {
+	const LiveObjectsD_ReconnectPolicy_t* policy = &ctx->reconnect;
+	LiveObjectsD_ReconnectInfo_t* info = &ctx->reconnect_info;
+	uint64_t window;
+	uint32_t delay;
+	uint32_t n;
+
+	if (info->error == LOD_CONN_ERR_NONE) {
+		info->error = LOD_CONN_ERR_LOST;
+		info->rc = 0;
+		if (TimerIsExpired(&ctx->reconnect_stable)) {
+			info->attempt = 0;
+			info->delay_ms = policy->first_ms;
+			return info->delay_ms;
+		}
+	}
+
+	if (info->attempt < UINT32_MAX) {
+		info->attempt++;
+	}
+
+	/* Full jitter: random delay in [0, min(cap, base * 2^(attempt-1))] */
+	window = policy->base_ms;
+	for (n = 1; (n < info->attempt) && (window < policy->cap_ms); n++) {
+		window <<= 1;
+	}
+	if (window > policy->cap_ms) {
+		window = policy->cap_ms;
+	}
+	delay = (window) ? (uint32_t) (LOCC_reconnectRandom(ctx) % (window + 1)) : 0;
+
+	if ((info->error == LOD_CONN_ERR_REFUSED) && (delay < policy->refused_ms)) {
+		/* Will not be accepted before a change of the configuration (device or platform) */
+		delay = policy->refused_ms;
+	}
+	else if ((info->error == LOD_CONN_ERR_TLS) && (delay < policy->base_ms)) {
+		/* Don't hammer the server with (costly) handshakes */
+		delay = policy->base_ms;
+	}
+	info->delay_ms = delay;
+	return delay;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Wait before the next connection attempt (stopped by LiveObjectsClient_StopEx) */
+static void LOCC_reconnectWait(LiveObjectsClient_Ctx* ctx, LiveObjectsD_CallbackState_t callback) {
+	uint32_t delay = LOCC_reconnectDelay(ctx);
+
+	LOTRACE_NOTICE("WAIT %"PRIu32" ms (error=%d rc=%d attempt=%"PRIu32") ...", delay, ctx->reconnect_info.error,
+			ctx->reconnect_info.rc, ctx->reconnect_info.attempt);
+	if (delay == 0) {
+		return;
+	}
+	if (callback) {
+		callback(CSTATE_WAITING);
+	}
+	while ((delay > 0) && (ctx->state_run > 0)) {
+		uint32_t dt = (delay < LOCC_POLL_PERIOD_MS) ? delay : LOCC_POLL_PERIOD_MS;
+		WAIT_MS(dt);
+		delay -= dt;
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Class of the error of the network (or SSL/TLS) connection, for the reconnection policy */
+static void LOCC_connectNetwError(LiveObjectsClient_Ctx* ctx, int rc) {
+	LOTRACE_ERR("Connection failed, rc=%d", rc);
+	ctx->reconnect_info.error = (rc == NETW_CONN_ERR_DNS) ? LOD_CONN_ERR_DNS :
+			(rc == NETW_CONN_ERR_TLS) ? LOD_CONN_ERR_TLS : LOD_CONN_ERR_TCP;
+	ctx->reconnect_info.rc = rc;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Result of the MQTT connection (see LOCC_MqttConnectResult), for the reconnection policy */
+static int LOCC_connectMqttDone(LiveObjectsClient_Ctx* ctx, int rc) {
+	if (rc) {
+		LOTRACE_ERR("MqttConnect failed, rc=%d", rc);
+		/* CONNACK 3 (server unavailable) is transient, the other refusals are not */
+		ctx->reconnect_info.error = ((rc > 0) && (rc != 3)) ? LOD_CONN_ERR_REFUSED : LOD_CONN_ERR_MQTT;
+		ctx->reconnect_info.rc = rc;
+		return rc;
+	}
+	/* Keep the number of attempts until the session is stable */
+	ctx->reconnect_info.error = LOD_CONN_ERR_NONE;
+	ctx->reconnect_info.rc = 0;
+	ctx->reconnect_info.delay_ms = 0;
+	TimerCountdownMS(&ctx->reconnect_stable, ctx->reconnect.stable_ms);
+#if LOC_MQTT_INFLIGHT
+	LOCC_inflightResend(ctx);
+#endif
+
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* MQTT connection, once the network (and SSL/TLS) connection is established. Without 'wait',
+ * only send the CONNECT packet: the CONNACK is read by LOCC_sessionConnack() */
+static int LOCC_connectMqtt(LiveObjectsClient_Ctx* ctx, uint8_t wait) {
+	int rc;
+
+#if LOC_MQTT_INFLIGHT
+	ctx->mqtt_ctx.pubackHandler = (ctx->inflight.window) ? LOCC_inflightAck : NULL;
+#endif
+	rc = LOCC_MqttConnect(ctx, wait);
+	if ((rc == 0) && (!wait)) {
+		return 0;
+	}
+	return LOCC_connectMqttDone(ctx, rc);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int LOCC_connectStart(LiveObjectsClient_Ctx* ctx) {
+	int rc;
+
+	rc = netw_connect(&ctx->netw, &_LOClient_params_connect);
+	if (rc) {
+		LOCC_connectNetwError(ctx, rc);
+		return rc;
+	}
+	return LOCC_connectMqtt(ctx, 1);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOCC_connectOK(LiveObjectsClient_Ctx* ctx) {
+	int ret;
+#if LOC_FEATURE_LO_STATUS  && (LOC_MAX_OF_DATA_SET > 0)
+	LOTRACE_DBG1("Device Status ....");
+	ret = LOCC_processStatus(ctx, 1);
+	LOTRACE_DBG1("Device Status, ret=%d", ret);
+#endif
+
+#if LOC_FEATURE_LO_RESOURCES
+	LOTRACE_DBG1("Device Resources ....");
+	ret = LOCC_processResources(ctx, 1);
+	LOTRACE_DBG1("Device Resources, ret=%d", ret);
+#endif
+
+#if LOC_FEATURE_LO_PARAMS_1
+	LOTRACE_DBG1("Device Config ....");
+	ret = LOCC_processConfig(ctx);
+	LOTRACE_DBG1("Device Config, ret=%d", ret);
+#endif
+
+#if LOC_FEATURE_LO_RESOURCES
+	if (ctx->set_rsc.rsc_ptr) {
+		LOTRACE_DBG1("Subcribe TOPIC_RSC_UPD=%d....", TOPIC_RSC_UPD);
+		ret = LOCC_SubscibeTopic(ctx, TOPIC_RSC_UPD);
+		LOTRACE_DBG1("Subcribe TOPIC_RSC_UPD, ret=%d", ret);
+	}
+#endif
+	(void)ret;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Process all pending requests to be published (pending messages, config, status, data, resources) */
+static void LOCC_processOutgoing(LiveObjectsClient_Ctx* ctx) {
+	int ret = 0;
+
+	/*  -- Pending user messages ? (command responses, ...) */
+#if LOM_MQUEUE
+	LOCC_processPendingMesssage(ctx);
+#endif
+
+#if LOC_FEATURE_JOURNAL
+	/*  -- Messages published while disconnected ? */
+	LOCC_journalReplay(ctx);
+#endif
+
+#if LOC_FEATURE_LO_PARAMS
+	/*  -- Config Parameters ? */
+	ret = LOCC_processConfig(ctx);
+#endif
+
+#if LOM_PUSH_ASYNC || LOM_STATUS_DELTA
+#if LOC_FEATURE_LO_STATUS  && (LOC_MAX_OF_DATA_SET > 0)
+	/*  -- 'Info' ? */
+	ret = LOCC_processStatus(ctx, 0);
+#endif
+#endif
+#if LOM_PUSH_ASYNC
+#if LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
+	/*  -- 'Collected data' ? */
+	ret = LOCC_processData(ctx, 0);
+#endif
+#endif /* LOM_PUSH_ASYNC */
+
+#if LOM_DATA_BATCH && LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
+	/*  -- Batches of 'collected data' to be flushed ? */
+	LOCC_processBatch(ctx);
+#endif
+
+#if LOC_FEATURE_LO_RESOURCES
+	LOCC_processResources(ctx, 0);
+
+	LOCC_processGetRsc(ctx);
+#endif
+	(void)ret;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Enable/disable the features (subscribe/unsubscribe topics) */
+static void LOCC_processControl(LiveObjectsClient_Ctx* ctx) {
+#if LOC_FEATURE_LO_COMMANDS
+	LOCC_controlFeature(ctx, &ctx->set_cmd.cmd_enable, TOPIC_COMMAND);
+#endif
+#if LOC_FEATURE_LO_RESOURCES
+	LOCC_controlFeature(ctx, &ctx->set_rsc.rsc_enable, TOPIC_RSC_UPD);
+#endif
+	(void)ctx;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Return the max time (ms) to wait for an event before processing the instance,
+ * or -1 if there is no timer (only network data or a wakeup). */
+static int LOCC_nextTimeoutMs(LiveObjectsClient_Ctx* ctx) {
+	int left;
+#if LOC_FEATURE_LO_RESOURCES
+	if ((ctx->set_updated_rsc.ursc_cid) && (ctx->set_updated_rsc.ursc_obj_ptr)) {
+		/* Resource transfer in progress: no wait */
+		return 0;
+	}
+#endif
+#if LOC_FEATURE_WAKEUP
+	left = (ctx->wakeup_ok) ? -1 : LOCC_POLL_PERIOD_MS;
+#else
+	/* Requests of the other threads are checked periodically */
+	left = LOCC_POLL_PERIOD_MS;
+#endif
+	if ((ctx->state_connected) && (ctx->mqtt_ctx.keepAliveInterval)) {
+		int ka = TimerLeftMS(&ctx->mqtt_ctx.ping_timer);
+		if (ka < 0) {
+			ka = 0;
+		}
+		if ((left < 0) || (ka < left)) {
+			left = ka;
+		}
+	}
+#if LOM_DATA_BATCH && LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
+	left = LOCC_batchTimeoutMs(ctx, left);
+#endif
+#if LOC_FEATURE_JOURNAL
+	left = LOCC_journalTimeoutMs(ctx, left);
+#endif
+	return left;
+}
+
+#if LOC_FEATURE_EVLOOP || LOC_FEATURE_WAKEUP
+/* --------------------------------------------------------------------------------- */
+/* Read all the available MQTT packets (readable != 0), or only send a keepalive if needed */
+static int LOCC_readOrKeepalive(LiveObjectsClient_Ctx* ctx, uint8_t readable) {
+	int ret;
+	if (readable) {
+		/* Only the packets already received (including the bytes buffered by TLS): never wait for
+		 * the next one, the caller waits for the socket to be readable. Stop when nothing is read. */
+		do {
+			ret = MQTTCycle(&ctx->mqtt_ctx, LOCC_PACKET_TMO_MS);
+		} while ((ret >= CONNECT) && (ret <= DISCONNECT) && (!netw_isLost(&ctx->netw))
+				&& (netw_readable(&ctx->netw)));
+	}
+	else {
+		MQTTKeepalive(&ctx->mqtt_ctx);
+	}
+	if (netw_isLost(&ctx->netw)) {
+		LOTRACE_NOTICE("LOST !!");
+		netw_disconnect(&ctx->netw, 0);
+		ctx->state_connected = 0;
+		return -1;
+	}
+	return 0;
+}
+#endif
+
+/* --------------------------------------------------------------------------------- */
+/* Wait (max timeout_ms) for network data or a wakeup, then read the received MQTT packets */
+static int LOCC_waitAndRead(LiveObjectsClient_Ctx* ctx, int timeout_ms) {
+#if LOC_FEATURE_WAKEUP
+	struct pollfd fds[2];
+	int tmo;
+	int n;
+
+	fds[0].fd = netw_getFd(&ctx->netw);
+	if ((!ctx->wakeup_ok) || (fds[0].fd < 0)) {
+		return LiveObjectsClient_YieldEx(ctx, (timeout_ms < 0) ? LOCC_POLL_PERIOD_MS : timeout_ms);
+	}
+	if (netw_pending(&ctx->netw) > 0) {
+		return LOCC_readOrKeepalive(ctx, 1);
+	}
+
+	tmo = LOCC_nextTimeoutMs(ctx);
+	if ((timeout_ms >= 0) && ((tmo < 0) || (timeout_ms < tmo))) {
+		tmo = timeout_ms;
+	}
+
+	fds[0].events = POLLIN;
+	fds[1].fd = ctx->wakeup_fd;
+	fds[1].events = POLLIN;
+	n = poll(fds, 2, tmo);
+	if (n < 0) {
+		if (errno != EINTR) {
+			LOTRACE_ERR("poll failed, errno=%d", errno);
+		}
+		return 0;
 	}
-	return rc;
-}
+	if (fds[1].revents) {
+		LOCC_wakeupDrain(ctx);
+	}
+	return LOCC_readOrKeepalive(ctx, (fds[0].revents) ? 1 : 0);
+#else
+	return LiveObjectsClient_YieldEx(ctx, (timeout_ms < 0) ? LOCC_POLL_PERIOD_MS : timeout_ms);
 #endif
+}
+
+#if LOC_FEATURE_EVLOOP
+/* ================================================================================= */
+/* Event loop interface (see loc_core.h)
+ * -------------------------------------
+ */
 
 /* --------------------------------------------------------------------------------- */
-/*  */
-#if LOM_MQUEUE
-static void LOCC_processPendingMesssage() {
-	const char* p_msg;
-	while ((p_msg = LOCC_mqGet()) != NULL) {
-		if (*p_msg == MTYPE_PUB_DATA) {
-			LOTRACE_DBG1("Publish DATA  %p...", p_msg);
-			LOCC_MqttPublish(QOS0, "dev/data", p_msg + 1);
-		}
-		else if (*p_msg == MTYPE_PUB_CMD_RSP) {
-			LOTRACE_INF("Publish Command Response %p...", p_msg);
-			LOCC_MqttPublish(QOS0, "dev/cmd/res", p_msg + 1);
-		}
-		else if (*p_msg == MTYPE_PUB_STATUS) {
-			LOTRACE_INF("Publish STATUS  %p...", p_msg);
-			LOCC_MqttPublish(QOS0, "dev/info", p_msg + 1);
-		}
-		else if (*p_msg == MTYPE_PUB_PARAM) {
-			LOTRACE_INF("Publish PARAMS  %p...", p_msg);
-			LOCC_MqttPublish(QOS0, "dev/cfg", p_msg + 1);
-		}
-		else if (*p_msg == MTYPE_PUB_RSC) {
-			LOTRACE_INF("Publish RESOURCES  %p...", p_msg);
-			LOCC_MqttPublish(QOS0, "dev/rsc", p_msg + 1);
-		}
-		else if (*p_msg == MTYPE_PUB_USR_MSG) {
-			const char* pc = p_msg + 1;
-			short tlen;
-			memcpy((char*) &tlen, pc, 2);
-			if (tlen > 0) {
-				pc += 2;
-				LOTRACE_INF("Publish t=%s msg='%s' ...", pc, pc + tlen + 1);
-				LOCC_MqttPublish(QOS0, pc, pc + tlen + 1);
-			}
-		}
-		else {
-			LOTRACE_ERR("ERROR -  UNKNOW msg %p x%x", p_msg, *p_msg);
+/* Result of a step of the network connection: TCP connection or handshake in progress, or
+ * connected (then send the MQTT CONNECT packet, the CONNACK is read when the socket is readable) */
+static int LOCC_sessionConnectDone(LiveObjectsClient_Ctx* ctx, int rc) {
+	if (rc == NETW_CONN_WANT_READ) {
+		return LOCC_SESSION_WANT_READ;
+	}
+	if (rc == NETW_CONN_WANT_WRITE) {
+		return LOCC_SESSION_WANT_WRITE;
+	}
+	if (rc) {
+		LOCC_connectNetwError(ctx, rc);
+	}
+	else {
+		rc = LOCC_connectMqtt(ctx, 0);
+		if (rc == 0) {
+			ctx->connack_wait = 1;
+			return LOCC_SESSION_WANT_READ;
 		}
-		LOTRACE_DBG1("MEM_FREE msg %p x%x", p_msg, *p_msg);
-		MEM_FREE(p_msg);
 	}
+	LOTRACE_INF("ctx=%p: connection failed, rc=%d", ctx, rc);
+	return -1;
 }
-#endif
+
 /* --------------------------------------------------------------------------------- */
-/*  */
-static int LOCC_setStreamId(uint8_t stream_prefix, LOMSetOfData_t* p_dataSet, const char* stream_id) {
-	if (stream_prefix == 1) {
-		int len = snprintf(p_dataSet->stream_id, sizeof(p_dataSet->stream_id) - 1, "urn:lo:nsid:%s:%s!%s",
-				_LOClient_dev_name_space, _LOClient_dev_id, stream_id);
-		if (len > 0) {
-			p_dataSet->stream_id[len] = 0;
-		}
-	}
-	else if (stream_prefix == 2) {
-		int len = snprintf(p_dataSet->stream_id, sizeof(p_dataSet->stream_id) - 1, "%s:%s!%s", _LOClient_dev_name_space,
-				_LOClient_dev_id, stream_id);
-		if (len > 0)
-			p_dataSet->stream_id[len] = 0;
+/* The socket is readable while waiting for the CONNACK: MQTT connection and initial messages */
+static int LOCC_sessionConnack(LiveObjectsClient_Ctx* ctx) {
+	int rc;
+
+	if (!netw_readable(&ctx->netw)) {
+		return LOCC_SESSION_WANT_READ;
 	}
-	else {
-		size_t len = strlen(stream_id);
-		memset(p_dataSet->stream_id, 0, sizeof(p_dataSet->stream_id));
-		memcpy(p_dataSet->stream_id, stream_id,
-				len < sizeof(p_dataSet->stream_id) ? len : sizeof(p_dataSet->stream_id));
-		p_dataSet->stream_id[sizeof(p_dataSet->stream_id) - 1] = 0;
+	ctx->connack_wait = 0;
+	rc = LOCC_connectMqttDone(ctx, LOCC_MqttConnack(ctx));
+	if (rc) {
+		LOTRACE_INF("ctx=%p: connection failed, rc=%d", ctx, rc);
+		return -1;
 	}
+	LOCC_connectOK(ctx);
 	return 0;
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-static void LOCC_controlFeature(uint8_t* enable_ptr, int topic_num) {
-	int ret;
-	if (*enable_ptr == 0x01) {
-		LOTRACE_INF("LOCC_controlFeature: ENABLE topic_num=%d", topic_num);
-		ret = LOCC_SubscibeTopic(topic_num);
-		if (ret == 0) {
-			LOTRACE_NOTICE("LOCC_controlFeature: OK to enable topic_num=%d", topic_num);
-			*enable_ptr = 0x11;
-		}
-	}
-	else if (*enable_ptr == 0x10) {
-		LOTRACE_NOTICE("LOCC_controlFeature: DISABLE topic_num=%d", topic_num);
-		ret = LOCC_UnsubscibeTopic(topic_num);
-		if (ret == 0) {
-			*enable_ptr = 0x00;
-		}
-	}
+int LOCC_sessionConnectStart(LiveObjectsClient_Ctx* ctx) {
+	LOCC_connectInit(ctx, 0);
+	ctx->connack_wait = 0;
+	return LOCC_sessionConnectDone(ctx, netw_connectStart(&ctx->netw, &_LOClient_params_connect, 1));
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-static void LOCC_connectInit(uint8_t mode) {
-	_LOClient_cfg_first = 1;
-	if (mode == 0) {
-		_LOClient_TopicSub[TOPIC_CFG_UPD].subscribed = 0;
-		_LOClient_TopicSub[TOPIC_COMMAND].subscribed = 0;
-		_LOClient_TopicSub[TOPIC_RSC_UPD].subscribed = 0;
+int LOCC_sessionConnectStep(LiveObjectsClient_Ctx* ctx) {
+	if (ctx->connack_wait) {
+		return LOCC_sessionConnack(ctx);
+	}
+	return LOCC_sessionConnectDone(ctx, netw_connectStep(&ctx->netw));
+}
 
-#if LOC_FEATURE_LO_PARAMS
-		memset(&_LOClient_Set_UpdatedParams, 0, sizeof(_LOClient_Set_UpdatedParams));
-#endif
-#if LOM_MQUEUE
-		LOCC_mqPurge();
-#endif /* LOM_MQUEUE */
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LOCC_sessionConnectAbort(LiveObjectsClient_Ctx* ctx) {
+	if (ctx->connack_wait) {
+		LOTRACE_ERR("ctx=%p: CONNACK timeout", ctx);
+		ctx->reconnect_info.error = LOD_CONN_ERR_MQTT;
+		ctx->reconnect_info.rc = -1;
+	}
+	else if (ctx->netw.tcp_wait) {
+		LOTRACE_ERR("ctx=%p: TCP connection timeout", ctx);
+		ctx->reconnect_info.error = LOD_CONN_ERR_TCP;
+		ctx->reconnect_info.rc = NETW_CONN_ERR_TCP;
+	}
+	else {
+		LOTRACE_ERR("ctx=%p: SSL/TLS handshake timeout", ctx);
+		ctx->reconnect_info.error = LOD_CONN_ERR_TLS;
+		ctx->reconnect_info.rc = NETW_CONN_ERR_TLS;
 	}
+	ctx->connack_wait = 0;
+	netw_disconnect(&ctx->netw, 0);
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-static int LOCC_connectStart(void) {
-	int rc;
+uint32_t LOCC_sessionReconnectMs(LiveObjectsClient_Ctx* ctx) {
+	return LOCC_reconnectDelay(ctx);
+}
 
-	rc = netw_connect(&_LOClient_MQTTClient_network, &_LOClient_params_connect);
-	if (rc) {
-		LOTRACE_ERR("Connection failed, rc=%d", rc);
-		return rc;
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LOCC_sessionCycle(LiveObjectsClient_Ctx* ctx, uint8_t readable) {
+	int ret;
+
+	if (!ctx->state_connected) {
+		return -1;
 	}
 
-	rc = LOCC_MqttConnect();
-	if (rc) {
-		LOTRACE_ERR("MqttConnect failed, rc=%d", rc);
-		return rc;
+	LOCC_processOutgoing(ctx);
+
+	ret = LOCC_readOrKeepalive(ctx, readable);
+	if (ret) {
+		LOTRACE_NOTICE("ctx=%p: ret=%d => Device Disconnecting ...", ctx, ret);
+		LiveObjectsClient_DisconnectEx(ctx);
+		return -1;
 	}
 
+	LOCC_processControl(ctx);
 	return 0;
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-static void LOCC_connectOK(void) {
-	int ret;
-#if LOC_FEATURE_LO_STATUS  && (LOC_MAX_OF_DATA_SET > 0)
-	LOTRACE_DBG1("Device Status ....");
-	ret = LOCC_processStatus(1);
-	LOTRACE_DBG1("Device Status, ret=%d", ret);
-#endif
+uint8_t LOCC_sessionIsConnected(const LiveObjectsClient_Ctx* ctx) {
+	return ctx->state_connected;
+}
 
-#if LOC_FEATURE_LO_RESOURCES
-	LOTRACE_DBG1("Device Resources ....");
-	ret = LOCC_processResources(1);
-	LOTRACE_DBG1("Device Resources, ret=%d", ret);
-#endif
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LOCC_sessionGetFd(LiveObjectsClient_Ctx* ctx) {
+	return netw_getFd(&ctx->netw);
+}
 
-#if LOC_FEATURE_LO_PARAMS_1
-	LOTRACE_DBG1("Device Config ....");
-	ret = LOCC_processConfig();
-	LOTRACE_DBG1("Device Config, ret=%d", ret);
-#endif
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LOCC_sessionTimeoutMs(LiveObjectsClient_Ctx* ctx) {
+	return LOCC_nextTimeoutMs(ctx);
+}
 
-#if LOC_FEATURE_LO_RESOURCES
-	if (_LOClient_Set_Rsc.rsc_ptr) {
-		LOTRACE_DBG1("Subcribe TOPIC_RSC_UPD=%d....", TOPIC_RSC_UPD);
-		ret = LOCC_SubscibeTopic(TOPIC_RSC_UPD);
-		LOTRACE_DBG1("Subcribe TOPIC_RSC_UPD, ret=%d", ret);
-	}
-#endif
-	(void)ret;
+#if LOC_FEATURE_WAKEUP
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LOCC_sessionGetWakeupFd(LiveObjectsClient_Ctx* ctx) {
+	return (ctx->wakeup_ok) ? ctx->wakeup_fd : -1;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LOCC_sessionWakeupDrain(LiveObjectsClient_Ctx* ctx) {
+	LOCC_wakeupDrain(ctx);
 }
+#endif /* LOC_FEATURE_WAKEUP */
+#endif /* LOC_FEATURE_EVLOOP */
 
 /* ================================================================================= */
 /* Public Functions : services provided to upper application
@@ -1105,14 +2998,85 @@ int LiveObjectsClient_CheckApiKey(const char* apikey) {
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_Init(void* net_iface_handler, unsigned long long apikey_p1_, unsigned long long apikey_p2_) {
+LiveObjectsClient_Ctx* LiveObjectsClient_CtxCreate(void) {
+	LiveObjectsClient_Ctx* ctx = (LiveObjectsClient_Ctx*) MEM_ALLOC(sizeof(LiveObjectsClient_Ctx));
+	if (ctx == NULL) {
+		LOTRACE_ERR("MEM_ALLOC ERROR (len=%u)", (unsigned int) sizeof(LiveObjectsClient_Ctx));
+		return NULL;
+	}
+	memset(ctx, 0, sizeof(LiveObjectsClient_Ctx));
+	ctx->allocated = 1;
+	LOTRACE_DBG1("ctx=%p", ctx);
+	return ctx;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_CtxDestroy(LiveObjectsClient_Ctx* ctx) {
+	if ((ctx == NULL) || (!ctx->allocated)) {
+		LOTRACE_ERR("ERROR - Invalid context %p", ctx);
+		return -1;
+	}
+	if (ctx->state_run > 0) {
+		LOTRACE_ERR("ERROR - ctx=%p is running", ctx);
+		return -1;
+	}
+	if (ctx->state_connected) {
+		LiveObjectsClient_DisconnectEx(ctx);
+	}
+#if LOC_FEATURE_LO_RESOURCES
+	if (_LOClient_wget_owner == ctx) {
+		LO_wget_close();
+		_LOClient_wget_owner = NULL;
+	}
+#endif
+	netw_tls_destroy(&ctx->netw);
+#if LOM_MQUEUE
+	LOCC_mqRelease(ctx);
+#endif
+#if LOM_DATA_BATCH && LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
+	{
+		int data_hdl;
+		for (data_hdl = 0; data_hdl < LOC_MAX_OF_DATA_SET; data_hdl++) {
+			LOCC_batchRelease(&ctx->batch[data_hdl]);
+		}
+	}
+#endif
+#if LOC_MQTT_INFLIGHT
+	LOCC_inflightRelease(ctx);
+#endif
+#if LOC_FEATURE_JOURNAL
+	LO_journal_close(ctx->journal);
+#endif
+#if LOC_FEATURE_LO_PARAMS
+	LOCC_paramsFree(ctx);
+#endif
+#if LOC_FEATURE_LO_COMMANDS
+	LO_msg_index_free(&ctx->set_cmd.cmd_index);
+#endif
+	LOCC_wakeupClose(ctx);
+	LOTRACE_DBG1("ctx=%p", ctx);
+	MEM_FREE(ctx);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+LiveObjectsClient_Ctx* LiveObjectsClient_CtxDefault(void) {
+	return &_LOClient_ctx;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_InitEx(LiveObjectsClient_Ctx* ctx, void* net_iface_handler, unsigned long long apikey_p1,
+		unsigned long long apikey_p2) {
 	int rc;
 	char tmpApikey[APIKEY_LENGTH];
 
-	apikey_p1 = apikey_p1_;
-	apikey_p2 = apikey_p2_;
+	ctx->apikey_p1 = apikey_p1;
+	ctx->apikey_p2 = apikey_p2;
 
-	rc = apikeyconv(tmpApikey, APIKEY_LENGTH);
+	rc = apikeyconv(ctx, tmpApikey, APIKEY_LENGTH);
 
 	if (rc == -1) {
 		LOTRACE_ERR("Apikeyconv failed, rc= %d", rc);
@@ -1124,43 +3088,61 @@ int LiveObjectsClient_Init(void* net_iface_handler, unsigned long long apikey_p1
 		return -1;
 	}
 
-	LO_sys_init();
+	if (!_LOClient_sys_init_done) {
+		LO_sys_init();
+		_LOClient_sys_init_done = 1;
+	}
 
 #if LOM_MQUEUE
-	LOCC_mqInit();
+	if (LOCC_mqInit(ctx)) {
+		return -1;
+	}
 #endif
+	LOCC_wakeupInit(ctx);
 
 #if LOC_FEATURE_LO_STATUS  && (LOC_MAX_OF_DATA_SET > 0)
-	memset(&_LOClient_Set_Status, 0, sizeof(_LOClient_Set_Status));
+	memset(&ctx->set_status, 0, sizeof(ctx->set_status));
 #endif
 #if LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
-	memset(&_LOClient_Set_Data, 0, sizeof(_LOClient_Set_Data));
+	memset(&ctx->set_data, 0, sizeof(ctx->set_data));
 #endif
 #if LOC_FEATURE_LO_PARAMS
-	memset(&_LOClient_Set_Params, 0, sizeof(_LOClient_Set_Params));
-	memset(&_LOClient_Set_UpdatedParams, 0, sizeof(_LOClient_Set_UpdatedParams));
+	LOCC_paramsFree(ctx);
+	memset(&ctx->set_params, 0, sizeof(ctx->set_params));
+	memset(&ctx->set_updated_params, 0, sizeof(ctx->set_updated_params));
 #endif
 #if LOC_FEATURE_LO_COMMANDS
-	memset(&_LOClient_Set_Cmd, 0, sizeof(_LOClient_Set_Cmd));
+	LO_msg_index_free(&ctx->set_cmd.cmd_index);
+	memset(&ctx->set_cmd, 0, sizeof(ctx->set_cmd));
 #endif
 #if LOC_FEATURE_LO_RESOURCES
-	memset(&_LOClient_Set_Rsc, 0, sizeof(_LOClient_Set_Rsc));
-	memset(&_LOClient_Set_UpdatedRsc, 0, sizeof(_LOClient_Set_UpdatedRsc));
+	memset(&ctx->set_rsc, 0, sizeof(ctx->set_rsc));
+	memset(&ctx->set_updated_rsc, 0, sizeof(ctx->set_updated_rsc));
 #endif
 
-	rc = netw_init(&_LOClient_MQTTClient_network, net_iface_handler);
+	ctx->reconnect.first_ms = LOC_RECONNECT_FIRST_MS;
+	ctx->reconnect.base_ms = LOC_RECONNECT_BASE_MS;
+	ctx->reconnect.cap_ms = LOC_RECONNECT_CAP_MS;
+	ctx->reconnect.refused_ms = LOC_RECONNECT_REFUSED_MS;
+	ctx->reconnect.stable_ms = LOC_RECONNECT_STABLE_MS;
+	memset(&ctx->reconnect_info, 0, sizeof(ctx->reconnect_info));
+	TimerInit(&ctx->reconnect_stable);
+	ctx->reconnect_rnd = 0;
+
+	rc = netw_init(&ctx->netw, net_iface_handler);
 	if (rc) {
 		LOTRACE_ERR("Error to initialize the network wrapper, rc=%d", rc);
 		return rc;
 	}
 
-	MQTTClientInit(&_LOClient_mqtt_ctx, &_LOClient_MQTTClient_network,
+	MQTTClientInit(&ctx->mqtt_ctx, &ctx->netw.net,
 			LOC_MQTT_DEF_COMMAND_TIMEOUT,
-			_LOClient_mqtt_buffer_snd, LOC_MQTT_DEF_SND_SZ,
-			_LOClient_mqtt_buffer_rcv, LOC_MQTT_DEF_RCV_SZ);
+			ctx->mqtt_buffer_snd, LOC_MQTT_DEF_SND_SZ,
+			ctx->mqtt_buffer_rcv, LOC_MQTT_DEF_RCV_SZ);
+	ctx->mqtt_ctx.mqttwritev = netw_mqtt_writev;
 
 #if SECURITY_ENABLED && ((LOC_SERV_PORT  == 1884) || (LOC_SERV_PORT  == 8883))
-	rc = LOCC_EnableTLS();
+	rc = LOCC_EnableTLS(ctx);
 	if (rc) {
 		return rc;
 	}
@@ -1173,37 +3155,117 @@ int LiveObjectsClient_Init(void* net_iface_handler, unsigned long long apikey_p1
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_SetDevId(const char* dev_id) {
+int LiveObjectsClient_SetDevIdEx(LiveObjectsClient_Ctx* ctx, const char* dev_id) {
 	if ((dev_id) &&(*dev_id)) {
 		size_t len = strlen(dev_id);
-		memset(_LOClient_dev_id, 0, sizeof(_LOClient_dev_id));
-		memcpy(_LOClient_dev_id, dev_id, len < sizeof(_LOClient_dev_id) ? len : sizeof(_LOClient_dev_id));
-		_LOClient_dev_id[sizeof(_LOClient_dev_id) - 1] = 0;
+		memset(ctx->dev_id, 0, sizeof(ctx->dev_id));
+		memcpy(ctx->dev_id, dev_id, len < sizeof(ctx->dev_id) ? len : sizeof(ctx->dev_id));
+		ctx->dev_id[sizeof(ctx->dev_id) - 1] = 0;
 
-		if (strlen(_LOClient_dev_id) != len) {
-			LOTRACE_ERR("Error to set dev_id, rc=%d != %d ", strlen(_LOClient_dev_id), len);
+		if (strlen(ctx->dev_id) != len) {
+			LOTRACE_ERR("Error to set dev_id, rc=%d != %d ", strlen(ctx->dev_id), len);
 			return -1;
 		}
 	}
-	LOTRACE_NOTICE("dev_id=\"%s\"", _LOClient_dev_id);
+	LOTRACE_NOTICE("dev_id=\"%s\"", ctx->dev_id);
 	return 0;
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_SetNameSpace(const char* name_space) {
+int LiveObjectsClient_SetNameSpaceEx(LiveObjectsClient_Ctx* ctx, const char* name_space) {
 	if ((name_space) &&(*name_space)) {
 		size_t len = strlen(name_space);
-		memset(_LOClient_dev_name_space, 0, sizeof(_LOClient_dev_id));
-		memcpy(_LOClient_dev_name_space, name_space,
-				len < sizeof(_LOClient_dev_name_space) ? len : sizeof(_LOClient_dev_name_space));
-		_LOClient_dev_name_space[sizeof(_LOClient_dev_name_space) - 1] = 0;
-		if (strlen(_LOClient_dev_name_space) != len) {
-			LOTRACE_ERR("Error to set name_space, rc=%d != %d ", strlen(_LOClient_dev_name_space), len);
+		memset(ctx->dev_name_space, 0, sizeof(ctx->dev_name_space));
+		memcpy(ctx->dev_name_space, name_space,
+				len < sizeof(ctx->dev_name_space) ? len : sizeof(ctx->dev_name_space));
+		ctx->dev_name_space[sizeof(ctx->dev_name_space) - 1] = 0;
+		if (strlen(ctx->dev_name_space) != len) {
+			LOTRACE_ERR("Error to set name_space, rc=%d != %d ", strlen(ctx->dev_name_space), len);
 			return -1;
 		}
 	}
-	LOTRACE_NOTICE("name_space=\"%s\"", _LOClient_dev_name_space);
+	LOTRACE_NOTICE("name_space=\"%s\"", ctx->dev_name_space);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetQueueEx(LiveObjectsClient_Ctx* ctx, uint32_t size, LiveObjectsD_QueuePolicy_t policy,
+		uint32_t block_ms) {
+#if LOM_MQUEUE
+	LOTRACE_INF("size=%"PRIu32" policy=%d block_ms=%"PRIu32, size, policy, block_ms);
+	if ((size == 0) || (policy > MQ_POLICY_BLOCK)) {
+		LOTRACE_ERR("ERROR - Invalid parameters");
+		return -1;
+	}
+	if ((ctx->queue.size == 0) || (ctx->state_run > 0) || (ctx->state_connected)) {
+		LOTRACE_ERR("ERROR - Must be called after init, and before connection");
+		return -1;
+	}
+	LOCC_mqPurge(ctx);
+	if ((size != ctx->queue.size) && (LOCC_mqAlloc(ctx, size))) {
+		return -1;
+	}
+	ctx->queue.policy = (uint8_t) policy;
+	ctx->queue.block_ms = block_ms;
+	LOCC_mqReset(ctx);
+	return 0;
+#else
+	LOTRACE_ERR("ERROR - not supported in this config");
+	return -1;
+#endif
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetQueueWatermarksEx(LiveObjectsClient_Ctx* ctx, uint32_t high, uint32_t low,
+		LiveObjectsD_CallbackQueueLevel_t callback, void* user_ctx) {
+#if LOM_MQUEUE
+	LOTRACE_INF("high=%"PRIu32" low=%"PRIu32" callback=%p", high, low, callback);
+	if ((high) && ((low >= high) || (high > ctx->queue.size))) {
+		LOTRACE_ERR("ERROR - Invalid watermarks (queue size %"PRIu32")", ctx->queue.size);
+		return -1;
+	}
+	ctx->queue.wm_high = 0;
+	ctx->queue.wm_low = low;
+	ctx->queue.wm_cb = callback;
+	ctx->queue.wm_user = user_ctx;
+	ctx->queue.above_high = 0;
+	ctx->queue.wm_high = high;
+	return 0;
+#else
+	LOTRACE_ERR("ERROR - not supported in this config");
+	return -1;
+#endif
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetEncodingEx(LiveObjectsClient_Ctx* ctx, LiveObjectsD_Encoding_t encoding) {
+	const LOMEncoder_t* enc;
+	if (encoding == LOD_ENCODING_JSON) {
+		enc = NULL;
+	}
+	else if (encoding == LOD_ENCODING_CBOR) {
+#if LOC_FEATURE_CBOR
+		enc = &LO_msg_enc_cbor;
+#else
+		LOTRACE_ERR("ERROR - not supported in this config");
+		return -1;
+#endif
+	}
+	else {
+		LOTRACE_ERR("ERROR - Invalid encoding %d", encoding);
+		return -1;
+	}
+	if ((ctx->state_run > 0) || (ctx->state_connected)) {
+		LOTRACE_ERR("ERROR - Must be called before connection");
+		return -1;
+	}
+	ctx->encoder = enc;
+	LOTRACE_INF("encoding=%s mqtt user=%s", (enc) ? enc->name : LO_msg_enc_json.name,
+			((enc) ? enc : &LO_msg_enc_json)->mqtt_user);
 	return 0;
 }
 
@@ -1247,12 +3309,26 @@ int LiveObjectsClient_DnsResolve(void) {
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_AttachCfgParams(const LiveObjectsD_Param_t* param_ptr, int32_t param_nb,
-		LiveObjectsD_CallbackParams_t callback) {
+int LiveObjectsClient_AttachCfgParamsEx(LiveObjectsClient_Ctx* ctx, const LiveObjectsD_Param_t* param_ptr,
+		int32_t param_nb, LiveObjectsD_CallbackParams_t callback) {
 #if LOC_FEATURE_LO_PARAMS
-	_LOClient_Set_Params.param_set.param_ptr = param_ptr;
-	_LOClient_Set_Params.param_set.param_nb = param_nb;
-	_LOClient_Set_Params.param_callback = callback;
+	LOMNameIndex_t idx;
+	LOMNameIndex_t old_idx;
+
+	/* The client thread may decode a request: built aside, then replaced under MSG_MUTEX */
+	memset(&idx, 0, sizeof(idx));
+	LO_msg_index_build(&idx, param_ptr, (param_nb > 0) ? param_nb : 0,
+			sizeof(LiveObjectsD_Param_t), offsetof(LiveObjectsD_Param_t, parm_data.data_name));
+
+	MSG_MUTEX_LOCK();
+	old_idx = ctx->set_params.param_index;
+	ctx->set_params.param_set.param_ptr = param_ptr;
+	ctx->set_params.param_set.param_nb = param_nb;
+	ctx->set_params.param_callback = callback;
+	ctx->set_params.param_index = idx;
+	MSG_MUTEX_UNLOCK();
+
+	LO_msg_index_free(&old_idx);
 
 	LOTRACE_INF("nb=%"PRIi32" callback=%p", param_nb, callback);
 
@@ -1264,7 +3340,8 @@ int LiveObjectsClient_AttachCfgParams(const LiveObjectsD_Param_t* param_ptr, int
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_AttachStatus(const LiveObjectsD_Data_t* data_ptr, int32_t data_nb) {
+int LiveObjectsClient_AttachStatusEx(LiveObjectsClient_Ctx* ctx, const LiveObjectsD_Data_t* data_ptr,
+		int32_t data_nb) {
 
 #if LOC_FEATURE_LO_STATUS  && (LOC_MAX_OF_DATA_SET > 0)
 	int status_hdl;
@@ -1272,16 +3349,19 @@ int LiveObjectsClient_AttachStatus(const LiveObjectsD_Data_t* data_ptr, int32_t
 		return -1;
 	}
 	for (status_hdl = 0; status_hdl < LOC_MAX_OF_STATUS_SET; status_hdl++) {
-		if (_LOClient_Set_Status[status_hdl].data_set.data_ptr == NULL) {
+		if (ctx->set_status[status_hdl].data_set.data_ptr == NULL) {
 			break;
 		}
 	}
 
 	if (status_hdl < LOC_MAX_OF_STATUS_SET) {
-		_LOClient_Set_Status[status_hdl].data_set.data_ptr = data_ptr;
-		_LOClient_Set_Status[status_hdl].data_set.data_nb = data_nb;
+		ctx->set_status[status_hdl].data_set.data_ptr = data_ptr;
+		ctx->set_status[status_hdl].data_set.data_nb = data_nb;
 #if LOM_PUSH_FLAG
-		_LOClient_Set_Status[status_hdl].pushtoLOServer = 1;
+		ctx->set_status[status_hdl].pushtoLOServer = 1;
+#endif
+#if LOM_STATUS_DELTA
+		ctx->set_status[status_hdl].delta_valid = 0;
 #endif
 
 		LOTRACE_INF("nb=%"PRIi32, data_nb);
@@ -1293,8 +3373,9 @@ int LiveObjectsClient_AttachStatus(const LiveObjectsD_Data_t* data_ptr, int32_t
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_AttachData(uint8_t stream_prefix, const char* stream_id, const char* model, const char* tags,
-		const LiveObjectsD_GpsFix_t* gps_ptr, const LiveObjectsD_Data_t* data_ptr, int32_t data_nb) {
+int LiveObjectsClient_AttachDataEx(LiveObjectsClient_Ctx* ctx, uint8_t stream_prefix, const char* stream_id,
+		const char* model, const char* tags, const LiveObjectsD_GpsFix_t* gps_ptr,
+		const LiveObjectsD_Data_t* data_ptr, int32_t data_nb) {
 
 #if LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
 	int data_hdl;
@@ -1302,7 +3383,7 @@ int LiveObjectsClient_AttachData(uint8_t stream_prefix, const char* stream_id, c
 		return -1;
 	}
 	for (data_hdl = 0; data_hdl < LOC_MAX_OF_DATA_SET; data_hdl++) {
-		if (_LOClient_Set_Data[data_hdl].stream_id[0] == 0) {
+		if (ctx->set_data[data_hdl].stream_id[0] == 0) {
 			break;
 		}
 	}
@@ -1311,9 +3392,9 @@ int LiveObjectsClient_AttachData(uint8_t stream_prefix, const char* stream_id, c
 #if (LOM_SETOFDATA_MODEL_SZ > 0) || (LOM_SETOFDATA_TAGS_SZ > 0)
 		size_t len;
 #endif
-		LOMSetOfData_t* p_dataSet = &_LOClient_Set_Data[data_hdl];
+		LOMSetOfData_t* p_dataSet = &ctx->set_data[data_hdl];
 
-		int ret = LOCC_setStreamId(stream_prefix, p_dataSet, stream_id);
+		int ret = LOCC_setStreamId(ctx, stream_prefix, p_dataSet, stream_id);
 		if (ret != 0) {
 			return -1;
 		}
@@ -1349,6 +3430,8 @@ int LiveObjectsClient_AttachData(uint8_t stream_prefix, const char* stream_id, c
 		p_dataSet->data_set.data_ptr = data_ptr;
 		p_dataSet->data_set.data_nb = data_nb;
 
+		LO_msg_data_tpl_compile(p_dataSet);
+
 		LOTRACE_INF("handle=%d nb=%"PRIi32" id=%s m=%s t=%s", data_hdl, data_nb,
 				stream_id, model, tags);
 		return data_hdl;
@@ -1359,13 +3442,27 @@ int LiveObjectsClient_AttachData(uint8_t stream_prefix, const char* stream_id, c
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_AttachCommands(const LiveObjectsD_Command_t* cmd_ptr, int32_t cmd_nb,
-		LiveObjectsD_CallbackCommand_t callback) {
+int LiveObjectsClient_AttachCommandsEx(LiveObjectsClient_Ctx* ctx, const LiveObjectsD_Command_t* cmd_ptr,
+		int32_t cmd_nb, LiveObjectsD_CallbackCommand_t callback) {
 #if LOC_FEATURE_LO_COMMANDS
-	_LOClient_Set_Cmd.cmd_enable = 0;
-	_LOClient_Set_Cmd.cmd_ptr = cmd_ptr;
-	_LOClient_Set_Cmd.cmd_nb = cmd_nb;
-	_LOClient_Set_Cmd.cmd_callback = callback;
+	LOMNameIndex_t idx;
+	LOMNameIndex_t old_idx;
+
+	/* The client thread may decode a request: built aside, then replaced under MSG_MUTEX */
+	memset(&idx, 0, sizeof(idx));
+	LO_msg_index_build(&idx, cmd_ptr, (cmd_nb > 0) ? cmd_nb : 0, sizeof(LiveObjectsD_Command_t),
+			offsetof(LiveObjectsD_Command_t, cmd_name));
+
+	MSG_MUTEX_LOCK();
+	old_idx = ctx->set_cmd.cmd_index;
+	ctx->set_cmd.cmd_enable = 0;
+	ctx->set_cmd.cmd_ptr = cmd_ptr;
+	ctx->set_cmd.cmd_nb = cmd_nb;
+	ctx->set_cmd.cmd_callback = callback;
+	ctx->set_cmd.cmd_index = idx;
+	MSG_MUTEX_UNLOCK();
+
+	LO_msg_index_free(&old_idx);
 
 	LOTRACE_INF("nb=%"PRIi32, cmd_nb);
 
@@ -1377,32 +3474,33 @@ int LiveObjectsClient_AttachCommands(const LiveObjectsD_Command_t* cmd_ptr, int3
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_ControlCommands(bool enable) {
+int LiveObjectsClient_ControlCommandsEx(LiveObjectsClient_Ctx* ctx, bool enable) {
 #if LOC_FEATURE_LO_COMMANDS
 	LOTRACE_INF("enable=%u (current state 0x%x)", enable,
-			_LOClient_Set_Cmd.cmd_enable);
+			ctx->set_cmd.cmd_enable);
 	if (enable) {
-		_LOClient_Set_Cmd.cmd_enable = 0x01;
+		ctx->set_cmd.cmd_enable = 0x01;
 	}
 	else {
-		if (_LOClient_Set_Cmd.cmd_enable & 0x10) {
-			_LOClient_Set_Cmd.cmd_enable = 0x10;
+		if (ctx->set_cmd.cmd_enable & 0x10) {
+			ctx->set_cmd.cmd_enable = 0x10;
 		}
 	}
+	LOCC_wakeup(ctx);
 #endif
 	return 0;
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_AttachResources(const LiveObjectsD_Resource_t* rsc_ptr, int32_t rsc_nb,
-		LiveObjectsD_CallbackResourceNotify_t ntfyCB, LiveObjectsD_CallbackResourceData_t dataCB) {
+int LiveObjectsClient_AttachResourcesEx(LiveObjectsClient_Ctx* ctx, const LiveObjectsD_Resource_t* rsc_ptr,
+		int32_t rsc_nb, LiveObjectsD_CallbackResourceNotify_t ntfyCB, LiveObjectsD_CallbackResourceData_t dataCB) {
 #if LOC_FEATURE_LO_RESOURCES
-	_LOClient_Set_Rsc.rsc_enable = 0x01;
-	_LOClient_Set_Rsc.rsc_ptr = rsc_ptr;
-	_LOClient_Set_Rsc.rsc_nb = rsc_nb;
-	_LOClient_Set_Rsc.rsc_cb_ntfy = ntfyCB;
-	_LOClient_Set_Rsc.rsc_cb_data = dataCB;
+	ctx->set_rsc.rsc_enable = 0x01;
+	ctx->set_rsc.rsc_ptr = rsc_ptr;
+	ctx->set_rsc.rsc_nb = rsc_nb;
+	ctx->set_rsc.rsc_cb_ntfy = ntfyCB;
+	ctx->set_rsc.rsc_cb_data = dataCB;
 
 	LOTRACE_INF("nb=%"PRIi32, rsc_nb);
 
@@ -1414,27 +3512,33 @@ int LiveObjectsClient_AttachResources(const LiveObjectsD_Resource_t* rsc_ptr, in
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_ControlResources(bool enable) {
+int LiveObjectsClient_ControlResourcesEx(LiveObjectsClient_Ctx* ctx, bool enable) {
 #if LOC_FEATURE_LO_RESOURCES
 	LOTRACE_INF("enable=%u (current state 0x%x)", enable,
-			_LOClient_Set_Rsc.rsc_enable);
+			ctx->set_rsc.rsc_enable);
 	if (enable) {
-		_LOClient_Set_Rsc.rsc_enable = 0x01;
+		ctx->set_rsc.rsc_enable = 0x01;
 	}
-	else if (_LOClient_Set_Rsc.rsc_enable & 0x01) {
-		_LOClient_Set_Rsc.rsc_enable = 0x10;
+	else if (ctx->set_rsc.rsc_enable & 0x01) {
+		ctx->set_rsc.rsc_enable = 0x10;
 	}
+	LOCC_wakeup(ctx);
 #endif
 	return 0;
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_ChangeDataStreamId(uint8_t prefix, int data_hdl, const char* stream_id) {
+int LiveObjectsClient_ChangeDataStreamIdEx(LiveObjectsClient_Ctx* ctx, uint8_t prefix, int data_hdl,
+		const char* stream_id) {
 #if LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
-	if ((data_hdl >= 0) && (data_hdl < LOC_MAX_OF_DATA_SET) && _LOClient_Set_Data[data_hdl].stream_id[0]
+	if ((data_hdl >= 0) && (data_hdl < LOC_MAX_OF_DATA_SET) && ctx->set_data[data_hdl].stream_id[0]
 			&& (stream_id) &&(*stream_id)) {
-		int ret = LOCC_setStreamId(prefix, &_LOClient_Set_Data[data_hdl], stream_id);
+		int ret = LOCC_setStreamId(ctx, prefix, &ctx->set_data[data_hdl], stream_id);
+		if (ret == 0) {
+			/* The stream id is in the JSON template */
+			LO_msg_data_tpl_compile(&ctx->set_data[data_hdl]);
+		}
 		return ret;
 	}
 #endif
@@ -1443,11 +3547,19 @@ int LiveObjectsClient_ChangeDataStreamId(uint8_t prefix, int data_hdl, const cha
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_RemoveData(int data_hdl) {
+int LiveObjectsClient_RemoveDataEx(LiveObjectsClient_Ctx* ctx, int data_hdl) {
 #if LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
-	if ((data_hdl >= 0) && (data_hdl < LOC_MAX_OF_DATA_SET) && _LOClient_Set_Data[data_hdl].stream_id[0]) {
-		_LOClient_Set_Data[data_hdl].data_set.data_ptr = NULL;
-		memset(&_LOClient_Set_Data[data_hdl], 0, sizeof(LOMSetOfData_t));
+	if ((data_hdl >= 0) && (data_hdl < LOC_MAX_OF_DATA_SET) && ctx->set_data[data_hdl].stream_id[0]) {
+#if LOM_DATA_BATCH
+		/* Batching disabled, pending samples are dropped (buffers released by LiveObjectsClient_SetDataBatch) */
+		MSG_MUTEX_LOCK();
+		ctx->batch[data_hdl].max_samples = 0;
+		ctx->batch[data_hdl].nb = 0;
+		ctx->batch[data_hdl].len = 0;
+		MSG_MUTEX_UNLOCK();
+#endif
+		ctx->set_data[data_hdl].data_set.data_ptr = NULL;
+		memset(&ctx->set_data[data_hdl], 0, sizeof(LOMSetOfData_t));
 		return 0;
 	}
 #endif
@@ -1456,69 +3568,146 @@ int LiveObjectsClient_RemoveData(int data_hdl) {
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_RemoveCommands(void) {
+int LiveObjectsClient_SetDataBatchEx(LiveObjectsClient_Ctx* ctx, int data_hdl, uint32_t max_samples,
+		uint32_t max_bytes, uint32_t max_latency_ms) {
+#if LOM_DATA_BATCH && LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
+	LOCCBatch_t* b;
+	LOTRACE_INF("data_hdl=%d max_samples=%"PRIu32" max_bytes=%"PRIu32" max_latency_ms=%"PRIu32,
+			data_hdl, max_samples, max_bytes, max_latency_ms);
+	if ((data_hdl < 0) || (data_hdl >= LOC_MAX_OF_DATA_SET) || (ctx->set_data[data_hdl].stream_id[0] == 0)
+			|| (max_samples > 0xFFFF) || ((max_samples) && (max_bytes <= LOCC_BATCH_PAYLOAD_OFFSET))) {
+		LOTRACE_ERR("ERROR - Invalid parameters");
+		return -1;
+	}
+	if ((ctx->state_run > 0) || (ctx->state_connected)) {
+		LOTRACE_ERR("ERROR - Must be called before connection");
+		return -1;
+	}
+	b = &ctx->batch[data_hdl];
+	LOCC_batchRelease(b);
+	if (max_samples == 0) {
+		return 0;
+	}
+	b->buf[0] = (unsigned char*) MEM_ALLOC(2 * max_bytes);
+	if (b->buf[0] == NULL) {
+		LOTRACE_ERR("MEM_ALLOC ERROR (2 x %"PRIu32" bytes)", max_bytes);
+		return -1;
+	}
+	b->buf[1] = b->buf[0] + max_bytes;
+	b->size = max_bytes;
+	b->max_latency_ms = max_latency_ms;
+	b->max_samples = (uint16_t) max_samples;
+	return 0;
+#else
+	(void) ctx;
+	(void) data_hdl;
+	(void) max_samples;
+	(void) max_bytes;
+	(void) max_latency_ms;
+	LOTRACE_ERR("ERROR - not supported in this config");
+	return -1;
+#endif
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_RemoveCommandsEx(LiveObjectsClient_Ctx* ctx) {
 #if LOC_FEATURE_LO_COMMANDS
-	memset(&_LOClient_Set_Cmd, 0, sizeof(_LOClient_Set_Cmd));
+	LOMNameIndex_t old_idx;
+
+	MSG_MUTEX_LOCK();
+	old_idx = ctx->set_cmd.cmd_index;
+	memset(&ctx->set_cmd, 0, sizeof(ctx->set_cmd));
+	MSG_MUTEX_UNLOCK();
+
+	LO_msg_index_free(&old_idx);
 #endif
 	return 0;
 }
 
+/* --------------------------------------------------------------------------------- */
+/* The argument value is a NUL terminated copy of the JSON value */
+int LiveObjectsClient_GetCommandArgInt32(const LiveObjectsD_CommandArg_t* arg, int32_t* value) {
+	if ((arg == NULL) || (arg->arg_value == NULL) || (arg->arg_type)) {
+		return -1;
+	}
+	return LO_json_atoi(arg->arg_value, (uint32_t) strlen(arg->arg_value), value);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_GetCommandArgUInt32(const LiveObjectsD_CommandArg_t* arg, uint32_t* value) {
+	if ((arg == NULL) || (arg->arg_value == NULL) || (arg->arg_type)) {
+		return -1;
+	}
+	return LO_json_atou(arg->arg_value, (uint32_t) strlen(arg->arg_value), value);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_GetCommandArgDouble(const LiveObjectsD_CommandArg_t* arg, double* value) {
+	if ((arg == NULL) || (arg->arg_value == NULL) || (arg->arg_type)) {
+		return -1;
+	}
+	return LO_json_atod(arg->arg_value, (uint32_t) strlen(arg->arg_value), value);
+}
+
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_RemoveResources(void) {
+int LiveObjectsClient_RemoveResourcesEx(LiveObjectsClient_Ctx* ctx) {
 #if LOC_FEATURE_LO_RESOURCES
-	memset(&_LOClient_Set_Rsc, 0, sizeof(_LOClient_Set_Rsc));
+	memset(&ctx->set_rsc, 0, sizeof(ctx->set_rsc));
 #endif
 	return 0;
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_Connect(void) {
+int LiveObjectsClient_ConnectEx(LiveObjectsClient_Ctx* ctx) {
 	int rc;
 
-	LOCC_connectInit(0);
+	LOCC_connectInit(ctx, 0);
 
-	rc = LOCC_connectStart();
+	rc = LOCC_connectStart(ctx);
 	if (rc) {
 		LOTRACE_ERR("connection failed, rc=%d", rc);
 	}
 	else {
-		LOCC_connectOK();
+		LOCC_connectOK(ctx);
 	}
 	return rc;
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_Disconnect(void) {
+int LiveObjectsClient_DisconnectEx(LiveObjectsClient_Ctx* ctx) {
 	int rc;
-	rc = MQTTDisconnect(&_LOClient_mqtt_ctx);
+	rc = MQTTDisconnect(&ctx->mqtt_ctx);
 	if (rc) {
 		LOTRACE_ERR("MQTTDisconnect failed, rc=%d", rc);
 	}
-	netw_disconnect(&_LOClient_MQTTClient_network, 0);
-	_LOClient_state_connected = 0;
+	netw_disconnect(&ctx->netw, 0);
+	ctx->state_connected = 0;
 	return 0;
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_Yield(int timeout_ms) {
+int LiveObjectsClient_YieldEx(LiveObjectsClient_Ctx* ctx, int timeout_ms) {
 	int ret = -1;
-	if (_LOClient_state_connected) {
+	if (ctx->state_connected) {
 		LOTRACE_DBG_VERBOSE("CONNECTED => MQTTYield(%d ms)...", timeout_ms);
-		ret = MQTTYield(&_LOClient_mqtt_ctx, timeout_ms);
+		ret = MQTTYield(&ctx->mqtt_ctx, timeout_ms);
 		LOTRACE_DBG_VERBOSE("CONNECTED => MQTTYield(%d ms) ========> ret=%d.", timeout_ms,
 				ret);
 		if (ret < 0) {
 			LOTRACE_DBG1("ret=%d  !!", ret);
 		}
 
-		if (netw_isLost(&_LOClient_MQTTClient_network)) {
+		if (netw_isLost(&ctx->netw)) {
 			LOTRACE_NOTICE("LOST !!");
-			netw_disconnect(&_LOClient_MQTTClient_network, 0);
-			_LOClient_state_connected = 0;
+			netw_disconnect(&ctx->netw, 0);
+			ctx->state_connected = 0;
 			ret = -1;
 		}
 		else {
@@ -1534,27 +3723,35 @@ int LiveObjectsClient_Yield(int timeout_ms) {
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_PushResources(void) {
+int LiveObjectsClient_PushResourcesEx(LiveObjectsClient_Ctx* ctx) {
 #if LOC_FEATURE_LO_RESOURCES
-	if ((_LOClient_state_connected) &&(_LOClient_Set_Rsc.rsc_ptr)) {
+	if ((ctx->state_connected) &&(ctx->set_rsc.rsc_ptr)) {
 #if LOM_PUSH_ASYNC
-		_LOClient_Set_Rsc.pushtoLOServer = 1;
+		ctx->set_rsc.pushtoLOServer = 1;
+		LOCC_wakeup(ctx);
 		return 0;
 #else
 		uint8_t from = LO_sys_threadIsLiveObjectsClient() ? 0 : MTYPE_PUB_RSC;
-		const char *p_msg = LO_msg_encode_resources(from, &_LOClient_Set_Rsc);
+		uint32_t buf_len = 0;
+		uint32_t len = 0;
+		const char *p_msg;
+		char* buf_ptr = (from) ? NULL : LOCC_MqttPublishBegin(ctx, QOS0, "dev/rsc", &buf_len);
+		if ((from == 0) && (buf_ptr == NULL)) {
+			return -1;
+		}
+		p_msg = LO_msg_encode_resources(from, buf_ptr, buf_len, LOCC_RING(ctx), &ctx->set_rsc, &len);
 		if (p_msg) {
 			if (from == 0) {
 				/* Publish now because it is LiveObjects Client thread */
-				return LOCC_MqttPublish(QOS0, "dev/rsc", p_msg);
+				return LOCC_MqttPublishEndBin(ctx, QOS0, "dev/rsc", p_msg, len);
 			}
 			/* otherwise put it in the queue */
-			if (LOCC_mqPut(p_msg) == 0) {
+			if (LOCC_mqPut(ctx, p_msg) == 0) {
 				LOTRACE_INF("msg is put in queue !!");
 				return 0;
 			}
-			LOTRACE_ERR("ERROR to put in queue - MEM_FREE %p x%x", p_msg, *p_msg);
-			MEM_FREE(p_msg);
+			LOTRACE_ERR("ERROR to put in queue - Free %p x%x", p_msg, *p_msg);
+			LO_msg_free(p_msg);
 		}
 #endif
 	}
@@ -1564,28 +3761,38 @@ int LiveObjectsClient_PushResources(void) {
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_PushStatus(int handle) {
+int LiveObjectsClient_PushStatusEx(LiveObjectsClient_Ctx* ctx, int handle) {
 #if LOC_FEATURE_LO_STATUS  && (LOC_MAX_OF_DATA_SET > 0)
-	if ((_LOClient_state_connected) &&(handle >= 0) && (handle < LOC_MAX_OF_STATUS_SET)
-			&& (_LOClient_Set_Status[handle].data_set.data_ptr)) {
-#if LOM_PUSH_ASYNC
-		_LOClient_Set_Status[handle].pushtoLOServer = 1;
+	if ((ctx->state_connected) &&(handle >= 0) && (handle < LOC_MAX_OF_STATUS_SET)
+			&& (ctx->set_status[handle].data_set.data_ptr)) {
+#if LOM_PUSH_ASYNC || LOM_STATUS_DELTA
+		/* Published by the LiveObjects Client thread (also the owner of the delta shadow) */
+		ctx->set_status[handle].pushtoLOServer = 1;
+		LOCC_wakeup(ctx);
 		return 0;
 #else
 		uint8_t from = LO_sys_threadIsLiveObjectsClient() ? 0 : MTYPE_PUB_STATUS;
-		const char *p_msg = LO_msg_encode_status(from, &_LOClient_Set_Status[handle].data_set);
+		uint32_t buf_len = 0;
+		uint32_t len = 0;
+		const char *p_msg;
+		char* buf_ptr = (from) ? NULL : LOCC_MqttPublishBegin(ctx, QOS0, "dev/info", &buf_len);
+		if ((from == 0) && (buf_ptr == NULL)) {
+			return -1;
+		}
+		p_msg = LO_msg_encode_status(from, buf_ptr, buf_len, LOCC_RING(ctx), ctx->encoder,
+				&ctx->set_status[handle].data_set, &len);
 		if (p_msg) {
 			if (from == 0) {
 				/* Publish now because it is LiveObjects Client thread */
-				return LOCC_MqttPublish(QOS0, "dev/info", p_msg);
+				return LOCC_MqttPublishEndBin(ctx, QOS0, "dev/info", p_msg, len);
 			}
 			/* otherwise put it in the queue */
-			if (LOCC_mqPut(p_msg) == 0) {
+			if (LOCC_mqPut(ctx, p_msg) == 0) {
 				LOTRACE_INF("msg is put in queue !!");
 				return 0;
 			}
-			LOTRACE_ERR("ERROR to put in queue - MEM_FREE %p x%x", p_msg, *p_msg);
-			MEM_FREE(p_msg);
+			LOTRACE_ERR("ERROR to put in queue - Free %p x%x", p_msg, *p_msg);
+			LO_msg_free(p_msg);
 		}
 #endif
 	}
@@ -1595,29 +3802,50 @@ int LiveObjectsClient_PushStatus(int handle) {
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_PushData(int data_hdl) {
+int LiveObjectsClient_PushDataEx(LiveObjectsClient_Ctx* ctx, int data_hdl) {
 #if LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
-	if (_LOClient_state_connected && (data_hdl >= 0) && (data_hdl < LOC_MAX_OF_DATA_SET)
-			&& _LOClient_Set_Data[data_hdl].stream_id[0] && _LOClient_Set_Data[data_hdl].data_set.data_ptr) {
+#if LOC_FEATURE_JOURNAL
+	if ((!ctx->state_connected) && (ctx->journal) && (data_hdl >= 0) && (data_hdl < LOC_MAX_OF_DATA_SET)
+			&& ctx->set_data[data_hdl].stream_id[0] && ctx->set_data[data_hdl].data_set.data_ptr) {
+		/* Published after the reconnection */
+		return LOCC_journalData(ctx, data_hdl);
+	}
+#endif
+	if (ctx->state_connected && (data_hdl >= 0) && (data_hdl < LOC_MAX_OF_DATA_SET)
+			&& ctx->set_data[data_hdl].stream_id[0] && ctx->set_data[data_hdl].data_set.data_ptr) {
+#if LOM_DATA_BATCH
+		if (ctx->batch[data_hdl].max_samples) {
+			return LOCC_batchCapture(ctx, data_hdl);
+		}
+#endif
 #if LOM_PUSH_ASYNC
 		LOTRACE_INF("ASYNC data_hdl=%d", data_hdl);
-		_LOClient_Set_Data[data_hdl].pushtoLOServer = 1;
+		ctx->set_data[data_hdl].pushtoLOServer = 1;
+		LOCC_wakeup(ctx);
 		return 0;
 #else
 		uint8_t from = LO_sys_threadIsLiveObjectsClient() ? 0 : MTYPE_PUB_DATA;
-		const char *p_msg = LO_msg_encode_data(from, &_LOClient_Set_Data[data_hdl]);
+		uint32_t buf_len = 0;
+		uint32_t len = 0;
+		const char *p_msg;
+		char* buf_ptr = (from) ? NULL : LOCC_MqttPublishBegin(ctx, QOS0, "dev/data", &buf_len);
+		if ((from == 0) && (buf_ptr == NULL)) {
+			return -1;
+		}
+		p_msg = LO_msg_encode_data(from, buf_ptr, buf_len, LOCC_RING(ctx), ctx->encoder,
+				&ctx->set_data[data_hdl], &len);
 		if (p_msg) {
 			if (from == 0) {
 				/* Publish now because it is LiveObjects Client thread */
-				return LOCC_MqttPublish(QOS0, "dev/data", p_msg);
+				return LOCC_MqttPublishEndBin(ctx, QOS0, "dev/data", p_msg, len);
 			}
 			/* otherwise put it in the queue */
-			if (LOCC_mqPut(p_msg) == 0) {
+			if (LOCC_mqPut(ctx, p_msg) == 0) {
 				LOTRACE_DBG1("msg is put in queue !!");
 				return 0;
 			}
-			LOTRACE_ERR("ERROR to put in queue - MEM_FREE %p x%x", p_msg, *p_msg);
-			MEM_FREE(p_msg);
+			LOTRACE_ERR("ERROR to put in queue - Free %p x%x", p_msg, *p_msg);
+			LO_msg_free(p_msg);
 		}
 #endif
 	}
@@ -1628,27 +3856,36 @@ int LiveObjectsClient_PushData(int data_hdl) {
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_PushCfgParams(void) {
+int LiveObjectsClient_PushCfgParamsEx(LiveObjectsClient_Ctx* ctx) {
 #if LOC_FEATURE_LO_PARAMS
-	if ((_LOClient_state_connected) &&(_LOClient_Set_Params.param_set.param_ptr)) {
+	if ((ctx->state_connected) &&(ctx->set_params.param_set.param_ptr)) {
 #if LOM_PUSH_ASYNC
-		_LOClient_Set_Params.pushtoLOServer = 1;
+		ctx->set_params.pushtoLOServer = 1;
+		LOCC_wakeup(ctx);
 		return 0;
 #else
 		uint8_t from = LO_sys_threadIsLiveObjectsClient() ? 0 : MTYPE_PUB_PARAM;
-		const char *p_msg = LO_msg_encode_params_all(from, &_LOClient_Set_Params.param_set, 0);
+		uint32_t buf_len = 0;
+		uint32_t len = 0;
+		const char *p_msg;
+		char* buf_ptr = (from) ? NULL : LOCC_MqttPublishBegin(ctx, QOS0, "dev/cfg", &buf_len);
+		if ((from == 0) && (buf_ptr == NULL)) {
+			return -1;
+		}
+		p_msg = LO_msg_encode_params_all(from, buf_ptr, buf_len, LOCC_RING(ctx),
+				&ctx->set_params.param_set, 0, &len);
 		if (p_msg) {
 			if (from == 0) {
 				/* Publish now because it is LiveObjects Client thread */
-				return LOCC_MqttPublish(QOS0, "dev/cfg", p_msg);
+				return LOCC_MqttPublishEndBin(ctx, QOS0, "dev/cfg", p_msg, len);
 			}
 			/* otherwise put it in the queue */
-			if (LOCC_mqPut(p_msg) == 0) {
+			if (LOCC_mqPut(ctx, p_msg) == 0) {
 				LOTRACE_INF("msg is put in queue !!");
 				return 0;
 			}
-			LOTRACE_ERR("ERROR to put in queue - MEM_FREE %p x%x", p_msg, *p_msg);
-			MEM_FREE(p_msg);
+			LOTRACE_ERR("ERROR to put in queue - Free %p x%x", p_msg, *p_msg);
+			LO_msg_free(p_msg);
 		}
 #endif
 	}
@@ -1658,27 +3895,35 @@ int LiveObjectsClient_PushCfgParams(void) {
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_CommandResponse(int32_t cid, const LiveObjectsD_Data_t* data_ptr, int data_nb) {
+int LiveObjectsClient_CommandResponseEx(LiveObjectsClient_Ctx* ctx, int32_t cid, const LiveObjectsD_Data_t* data_ptr,
+		int data_nb) {
 #if LOC_FEATURE_LO_COMMANDS
-	if (_LOClient_state_connected) {
+	if (ctx->state_connected) {
 		const char *p_msg ;
 		uint8_t from = LO_sys_threadIsLiveObjectsClient() ? 0 : MTYPE_PUB_CMD_RSP;
+		uint32_t buf_len = 0;
+		uint32_t len = 0;
+		char* buf_ptr = (from) ? NULL : LOCC_MqttPublishBegin(ctx, QOS0, "dev/cmd/res", &buf_len);
+		if ((from == 0) && (buf_ptr == NULL)) {
+			return -1;
+		}
 		LOTRACE_INF("from=x%x cid= %"PRIi32" obj_ptr=x%p  obj_nb=%d ...", from, cid,
 				data_ptr, data_nb);
-		p_msg = LO_msg_encode_cmd_resp(from, cid, data_ptr, data_nb);
+		p_msg = LO_msg_encode_cmd_resp(from, buf_ptr, buf_len, LOCC_RING(ctx), cid,
+				data_ptr, data_nb, &len);
 		if (p_msg) {
 			if (from == 0) {
 				/* Publish now because it is LOM Client thread (negative response ...) */
-				return LOCC_MqttPublish(QOS0, "dev/cmd/res", p_msg);
+				return LOCC_MqttPublishEndBin(ctx, QOS0, "dev/cmd/res", p_msg, len);
 			}
 #if LOM_MQUEUE
 			/* otherwise put it in the queue */
-			if (LOCC_mqPut(p_msg) == 0) {
+			if (LOCC_mqPut(ctx, p_msg) == 0) {
 				LOTRACE_INF("msg is put in queue !!");
 				return 0;
 			}
-			LOTRACE_ERR("ERROR to put in queue - MEM_FREE %p x%x", p_msg, *p_msg);
-			MEM_FREE(p_msg);
+			LOTRACE_ERR("ERROR to put in queue - Free %p x%x", p_msg, *p_msg);
+			LO_msg_free(p_msg);
 #else
 			LOTRACE_ERR("ERROR - not supported in this config");
 #endif
@@ -1690,272 +3935,658 @@ int LiveObjectsClient_CommandResponse(int32_t cid, const LiveObjectsD_Data_t* da
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_RscGetChunck(const LiveObjectsD_Resource_t* rsc_ptr, char* data_ptr, int data_len) {
+int LiveObjectsClient_RscGetChunckEx(LiveObjectsClient_Ctx* ctx, const LiveObjectsD_Resource_t* rsc_ptr,
+		char* data_ptr, int data_len) {
 #if LOC_FEATURE_LO_RESOURCES
 	int ret;
-	/* see code in LOCC_processGetRsc() function */
-	if ((_LOClient_Set_UpdatedRsc.ursc_cid) && (_LOClient_Set_UpdatedRsc.ursc_obj_ptr == rsc_ptr)) {
+	/* see code in LOCC_processGetRsc(ctx) function */
+	if ((ctx->set_updated_rsc.ursc_cid) && (ctx->set_updated_rsc.ursc_obj_ptr == rsc_ptr)
+			&& (_LOClient_wget_owner == ctx)) {
 		ret = LO_wget_data(data_ptr, data_len);
 		if (ret > 0) {
 			/* Update checksum md5 and offset */
 #if LOC_FEATURE_MBEDTLS
-			mbedtls_md5_update(&_LOClient_Set_UpdatedRsc.md5_ctx, (const unsigned char *) data_ptr, (size_t) ret);
+			mbedtls_md5_update(&ctx->set_updated_rsc.md5_ctx, (const unsigned char *) data_ptr, (size_t) ret);
 #endif
-			_LOClient_Set_UpdatedRsc.ursc_offset += ret;
+			ctx->set_updated_rsc.ursc_offset += ret;
 			LOTRACE_DBG1("(len=%d): read len=%d => new offset=%"PRIu32"/%"PRIu32, data_len,
-					ret, _LOClient_Set_UpdatedRsc.ursc_offset, _LOClient_Set_UpdatedRsc.ursc_size);
+					ret, ctx->set_updated_rsc.ursc_offset, ctx->set_updated_rsc.ursc_size);
 		}
 		else if (ret == 0) {
 			LOTRACE_NOTICE(
 					"No byte while reading %d bytes (offset=%"PRIu32"/%"PRIu32" of  %s)",
-					data_len, _LOClient_Set_UpdatedRsc.ursc_offset, _LOClient_Set_UpdatedRsc.ursc_size,
+					data_len, ctx->set_updated_rsc.ursc_offset, ctx->set_updated_rsc.ursc_size,
 					rsc_ptr->rsc_name);
 		}
 		else {
 			/*TODO: implement a procedure to retry the operation. at the last offset/md5 */
 			LOTRACE_ERR(
 					"ERROR(%d) while reading %d bytes (offset=%"PRIu32"/%"PRIu32" of  %s)",
-					ret, data_len, _LOClient_Set_UpdatedRsc.ursc_offset, _LOClient_Set_UpdatedRsc.ursc_size,
+					ret, data_len, ctx->set_updated_rsc.ursc_offset, ctx->set_updated_rsc.ursc_size,
 					rsc_ptr->rsc_name);
 		}
 	}
-	else {
-		LOTRACE_ERR("ERROR - No running resource download !");
-		LO_wget_close();
-		ret = -1;
-	}
-	return ret;
+	else {
+		LOTRACE_ERR("ERROR - No running resource download !");
+		if (_LOClient_wget_owner == ctx) {
+			LO_wget_close();
+			_LOClient_wget_owner = NULL;
+		}
+		ret = -1;
+	}
+	return ret;
+#else
+	return -1;
+#endif
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_CycleEx(LiveObjectsClient_Ctx* ctx, int timeout_ms) {
+	int ret;
+
+	if (!ctx->state_connected) {
+		LOTRACE_INF("(tms=%d): ERROR - Not connected !!.", timeout_ms);
+		return -1;
+	}
+
+	LOTRACE_DBG1("(tms=%d) ...", timeout_ms);
+
+	/* Something to publish ? */
+	LOCC_processOutgoing(ctx);
+
+	/* Wait for and process some MQTT messages received from the LiveObject Server */
+	ret = LOCC_waitAndRead(ctx, timeout_ms);
+	if (ret) {
+		LOTRACE_NOTICE("ret=%d => Device Disconnecting ...", ret);
+		ret = LiveObjectsClient_DisconnectEx(ctx);
+		if (ret) {
+			LOTRACE_ERR("Device Disconnect, ret=%d", ret);
+		}
+		return -1;
+	}
+
+	LOCC_processControl(ctx);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int8_t LiveObjectsClient_ThreadStateEx(LiveObjectsClient_Ctx* ctx) {
+	return ctx->state_run;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_StopEx(LiveObjectsClient_Ctx* ctx) {
+	if (ctx->state_run > 0) {
+		ctx->state_run = -1;
+		LOCC_wakeup(ctx);
+		return 0;
+	}
+	return -1;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LiveObjectsClient_RunEx(LiveObjectsClient_Ctx* ctx, LiveObjectsD_CallbackState_t callback) {
+	int ret;
+	uint32_t loop_cnt;
+
+	LO_sys_threadRun();
+	ctx->state_run = 1;
+
+	while (ctx->state_run > 0) {
+		ret = -1;
+		loop_cnt = 0;
+
+		LOCC_connectInit(ctx, 0);
+
+		while (ctx->state_run > 0) {
+			LOTRACE_DBG1("Try connection ...");
+			if (callback) {
+				callback(CSTATE_CONNECTING);
+			}
+			ret = LOCC_connectStart(ctx);
+			if (ret == 0) {
+				break;
+			}
+			LOCC_reconnectWait(ctx, callback);
+		}
+
+		if ((ctx->state_run > 0) && (ctx->state_connected)) {
+
+			LO_sys_threadCheck();
+
+			if (callback) {
+				callback(CSTATE_CONNECTED);
+			}
+
+			LOCC_connectOK(ctx);
+
+		}
+
+		while ((ctx->state_run > 0) && (ctx->state_connected)) {
+
+			++loop_cnt;
+			if ((loop_cnt % 10) == 0) {
+				LOTRACE_DBG1("I am alive - %"PRIu32, loop_cnt);
+			}
+
+			/* Something to publish ? */
+			LOCC_processOutgoing(ctx);
+
+			/* Wait for and process some MQTT messages received from the LiveObject Server,
+			 * or a message to publish (wakeup) */
+			ret = LOCC_waitAndRead(ctx, -1);
+			if (ret) {
+				LOTRACE_ERR("Device Yield, ret=%d", ret);
+				break;
+			}
+			LOCC_processControl(ctx);
+			ret = 0;
+		}
+		LOTRACE_NOTICE("Device Disconnecting ...");
+		ret = LiveObjectsClient_DisconnectEx(ctx);
+		if (ret) {
+			LOTRACE_ERR("Device Disconnect, ret=%d", ret);
+		}
+		if (callback) {
+			callback(CSTATE_DISCONNECTED);
+		}
+		if (ctx->state_run > 0) {
+			LOCC_reconnectWait(ctx, callback);
+		}
+	}
+
+	ctx->state_run = -2;
+
+	if (callback) {
+		callback(CSTATE_DOWN);
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_ThreadStart(LiveObjectsD_CallbackState_t callback) {
+	int ret;
+	LOTRACE_INF("(callback=x%p) ...", callback);
+	ret = LO_sys_threadStart((void const *) callback);
+	if (ret)
+		LOTRACE_ERR("(x%p) ret=%d", callback, ret);
+
+	return ret;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_PublishEx(LiveObjectsClient_Ctx* ctx, const char* topicName,
+		const char* payload_data) {
+#if LOM_MQUEUE
+	char* p_msg;
+	short tlen = strlen(topicName);
+	int len = 1 + 2 + tlen + 1 + strlen(payload_data) + 1;
+#endif
+#if LOC_FEATURE_JOURNAL
+	if ((!ctx->state_connected) && (ctx->journal)) {
+		/* Published after the reconnection */
+		return LO_journal_append(ctx->journal, topicName, payload_data, strlen(payload_data));
+	}
+#endif
+#if LOM_MQUEUE
+	if (MSG_MUTEX_LOCK()) {
+		LOTRACE_ERR("Error to lock mutex");
+		return -1;
+	}
+	p_msg = LO_msg_ring_reserve(&ctx->ring, len);
+	if (p_msg) {
+		char *pc = p_msg;
+		*pc++ = MTYPE_PUB_USR_MSG;     /* 1- Set the message type */
+		memcpy(pc, &tlen, 2);          /* 2- Copy the topic length */
+		pc += 2;
+		strcpy(pc, topicName);         /* 3- Copy the topic */
+		pc += tlen;
+		*pc++ = 0;
+		strcpy(pc, payload_data);      /* 4- Copy the payload */
+		LO_msg_ring_commit(&ctx->ring, p_msg, len);
+	}
+	MSG_MUTEX_UNLOCK();
+	if (p_msg) {
+		LOTRACE_NOTICE("msg=x%p msg_type=x%x", p_msg, *p_msg);
+		if (LOCC_mqPut(ctx, p_msg) == 0) {  /* 5- Put in the queue */
+			return 0;
+		}
+		LOTRACE_ERR("ERROR to enqueue msg -> Free msg %p x%x", p_msg, *p_msg);
+		LO_msg_free(p_msg);
+	}
+	else if (ctx->queue.policy == MQ_POLICY_DROP_NEWEST) {
+		LOTRACE_WARN("Ring full - drop the new msg");
+		return 0;
+	}
+	else {
+		LOTRACE_ERR("ERROR - Message ring full");
+	}
+#else
+	LOTRACE_NOTICE("Not supported");
+#endif
+	return -1;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_PublishBinEx(LiveObjectsClient_Ctx* ctx, const char* topicName,
+		const void* payload_ptr, uint32_t payload_len, uint8_t qos) {
+#if LOM_MQUEUE
+	char* p_msg;
+	short tlen;
+	uint32_t len;
+#endif
+	if ((topicName == NULL) || ((payload_ptr == NULL) && (payload_len)) || (qos > QOS1)) {
+		LOTRACE_ERR("ERROR - Invalid parameters");
+		return -1;
+	}
+#if LOC_FEATURE_JOURNAL
+	if ((!ctx->state_connected) && (ctx->journal)) {
+		/* Published after the reconnection */
+		return LO_journal_append(ctx->journal, topicName, payload_ptr, payload_len);
+	}
+#endif
+	if (LO_sys_threadIsLiveObjectsClient()) {
+		/* Publish now because it is LiveObjects Client thread */
+		return LOCC_MqttPublishBin(ctx, (enum QoS) qos, topicName, payload_ptr, payload_len);
+	}
+#if LOM_MQUEUE
+	tlen = strlen(topicName);
+	len = 1 + 1 + 2 + tlen + 1 + 4 + payload_len;
+	if (MSG_MUTEX_LOCK()) {
+		LOTRACE_ERR("Error to lock mutex");
+		return -1;
+	}
+	p_msg = LO_msg_ring_reserve(&ctx->ring, len);
+	if (p_msg) {
+		char *pc = p_msg;
+		*pc++ = MTYPE_PUB_USR_BIN;     /* 1- Set the message type and the QoS */
+		*pc++ = qos;
+		memcpy(pc, &tlen, 2);          /* 2- Copy the topic length and the topic */
+		pc += 2;
+		memcpy(pc, topicName, tlen + 1);
+		pc += tlen + 1;
+		memcpy(pc, &payload_len, 4);   /* 3- Copy the payload length and the payload */
+		pc += 4;
+		if (payload_len) {
+			memcpy(pc, payload_ptr, payload_len);
+		}
+		LO_msg_ring_commit(&ctx->ring, p_msg, len);
+	}
+	MSG_MUTEX_UNLOCK();
+	if (p_msg) {
+		if (LOCC_mqPut(ctx, p_msg) == 0) {  /* 4- Put in the queue */
+			return 0;
+		}
+		LOTRACE_ERR("ERROR to enqueue msg -> Free msg %p x%x", p_msg, *p_msg);
+		LO_msg_free(p_msg);
+	}
+	else if (ctx->queue.policy == MQ_POLICY_DROP_NEWEST) {
+		LOTRACE_WARN("Ring full - drop the new msg");
+		return 0;
+	}
+	else {
+		LOTRACE_ERR("ERROR - Message ring full");
+	}
+#else
+	LOTRACE_NOTICE("Not supported");
+#endif
+	return -1;
+}
+
+/* ================================================================================= */
+/* Public Functions : default instance
+ * -----------------------------------
+ */
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_Init(void* net_iface_handler, unsigned long long apikey_p1, unsigned long long apikey_p2) {
+	return LiveObjectsClient_InitEx(&_LOClient_ctx, net_iface_handler, apikey_p1, apikey_p2);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetDevId(const char* dev_id) {
+	return LiveObjectsClient_SetDevIdEx(&_LOClient_ctx, dev_id);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetNameSpace(const char* name_space) {
+	return LiveObjectsClient_SetNameSpaceEx(&_LOClient_ctx, name_space);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetPublishWindowEx(LiveObjectsClient_Ctx* ctx, uint32_t window, uint32_t max_bytes,
+		LiveObjectsD_CallbackPublished_t callback, void* user_ctx) {
+#if LOC_MQTT_INFLIGHT
+	LOCCInflight_t* slot;
+	uint32_t slot_sz;
+	LOTRACE_INF("window=%"PRIu32" max_bytes=%"PRIu32" callback=%p", window, max_bytes, callback);
+	if ((window > 0xFFFF) || ((window) && (max_bytes < 64))) {
+		LOTRACE_ERR("ERROR - Invalid window %"PRIu32" (max_bytes %"PRIu32")", window, max_bytes);
+		return -1;
+	}
+	if ((ctx->state_run > 0) || (ctx->state_connected)) {
+		LOTRACE_ERR("ERROR - Must be called before connection");
+		return -1;
+	}
+
+	LOCC_inflightRelease(ctx);
+	if (window == 0) {
+		return 0;
+	}
+
+	slot_sz = (window * sizeof(LOCCInflight_t) + 7) & ~7U;
+	slot = (LOCCInflight_t*) MEM_ALLOC(slot_sz + max_bytes);
+	if (slot == NULL) {
+		LOTRACE_ERR("ERROR - Failed to allocate the window (%"PRIu32" bytes)", slot_sz + max_bytes);
+		return -1;
+	}
+	memset(slot, 0, slot_sz);
+	LO_msg_ring_init(&ctx->inflight.ring, (char*) slot + slot_sz, max_bytes);
+	ctx->inflight.slot = slot;
+	ctx->inflight.cb = callback;
+	ctx->inflight.user_ctx = user_ctx;
+	ctx->inflight.window = (uint16_t) window;
+	return 0;
+#else
+	(void) ctx;
+	(void) window;
+	(void) max_bytes;
+	(void) callback;
+	(void) user_ctx;
+	LOTRACE_ERR("ERROR - not supported in this config");
+	return -1;
+#endif
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetJournalEx(LiveObjectsClient_Ctx* ctx, const char* dir, uint32_t segment_sz, uint64_t quota,
+		uint8_t compress, uint32_t replay_rate) {
+#if LOC_FEATURE_JOURNAL
+	LOJournal_t* journal = NULL;
+	LOTRACE_INF("dir=%s segment_sz=%"PRIu32" quota=%"PRIu64" compress=%u replay_rate=%"PRIu32,
+			(dir) ? dir : "", segment_sz, quota, compress, replay_rate);
+	if ((ctx->state_run > 0) || (ctx->state_connected)) {
+		LOTRACE_ERR("ERROR - Must be called before connection");
+		return -1;
+	}
+	if (dir) {
+		journal = LO_journal_open(dir, segment_sz, quota, compress);
+		if (journal == NULL) {
+			LOTRACE_ERR("ERROR - Failed to open the journal %s", dir);
+			return -1;
+		}
+	}
+	LO_journal_close(ctx->journal);
+	ctx->journal = journal;
+	ctx->journal_rate = replay_rate;
+	TimerInit(&ctx->journal_timer);
+	TimerCountdownMS(&ctx->journal_timer, 0);
+	return 0;
 #else
+	(void) ctx;
+	(void) dir;
+	(void) segment_sz;
+	(void) quota;
+	(void) compress;
+	(void) replay_rate;
+	LOTRACE_ERR("ERROR - not supported in this config");
 	return -1;
 #endif
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_Cycle(int timeout_ms) {
-	int ret;
-
-	if (!_LOClient_state_connected) {
-		LOTRACE_INF("(tms=%d): ERROR - Not connected !!.", timeout_ms);
+int LiveObjectsClient_SetReconnectPolicyEx(LiveObjectsClient_Ctx* ctx, const LiveObjectsD_ReconnectPolicy_t* policy) {
+	if ((ctx->state_run > 0) || (ctx->state_connected)) {
+		LOTRACE_ERR("ERROR - Must be called before connection");
 		return -1;
 	}
+	if (policy == NULL) {
+		ctx->reconnect.first_ms = LOC_RECONNECT_FIRST_MS;
+		ctx->reconnect.base_ms = LOC_RECONNECT_BASE_MS;
+		ctx->reconnect.cap_ms = LOC_RECONNECT_CAP_MS;
+		ctx->reconnect.refused_ms = LOC_RECONNECT_REFUSED_MS;
+		ctx->reconnect.stable_ms = LOC_RECONNECT_STABLE_MS;
+	}
+	else {
+		ctx->reconnect = *policy;
+	}
+	LOTRACE_INF("first=%"PRIu32" base=%"PRIu32" cap=%"PRIu32" refused=%"PRIu32" stable=%"PRIu32" ms",
+			ctx->reconnect.first_ms, ctx->reconnect.base_ms, ctx->reconnect.cap_ms, ctx->reconnect.refused_ms,
+			ctx->reconnect.stable_ms);
+	return 0;
+}
 
-	LOTRACE_DBG1("(tms=%d) ...", timeout_ms);
-
-	/*  -- Pending user messages ? (command responses, ...) */
-#if LOM_MQUEUE
-	LOCC_processPendingMesssage();
-#endif
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_GetReconnectInfoEx(LiveObjectsClient_Ctx* ctx, LiveObjectsD_ReconnectInfo_t* info) {
+	if (info == NULL) {
+		return -1;
+	}
+	*info = ctx->reconnect_info;
+	return 0;
+}
 
-#if LOC_FEATURE_LO_PARAMS
-	/* Something to publish ?  */
-	/*  -- Config Parameters ? */
-	ret = LOCC_processConfig();
-#endif
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetQueue(uint32_t size, LiveObjectsD_QueuePolicy_t policy, uint32_t block_ms) {
+	return LiveObjectsClient_SetQueueEx(&_LOClient_ctx, size, policy, block_ms);
+}
 
-#if LOM_PUSH_ASYNC
-#if LOC_FEATURE_LO_STATUS  && (LOC_MAX_OF_DATA_SET > 0)
-	/*  -- 'Info' ? */
-	ret = LOCC_processStatus(0);
-#endif
-#if  LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
-	/*  -- 'Collected data' ? */
-	ret = LOCC_processData(0);
-#endif
-#endif /* LOM_PUSH_ASYNC */
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetQueueWatermarks(uint32_t high, uint32_t low, LiveObjectsD_CallbackQueueLevel_t callback,
+		void* user_ctx) {
+	return LiveObjectsClient_SetQueueWatermarksEx(&_LOClient_ctx, high, low, callback, user_ctx);
+}
 
-#if LOC_FEATURE_LO_RESOURCES
-	LOCC_processResources(0);
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetEncoding(LiveObjectsD_Encoding_t encoding) {
+	return LiveObjectsClient_SetEncodingEx(&_LOClient_ctx, encoding);
+}
 
-	LOCC_processGetRsc();
-#endif
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetPublishWindow(uint32_t window, uint32_t max_bytes, LiveObjectsD_CallbackPublished_t callback,
+		void* user_ctx) {
+	return LiveObjectsClient_SetPublishWindowEx(&_LOClient_ctx, window, max_bytes, callback, user_ctx);
+}
 
-	/* Get and process some MQTT messages received from the LiveObject Server */
-	ret = LiveObjectsClient_Yield(timeout_ms);
-	if (ret) {
-		LOTRACE_NOTICE("ret=%d => Device Disconnecting ...", ret);
-		ret = LiveObjectsClient_Disconnect();
-		if (ret) {
-			LOTRACE_ERR("Device Disconnect, ret=%d", ret);
-		}
-		return -1;
-	}
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetJournal(const char* dir, uint32_t segment_sz, uint64_t quota, uint8_t compress,
+		uint32_t replay_rate) {
+	return LiveObjectsClient_SetJournalEx(&_LOClient_ctx, dir, segment_sz, quota, compress, replay_rate);
+}
 
-#if LOC_FEATURE_LO_COMMANDS
-	LOCC_controlFeature(&_LOClient_Set_Cmd.cmd_enable, TOPIC_COMMAND);
-#endif
-#if LOC_FEATURE_LO_RESOURCES
-	LOCC_controlFeature(&_LOClient_Set_Rsc.rsc_enable, TOPIC_RSC_UPD);
-#endif
-	return 0;
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetReconnectPolicy(const LiveObjectsD_ReconnectPolicy_t* policy) {
+	return LiveObjectsClient_SetReconnectPolicyEx(&_LOClient_ctx, policy);
 }
 
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_GetReconnectInfo(LiveObjectsD_ReconnectInfo_t* info) {
+	return LiveObjectsClient_GetReconnectInfoEx(&_LOClient_ctx, info);
+}
 
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_AttachCfgParams(const LiveObjectsD_Param_t* param_ptr, int32_t param_nb,
+		LiveObjectsD_CallbackParams_t callback) {
+	return LiveObjectsClient_AttachCfgParamsEx(&_LOClient_ctx, param_ptr, param_nb, callback);
+}
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int8_t LiveObjectsClient_ThreadState(void) {
-	return _LOClient_state_run;
+int LiveObjectsClient_AttachStatus(const LiveObjectsD_Data_t* data_ptr, int32_t data_nb) {
+	return LiveObjectsClient_AttachStatusEx(&_LOClient_ctx, data_ptr, data_nb);
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_Stop(void) {
-	if (_LOClient_state_run > 0) {
-		_LOClient_state_run = -1;
-		return 0;
-	}
-	return -1;
+int LiveObjectsClient_AttachData(uint8_t stream_prefix, const char* stream_id, const char* model, const char* tags,
+		const LiveObjectsD_GpsFix_t* gps_ptr, const LiveObjectsD_Data_t* data_ptr, int32_t data_nb) {
+	return LiveObjectsClient_AttachDataEx(&_LOClient_ctx, stream_prefix, stream_id, model, tags, gps_ptr, data_ptr,
+			data_nb);
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-void LiveObjectsClient_Run(LiveObjectsD_CallbackState_t callback) {
-	int ret;
-	uint32_t loop_cnt;
+int LiveObjectsClient_AttachCommands(const LiveObjectsD_Command_t* cmd_ptr, int32_t cmd_nb,
+		LiveObjectsD_CallbackCommand_t callback) {
+	return LiveObjectsClient_AttachCommandsEx(&_LOClient_ctx, cmd_ptr, cmd_nb, callback);
+}
 
-	LO_sys_threadRun();
-	_LOClient_state_run = 1;
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_ControlCommands(bool enable) {
+	return LiveObjectsClient_ControlCommandsEx(&_LOClient_ctx, enable);
+}
 
-	while (_LOClient_state_run > 0) {
-		ret = -1;
-		loop_cnt = 0;
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_AttachResources(const LiveObjectsD_Resource_t* rsc_ptr, int32_t rsc_nb,
+		LiveObjectsD_CallbackResourceNotify_t ntfyCB, LiveObjectsD_CallbackResourceData_t dataCB) {
+	return LiveObjectsClient_AttachResourcesEx(&_LOClient_ctx, rsc_ptr, rsc_nb, ntfyCB, dataCB);
+}
 
-		LOCC_connectInit(0);
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_ControlResources(bool enable) {
+	return LiveObjectsClient_ControlResourcesEx(&_LOClient_ctx, enable);
+}
 
-		while (_LOClient_state_run > 0) {
-			LOTRACE_DBG1("Try connection ...");
-			if (callback) {
-				callback(CSTATE_CONNECTING);
-			}
-			ret = LOCC_connectStart();
-			if (ret == 0) {
-				break;
-			}
-			WAIT_MS(5000);
-		}
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_ChangeDataStreamId(uint8_t prefix, int data_hdl, const char* stream_id) {
+	return LiveObjectsClient_ChangeDataStreamIdEx(&_LOClient_ctx, prefix, data_hdl, stream_id);
+}
 
-		if ((_LOClient_state_run > 0) && (_LOClient_state_connected)) {
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_RemoveData(int data_hdl) {
+	return LiveObjectsClient_RemoveDataEx(&_LOClient_ctx, data_hdl);
+}
 
-			LO_sys_threadCheck();
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_SetDataBatch(int data_hdl, uint32_t max_samples, uint32_t max_bytes, uint32_t max_latency_ms) {
+	return LiveObjectsClient_SetDataBatchEx(&_LOClient_ctx, data_hdl, max_samples, max_bytes, max_latency_ms);
+}
 
-			if (callback) {
-				callback(CSTATE_CONNECTED);
-			}
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_RemoveCommands(void) {
+	return LiveObjectsClient_RemoveCommandsEx(&_LOClient_ctx);
+}
 
-			LOCC_connectOK();
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_RemoveResources(void) {
+	return LiveObjectsClient_RemoveResourcesEx(&_LOClient_ctx);
+}
 
-		}
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_Connect(void) {
+	return LiveObjectsClient_ConnectEx(&_LOClient_ctx);
+}
 
-		while ((_LOClient_state_run > 0) && (_LOClient_state_connected)) {
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_Disconnect(void) {
+	return LiveObjectsClient_DisconnectEx(&_LOClient_ctx);
+}
 
-			++loop_cnt;
-			if ((loop_cnt % 10) == 0) {
-				LOTRACE_DBG1("I am alive - %"PRIu32, loop_cnt);
-			}
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_Yield(int timeout_ms) {
+	return LiveObjectsClient_YieldEx(&_LOClient_ctx, timeout_ms);
+}
 
-			/*  -- Pending user messages ? (command responses, ...) */
-#if LOM_MQUEUE
-			LOCC_processPendingMesssage();
-#endif
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_PushResources(void) {
+	return LiveObjectsClient_PushResourcesEx(&_LOClient_ctx);
+}
 
-#if LOC_FEATURE_LO_PARAMS
-			/* Something to publish ? */
-			/*  -- Config Parameters ? */
-			ret = LOCC_processConfig();
-#endif
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_PushStatus(int handle) {
+	return LiveObjectsClient_PushStatusEx(&_LOClient_ctx, handle);
+}
 
-#if LOM_PUSH_ASYNC
-#if LOC_FEATURE_LO_STATUS  && (LOC_MAX_OF_DATA_SET > 0)
-			/*  -- 'Info' ? */
-			ret = LOCC_processStatus(0);
-#endif
-#if LOC_FEATURE_LO_DATA && (LOC_MAX_OF_DATA_SET > 0)
-			/*  -- 'Collected data' ? */
-			ret = LOCC_processData(0);
-#endif
-#endif /* LOM_PUSH_ASYNC */
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_PushData(int data_hdl) {
+	return LiveObjectsClient_PushDataEx(&_LOClient_ctx, data_hdl);
+}
 
-#if LOC_FEATURE_LO_RESOURCES
-			LOCC_processResources(0);
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_PushCfgParams(void) {
+	return LiveObjectsClient_PushCfgParamsEx(&_LOClient_ctx);
+}
 
-			LOCC_processGetRsc();
-#endif
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_CommandResponse(int32_t cid, const LiveObjectsD_Data_t* data_ptr, int data_nb) {
+	return LiveObjectsClient_CommandResponseEx(&_LOClient_ctx, cid, data_ptr, data_nb);
+}
 
-			/* Get and process some MQTT messages received from the LiveObject Server */
-			ret = LiveObjectsClient_Yield(100);
-			if (ret) {
-				LOTRACE_ERR("Device Yield, ret=%d", ret);
-				break;
-			}
-#if LOC_FEATURE_LO_COMMANDS
-			LOCC_controlFeature(&_LOClient_Set_Cmd.cmd_enable, TOPIC_COMMAND);
-#endif
-#if LOC_FEATURE_LO_RESOURCES
-			LOCC_controlFeature(&_LOClient_Set_Rsc.rsc_enable, TOPIC_RSC_UPD);
-#endif
-			ret = 0;
-		}
-		LOTRACE_NOTICE("Device Disconnecting ...");
-		ret = LiveObjectsClient_Disconnect();
-		if (ret) {
-			LOTRACE_ERR("Device Disconnect, ret=%d", ret);
-		}
-		if (callback) {
-			callback(CSTATE_DISCONNECTED);
-		}
-		LOTRACE_NOTICE("WAIT 5 seconds ...");
-		WAIT_MS(5000);
-	}
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_RscGetChunck(const LiveObjectsD_Resource_t* rsc_ptr, char* data_ptr, int data_len) {
+	return LiveObjectsClient_RscGetChunckEx(&_LOClient_ctx, rsc_ptr, data_ptr, data_len);
+}
 
-	_LOClient_state_run = -2;
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_Cycle(int timeout_ms) {
+	return LiveObjectsClient_CycleEx(&_LOClient_ctx, timeout_ms);
+}
 
-	if (callback) {
-		callback(CSTATE_DOWN);
-	}
+/* --------------------------------------------------------------------------------- */
+/*  */
+int8_t LiveObjectsClient_ThreadState(void) {
+	return LiveObjectsClient_ThreadStateEx(&_LOClient_ctx);
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LiveObjectsClient_ThreadStart(LiveObjectsD_CallbackState_t callback) {
-	int ret;
-	LOTRACE_INF("(callback=x%p) ...", callback);
-	ret = LO_sys_threadStart((void const *) callback);
-	if (ret)
-		LOTRACE_ERR("(x%p) ret=%d", callback, ret);
+int LiveObjectsClient_Stop(void) {
+	return LiveObjectsClient_StopEx(&_LOClient_ctx);
+}
 
-	return ret;
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LiveObjectsClient_Run(LiveObjectsD_CallbackState_t callback) {
+	LiveObjectsClient_RunEx(&_LOClient_ctx, callback);
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
 int LiveObjectsClient_Publish(const char* topicName, const char* payload_data) {
-#if LOM_MQUEUE
-	char* p_msg;
-	short tlen = strlen(topicName);
-	int len = 1 + 2 + tlen + 1 + strlen(payload_data) + 2;
-	p_msg = (char*) MEM_ALLOC(len);
-	if (p_msg) {
-		char *pc = p_msg;
-		*pc++ = MTYPE_PUB_USR_MSG;     /* 1- Set the message type */
-		memcpy(pc, &tlen, 2);          /* 2- Copy the topic length */
-		pc += 2;
-		strcpy(pc, topicName);         /* 3- Copy the topic */
-		pc += tlen;
-		*pc++ = 0;
-		strcpy(pc, payload_data);      /* 4- Copy the payload */
-		LOTRACE_NOTICE("MEM_ALLOC msg=x%p msg_type=x%x", p_msg, *p_msg);
-		if (LOCC_mqPut(p_msg) == 0) {  /* 5- Put in the queue */
-			return 0;
-		}
-		LOTRACE_ERR("ERROR to enqueue msg -> MEM_FREE msg %p x%x", p_msg, *p_msg);
-		MEM_FREE(p_msg);
-	}
-	else {
-		LOTRACE_ERR("MALLOC ERROR");
-	}
-#else
-	LOTRACE_NOTICE("Not supported");
-#endif
-	return -1;
+	return LiveObjectsClient_PublishEx(&_LOClient_ctx, topicName, payload_data);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_PublishBin(const char* topicName, const void* payload_ptr, uint32_t payload_len,
+		uint8_t qos) {
+	return LiveObjectsClient_PublishBinEx(&_LOClient_ctx, topicName, payload_ptr, payload_len, qos);
 }
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file   loc_core.h
+ * @brief  Internal interface of the LiveObjects Client core,
+ *         used to drive one client instance from an external event loop.
+ *
+ */
+
+#ifndef __loc_core_H_
+#define __loc_core_H_
+
+#include <stdint.h>
+
+#include "liveobjects-client/LiveObjectsClient_Config.h"
+#include "liveobjects-client/LiveObjectsClient_Core.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#if LOC_FEATURE_EVLOOP
+
+/* Returns of LOCC_sessionConnectStart() and LOCC_sessionConnectStep(): the connection (TCP, SSL/TLS handshake
+ * or CONNACK) is in progress, call LOCC_sessionConnectStep() when the socket (LOCC_sessionGetFd) is readable / writable */
+#define LOCC_SESSION_WANT_READ    1
+#define LOCC_SESSION_WANT_WRITE   2
+
+/* Start the connection of the instance to the LiveObjects platform: connect the socket and do the SSL/TLS
+ * handshake, then send the MQTT CONNECT packet, without waiting for the server (only the resolution of the
+ * host name is blocking, at the first connection). When the CONNACK is read, publish the initial messages.
+ * Return 0 (connected), LOCC_SESSION_WANT_xxx, or -1 */
+int LOCC_sessionConnectStart(LiveObjectsClient_Ctx* ctx);
+
+/* Continue the connection. Return 0 (connected), LOCC_SESSION_WANT_xxx, or -1 */
+int LOCC_sessionConnectStep(LiveObjectsClient_Ctx* ctx);
+
+/* Abort the connection in progress (timeout) */
+void LOCC_sessionConnectAbort(LiveObjectsClient_Ctx* ctx);
+
+/* Process one cycle: publish pending messages, then read (readable != 0) or send a keepalive.
+ * Return -1 if the instance has been disconnected. */
+int LOCC_sessionCycle(LiveObjectsClient_Ctx* ctx, uint8_t readable);
+
+uint8_t LOCC_sessionIsConnected(const LiveObjectsClient_Ctx* ctx);
+
+/* Return the socket descriptor of the instance, or -1 if not connected */
+int LOCC_sessionGetFd(LiveObjectsClient_Ctx* ctx);
+
+/* Return the max time (ms) before the next cycle (keepalive, resource transfer, ...),
+ * or -1 if the instance only waits for network data or a wakeup */
+int LOCC_sessionTimeoutMs(LiveObjectsClient_Ctx* ctx);
+
+/* Return the delay (ms) before the next connection attempt, according to the reconnection policy
+ * and to the error of the last attempt (or to the loss of the session) */
+uint32_t LOCC_sessionReconnectMs(LiveObjectsClient_Ctx* ctx);
+
+#if LOC_FEATURE_WAKEUP
+/* Return the eventfd signalled when there is something to publish, or -1 */
+int LOCC_sessionGetWakeupFd(LiveObjectsClient_Ctx* ctx);
+
+void LOCC_sessionWakeupDrain(LiveObjectsClient_Ctx* ctx);
+#endif
+
+#endif /* LOC_FEATURE_EVLOOP */
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __loc_core_H_ */
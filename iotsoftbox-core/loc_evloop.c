@@ -0,0 +1,666 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  loc_evloop.c
+ * @brief Event loop (epoll) to run several LiveObjects Client instances in one thread
+ */
+
+#include "liveobjects-client/LiveObjectsClient_Config.h"
+
+#if LOC_FEATURE_EVLOOP
+
+#include "liveobjects-client/LiveObjectsClient_EvLoop.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#if LOC_FEATURE_WAKEUP
+#include <sys/eventfd.h>
+#endif
+
+#include "loc_core.h"
+#include "loc_sys.h"
+
+#include "liveobjects-sys/loc_trace.h"
+#include "liveobjects-sys/LiveObjectsClient_Platform.h"
+#include "platform_default.h"
+
+/* --------------------------------------------------------------------------------- */
+/* Definitions
+ * -----------
+ */
+
+typedef enum {
+	LOEV_ST_WAIT_CONNECT = 0,  /* Waiting for the next connection attempt */
+	LOEV_ST_HANDSHAKE,         /* Connection (TCP, SSL/TLS handshake, CONNACK) in progress, socket registered in epoll set */
+	LOEV_ST_CONNECTED          /* Connected, socket registered in epoll set */
+} LOEvState_t;
+
+/* No timer */
+#define LOEV_NEVER                    ((uint64_t) -1)
+
+/* Kind of file descriptor registered in the epoll set */
+typedef enum {
+	LOEV_SRC_SOCKET = 0,       /* Socket of a session */
+	LOEV_SRC_WAKEUP            /* Wakeup (eventfd) of a session */
+} LOEvSourceKind_t;
+
+typedef struct {
+	struct LOEvSession* s;
+	uint8_t kind;              /* LOEvSourceKind_t */
+} LOEvSource_t;
+
+typedef struct LOEvSession {
+	LiveObjectsClient_Ctx* ctx;           /*!< Client instance */
+	LiveObjectsClient_EvCallback_t cb;    /*!< User state callback */
+	void* user_ctx;                       /*!< User context given to the callback */
+	uint8_t state;                        /*!< LOEvState_t */
+	uint8_t removed;                      /*!< Removed while the loop is dispatching */
+	int fd;                               /*!< Socket registered in the epoll set, or -1 */
+	int wake_fd;                          /*!< Wakeup eventfd registered in the epoll set, or -1 */
+	LOEvSource_t src_sock;                /*!< epoll data of the socket */
+	LOEvSource_t src_wake;                /*!< epoll data of the wakeup eventfd */
+	int32_t heap_idx;                     /*!< Index in the timer heap, or -1 */
+	uint64_t deadline;                    /*!< Next timer (ms, monotonic clock) */
+	struct LOEvSession* next;
+} LOEvSession_t;
+
+struct LiveObjectsClient_EvLoop {
+	int epfd;                     /*!< epoll descriptor */
+	int wake_fd;                  /*!< eventfd to wake up the loop (stop), or -1 */
+	volatile int8_t state_run;    /*!< 1: running, -1: stop requested, 0: not running */
+	LOEvSession_t* sessions;      /*!< List of the attached sessions */
+	LOEvSession_t* zombies;       /*!< Sessions removed during dispatch, freed at the end of the iteration */
+	LOEvSession_t** heap;         /*!< Min-heap of the session timers */
+	uint32_t heap_nb;
+	uint32_t heap_max;
+};
+
+/* ================================================================================= */
+/* Private Functions
+ * -----------------
+ */
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static uint64_t LOEV_nowMs(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t) ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOEV_heapSwap(LiveObjectsClient_EvLoop* loop, uint32_t i, uint32_t j) {
+	LOEvSession_t* s = loop->heap[i];
+	loop->heap[i] = loop->heap[j];
+	loop->heap[j] = s;
+	loop->heap[i]->heap_idx = i;
+	loop->heap[j]->heap_idx = j;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOEV_heapFix(LiveObjectsClient_EvLoop* loop, uint32_t i) {
+	/* Up */
+	while (i > 0) {
+		uint32_t p = (i - 1) / 2;
+		if (loop->heap[p]->deadline <= loop->heap[i]->deadline) {
+			break;
+		}
+		LOEV_heapSwap(loop, i, p);
+		i = p;
+	}
+	/* Down */
+	for (;;) {
+		uint32_t l = 2 * i + 1;
+		uint32_t m = i;
+		if ((l < loop->heap_nb) && (loop->heap[l]->deadline < loop->heap[m]->deadline)) {
+			m = l;
+		}
+		if ((l + 1 < loop->heap_nb) && (loop->heap[l + 1]->deadline < loop->heap[m]->deadline)) {
+			m = l + 1;
+		}
+		if (m == i) {
+			break;
+		}
+		LOEV_heapSwap(loop, i, m);
+		i = m;
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int LOEV_heapPush(LiveObjectsClient_EvLoop* loop, LOEvSession_t* s) {
+	if (loop->heap_nb >= loop->heap_max) {
+		uint32_t max = (loop->heap_max) ? (2 * loop->heap_max) : 8;
+		LOEvSession_t** heap = (LOEvSession_t**) MEM_ALLOC(max * sizeof(LOEvSession_t*));
+		if (heap == NULL) {
+			LOTRACE_ERR("Failed to allocate the timer heap (%"PRIu32" sessions)", max);
+			return -1;
+		}
+		if (loop->heap) {
+			memcpy(heap, loop->heap, loop->heap_nb * sizeof(LOEvSession_t*));
+			MEM_FREE(loop->heap);
+		}
+		loop->heap = heap;
+		loop->heap_max = max;
+	}
+	s->heap_idx = loop->heap_nb;
+	loop->heap[loop->heap_nb++] = s;
+	LOEV_heapFix(loop, s->heap_idx);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOEV_heapRemove(LiveObjectsClient_EvLoop* loop, LOEvSession_t* s) {
+	uint32_t i = s->heap_idx;
+	if (s->heap_idx < 0) {
+		return;
+	}
+	s->heap_idx = -1;
+	if (--loop->heap_nb != i) {
+		loop->heap[i] = loop->heap[loop->heap_nb];
+		loop->heap[i]->heap_idx = i;
+		LOEV_heapFix(loop, i);
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOEV_schedule(LiveObjectsClient_EvLoop* loop, LOEvSession_t* s, uint64_t deadline) {
+	s->deadline = deadline;
+	if (s->heap_idx >= 0) {
+		LOEV_heapFix(loop, s->heap_idx);
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOEV_notify(LOEvSession_t* s, LiveObjectsD_State_t state) {
+	if (s->cb) {
+		s->cb(s->ctx, state, s->user_ctx);
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Schedule the next connection attempt, after the delay given by the reconnection policy
+ * of the instance */
+static void LOEV_retry(LiveObjectsClient_EvLoop* loop, LOEvSession_t* s) {
+	uint32_t delay = LOCC_sessionReconnectMs(s->ctx);
+	LOEV_schedule(loop, s, LOEV_nowMs() + delay);
+	if ((delay) && (!s->removed)) {
+		LOEV_notify(s, CSTATE_WAITING);
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* The session has been disconnected: its socket is already closed (and so removed
+ * from the epoll set). Schedule a new connection. */
+static void LOEV_lost(LiveObjectsClient_EvLoop* loop, LOEvSession_t* s) {
+	s->fd = -1;
+	s->state = LOEV_ST_WAIT_CONNECT;
+	LOEV_notify(s, CSTATE_DISCONNECTED);
+	if (!s->removed) {
+		LOEV_retry(loop, s);
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Disconnect a connected session (socket still open), or abort its connection */
+static void LOEV_disconnect(LiveObjectsClient_EvLoop* loop, LOEvSession_t* s) {
+	if (s->state == LOEV_ST_WAIT_CONNECT) {
+		return;
+	}
+	if (s->fd >= 0) {
+		epoll_ctl(loop->epfd, EPOLL_CTL_DEL, s->fd, NULL);
+		s->fd = -1;
+	}
+	if (s->state == LOEV_ST_HANDSHAKE) {
+		LOCC_sessionConnectAbort(s->ctx);
+	}
+	else {
+		LiveObjectsClient_DisconnectEx(s->ctx);
+	}
+	s->state = LOEV_ST_WAIT_CONNECT;
+	LOEV_notify(s, CSTATE_DISCONNECTED);
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Register (or update) the socket of the session in the epoll set */
+static int LOEV_watch(LiveObjectsClient_EvLoop* loop, LOEvSession_t* s, uint32_t events) {
+	struct epoll_event ev;
+	int op = (s->fd < 0) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+
+	if (s->fd < 0) {
+		s->fd = LOCC_sessionGetFd(s->ctx);
+	}
+	memset(&ev, 0, sizeof(ev));
+	ev.events = events;
+	ev.data.ptr = &s->src_sock;
+	if ((s->fd < 0) || epoll_ctl(loop->epfd, op, s->fd, &ev)) {
+		LOTRACE_ERR("ctx=%p: failed to register socket %d, errno=%d", s->ctx, s->fd, errno);
+		if (s->fd >= 0) {
+			epoll_ctl(loop->epfd, EPOLL_CTL_DEL, s->fd, NULL);
+		}
+		s->fd = -1;
+		return -1;
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Result of a connection step: in progress (wait for the socket), connected, or failed */
+static void LOEV_connectNext(LiveObjectsClient_EvLoop* loop, LOEvSession_t* s, int ret) {
+	if (ret > 0) {
+		/* TCP connection, SSL/TLS handshake or CONNACK in progress */
+		if (LOEV_watch(loop, s, (ret == LOCC_SESSION_WANT_WRITE) ? EPOLLOUT : EPOLLIN)) {
+			LOCC_sessionConnectAbort(s->ctx);
+			s->state = LOEV_ST_WAIT_CONNECT;
+			LOEV_retry(loop, s);
+			return;
+		}
+		if (s->state != LOEV_ST_HANDSHAKE) {
+			s->state = LOEV_ST_HANDSHAKE;
+			LOEV_schedule(loop, s, LOEV_nowMs() + LOC_EVLOOP_HANDSHAKE_MS);
+		}
+		return;
+	}
+	if (ret < 0) {
+		if (s->fd >= 0) {
+			/* Socket already closed (so removed from the epoll set) */
+			s->fd = -1;
+		}
+		s->state = LOEV_ST_WAIT_CONNECT;
+		LOEV_retry(loop, s);
+		return;
+	}
+
+	if (LOEV_watch(loop, s, EPOLLIN)) {
+		LiveObjectsClient_DisconnectEx(s->ctx);
+		s->state = LOEV_ST_WAIT_CONNECT;
+		LOEV_retry(loop, s);
+		return;
+	}
+
+	s->state = LOEV_ST_CONNECTED;
+	LOEV_schedule(loop, s, LOEV_nowMs());
+	LOEV_notify(s, CSTATE_CONNECTED);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOEV_connect(LiveObjectsClient_EvLoop* loop, LOEvSession_t* s) {
+	LOEV_notify(s, CSTATE_CONNECTING);
+	if (s->removed) {
+		return;
+	}
+	LOEV_connectNext(loop, s, LOCC_sessionConnectStart(s->ctx));
+}
+
+/* --------------------------------------------------------------------------------- */
+/* The socket of a session being connected is ready */
+static void LOEV_handshake(LiveObjectsClient_EvLoop* loop, LOEvSession_t* s) {
+	LOEV_connectNext(loop, s, LOCC_sessionConnectStep(s->ctx));
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOEV_cycle(LiveObjectsClient_EvLoop* loop, LOEvSession_t* s, uint8_t readable) {
+	int left;
+	int ret = LOCC_sessionCycle(s->ctx, readable);
+	if (s->removed) {
+		/* Removed by a user callback */
+		return;
+	}
+	if (ret) {
+		LOEV_lost(loop, s);
+		return;
+	}
+	left = LOCC_sessionTimeoutMs(s->ctx);
+	if ((s->wake_fd < 0) && ((left < 0) || (left > LOC_EVLOOP_TICK_MS))) {
+		/* No wakeup: check periodically the requests of the other threads */
+		left = LOC_EVLOOP_TICK_MS;
+	}
+	if (left < 0) {
+		/* Only network data or wakeup */
+		LOEV_schedule(loop, s, LOEV_NEVER);
+		return;
+	}
+	LOEV_schedule(loop, s, LOEV_nowMs() + ((left) ? left : 1));
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOEV_drain(int fd) {
+#if LOC_FEATURE_WAKEUP
+	uint64_t cnt;
+	if ((read(fd, &cnt, sizeof(cnt)) < 0) && (errno != EAGAIN)) {
+		LOTRACE_WARN("read eventfd failed, errno=%d", errno);
+	}
+#else
+	(void)fd;
+#endif
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOEV_freeZombies(LiveObjectsClient_EvLoop* loop) {
+	while (loop->zombies) {
+		LOEvSession_t* s = loop->zombies;
+		loop->zombies = s->next;
+		MEM_FREE(s);
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LOEV_iterate(LiveObjectsClient_EvLoop* loop, struct epoll_event* events) {
+	uint64_t now;
+	int timeout;
+	int connect_nb = 0;
+	int i, n;
+
+	now = LOEV_nowMs();
+	/* Without wakeup, the stop request is checked periodically */
+	timeout = (loop->wake_fd < 0) ? LOC_EVLOOP_TICK_MS : -1;
+	if ((loop->heap_nb) && (loop->heap[0]->deadline != LOEV_NEVER)) {
+		uint64_t next = loop->heap[0]->deadline;
+		if (next <= now) {
+			timeout = 0;
+		}
+		else if ((timeout < 0) || ((next - now) < (uint64_t) timeout)) {
+			timeout = ((next - now) < 0x7FFFFFFF) ? (int) (next - now) : 0x7FFFFFFF;
+		}
+	}
+
+	n = epoll_wait(loop->epfd, events, LOC_EVLOOP_MAX_EVENTS, timeout);
+	if ((n < 0) && (errno != EINTR)) {
+		LOTRACE_ERR("epoll_wait failed, errno=%d", errno);
+		WAIT_MS(LOC_EVLOOP_TICK_MS);
+	}
+
+	/* Sockets ready to be read, and wakeups */
+	for (i = 0; i < n; i++) {
+		LOEvSource_t* src = (LOEvSource_t*) events[i].data.ptr;
+		LOEvSession_t* s;
+		if (src == NULL) {
+			/* Loop wakeup (stop request) */
+			LOEV_drain(loop->wake_fd);
+			continue;
+		}
+		s = src->s;
+		if (s->removed) {
+			continue;
+		}
+#if LOC_FEATURE_WAKEUP
+		if (src->kind == LOEV_SRC_WAKEUP) {
+			LOCC_sessionWakeupDrain(s->ctx);
+			if (s->state == LOEV_ST_CONNECTED) {
+				LOEV_cycle(loop, s, 0);
+			}
+			continue;
+		}
+#endif
+		if (s->state == LOEV_ST_CONNECTED) {
+			LOEV_cycle(loop, s, 1);
+		}
+		else if (s->state == LOEV_ST_HANDSHAKE) {
+			LOEV_handshake(loop, s);
+		}
+	}
+
+	/* Expired timers */
+	now = LOEV_nowMs();
+	while ((loop->state_run > 0) && (loop->heap_nb) && (loop->heap[0]->deadline <= now)
+			&& (loop->heap[0]->deadline != LOEV_NEVER)) {
+		LOEvSession_t* s = loop->heap[0];
+		if (s->state == LOEV_ST_CONNECTED) {
+			LOEV_cycle(loop, s, 0);
+		}
+		else if (s->state == LOEV_ST_HANDSHAKE) {
+			LOTRACE_WARN("ctx=%p: connection timeout", s->ctx);
+			epoll_ctl(loop->epfd, EPOLL_CTL_DEL, s->fd, NULL);
+			s->fd = -1;
+			LOCC_sessionConnectAbort(s->ctx);
+			s->state = LOEV_ST_WAIT_CONNECT;
+			LOEV_retry(loop, s);
+		}
+		else if (connect_nb < LOC_EVLOOP_CONNECT_BURST) {
+			/* The resolution of the host name (first connection) is blocking, and the
+			 * connections started at once load the server: limit them in one iteration */
+			connect_nb++;
+			LOEV_connect(loop, s);
+		}
+		else {
+			LOEV_schedule(loop, s, now + LOC_EVLOOP_TICK_MS);
+		}
+	}
+
+	LOEV_freeZombies(loop);
+}
+
+/* ================================================================================= */
+/* Public Functions
+ * ----------------
+ */
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+LiveObjectsClient_EvLoop* LiveObjectsClient_EvLoopCreate(void) {
+	LiveObjectsClient_EvLoop* loop;
+
+	loop = (LiveObjectsClient_EvLoop*) MEM_ALLOC(sizeof(LiveObjectsClient_EvLoop));
+	if (loop == NULL) {
+		LOTRACE_ERR("Failed to allocate the event loop");
+		return NULL;
+	}
+	memset(loop, 0, sizeof(LiveObjectsClient_EvLoop));
+
+	loop->wake_fd = -1;
+	loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (loop->epfd < 0) {
+		LOTRACE_ERR("epoll_create1 failed, errno=%d", errno);
+		MEM_FREE(loop);
+		return NULL;
+	}
+#if LOC_FEATURE_WAKEUP
+	loop->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (loop->wake_fd >= 0) {
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.ptr = NULL;
+		if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->wake_fd, &ev)) {
+			close(loop->wake_fd);
+			loop->wake_fd = -1;
+		}
+	}
+	if (loop->wake_fd < 0) {
+		LOTRACE_WARN("No loop wakeup, errno=%d", errno);
+	}
+#endif
+	LOTRACE_INF("loop=%p epfd=%d", loop, loop->epfd);
+	return loop;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LiveObjectsClient_EvLoopDestroy(LiveObjectsClient_EvLoop* loop) {
+	if (loop == NULL) {
+		return;
+	}
+	if (loop->state_run) {
+		LOTRACE_ERR("loop=%p is running", loop);
+		return;
+	}
+	while (loop->sessions) {
+		LiveObjectsClient_EvLoopRemove(loop, loop->sessions->ctx);
+	}
+	LOEV_freeZombies(loop);
+	if (loop->heap) {
+		MEM_FREE(loop->heap);
+	}
+	if (loop->wake_fd >= 0) {
+		close(loop->wake_fd);
+	}
+	close(loop->epfd);
+	MEM_FREE(loop);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_EvLoopAdd(LiveObjectsClient_EvLoop* loop, LiveObjectsClient_Ctx* ctx,
+		LiveObjectsClient_EvCallback_t callback, void* user_ctx) {
+	LOEvSession_t* s;
+
+	if ((loop == NULL) || (ctx == NULL)) {
+		return -1;
+	}
+	for (s = loop->sessions; s; s = s->next) {
+		if (s->ctx == ctx) {
+			LOTRACE_ERR("ctx=%p already in loop=%p", ctx, loop);
+			return -1;
+		}
+	}
+
+	s = (LOEvSession_t*) MEM_ALLOC(sizeof(LOEvSession_t));
+	if (s == NULL) {
+		LOTRACE_ERR("Failed to allocate a session");
+		return -1;
+	}
+	memset(s, 0, sizeof(LOEvSession_t));
+	s->ctx = ctx;
+	s->cb = callback;
+	s->user_ctx = user_ctx;
+	s->state = LOEV_ST_WAIT_CONNECT;
+	s->fd = -1;
+	s->wake_fd = -1;
+	s->src_sock.s = s;
+	s->src_sock.kind = LOEV_SRC_SOCKET;
+	s->src_wake.s = s;
+	s->src_wake.kind = LOEV_SRC_WAKEUP;
+	s->heap_idx = -1;
+	s->deadline = 0; /* connect as soon as possible */
+
+	if (LOEV_heapPush(loop, s)) {
+		MEM_FREE(s);
+		return -1;
+	}
+#if LOC_FEATURE_WAKEUP
+	s->wake_fd = LOCC_sessionGetWakeupFd(ctx);
+	if (s->wake_fd >= 0) {
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.ptr = &s->src_wake;
+		if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, s->wake_fd, &ev)) {
+			LOTRACE_WARN("ctx=%p: failed to register wakeup, errno=%d", ctx, errno);
+			s->wake_fd = -1;
+		}
+	}
+#endif
+	s->next = loop->sessions;
+	loop->sessions = s;
+	LOTRACE_INF("loop=%p: ctx=%p added", loop, ctx);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_EvLoopRemove(LiveObjectsClient_EvLoop* loop, LiveObjectsClient_Ctx* ctx) {
+	LOEvSession_t** pp;
+	LOEvSession_t* s;
+
+	if ((loop == NULL) || (ctx == NULL)) {
+		return -1;
+	}
+	for (pp = &loop->sessions; *pp; pp = &(*pp)->next) {
+		if ((*pp)->ctx == ctx) {
+			break;
+		}
+	}
+	s = *pp;
+	if (s == NULL) {
+		LOTRACE_ERR("ctx=%p not in loop=%p", ctx, loop);
+		return -1;
+	}
+	*pp = s->next;
+
+	LOEV_disconnect(loop, s);
+	LOEV_heapRemove(loop, s);
+	if (s->wake_fd >= 0) {
+		epoll_ctl(loop->epfd, EPOLL_CTL_DEL, s->wake_fd, NULL);
+		s->wake_fd = -1;
+	}
+
+	/* Pending epoll events may still reference this session */
+	s->removed = 1;
+	s->next = loop->zombies;
+	loop->zombies = s;
+	if (loop->state_run == 0) {
+		LOEV_freeZombies(loop);
+	}
+	LOTRACE_INF("loop=%p: ctx=%p removed", loop, ctx);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_EvLoopRun(LiveObjectsClient_EvLoop* loop) {
+	struct epoll_event events[LOC_EVLOOP_MAX_EVENTS];
+	LOEvSession_t* s;
+
+	if ((loop == NULL) || (loop->state_run)) {
+		return -1;
+	}
+
+	LO_sys_threadRun();
+	loop->state_run = 1;
+	LOTRACE_INF("loop=%p: running ...", loop);
+
+	while (loop->state_run > 0) {
+		LOEV_iterate(loop, events);
+	}
+
+	/* Disconnect all sessions, ready to be connected again by a next run */
+	for (s = loop->sessions; s; s = s->next) {
+		LOEV_disconnect(loop, s);
+		LOEV_schedule(loop, s, 0);
+		LOEV_notify(s, CSTATE_DOWN);
+	}
+	LOEV_freeZombies(loop);
+
+	loop->state_run = 0;
+	LOTRACE_INF("loop=%p: stopped", loop);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LiveObjectsClient_EvLoopStop(LiveObjectsClient_EvLoop* loop) {
+	if ((loop) && (loop->state_run > 0)) {
+		loop->state_run = -1;
+#if LOC_FEATURE_WAKEUP
+		if (loop->wake_fd >= 0) {
+			uint64_t one = 1;
+			if (write(loop->wake_fd, &one, sizeof(one)) < 0) {
+				LOTRACE_WARN("write eventfd failed, errno=%d", errno);
+			}
+		}
+#endif
+		return 0;
+	}
+	return -1;
+}
+
+#endif /* LOC_FEATURE_EVLOOP */
@@ -0,0 +1,798 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  loc_journal.c
+ * @brief Persistent journal of the messages published while disconnected (POSIX, mmap)
+ *
+ * Files of the journal directory:
+ * - <seq>.seg : segment, a header followed by the records (memory-mapped),
+ * - <seq>.lz4 : sealed segment, the header followed by the LZ4 block of the records.
+ *
+ * The active segment is created with its full size (zero filled). A record is valid
+ * when its topic length is set: it is written last by LO_journal_commit(), and the
+ * hash of the record detects a torn record after a crash. A replayed record is marked
+ * as done in place when it is acknowledged (not for a compressed segment: its records
+ * may be replayed again after a crash, as with the QoS 1 of MQTT).
+ */
+
+#include "liveobjects-client/LiveObjectsClient_Config.h"
+
+#if LOC_FEATURE_JOURNAL
+
+#include "loc_journal.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if LOC_FEATURE_LZ4
+#include <lz4.h>
+#endif
+
+#include "liveobjects-sys/loc_trace.h"
+#include "liveobjects-sys/LiveObjectsClient_Platform.h"
+#include "platform_default.h"
+
+/* --------------------------------------------------------------------------------- */
+/* Definitions
+ * -----------
+ */
+
+#define LOJ_MAGIC                0x314A4F4CU    /* "LOJ1" */
+
+#define LOJ_SEG_LZ4              0x0001         /* Records compressed (LZ4 block) */
+
+#define LOJ_REC_DONE             0x0001         /* Record replayed */
+
+#define LOJ_PATH_SZ              256
+
+#define LOJ_ALIGN(n)             (((n) + 3U) & ~3U)
+
+typedef enum {
+	LOJ_RD_NONE = 0,           /* No segment loaded */
+	LOJ_RD_ACTIVE,             /* Reading the active segment (mapping of the writer) */
+	LOJ_RD_MAP,                /* Reading a sealed segment, memory-mapped */
+	LOJ_RD_HEAP                /* Reading a compressed segment, decompressed in memory */
+} LOJReadMode_t;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t seq;
+	uint32_t len;              /* Sealed segment: end of the records (header included), 0: not sealed */
+	uint32_t flags;            /* LOJ_SEG_xxx */
+} LOJSegHdr_t;
+
+typedef struct {
+	uint32_t payload_len;
+	uint16_t topic_len;        /* 0: no more record */
+	uint16_t flags;            /* LOJ_REC_xxx */
+	uint32_t hash;             /* FNV-1a of the topic and the payload */
+} LOJRecHdr_t;                 /* followed by the topic, '\0', and the payload */
+
+#define LOJ_REC_SZ(tlen, plen)   LOJ_ALIGN(sizeof(LOJRecHdr_t) + (tlen) + 1 + (plen))
+
+typedef struct LOJSeg {
+	uint32_t seq;
+	uint32_t disk_sz;          /* Size of the file */
+	uint8_t lz4;
+	struct LOJSeg* next;
+} LOJSeg_t;
+
+struct LOJournal {
+	pthread_mutex_t lock;
+	char dir[LOJ_PATH_SZ];
+	uint32_t segment_sz;
+	uint64_t quota;
+	uint64_t disk;             /* Size of all the files */
+	uint8_t compress;
+	uint32_t seq_next;
+	LOJSeg_t* head;            /* Oldest segment */
+	LOJSeg_t* tail;            /* Newest segment, the active one when wmap is set */
+
+	int wfd;                   /* Writer: active segment */
+	char* wmap;
+	uint32_t wpos;
+	uint16_t wtlen;            /* Topic length of the reserved record */
+
+	uint8_t rmode;             /* Reader: LOJReadMode_t, on the head segment */
+	char* rbuf;
+	uint32_t rbuf_sz;
+	uint32_t rpos;             /* Oldest record not acknowledged */
+	uint32_t spos;             /* Next record to be sent */
+	uint32_t rlen;             /* End of the records of a sealed segment */
+	uint8_t busy;              /* A record of the head segment is being published (journal unlocked) */
+	uint8_t drop_head;         /* Quota: the head segment is removed after the publication */
+};
+
+/* Token of a record given to the publish function: sequence number of its segment and offset */
+#define LOJ_TOKEN(seq, pos)      (((uint64_t) (seq) << 32) | (pos))
+
+/* --------------------------------------------------------------------------------- */
+/* Private Functions
+ * -----------------
+ */
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static uint32_t LO_journal_hash(const char* p, uint32_t len, uint32_t h) {
+	while (len--) {
+		h ^= (uint8_t) *p++;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static uint32_t LO_journal_recHash(const LOJRecHdr_t* rec) {
+	return LO_journal_hash((const char*) (rec + 1), rec->topic_len + 1 + rec->payload_len, 2166136261U);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LO_journal_path(const LOJournal_t* j, uint32_t seq, const char* ext, char* path) {
+	snprintf(path, LOJ_PATH_SZ, "%s/%08"PRIx32".%s", j->dir, seq, ext);
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Return the end of the valid records in [pos, limit[ */
+static uint32_t LO_journal_scan(const char* buf, uint32_t pos, uint32_t limit) {
+	while (pos + sizeof(LOJRecHdr_t) <= limit) {
+		const LOJRecHdr_t* rec = (const LOJRecHdr_t*) (buf + pos);
+		uint32_t sz;
+		if (rec->topic_len == 0) {
+			break;
+		}
+		sz = LOJ_REC_SZ(rec->topic_len, rec->payload_len);
+		if ((rec->payload_len > limit) || (pos + sz > limit) || (rec->hash != LO_journal_recHash(rec))) {
+			break;
+		}
+		pos += sz;
+	}
+	return pos;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Insert a segment file found in the directory, in sequence order */
+static void LO_journal_insert(LOJournal_t* j, uint32_t seq, uint8_t lz4, uint32_t disk_sz) {
+	LOJSeg_t** pp = &j->head;
+	LOJSeg_t* seg;
+	char path[LOJ_PATH_SZ];
+
+	while ((*pp) && ((*pp)->seq < seq)) {
+		pp = &(*pp)->next;
+	}
+	if ((*pp) && ((*pp)->seq == seq)) {
+		/* Compressed then crashed before the removal of the segment: keep the compressed one */
+		seg = *pp;
+		LO_journal_path(j, seq, "seg", path);
+		unlink(path);
+		if (lz4) {
+			j->disk -= seg->disk_sz;
+			seg->lz4 = 1;
+			seg->disk_sz = disk_sz;
+			j->disk += disk_sz;
+		}
+		return;
+	}
+	seg = (LOJSeg_t*) MEM_ALLOC(sizeof(LOJSeg_t));
+	if (seg == NULL) {
+		return;
+	}
+	seg->seq = seq;
+	seg->lz4 = lz4;
+	seg->disk_sz = disk_sz;
+	seg->next = *pp;
+	*pp = seg;
+	if (seg->next == NULL) {
+		j->tail = seg;
+	}
+	j->disk += disk_sz;
+	if (seq >= j->seq_next) {
+		j->seq_next = seq + 1;
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Seal a segment of a previous run (crash or no close): find the end of its records */
+static void LO_journal_recover(LOJournal_t* j, LOJSeg_t* seg) {
+	char path[LOJ_PATH_SZ];
+	LOJSegHdr_t* hdr;
+	uint32_t map_sz = seg->disk_sz;
+	char* map;
+	int fd;
+
+	LO_journal_path(j, seg->seq, "seg", path);
+	fd = open(path, O_RDWR);
+	if (fd < 0) {
+		return;
+	}
+	map = (map_sz >= sizeof(LOJSegHdr_t)) ?
+			(char*) mmap(NULL, map_sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : (char*) MAP_FAILED;
+	if (map != (char*) MAP_FAILED) {
+		hdr = (LOJSegHdr_t*) map;
+		if ((hdr->magic == LOJ_MAGIC) && (hdr->len == 0)) {
+			hdr->len = LO_journal_scan(map, sizeof(LOJSegHdr_t), map_sz);
+			LOTRACE_NOTICE("Journal segment %08"PRIx32" recovered, %"PRIu32" bytes", seg->seq, hdr->len);
+			msync(map, sizeof(LOJSegHdr_t), MS_SYNC);
+			if (ftruncate(fd, hdr->len) == 0) {
+				j->disk -= seg->disk_sz;
+				seg->disk_sz = hdr->len;
+				j->disk += seg->disk_sz;
+			}
+		}
+		munmap(map, map_sz);
+	}
+	close(fd);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LO_journal_unload(LOJournal_t* j) {
+	if (j->rmode == LOJ_RD_MAP) {
+		munmap(j->rbuf, j->rbuf_sz);
+	}
+	else if (j->rmode == LOJ_RD_HEAP) {
+		MEM_FREE(j->rbuf);
+	}
+	j->rmode = LOJ_RD_NONE;
+	j->rbuf = NULL;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Remove the oldest segment */
+static void LO_journal_remove(LOJournal_t* j) {
+	LOJSeg_t* seg = j->head;
+	char path[LOJ_PATH_SZ];
+
+	LO_journal_unload(j);
+	LO_journal_path(j, seg->seq, (seg->lz4) ? "lz4" : "seg", path);
+	if (unlink(path)) {
+		LOTRACE_WARN("unlink(%s) failed, errno=%d", path, errno);
+	}
+	j->disk -= seg->disk_sz;
+	j->head = seg->next;
+	if (j->tail == seg) {
+		j->tail = NULL;
+	}
+	MEM_FREE(seg);
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Load the records of the oldest segment (sealed) */
+static int LO_journal_load(LOJournal_t* j) {
+	LOJSeg_t* seg = j->head;
+	char path[LOJ_PATH_SZ];
+	const LOJSegHdr_t* hdr;
+	int fd;
+
+	LO_journal_path(j, seg->seq, (seg->lz4) ? "lz4" : "seg", path);
+	fd = open(path, O_RDWR);
+	if ((fd < 0) || (seg->disk_sz < sizeof(LOJSegHdr_t))) {
+		LOTRACE_ERR("Journal segment %s: open failed, errno=%d", path, errno);
+		if (fd >= 0) {
+			close(fd);
+		}
+		return -1;
+	}
+	if (!seg->lz4) {
+		char* map = (char*) mmap(NULL, seg->disk_sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (map == (char*) MAP_FAILED) {
+			LOTRACE_ERR("Journal segment %s: mmap failed, errno=%d", path, errno);
+			return -1;
+		}
+		j->rmode = LOJ_RD_MAP;
+		j->rbuf = map;
+		j->rbuf_sz = seg->disk_sz;
+	}
+	else {
+#if LOC_FEATURE_LZ4
+		LOJSegHdr_t h;
+		char* src = NULL;
+		char* dst = NULL;
+		int n = -1;
+		if ((read(fd, &h, sizeof(h)) == sizeof(h)) && (h.magic == LOJ_MAGIC) && (h.len >= sizeof(h))) {
+			src = MEM_ALLOC(seg->disk_sz - sizeof(h));
+			dst = MEM_ALLOC(h.len);
+		}
+		if ((src) && (dst) && (read(fd, src, seg->disk_sz - sizeof(h)) == (ssize_t) (seg->disk_sz - sizeof(h)))) {
+			n = LZ4_decompress_safe(src, dst + sizeof(h), (int) (seg->disk_sz - sizeof(h)), (int) (h.len - sizeof(h)));
+		}
+		close(fd);
+		if (src) {
+			MEM_FREE(src);
+		}
+		if (n != (int) (h.len - sizeof(h))) {
+			LOTRACE_ERR("Journal segment %s: decompression failed, rc=%d", path, n);
+			if (dst) {
+				MEM_FREE(dst);
+			}
+			return -1;
+		}
+		memcpy(dst, &h, sizeof(h));
+		j->rmode = LOJ_RD_HEAP;
+		j->rbuf = dst;
+		j->rbuf_sz = h.len;
+#else
+		close(fd);
+		LOTRACE_ERR("Journal segment %s: compressed, not supported in this config", path);
+		return -1;
+#endif
+	}
+	hdr = (const LOJSegHdr_t*) j->rbuf;
+	if ((hdr->magic != LOJ_MAGIC) || (hdr->len < sizeof(LOJSegHdr_t)) || (hdr->len > j->rbuf_sz)) {
+		LOTRACE_ERR("Journal segment %s: invalid header", path);
+		LO_journal_unload(j);
+		return -1;
+	}
+	j->rpos = j->spos = sizeof(LOJSegHdr_t);
+	j->rlen = hdr->len;
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Move the oldest record not acknowledged over the acknowledged ones */
+static void LO_journal_advance(LOJournal_t* j) {
+	while (j->rpos < j->spos) {
+		const LOJRecHdr_t* rec = (const LOJRecHdr_t*) (j->rbuf + j->rpos);
+		if (!(rec->flags & LOJ_REC_DONE)) {
+			break;
+		}
+		j->rpos += LOJ_REC_SZ(rec->topic_len, rec->payload_len);
+	}
+}
+
+#if LOC_FEATURE_LZ4
+/* --------------------------------------------------------------------------------- */
+/* Compress the active segment (being sealed) in a new file. Return 0 if done. */
+static int LO_journal_compress(LOJournal_t* j) {
+	LOJSeg_t* seg = j->tail;
+	char path[LOJ_PATH_SZ];
+	char tmp[LOJ_PATH_SZ];
+	int bound = LZ4_compressBound((int) (j->wpos - sizeof(LOJSegHdr_t)));
+	char* out = MEM_ALLOC(sizeof(LOJSegHdr_t) + bound);
+	uint32_t len;
+	int n, fd;
+
+	if (out == NULL) {
+		return -1;
+	}
+	n = LZ4_compress_default(j->wmap + sizeof(LOJSegHdr_t), out + sizeof(LOJSegHdr_t),
+			(int) (j->wpos - sizeof(LOJSegHdr_t)), bound);
+	if ((n <= 0) || (sizeof(LOJSegHdr_t) + n >= j->wpos)) {
+		/* Not worth it */
+		MEM_FREE(out);
+		return -1;
+	}
+	memcpy(out, j->wmap, sizeof(LOJSegHdr_t));
+	((LOJSegHdr_t*) out)->flags |= LOJ_SEG_LZ4;
+	len = sizeof(LOJSegHdr_t) + n;
+
+	LO_journal_path(j, seg->seq, "tmp", tmp);
+	fd = open(tmp, O_CREAT | O_WRONLY | O_TRUNC, 0600);
+	n = (fd >= 0) ? (int) write(fd, out, len) : -1;
+	if ((fd >= 0) && (fsync(fd) != 0)) {
+		n = -1;
+	}
+	if (fd >= 0) {
+		close(fd);
+	}
+	MEM_FREE(out);
+	LO_journal_path(j, seg->seq, "lz4", path);
+	if ((n != (int) len) || (rename(tmp, path))) {
+		LOTRACE_ERR("Journal segment %s: write failed, errno=%d", path, errno);
+		unlink(tmp);
+		return -1;
+	}
+	LO_journal_path(j, seg->seq, "seg", path);
+	unlink(path);
+
+	LOTRACE_DBG1("Journal segment %08"PRIx32" compressed: %"PRIu32" -> %"PRIu32" bytes", seg->seq, j->wpos, len);
+	j->disk -= seg->disk_sz;
+	seg->disk_sz = len;
+	seg->lz4 = 1;
+	j->disk += len;
+	return 0;
+}
+#endif
+
+/* --------------------------------------------------------------------------------- */
+/* Seal the active segment */
+static void LO_journal_seal(LOJournal_t* j) {
+	LOJSeg_t* seg = j->tail;
+	LOJSegHdr_t* hdr = (LOJSegHdr_t*) j->wmap;
+	uint8_t keep_map = (j->rmode == LOJ_RD_ACTIVE);
+
+	hdr->len = j->wpos;
+	msync(j->wmap, j->wpos, MS_SYNC);
+
+	if (keep_map) {
+		/* Being replayed: the mapping is given to the reader */
+		j->rmode = LOJ_RD_MAP;
+		j->rbuf_sz = j->segment_sz;
+		j->rlen = j->wpos;
+	}
+#if LOC_FEATURE_LZ4
+	else if ((j->compress) && (LO_journal_compress(j) == 0)) {
+		munmap(j->wmap, j->segment_sz);
+		close(j->wfd);
+		j->wmap = NULL;
+		j->wfd = -1;
+		return;
+	}
+#endif
+	if (ftruncate(j->wfd, j->wpos) == 0) {
+		j->disk -= seg->disk_sz;
+		seg->disk_sz = j->wpos;
+		j->disk += seg->disk_sz;
+	}
+	if (!keep_map) {
+		munmap(j->wmap, j->segment_sz);
+	}
+	close(j->wfd);
+	j->wmap = NULL;
+	j->wfd = -1;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Seal the active segment (if any), enforce the quota, and create a new segment */
+static int LO_journal_roll(LOJournal_t* j) {
+	char path[LOJ_PATH_SZ];
+	LOJSegHdr_t* hdr;
+	LOJSeg_t* seg;
+	char* map;
+	int fd;
+
+	if (j->wmap) {
+		LO_journal_seal(j);
+	}
+
+	while ((j->head) && (j->disk + j->segment_sz > j->quota)) {
+		LOTRACE_WARN("Journal quota reached (%"PRIu64" bytes): drop the segment %08"PRIx32, j->quota, j->head->seq);
+		if (j->busy) {
+			/* Being published: removed just after */
+			j->drop_head = 1;
+			break;
+		}
+		LO_journal_remove(j);
+	}
+
+	seg = (LOJSeg_t*) MEM_ALLOC(sizeof(LOJSeg_t));
+	if (seg == NULL) {
+		return -1;
+	}
+	LO_journal_path(j, j->seq_next, "seg", path);
+	fd = open(path, O_CREAT | O_RDWR | O_TRUNC, 0600);
+	if ((fd < 0) || (ftruncate(fd, j->segment_sz))) {
+		LOTRACE_ERR("Journal segment %s: create failed, errno=%d", path, errno);
+		if (fd >= 0) {
+			close(fd);
+			unlink(path);
+		}
+		MEM_FREE(seg);
+		return -1;
+	}
+	map = (char*) mmap(NULL, j->segment_sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == (char*) MAP_FAILED) {
+		LOTRACE_ERR("Journal segment %s: mmap failed, errno=%d", path, errno);
+		close(fd);
+		unlink(path);
+		MEM_FREE(seg);
+		return -1;
+	}
+	hdr = (LOJSegHdr_t*) map;
+	hdr->magic = LOJ_MAGIC;
+	hdr->seq = j->seq_next;
+
+	seg->seq = j->seq_next++;
+	seg->lz4 = 0;
+	seg->disk_sz = j->segment_sz;
+	seg->next = NULL;
+	if (j->tail) {
+		j->tail->next = seg;
+	}
+	else {
+		j->head = seg;
+	}
+	j->tail = seg;
+	j->disk += seg->disk_sz;
+
+	j->wfd = fd;
+	j->wmap = map;
+	j->wpos = sizeof(LOJSegHdr_t);
+	LOTRACE_DBG1("Journal segment %08"PRIx32" created (disk %"PRIu64"/%"PRIu64" bytes)", seg->seq, j->disk, j->quota);
+	return 0;
+}
+
+/* ================================================================================= */
+/* Public Functions
+ * ----------------
+ */
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+LOJournal_t* LO_journal_open(const char* dir, uint32_t segment_sz, uint64_t quota, uint8_t compress) {
+	LOJournal_t* j;
+	LOJSeg_t* seg;
+	struct dirent* ent;
+	DIR* d;
+
+	if ((dir == NULL) || (strlen(dir) + 16 >= LOJ_PATH_SZ) || (segment_sz < 1024)
+			|| (quota < 2 * (uint64_t) segment_sz)) {
+		LOTRACE_ERR("Invalid parameters");
+		return NULL;
+	}
+#if !LOC_FEATURE_LZ4
+	if (compress) {
+		LOTRACE_WARN("LZ4 compression not supported in this config");
+		compress = 0;
+	}
+#endif
+	if ((mkdir(dir, 0700)) && (errno != EEXIST)) {
+		LOTRACE_ERR("mkdir(%s) failed, errno=%d", dir, errno);
+		return NULL;
+	}
+	d = opendir(dir);
+	if (d == NULL) {
+		LOTRACE_ERR("opendir(%s) failed, errno=%d", dir, errno);
+		return NULL;
+	}
+	j = (LOJournal_t*) MEM_ALLOC(sizeof(LOJournal_t));
+	if (j == NULL) {
+		closedir(d);
+		return NULL;
+	}
+	memset(j, 0, sizeof(LOJournal_t));
+	pthread_mutex_init(&j->lock, NULL);
+	strcpy(j->dir, dir);
+	j->segment_sz = segment_sz & ~3U;
+	j->quota = quota;
+	j->compress = compress;
+	j->seq_next = 1;
+	j->wfd = -1;
+
+	while ((ent = readdir(d)) != NULL) {
+		char path[LOJ_PATH_SZ];
+		struct stat st;
+		uint32_t seq;
+		int n = 0;
+		if ((sscanf(ent->d_name, "%8"SCNx32"%n", &seq, &n) != 1) || (n != 8) || (ent->d_name[8] != '.')) {
+			continue;
+		}
+		snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+		if (!strcmp(ent->d_name + 9, "tmp")) {
+			unlink(path);
+		}
+		else if (((!strcmp(ent->d_name + 9, "seg")) || (!strcmp(ent->d_name + 9, "lz4")))
+				&& (stat(path, &st) == 0)) {
+			LO_journal_insert(j, seq, (ent->d_name[9] == 'l'), (uint32_t) st.st_size);
+		}
+	}
+	closedir(d);
+
+	for (seg = j->head; seg; seg = seg->next) {
+		if (!seg->lz4) {
+			LO_journal_recover(j, seg);
+		}
+	}
+	LOTRACE_INF("Journal %s: %"PRIu64" bytes to replay", dir, j->disk);
+	return j;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_journal_close(LOJournal_t* j) {
+	if (j == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&j->lock);
+	if (j->rmode == LOJ_RD_ACTIVE) {
+		j->rmode = LOJ_RD_NONE;
+	}
+	if (j->wmap) {
+		LO_journal_seal(j);
+	}
+	LO_journal_unload(j);
+	while (j->head) {
+		LOJSeg_t* seg = j->head;
+		j->head = seg->next;
+		MEM_FREE(seg);
+	}
+	pthread_mutex_unlock(&j->lock);
+	pthread_mutex_destroy(&j->lock);
+	MEM_FREE(j);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+char* LO_journal_reserve(LOJournal_t* j, const char* topic, uint32_t max_len) {
+	size_t tlen = strlen(topic);
+	uint32_t need = LOJ_REC_SZ(tlen, max_len);
+	LOJRecHdr_t* rec;
+
+	if ((tlen == 0) || (tlen > 0xFFFF) || (need > j->segment_sz - sizeof(LOJSegHdr_t))) {
+		LOTRACE_ERR("Record too long (%"PRIu32" bytes) for the journal segment", need);
+		return NULL;
+	}
+	pthread_mutex_lock(&j->lock);
+	if (((j->wmap == NULL) || (j->wpos + need > j->segment_sz)) && (LO_journal_roll(j))) {
+		pthread_mutex_unlock(&j->lock);
+		return NULL;
+	}
+	rec = (LOJRecHdr_t*) (j->wmap + j->wpos);
+	rec->flags = 0;
+	memcpy(rec + 1, topic, tlen + 1);
+	j->wtlen = (uint16_t) tlen;
+	return (char*) (rec + 1) + tlen + 1;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_journal_commit(LOJournal_t* j, const char* payload, uint32_t len) {
+	LOJRecHdr_t* rec = (LOJRecHdr_t*) (j->wmap + j->wpos);
+	if (payload) {
+		rec->payload_len = len;
+		rec->hash = LO_journal_hash((const char*) (rec + 1), j->wtlen + 1 + len, 2166136261U);
+		/* Now a valid record */
+		__atomic_store_n(&rec->topic_len, j->wtlen, __ATOMIC_RELEASE);
+		j->wpos += LOJ_REC_SZ(j->wtlen, len);
+	}
+	pthread_mutex_unlock(&j->lock);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_journal_append(LOJournal_t* j, const char* topic, const void* payload, uint32_t len) {
+	char* p = LO_journal_reserve(j, topic, len);
+	if (p == NULL) {
+		return -1;
+	}
+	memcpy(p, payload, len);
+	LO_journal_commit(j, p, len);
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_journal_replay(LOJournal_t* j, uint32_t max_nb, LOJournalPublish_t publish, void* user) {
+	uint32_t n = 0;
+
+	pthread_mutex_lock(&j->lock);
+	while ((n < max_nb) && (!j->busy)) {
+		LOJRecHdr_t* rec;
+		uint32_t limit, sz, pos;
+		int rc;
+
+		if (j->rmode == LOJ_RD_NONE) {
+			if (j->head == NULL) {
+				break;
+			}
+			if ((j->head == j->tail) && (j->wmap)) {
+				j->rmode = LOJ_RD_ACTIVE;
+				j->rbuf = j->wmap;
+				j->rpos = j->spos = sizeof(LOJSegHdr_t);
+			}
+			else if (LO_journal_load(j)) {
+				LOTRACE_ERR("Journal segment %08"PRIx32" dropped", j->head->seq);
+				LO_journal_remove(j);
+				continue;
+			}
+		}
+
+		limit = (j->rmode == LOJ_RD_ACTIVE) ? j->wpos : j->rlen;
+		pos = j->spos;
+		rec = (LOJRecHdr_t*) (j->rbuf + pos);
+		sz = ((pos + sizeof(LOJRecHdr_t) <= limit) && (rec->topic_len)) ?
+				LOJ_REC_SZ(rec->topic_len, rec->payload_len) : 0;
+		if ((sz) && ((pos + sz > limit) || (rec->hash != LO_journal_recHash(rec)))) {
+			LOTRACE_WARN("Journal segment %08"PRIx32": invalid record at %"PRIu32, j->head->seq, pos);
+			sz = 0;
+		}
+		if (sz == 0) {
+			if ((j->rmode == LOJ_RD_ACTIVE) || (j->rpos < pos)) {
+				/* Wait for the next records, or for the acknowledges of the sent ones */
+				break;
+			}
+			/* All the records of this segment are replayed */
+			LO_journal_remove(j);
+			continue;
+		}
+
+		j->spos = pos + sz;
+		if (rec->flags & LOJ_REC_DONE) {
+			/* Done in a previous run */
+			LO_journal_advance(j);
+			continue;
+		}
+		/* Published without the lock: the head segment is kept (busy), the writer only appends */
+		j->busy = 1;
+		pthread_mutex_unlock(&j->lock);
+		rc = publish(user, (const char*) (rec + 1), (const char*) (rec + 1) + rec->topic_len + 1, rec->payload_len,
+				LOJ_TOKEN(j->head->seq, pos));
+		pthread_mutex_lock(&j->lock);
+		j->busy = 0;
+		if (j->drop_head) {
+			j->drop_head = 0;
+			LO_journal_remove(j);
+			if (rc == 0) {
+				n++;
+			}
+			continue;
+		}
+		if (rc) {
+			/* Sent again at the next replay */
+			if (j->spos > pos) {
+				j->spos = pos;
+			}
+			break;
+		}
+		n++;
+	}
+	pthread_mutex_unlock(&j->lock);
+	return (int) n;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_journal_ack(LOJournal_t* j, uint64_t token) {
+	uint32_t pos = (uint32_t) token;
+	pthread_mutex_lock(&j->lock);
+	/* Only the records of the head segment are sent before their acknowledge */
+	if ((j->head) && (j->rmode != LOJ_RD_NONE) && (j->head->seq == (uint32_t) (token >> 32))
+			&& (pos >= j->rpos) && (pos < j->spos)) {
+		LOJRecHdr_t* rec = (LOJRecHdr_t*) (j->rbuf + pos);
+		rec->flags |= LOJ_REC_DONE;
+		LO_journal_advance(j);
+	}
+	pthread_mutex_unlock(&j->lock);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_journal_rewind(LOJournal_t* j) {
+	pthread_mutex_lock(&j->lock);
+	if (j->rmode != LOJ_RD_NONE) {
+		j->spos = j->rpos;
+	}
+	pthread_mutex_unlock(&j->lock);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+uint8_t LO_journal_pending(LOJournal_t* j) {
+	uint8_t ret;
+	pthread_mutex_lock(&j->lock);
+	if (j->head == NULL) {
+		ret = 0;
+	}
+	else if (j->rmode == LOJ_RD_ACTIVE) {
+		ret = (j->wpos > j->spos) ? 1 : 0;
+	}
+	else if (j->rmode != LOJ_RD_NONE) {
+		/* Next records, or next segment (0: waiting for the acknowledges) */
+		ret = ((j->spos < j->rlen) || (j->rpos == j->spos)) ? 1 : 0;
+	}
+	else if ((j->head == j->tail) && (j->wmap)) {
+		ret = (j->wpos > sizeof(LOJSegHdr_t)) ? 1 : 0;
+	}
+	else {
+		ret = 1;
+	}
+	pthread_mutex_unlock(&j->lock);
+	return ret;
+}
+
+#endif /* LOC_FEATURE_JOURNAL */
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file   loc_journal.h
+ * @brief  Persistent journal of the messages published while disconnected (store-and-forward).
+ *
+ * Append-only segments, memory-mapped, in a directory of the file system:
+ * - the records (topic and payload) are built in place in the active segment,
+ * - a full segment is sealed (and optionally LZ4 compressed), a new one is created,
+ * - the records are replayed in order, marked as done when acknowledged, and a replayed segment is removed,
+ * - the disk quota is enforced by removing the oldest segments (oldest messages dropped first).
+ */
+
+#ifndef __loc_journal_H_
+#define __loc_journal_H_
+
+#include <stdint.h>
+
+#include "liveobjects-client/LiveObjectsClient_Config.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#if LOC_FEATURE_JOURNAL
+
+typedef struct LOJournal LOJournal_t;
+
+/* Called for each replayed record (journal not locked), return 0 if the record is sent.
+ * It is marked as done by LO_journal_ack(token), when its PUBACK is received (possibly before the return). */
+typedef int (*LOJournalPublish_t)(void* user, const char* topic, const char* payload, uint32_t len, uint64_t token);
+
+/* Open (or create) the journal in the directory 'dir'. The records of a previous run are kept. */
+LOJournal_t* LO_journal_open(const char* dir, uint32_t segment_sz, uint64_t quota, uint8_t compress);
+
+void LO_journal_close(LOJournal_t* j);
+
+/* Reserve room for a record of max 'max_len' bytes of payload, return where the payload is to be written.
+ * The journal stays locked until LO_journal_commit() (len 0: cancel). */
+char* LO_journal_reserve(LOJournal_t* j, const char* topic, uint32_t max_len);
+
+void LO_journal_commit(LOJournal_t* j, const char* payload, uint32_t len);
+
+int LO_journal_append(LOJournal_t* j, const char* topic, const void* payload, uint32_t len);
+
+/* Replay max 'max_nb' records, in order, from the first record not yet sent. Stop at the first record not sent,
+ * and at the end of a segment until all its records are acknowledged.
+ * Return the number of sent records, or -1 on error. */
+int LO_journal_replay(LOJournal_t* j, uint32_t max_nb, LOJournalPublish_t publish, void* user);
+
+/* The record is acknowledged: marked as done */
+void LO_journal_ack(LOJournal_t* j, uint64_t token);
+
+/* The records sent but not acknowledged are to be sent again (lost with the session) */
+void LO_journal_rewind(LOJournal_t* j);
+
+/* Return 1 if there is something to replay */
+uint8_t LO_journal_pending(LOJournal_t* j);
+
+#endif /* LOC_FEATURE_JOURNAL */
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __loc_journal_H_ */
@@ -108,156 +108,147 @@ LiveObjectsD_Type_t LO_getDataTypeFromStrL(const char* p, uint32_t len) {
 }
 
 /* --------------------------------------------------------------------------------- */
-/*  */
-int LO_json_begin(char *pbuf, uint32_t sz) {
-	int rc;
-	rc = snprintf(pbuf, sz, "{");
-	if (rc != 1) {
-		LOTRACE_ERR("failed %d", rc);
-		return -1;
+/* Append n bytes, or set the overflow flag if they do not fit (with the final NUL) */
+static void LO_json_put(LOJsonWriter_t* w, const char* p, uint32_t n) {
+	if (w->overflow) {
+		return;
 	}
-	return 0;
+	if (n >= w->size - w->len) {
+		w->overflow = 1;
+		return;
+	}
+	memcpy(w->buf + w->len, p, n);
+	w->len += n;
+	w->buf[w->len] = 0;
 }
 
+#define LO_json_puts(w, s)      LO_json_put((w), (s), strlen(s))
+#define LO_json_putl(w, s)      LO_json_put((w), (s), sizeof(s) - 1)    /* literal string */
+
 /* --------------------------------------------------------------------------------- */
-/*  */
-int LO_json_end(char *pbuf, uint32_t sz) {
-	int rc;
-	int len = sz - strlen(pbuf);
-	char* pcur = pbuf + strlen(pbuf);
-	if (*(pcur - 1) == ',') {
-		pcur--;
-		len++;
-	}
-	rc = snprintf(pcur, sz, "}");
-	if (rc != 1) {
-		LOTRACE_ERR("failed %d", rc);
-		return -1;
+/* Append a formatted number (LO_json_xtoa) followed by ',' */
+#define LO_json_put_num(w, xtoa, value) \
+	do { \
+		char num[LO_JSON_NUM_SZ + 1]; \
+		int n = xtoa(num, value); \
+		num[n++] = ','; \
+		LO_json_put((w), num, n); \
+	} while (0)
+
+/* --------------------------------------------------------------------------------- */
+/* Remove the last ',' before closing an object or an array */
+static void LO_json_unput_comma(LOJsonWriter_t* w) {
+	if ((!w->overflow) && (w->len > 0) && (w->buf[w->len - 1] == ',')) {
+		w->buf[--w->len] = 0;
 	}
-	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* "name": */
+static void LO_json_put_name(LOJsonWriter_t* w, const char* name) {
+	LO_json_putl(w, "\"");
+	LO_json_puts(w, name);
+	LO_json_putl(w, "\":");
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LO_json_add_section_start(const char* section_name, char *pbuf, uint32_t sz) {
-	int rc;
-	int len = sz - strlen(pbuf);
-	char* pcur = pbuf + strlen(pbuf);
-	rc = snprintf(pcur, len, "\"%s\": {", section_name);
-	if (rc < 0) {
-		LOTRACE_ERR("(%s): failed, rc=%d", section_name, rc);
-		return -1;
+void LO_json_init(LOJsonWriter_t* w, char *pbuf, uint32_t sz) {
+	w->buf = pbuf;
+	w->size = sz;
+	w->len = 0;
+	w->overflow = (sz == 0) ? 1 : 0;
+	if (sz) {
+		*pbuf = 0;
 	}
-	return 0;
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LO_json_add_section_end(char *pbuf, uint32_t sz) {
-	int rc;
-	int len = sz - strlen(pbuf);
-	char* pcur = pbuf + strlen(pbuf);
-	if (*(pcur - 1) == ',') {
-		pcur--;
-		len++;
-	}
-	rc = snprintf(pcur, len, "},");
-	if (rc != 2) {
-		LOTRACE_ERR("failed, rc=%d", rc);
-		return -1;
+const char* LO_json_result(LOJsonWriter_t* w) {
+	if (w->overflow) {
+		LOTRACE_ERR("failed, buffer too short (size=%"PRIu32" len=%"PRIu32")", w->size, w->len);
+		return NULL;
 	}
-	return 0;
+	return w->buf;
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LO_json_begin_section(char *pbuf, uint32_t sz, const char* section_name) {
-	int rc;
-	rc = snprintf(pbuf, sz, "{\"%s\":{", section_name);
-	if (rc <= 0) {
-		LOTRACE_ERR("failed %d", rc);
-		return -1;
-	}
-	if (rc == (int) sz) {
-		LOTRACE_ERR("too short %d", rc);
-		return -1;
-	}
-	return 0;
+void LO_json_begin(LOJsonWriter_t* w) {
+	LO_json_putl(w, "{");
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LO_json_end_section(char *pbuf, uint32_t sz) {
-	int rc;
-	int len = sz - strlen(pbuf);
-	char* pcur = pbuf + strlen(pbuf);
-	if (*(pcur - 1) == ',') {
-		pcur--;
-		len++;
-	}
-	rc = snprintf(pcur, len, "}}");
-	if (rc != 2) {
-		LOTRACE_ERR("failed %d != 2", rc);
-		return -1;
-	}
-	return 0;
+void LO_json_end(LOJsonWriter_t* w) {
+	LO_json_unput_comma(w);
+	LO_json_putl(w, "}");
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LO_json_add_name_int(const char* name, int32_t value, char *pbuf, uint32_t sz) {
-	int rc;
-	int len = sz - strlen(pbuf);
-	char* pcur = pbuf + strlen(pbuf);
-
-	rc = snprintf(pcur, len, "\"%s\":%"PRIi32",", name, value);
-	if (rc < 0) {
-		LOTRACE_ERR("(%s, %"PRIi32"): failed, rc=%d", name, value, rc);
-		return -1;
-	}
-	return 0;
+void LO_json_add_section_start(LOJsonWriter_t* w, const char* section_name) {
+	LO_json_put_name(w, section_name);
+	LO_json_putl(w, " {");
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LO_json_add_name_str(const char* name, const char* value, char *pbuf, uint32_t sz) {
-	int rc;
-	int len = sz - strlen(pbuf);
-	char* pcur = pbuf + strlen(pbuf);
-
-	rc = snprintf(pcur, len, "\"%s\":\"%s\",", name, value);
-	if (rc < 0) {
-		LOTRACE_ERR("(%s, %s): failed, rc=%d", name, value, rc);
-		return -1;
-	}
-	return 0;
+void LO_json_add_section_end(LOJsonWriter_t* w) {
+	LO_json_unput_comma(w);
+	LO_json_putl(w, "},");
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LO_json_add_name_array(const char* name, const char* array, char *pbuf, uint32_t sz) {
-	int rc;
-	int len = sz - strlen(pbuf);
-	char* pcur = pbuf + strlen(pbuf);
-
-	rc = snprintf(pcur, len, "\"%s\":[%s],", name, array);
-	if (rc < 0) {
-		LOTRACE_ERR("(%s, %s): failed, rc=%d", name, array, rc);
-		return -1;
-	}
-	return 0;
+void LO_json_begin_section(LOJsonWriter_t* w, const char* section_name) {
+	LO_json_putl(w, "{");
+	LO_json_put_name(w, section_name);
+	LO_json_putl(w, "{");
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LO_json_add_item(const LiveObjectsD_Data_t* data_ptr, char *pbuf, uint32_t sz) {
-	int rc;
-	short i;
-	short dim;
-	char* data_value_ptr;
-	int len = sz - strlen(pbuf);
-	char* pcur = pbuf + strlen(pbuf);
+void LO_json_end_section(LOJsonWriter_t* w) {
+	LO_json_unput_comma(w);
+	LO_json_putl(w, "}}");
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_json_add_name_int(LOJsonWriter_t* w, const char* name, int32_t value) {
+	LO_json_put_name(w, name);
+	LO_json_put_num(w, LO_json_itoa, value);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_json_add_name_str(LOJsonWriter_t* w, const char* name, const char* value) {
+	LO_json_put_name(w, name);
+	LO_json_putl(w, "\"");
+	LO_json_puts(w, value);
+	LO_json_putl(w, "\",");
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_json_add_name_array(LOJsonWriter_t* w, const char* name, const char* array) {
+	LO_json_put_name(w, name);
+	LO_json_putl(w, "[");
+	LO_json_puts(w, array);
+	LO_json_putl(w, "],");
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_json_add_raw(LOJsonWriter_t* w, const char* p, uint32_t len) {
+	LO_json_put(w, p, len);
+}
 
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_json_add_item(LOJsonWriter_t* w, const LiveObjectsD_Data_t* data_ptr) {
 	if (data_ptr == NULL) {
 		LOTRACE_ERR("Invalid Arguments - data_ptr = NULL ");
 		return -1;
@@ -267,93 +258,87 @@ int LO_json_add_item(const LiveObjectsD_Data_t* data_ptr, char *pbuf, uint32_t s
 			data_ptr->data_name, data_ptr->data_value, data_ptr->data_dim);
 		return -1;
 	}
-	
-	rc = snprintf(pcur, len, "\"%s\":", data_ptr->data_name);
-	if (rc < 0) {
-		LOTRACE_ERR("(%d, %s): failed, rc=%d", data_ptr->data_type, data_ptr->data_name, rc);
-		return -1;
-	}
-	len = sz - strlen(pbuf);
-	pcur = pbuf + strlen(pbuf);
-	if (len < 4) { /* at least 4 free bytes remmaining in buffer */
-		LOTRACE_ERR("(%d, %s): failed, free len = %d < 4", data_ptr->data_type, data_ptr->data_name, len);
+
+	LO_json_put_name(w, data_ptr->data_name);
+	return LO_json_add_value(w, data_ptr);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_json_add_value(LOJsonWriter_t* w, const LiveObjectsD_Data_t* data_ptr) {
+	short i;
+	short dim;
+	const char* data_value_ptr;
+
+	if ((data_ptr->data_value == NULL) || (data_ptr->data_dim <= 0)) {
+		LOTRACE_ERR("Invalid DataDef - value=%p dim=%d", data_ptr->data_value, data_ptr->data_dim);
 		return -1;
 	}
+
 	dim = data_ptr->data_dim;
 	if (dim > 1) {
-		*pcur++ = '[';
-		len--;
-	}
-	else if (dim <= 0) {
-		LOTRACE_ERR("(%d, %s): force dim=%d to 1", data_ptr->data_type, data_ptr->data_name, dim);
-		dim = 1;
+		LO_json_putl(w, "[");
 	}
 
-	data_value_ptr = (char*)data_ptr->data_value;
-	for (i=0;i<dim;i++) {
+	data_value_ptr = (const char*) data_ptr->data_value;
+	for (i = 0; i < dim; i++) {
 		switch (data_ptr->data_type) {
 		case LOD_TYPE_INT32:
-			rc = snprintf(pcur, len, "%"PRIi32",", *((int32_t*) data_value_ptr));
-			if (dim > 1) data_value_ptr += sizeof(int32_t);
+			LO_json_put_num(w, LO_json_itoa, *((const int32_t*) data_value_ptr));
+			data_value_ptr += sizeof(int32_t);
 			break;
 		case LOD_TYPE_INT16:
-			rc = snprintf(pcur, len, "%"PRIi16",", *((int16_t*)data_value_ptr));
-			if (dim > 1) data_value_ptr += sizeof(int16_t);			
+			LO_json_put_num(w, LO_json_itoa, *((const int16_t*) data_value_ptr));
+			data_value_ptr += sizeof(int16_t);
 			break;
 		case LOD_TYPE_INT8:
-			rc = snprintf(pcur, len, "%"PRIi8"," , *((int8_t*)data_value_ptr));
-			if (dim > 1) data_value_ptr += sizeof(int8_t);
+			LO_json_put_num(w, LO_json_itoa, *((const int8_t*) data_value_ptr));
+			data_value_ptr += sizeof(int8_t);
 			break;
 		case LOD_TYPE_UINT32:
-			rc = snprintf(pcur, len, "%"PRIu32",", *((uint32_t*)data_value_ptr));
-			if (dim > 1) data_value_ptr += sizeof(uint32_t);
+			LO_json_put_num(w, LO_json_utoa, *((const uint32_t*) data_value_ptr));
+			data_value_ptr += sizeof(uint32_t);
 			break;
 		case LOD_TYPE_UINT16:
-			rc = snprintf(pcur, len, "%"PRIu16",", *((uint16_t*)data_value_ptr));
-			if (dim > 1) data_value_ptr += sizeof(uint16_t);
+			LO_json_put_num(w, LO_json_utoa, *((const uint16_t*) data_value_ptr));
+			data_value_ptr += sizeof(uint16_t);
 			break;
 		case LOD_TYPE_UINT8:
-			rc = snprintf(pcur, len, "%"PRIu8"," , *((uint8_t*)data_value_ptr));
-			if (dim > 1) data_value_ptr += sizeof(uint8_t);
+			LO_json_put_num(w, LO_json_utoa, *((const uint8_t*) data_value_ptr));
+			data_value_ptr += sizeof(uint8_t);
 			break;
 		case LOD_TYPE_FLOAT:
-			rc = snprintf(pcur, len, "%f,", *((float*)data_value_ptr));
-			if (dim > 1) data_value_ptr += sizeof(float);
+			LO_json_put_num(w, LO_json_ftoa, *((const float*) data_value_ptr));
+			data_value_ptr += sizeof(float);
 			break;
 		case LOD_TYPE_DOUBLE:
-			rc = snprintf(pcur, len, "%lf,", *((double*)data_value_ptr));
-			if (dim > 1) data_value_ptr += sizeof(double);
+			LO_json_put_num(w, LO_json_dtoa, *((const double*) data_value_ptr));
+			data_value_ptr += sizeof(double);
 			break;
 		case LOD_TYPE_BOOL:
-			rc = snprintf(pcur, len, "%s,", *((uint8_t*)data_value_ptr) ? "true" : "false");
-			if (dim > 1) data_value_ptr += sizeof(uint8_t);
+			if (*((const uint8_t*) data_value_ptr)) {
+				LO_json_putl(w, "true,");
+			}
+			else {
+				LO_json_putl(w, "false,");
+			}
+			data_value_ptr += sizeof(uint8_t);
 			break;
 		case LOD_TYPE_STRING_C:
-			rc = snprintf(pcur, len, "\"%s\",", (const char*)data_value_ptr);
-			if (dim > 1) data_value_ptr += sizeof(char*);
+			/* A single string is the data value, an array of strings is an array of pointers */
+			LO_json_putl(w, "\"");
+			LO_json_puts(w, (dim > 1) ? *((const char* const *) data_value_ptr) : data_value_ptr);
+			LO_json_putl(w, "\",");
+			data_value_ptr += sizeof(char*);
 			break;
 		default:
 			LOTRACE_ERR("failed  - unknown type %d", data_ptr->data_type);
 			return -1;
 		}
-		if (dim > 1) {
-			len = sz - strlen(pbuf);
-			pcur = pbuf + strlen(pbuf);
-			if (len < 2) { /* at least 2 free bytes remmaining in buffer */
-				LOTRACE_ERR("(%d, %s)[%d]: failed, free len = %d < 2", data_ptr->data_type, data_ptr->data_name, i, len);
-				return -1;
-			}		
-		}
 	}
 	if (dim > 1) {
-		pcur--;
-		if ((*pcur != ',')  || (len < 2)){
-			LOTRACE_ERR("(%d, %s): failed, unexpected char %c or free len = %d", data_ptr->data_type, data_ptr->data_name, *pcur, len);
-			return -1;
-		}
-		*pcur++ = ']';
-		*pcur++ = ',';
-		*pcur = 0;
+		LO_json_unput_comma(w);
+		LO_json_putl(w, "],");
 	}
 	LOTRACE_DBG1("OK - type=%d=%s name=%s", data_ptr->data_type, LO_getDataTypeToStr(data_ptr->data_type),
 			data_ptr->data_name);
@@ -362,38 +347,34 @@ int LO_json_add_item(const LiveObjectsD_Data_t* data_ptr, char *pbuf, uint32_t s
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int LO_json_add_param(const LiveObjectsD_Data_t* data_ptr, char *pbuf, uint32_t sz) {
+int LO_json_add_param(LOJsonWriter_t* w, const LiveObjectsD_Data_t* data_ptr) {
 	if ((data_ptr->data_type == LOD_TYPE_INT32) || (data_ptr->data_type == LOD_TYPE_UINT32)
 			|| (data_ptr->data_type == LOD_TYPE_STRING_C) || (data_ptr->data_type == LOD_TYPE_FLOAT)) {
-		int rc;
-		int len = sz - strlen(pbuf);
-		char* pcur = pbuf + strlen(pbuf);
-
-		rc = snprintf(pcur, len, "\"%s\":{", data_ptr->data_name);
-		if (rc < 0) {
-			LOTRACE_ERR("(%d, %s): failed, rc=%d", data_ptr->data_type, data_ptr->data_name, rc);
-			return -1;
-		}
 
-		len = sz - strlen(pbuf);
-		pcur = pbuf + strlen(pbuf);
+		LO_json_put_name(w, data_ptr->data_name);
 		switch (data_ptr->data_type) {
 		case LOD_TYPE_INT32:
-			rc = snprintf(pcur, len, "\"t\":\"i32\",\"v\":%d},", *((int*) data_ptr->data_value));
+			LO_json_putl(w, "{\"t\":\"i32\",\"v\":");
+			LO_json_put_num(w, LO_json_itoa, *((const int32_t*) data_ptr->data_value));
 			break;
 		case LOD_TYPE_UINT32:
-			rc = snprintf(pcur, len, "\"t\":\"u32\",\"v\":%u},", *((unsigned int*) data_ptr->data_value));
+			LO_json_putl(w, "{\"t\":\"u32\",\"v\":");
+			LO_json_put_num(w, LO_json_utoa, *((const uint32_t*) data_ptr->data_value));
 			break;
 		case LOD_TYPE_FLOAT:
-			rc = snprintf(pcur, len, "\"t\":\"f64\",\"v\":%f},", *((float*) data_ptr->data_value));
+			LO_json_putl(w, "{\"t\":\"f64\",\"v\":");
+			LO_json_put_num(w, LO_json_ftoa, *((const float*) data_ptr->data_value));
 			break;
 		case LOD_TYPE_STRING_C:
-			rc = snprintf(pcur, len, "\"t\":\"str\",\"v\":\"%s\"},", (const char*) data_ptr->data_value);
+			LO_json_putl(w, "{\"t\":\"str\",\"v\":\"");
+			LO_json_puts(w, (const char*) data_ptr->data_value);
+			LO_json_putl(w, "\",");
 			break;
 		default:
 			LOTRACE_ERR("LO_json_add_param: failed -  type %d not implemented", data_ptr->data_type);
 			return -1;
 		}
+		LO_json_add_section_end(w);
 		LOTRACE_DBG1("OK - type=%d=%s name=%s", data_ptr->data_type,
 				LO_getDataTypeToStr(data_ptr->data_type), data_ptr->data_name);
 		return 0;
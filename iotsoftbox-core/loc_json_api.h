@@ -21,31 +21,78 @@
 extern "C" {
 #endif
 
+/**
+ * @brief JSON writer: the cursor and the remaining space of the buffer are tracked,
+ *        and an overflow is only checked once, by LO_json_result()
+ */
+typedef struct {
+	char* buf;          /*!< Output buffer (always NUL terminated) */
+	uint32_t size;      /*!< Size of the buffer */
+	uint32_t len;       /*!< Current length of the JSON text */
+	uint8_t overflow;   /*!< Set when a write did not fit: next writes are ignored */
+} LOJsonWriter_t;
+
 const char* LO_getDataTypeToStr(LiveObjectsD_Type_t objType);
 
 LiveObjectsD_Type_t LO_getDataTypeFromStrL(const char* p, uint32_t len);
 
-int LO_json_begin(char *pbuf, uint32_t sz);
+/* Number formatting (loc_json_num.c): the buffer must have at least LO_JSON_NUM_SZ bytes.
+ * Return the number of written characters (not NUL terminated).
+ * The floating point numbers are written with the shortest form read back to the same value,
+ * and a non-finite value (NaN, Infinity) is written as null. */
+#define LO_JSON_NUM_SZ      32
+
+int LO_json_utoa(char* buf, uint32_t value);
+
+int LO_json_itoa(char* buf, int32_t value);
+
+int LO_json_ftoa(char* buf, float value);
+
+int LO_json_dtoa(char* buf, double value);
+
+/* Number parsing (loc_json_num.c): the 'len' characters at p must be a JSON number (not NUL terminated).
+ * Return 0 if successful, or -1 if it is not a valid number, not an integer (atou, atoi) or out of range.
+ * The floating point numbers are correctly rounded. */
+int LO_json_atou(const char* p, uint32_t len, uint32_t* value);
+
+int LO_json_atoi(const char* p, uint32_t len, int32_t* value);
+
+int LO_json_atof(const char* p, uint32_t len, float* value);
+
+int LO_json_atod(const char* p, uint32_t len, double* value);
+
+void LO_json_init(LOJsonWriter_t* w, char *pbuf, uint32_t sz);
+
+/* Return the JSON text, or NULL if the buffer was too short */
+const char* LO_json_result(LOJsonWriter_t* w);
+
+void LO_json_begin(LOJsonWriter_t* w);
+
+void LO_json_end(LOJsonWriter_t* w);
+
+void LO_json_begin_section(LOJsonWriter_t* w, const char* name);
 
-int LO_json_end(char *pbuf, uint32_t sz);
+void LO_json_end_section(LOJsonWriter_t* w);
 
-int LO_json_begin_section(char *pbuf, uint32_t sz, const char* name);
+void LO_json_add_section_start(LOJsonWriter_t* w, const char* section_name);
 
-int LO_json_end_section(char *pbuf, uint32_t sz);
+void LO_json_add_section_end(LOJsonWriter_t* w);
 
-int LO_json_add_section_start(const char* section_name, char *pbuf, uint32_t sz);
+void LO_json_add_name_int(LOJsonWriter_t* w, const char* name, int32_t value);
 
-int LO_json_add_section_end(char *pbuf, uint32_t sz);
+void LO_json_add_name_str(LOJsonWriter_t* w, const char* name, const char* value);
 
-int LO_json_add_name_int(const char* name, int32_t value, char *pbuf, uint32_t sz);
+void LO_json_add_name_array(LOJsonWriter_t* w, const char* name, const char* array);
 
-int LO_json_add_name_str(const char* name, const char* value, char *pbuf, uint32_t sz);
+/* Append len bytes of already encoded JSON text */
+void LO_json_add_raw(LOJsonWriter_t* w, const char* p, uint32_t len);
 
-int LO_json_add_name_array(const char* name, const char* array, char *pbuf, uint32_t sz);
+int LO_json_add_item(LOJsonWriter_t* w, const LiveObjectsD_Data_t* p);
 
-int LO_json_add_item(const LiveObjectsD_Data_t* p, char *pbuf, uint32_t sz);
+/* Same as LO_json_add_item(), but only the value (or the array of values), without the name */
+int LO_json_add_value(LOJsonWriter_t* w, const LiveObjectsD_Data_t* p);
 
-int LO_json_add_param(const LiveObjectsD_Data_t* p, char *pbuf, uint32_t sz);
+int LO_json_add_param(LOJsonWriter_t* w, const LiveObjectsD_Data_t* p);
 
 #if defined(__cplusplus)
 }
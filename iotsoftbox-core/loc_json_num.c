@@ -0,0 +1,712 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  loc_json_num.c
+ * @brief Number formatting (without printf) for the JSON encoder, and number parsing for the decoder
+ *
+ * - Integers: two digits per division, from a table of the 100 pairs of digits.
+ * - Floating point numbers: Grisu2 algorithm (Florian Loitsch, "Printing Floating-Point
+ *   Numbers Quickly and Accurately with Integers", PLDI 2010), as implemented by Milo Yip
+ *   (dtoa-benchmark, MIT license). The output is the shortest (or very close to the
+ *   shortest) decimal string that reads back to the same float or double.
+ */
+
+#include "loc_json_api.h"
+
+#include <float.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char _LO_json_digits2[200] = {
+	'0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+	'1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+	'2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+	'3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+	'4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+	'5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+	'6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+	'7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+	'8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+	'9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+/* ================================================================================= */
+/* Integers
+ * --------
+ */
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_json_utoa(char* buf, uint32_t value) {
+	char tmp[10];
+	char* p = tmp + sizeof(tmp);
+	int len;
+	while (value >= 100) {
+		uint32_t i = (value % 100) * 2;
+		value /= 100;
+		*--p = _LO_json_digits2[i + 1];
+		*--p = _LO_json_digits2[i];
+	}
+	if (value >= 10) {
+		*--p = _LO_json_digits2[value * 2 + 1];
+		*--p = _LO_json_digits2[value * 2];
+	}
+	else {
+		*--p = (char) ('0' + value);
+	}
+	len = (int) (tmp + sizeof(tmp) - p);
+	memcpy(buf, p, len);
+	return len;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_json_itoa(char* buf, int32_t value) {
+	if (value < 0) {
+		*buf = '-';
+		return 1 + LO_json_utoa(buf + 1, 0U - (uint32_t) value);
+	}
+	return LO_json_utoa(buf, (uint32_t) value);
+}
+
+/* ================================================================================= */
+/* Floating point numbers (Grisu2)
+ * -------------------------------
+ */
+
+typedef struct {
+	uint64_t f;
+	int e;
+} LODiyFp_t;
+
+/* Normalized 10^k, k = -348, -340, ..., 340 */
+static const uint64_t _LO_json_pow10_f[] = {
+	0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+	0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+	0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+	0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+	0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+	0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+	0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+	0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+	0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+	0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+	0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+	0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+	0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+	0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+	0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+	0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+	0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+	0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+	0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+	0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+	0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+	0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+	0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+	0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+	0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+	0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+	0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+	0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+	0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+
+static const int16_t _LO_json_pow10_e[] = {
+	-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+	-901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+	-582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+	-263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+	56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+	375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+	694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+	1013, 1039, 1066
+};
+
+static const uint32_t _LO_json_pow10_32[] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+/* --------------------------------------------------------------------------------- */
+/* Product rounded to 64 bits */
+static LODiyFp_t LO_diyfp_mul(LODiyFp_t x, LODiyFp_t y) {
+	const uint64_t M32 = 0xFFFFFFFFULL;
+	uint64_t a = x.f >> 32, b = x.f & M32, c = y.f >> 32, d = y.f & M32;
+	uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+	uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+	LODiyFp_t r;
+	tmp += 1U << 31;
+	r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+	r.e = x.e + y.e + 64;
+	return r;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static LODiyFp_t LO_diyfp_normalize(LODiyFp_t x) {
+	while (!(x.f & 0xFFC0000000000000ULL)) {
+		x.f <<= 10;
+		x.e -= 10;
+	}
+	while (!(x.f & 0x8000000000000000ULL)) {
+		x.f <<= 1;
+		x.e--;
+	}
+	return x;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Cached power c = 10^-K such that the exponent of w * c is in [-60, -32] */
+static LODiyFp_t LO_diyfp_cached_power(int e, int* K) {
+	double dk = (-61 - e) * 0.30102999566398114 + 347;
+	int k = (int) dk;
+	unsigned index;
+	LODiyFp_t c;
+	if (dk - k > 0.0) {
+		k++;
+	}
+	index = (unsigned) ((k >> 3) + 1);
+	*K = -(-348 + (int) (index << 3));
+	c.f = _LO_json_pow10_f[index];
+	c.e = _LO_json_pow10_e[index];
+	return c;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LO_grisu_round(char* buf, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa,
+		uint64_t wp_w) {
+	while ((rest < wp_w) && (delta - rest >= ten_kappa)
+			&& ((rest + ten_kappa < wp_w) || (wp_w - rest > rest + ten_kappa - wp_w))) {
+		buf[len - 1]--;
+		rest += ten_kappa;
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int LO_count_digits(uint32_t n) {
+	int i = 1;
+	while ((i < 10) && (n >= _LO_json_pow10_32[i])) {
+		i++;
+	}
+	return i;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Generate the digits of Mp, the shortest in the interval [Mp - delta, Mp] */
+static int LO_grisu_digits(LODiyFp_t W, LODiyFp_t Mp, uint64_t delta, char* buf, int* K) {
+	LODiyFp_t one;
+	uint64_t wp_w = Mp.f - W.f;
+	uint32_t p1;
+	uint64_t p2;
+	int kappa;
+	int len = 0;
+	uint64_t unit = 1;
+
+	one.f = ((uint64_t) 1) << -Mp.e;
+	one.e = Mp.e;
+	p1 = (uint32_t) (Mp.f >> -one.e);
+	p2 = Mp.f & (one.f - 1);
+	kappa = LO_count_digits(p1);
+
+	while (kappa > 0) {
+		uint32_t d = p1 / _LO_json_pow10_32[kappa - 1];
+		uint64_t tmp;
+		p1 %= _LO_json_pow10_32[kappa - 1];
+		if (d || len) {
+			buf[len++] = (char) ('0' + d);
+		}
+		kappa--;
+		tmp = (((uint64_t) p1) << -one.e) + p2;
+		if (tmp <= delta) {
+			*K += kappa;
+			LO_grisu_round(buf, len, delta, tmp, ((uint64_t) _LO_json_pow10_32[kappa]) << -one.e, wp_w);
+			return len;
+		}
+	}
+
+	for (;;) {
+		char d;
+		p2 *= 10;
+		delta *= 10;
+		unit *= 10;
+		d = (char) (p2 >> -one.e);
+		if (d || len) {
+			buf[len++] = (char) ('0' + d);
+		}
+		p2 &= one.f - 1;
+		kappa--;
+		if (p2 < delta) {
+			*K += kappa;
+			LO_grisu_round(buf, len, delta, p2, one.f, wp_w * unit);
+			return len;
+		}
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Digits and decimal exponent K of the value v = f * 2^e, given the boundaries
+ * of its rounding interval: m- (lower) and m+ (upper) */
+static int LO_grisu2(LODiyFp_t v, LODiyFp_t m_minus, LODiyFp_t m_plus, char* buf, int* K) {
+	LODiyFp_t c_mk, W, Wp, Wm;
+
+	m_plus = LO_diyfp_normalize(m_plus);
+	m_minus.f <<= m_minus.e - m_plus.e;
+	m_minus.e = m_plus.e;
+
+	c_mk = LO_diyfp_cached_power(m_plus.e, K);
+	W = LO_diyfp_mul(LO_diyfp_normalize(v), c_mk);
+	Wp = LO_diyfp_mul(m_plus, c_mk);
+	Wm = LO_diyfp_mul(m_minus, c_mk);
+	Wm.f++;
+	Wp.f--;
+	return LO_grisu_digits(W, Wp, Wp.f - Wm.f, buf, K);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int LO_write_exponent(char* buf, int k) {
+	char* p = buf;
+	if (k < 0) {
+		*p++ = '-';
+		k = -k;
+	}
+	p += LO_json_utoa(p, (uint32_t) k);
+	return (int) (p - buf);
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Format the digits [len] with the decimal exponent k: digits * 10^k */
+static int LO_prettify(char* buf, int len, int k) {
+	int kk = len + k; /* 10^(kk-1) <= v < 10^kk */
+	int i;
+
+	if ((len <= kk) && (kk <= 21)) {
+		/* 1234e7 -> 12340000000.0 */
+		for (i = len; i < kk; i++) {
+			buf[i] = '0';
+		}
+		buf[kk] = '.';
+		buf[kk + 1] = '0';
+		return kk + 2;
+	}
+	if ((0 < kk) && (kk <= 21)) {
+		/* 1234e-2 -> 12.34 */
+		memmove(&buf[kk + 1], &buf[kk], len - kk);
+		buf[kk] = '.';
+		return len + 1;
+	}
+	if ((-6 < kk) && (kk <= 0)) {
+		/* 1234e-6 -> 0.001234 */
+		int offset = 2 - kk;
+		memmove(&buf[offset], &buf[0], len);
+		buf[0] = '0';
+		buf[1] = '.';
+		for (i = 2; i < offset; i++) {
+			buf[i] = '0';
+		}
+		return len + offset;
+	}
+	if (len == 1) {
+		/* 1e30 */
+		buf[1] = 'e';
+		return 2 + LO_write_exponent(&buf[2], kk - 1);
+	}
+	/* 1234e30 -> 1.234e33 */
+	memmove(&buf[2], &buf[1], len - 1);
+	buf[1] = '.';
+	buf[len + 1] = 'e';
+	return len + 2 + LO_write_exponent(&buf[len + 2], kk - 1);
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Format a finite value f * 2^e (f != 0). The lower boundary is closer when f is
+ * a power of 2 (normalized significand with only the hidden bit) */
+static int LO_fmt_float(char* buf, uint64_t f, int e, int lower_closer) {
+	LODiyFp_t v, m_plus, m_minus;
+	int K;
+	int len;
+
+	v.f = f;
+	v.e = e;
+	m_plus.f = (f << 1) + 1;
+	m_plus.e = e - 1;
+	if (lower_closer) {
+		m_minus.f = (f << 2) - 1;
+		m_minus.e = e - 2;
+	}
+	else {
+		m_minus.f = (f << 1) - 1;
+		m_minus.e = e - 1;
+	}
+	len = LO_grisu2(v, m_minus, m_plus, buf, &K);
+	return LO_prettify(buf, len, K);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_json_dtoa(char* buf, double value) {
+	uint64_t u;
+	uint64_t f;
+	int be;
+	char* p = buf;
+
+	memcpy(&u, &value, sizeof(u));
+	be = (int) ((u >> 52) & 0x7FF);
+	f = u & 0x000FFFFFFFFFFFFFULL;
+
+	if (be == 0x7FF) {
+		/* NaN or Infinity: not a JSON number */
+		memcpy(buf, "null", 4);
+		return 4;
+	}
+	if (u >> 63) {
+		*p++ = '-';
+	}
+	if ((be == 0) && (f == 0)) {
+		memcpy(p, "0.0", 3);
+		return (int) (p - buf) + 3;
+	}
+	if (be) {
+		return (int) (p - buf) + LO_fmt_float(p, f | 0x0010000000000000ULL, be - 1075, (f == 0) && (be > 1));
+	}
+	return (int) (p - buf) + LO_fmt_float(p, f, -1074, 0);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_json_ftoa(char* buf, float value) {
+	uint32_t u;
+	uint32_t f;
+	int be;
+	char* p = buf;
+
+	memcpy(&u, &value, sizeof(u));
+	be = (int) ((u >> 23) & 0xFF);
+	f = u & 0x007FFFFF;
+
+	if (be == 0xFF) {
+		/* NaN or Infinity: not a JSON number */
+		memcpy(buf, "null", 4);
+		return 4;
+	}
+	if (u >> 31) {
+		*p++ = '-';
+	}
+	if ((be == 0) && (f == 0)) {
+		memcpy(p, "0.0", 3);
+		return (int) (p - buf) + 3;
+	}
+	if (be) {
+		return (int) (p - buf) + LO_fmt_float(p, f | 0x00800000, be - 150, (f == 0) && (be > 1));
+	}
+	return (int) (p - buf) + LO_fmt_float(p, f, -149, 0);
+}
+
+/* ================================================================================= */
+/* Number parsing
+ * --------------
+ * The text of a JSON number (given by its position and length, not NUL terminated) is
+ * checked and read in one pass: up to 19 significant digits in a 64-bit mantissa, and
+ * a decimal exponent. The integers are range checked. A floating point number is exact
+ * when the mantissa and the power of 10 are both exactly representable (Clinger's fast
+ * path, most of the received values), otherwise the correctly rounded value is given by
+ * strtod() on a bounded copy of the text. A longer text is copied with its first
+ * LO_NUM_TEXT_DIGITS significant digits (then a '1' if a dropped digit is not zero),
+ * and the exponent adjusted to the dropped digits.
+ */
+#define LO_NUM_MAX_DIGITS     19
+#define LO_NUM_TEXT_SZ        128    /* Max length of a number read by the slow path */
+#define LO_NUM_TEXT_DIGITS    (LO_NUM_TEXT_SZ - 20)
+
+typedef struct {
+	uint64_t m;                      /* Mantissa (first LO_NUM_MAX_DIGITS significant digits) */
+	int32_t e;                       /* Decimal exponent */
+	uint8_t neg;
+	uint8_t trunc;                   /* Set if significant digits are dropped */
+	uint8_t is_int;                  /* Set if neither fraction nor exponent */
+} LONumText_t;
+
+static const double _LO_pow10_dbl[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const float _LO_pow10_flt[] = {
+	1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+/* --------------------------------------------------------------------------------- */
+/* Check the JSON number grammar: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?  */
+static int LO_num_scan(const char* p, uint32_t len, LONumText_t* n) {
+	const char* end = p + len;
+	int32_t nd = 0;
+	int32_t ex = 0;
+
+	n->m = 0;
+	n->e = 0;
+	n->neg = 0;
+	n->trunc = 0;
+	n->is_int = 1;
+
+	if ((p < end) && (*p == '-')) {
+		n->neg = 1;
+		p++;
+	}
+	if ((p >= end) || (*p < '0') || (*p > '9')) {
+		return -1;
+	}
+	if (*p == '0') {
+		p++;
+	}
+	else {
+		while ((p < end) && (*p >= '0') && (*p <= '9')) {
+			if (nd < LO_NUM_MAX_DIGITS) {
+				n->m = n->m * 10 + (uint64_t) (*p - '0');
+				nd++;
+			}
+			else {
+				n->e++;
+				if (*p != '0') {
+					n->trunc = 1;
+				}
+			}
+			p++;
+		}
+	}
+	if ((p < end) && (*p == '.')) {
+		n->is_int = 0;
+		p++;
+		if ((p >= end) || (*p < '0') || (*p > '9')) {
+			return -1;
+		}
+		while ((p < end) && (*p >= '0') && (*p <= '9')) {
+			if ((n->m == 0) && (*p == '0')) {
+				n->e--;  /* Leading zero */
+			}
+			else if (nd < LO_NUM_MAX_DIGITS) {
+				n->m = n->m * 10 + (uint64_t) (*p - '0');
+				n->e--;
+				nd++;
+			}
+			else if (*p != '0') {
+				n->trunc = 1;
+			}
+			p++;
+		}
+	}
+	if ((p < end) && ((*p == 'e') || (*p == 'E'))) {
+		uint8_t ex_neg = 0;
+		n->is_int = 0;
+		p++;
+		if ((p < end) && ((*p == '+') || (*p == '-'))) {
+			ex_neg = (*p == '-');
+			p++;
+		}
+		if ((p >= end) || (*p < '0') || (*p > '9')) {
+			return -1;
+		}
+		while ((p < end) && (*p >= '0') && (*p <= '9')) {
+			if (ex < 100000) {
+				ex = ex * 10 + (*p - '0');
+			}
+			p++;
+		}
+		n->e += (ex_neg) ? -ex : ex;
+	}
+	return (p == end) ? 0 : -1;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Integer value (without fraction or exponent) */
+static int LO_num_integer(const char* p, uint32_t len, LONumText_t* n) {
+	if ((LO_num_scan(p, len, n)) || (!n->is_int) || (n->trunc) || (n->e)) {
+		return -1;
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Copy the text (checked by LO_num_scan) to be read by strtod() or strtof(), and return
+ * the length of the copy. */
+static int LO_num_text(char* buf, const char* p, uint32_t len) {
+	const char* end = p + len;
+	int32_t nd = 0;
+	int32_t ex = 0;
+	int32_t e = 0;
+	uint8_t sticky = 0;
+	int k = 0;
+
+	if (len < LO_NUM_TEXT_SZ) {
+		memcpy(buf, p, len);
+		buf[len] = 0;
+		return (int) len;
+	}
+	if (*p == '-') {
+		buf[k++] = *p++;
+	}
+	while ((p < end) && (*p >= '0') && (*p <= '9')) {
+		if ((nd == 0) && (*p == '0')) {
+			;                        /* The integer part is 0 */
+		}
+		else if (nd < LO_NUM_TEXT_DIGITS) {
+			buf[k++] = *p;
+			nd++;
+		}
+		else {
+			e++;
+			if (*p != '0') {
+				sticky = 1;
+			}
+		}
+		p++;
+	}
+	if ((p < end) && (*p == '.')) {
+		p++;
+		while ((p < end) && (*p >= '0') && (*p <= '9')) {
+			if ((nd == 0) && (*p == '0')) {
+				e--;                 /* Leading zero */
+			}
+			else if (nd < LO_NUM_TEXT_DIGITS) {
+				buf[k++] = *p;
+				nd++;
+				e--;
+			}
+			else if (*p != '0') {
+				sticky = 1;
+			}
+			p++;
+		}
+	}
+	if ((p < end) && ((*p == 'e') || (*p == 'E'))) {
+		uint8_t ex_neg = 0;
+		p++;
+		if ((p < end) && ((*p == '+') || (*p == '-'))) {
+			ex_neg = (*p == '-');
+			p++;
+		}
+		while ((p < end) && (*p >= '0') && (*p <= '9')) {
+			if (ex < 100000) {
+				ex = ex * 10 + (*p - '0');
+			}
+			p++;
+		}
+		e += (ex_neg) ? -ex : ex;
+	}
+	if (nd == 0) {
+		buf[k++] = '0';
+	}
+	else if (sticky) {
+		buf[k++] = '1';
+		e--;
+	}
+	buf[k++] = 'e';
+	k += LO_write_exponent(buf + k, (int) e);
+	buf[k] = 0;
+	return k;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_json_atou(const char* p, uint32_t len, uint32_t* value) {
+	LONumText_t n;
+	if ((LO_num_integer(p, len, &n)) || ((n.neg) && (n.m)) || (n.m > 0xFFFFFFFFU)) {
+		return -1;
+	}
+	*value = (uint32_t) n.m;
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_json_atoi(const char* p, uint32_t len, int32_t* value) {
+	LONumText_t n;
+	if ((LO_num_integer(p, len, &n)) || (n.m > ((n.neg) ? 0x80000000U : 0x7FFFFFFFU))) {
+		return -1;
+	}
+	*value = (n.neg) ? (int32_t) (0U - (uint32_t) n.m) : (int32_t) n.m;
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_json_atod(const char* p, uint32_t len, double* value) {
+	LONumText_t n;
+	char buf[LO_NUM_TEXT_SZ];
+	char* end;
+	double d;
+
+	if (LO_num_scan(p, len, &n)) {
+		return -1;
+	}
+	if (n.m == 0) {
+		*value = (n.neg) ? -0.0 : 0.0;
+		return 0;
+	}
+	if ((!n.trunc) && (n.m <= (1ULL << 53))) {
+		if ((n.e >= -22) && (n.e <= 22)) {
+			d = (double) n.m;
+			d = (n.e < 0) ? d / _LO_pow10_dbl[-n.e] : d * _LO_pow10_dbl[n.e];
+			*value = (n.neg) ? -d : d;
+			return 0;
+		}
+		if ((n.e > 22) && (n.e <= 22 + 15)) {
+			/* The excess of the power of 10 in the mantissa, if it is still exact */
+			uint64_t p10 = (uint64_t) _LO_pow10_dbl[n.e - 22];
+			if (n.m <= (1ULL << 53) / p10) {
+				d = (double) (n.m * p10) * 1e22;
+				*value = (n.neg) ? -d : d;
+				return 0;
+			}
+		}
+	}
+	len = (uint32_t) LO_num_text(buf, p, len);
+	d = strtod(buf, &end);
+	if ((end != buf + len) || (d > DBL_MAX) || (d < -DBL_MAX)) {
+		return -1;
+	}
+	*value = d;
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_json_atof(const char* p, uint32_t len, float* value) {
+	LONumText_t n;
+	char buf[LO_NUM_TEXT_SZ];
+	char* end;
+	float f;
+
+	if (LO_num_scan(p, len, &n)) {
+		return -1;
+	}
+	if (n.m == 0) {
+		*value = (n.neg) ? -0.0f : 0.0f;
+		return 0;
+	}
+	if ((!n.trunc) && (n.m <= (1U << 24)) && (n.e >= -10) && (n.e <= 10)) {
+		f = (float) n.m;
+		f = (n.e < 0) ? f / _LO_pow10_flt[-n.e] : f * _LO_pow10_flt[n.e];
+		*value = (n.neg) ? -f : f;
+		return 0;
+	}
+	len = (uint32_t) LO_num_text(buf, p, len);
+#ifdef ARDUINO
+	f = (float) strtod(buf, &end);
+#else
+	f = strtof(buf, &end);
+#endif
+	if ((end != buf + len) || (f > FLT_MAX) || (f < -FLT_MAX)) {
+		return -1;
+	}
+	*value = f;
+	return 0;
+}
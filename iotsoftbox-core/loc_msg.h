@@ -18,6 +18,8 @@
 #include "liveobjects-client/LiveObjectsClient_Config.h"
 #include "liveobjects-client/LiveObjectsClient_Defs.h"
 
+#include "loc_json_api.h"
+
 #if LOC_FEATURE_MBEDTLS
 #include "mbedtls/config.h"
 #include "mbedtls/md5.h"
@@ -38,10 +40,41 @@ typedef struct
 } md5_context_t;
 #endif
 
-#if LOM_PUSH_ASYNC
+#if LOM_PUSH_ASYNC || LOM_STATUS_DELTA
 #define LOM_PUSH_FLAG         1
 #endif
 
+/* Flag set in the type of a message of the ring (first byte) when the payload is binary:
+ * the type is followed by the length of the payload (4 bytes), and then by the payload */
+#define LOM_MSG_BIN           0x80
+
+/**
+ * @brief Encoder of the 'status' and 'collected data' messages: the operations
+ *        to build a message (see loc_json_api.h), in a given format
+ */
+typedef struct {
+	const char* name;                                          /*!< Name of the format */
+	const char* mqtt_user;                                     /*!< MQTT user name: content mode of the connection */
+	uint8_t binary;                                            /*!< Set if the message is not a NUL terminated text */
+	const char* (*result)(LOJsonWriter_t* w);
+	void (*begin)(LOJsonWriter_t* w);
+	void (*end)(LOJsonWriter_t* w);
+	void (*begin_section)(LOJsonWriter_t* w, const char* name);
+	void (*end_section)(LOJsonWriter_t* w);
+	void (*add_section_start)(LOJsonWriter_t* w, const char* name);
+	void (*add_section_end)(LOJsonWriter_t* w);
+	void (*add_name_str)(LOJsonWriter_t* w, const char* name, const char* value);
+	void (*add_name_array)(LOJsonWriter_t* w, const char* name, const char* array);
+	void (*add_name_loc)(LOJsonWriter_t* w, const char* name, double lat, double lon);
+	int (*add_item)(LOJsonWriter_t* w, const LiveObjectsD_Data_t* p);
+} LOMEncoder_t;
+
+extern const LOMEncoder_t LO_msg_enc_json;
+
+#if LOC_FEATURE_CBOR
+extern const LOMEncoder_t LO_msg_enc_cbor;
+#endif
+
 /**
  * @brief Define an array of simple LiveObjects data elements
  */
@@ -66,6 +99,11 @@ typedef struct {
 #if LOM_PUSH_FLAG
 	uint8_t pushtoLOServer;     /*!< flag to publish 'info' to the LiveObject Server */
 #endif
+#if LOM_STATUS_DELTA
+	uint8_t delta_valid;        /*!< Set when delta_shadow contains the last published values */
+	uint16_t delta_cnt;         /*!< Number of delta publications since the last full publication */
+	uint32_t delta_shadow[LOM_STATUS_DELTA_NB]; /*!< Hash of the last published value of each element */
+#endif
 } LOMSetOfStatus_t;
 
 /**
@@ -88,8 +126,24 @@ typedef struct {
 #if LOM_PUSH_FLAG
 	uint8_t pushtoLOServer; /*!< flag to forward 'collected data' to the LiveObject Server */
 #endif
+#if (LOM_SETOFDATA_TPL_SZ > 0)
+	uint8_t tpl_valid;                 /*!< Set when tpl matches the current stream-id, model, tags and data */
+	char tpl[LOM_SETOFDATA_TPL_SZ];    /*!< Precompiled JSON message: the literal runs (length byte + text)
+	                                        between the values (see LO_msg_data_tpl_compile) */
+#endif
 } LOMSetOfData_t;
 
+/**
+ * @brief Hash index of the names of an attached table (configuration parameters or commands)
+ *
+ * Open addressing with linear probing. A slot holds the upper bits of the name hash and the
+ * position + 1 of the element in the table (0: free slot).
+ */
+typedef struct {
+	uint32_t* slot;                   /*!< Array of (mask + 1) slots, NULL if no index (linear search) */
+	uint32_t mask;                    /*!< Number of slots - 1 (power of 2) */
+} LOMNameIndex_t;
+
 /**
  * @brief Define the full set of user configuration parameters to be published to the LOM server
  *
@@ -97,6 +151,7 @@ typedef struct {
 typedef struct {
 	LOMArrayOfParams_t param_set;                 /*!< Array of configuration parameters */
 	LiveObjectsD_CallbackParams_t param_callback; /*!< User callback function, called when parameter is updated */
+	LOMNameIndex_t param_index;                   /*!< Index of the parameter names */
 #if LOM_PUSH_FLAG
 	uint8_t pushtoLOServer;                       /*!< flag to publish 'config parameter' to the LiveObject Server */
 #endif
@@ -109,7 +164,8 @@ typedef struct {
 typedef struct {
 	int32_t cid;                      /*!< Correlation Identigfier */
 	int32_t nb_of_params;             /*!< Number of elements in tab_of_param_ptr */
-	const LiveObjectsD_Param_t* tab_of_param_ptr[LOC_MAX_OF_PARSED_PARAMS]; /*!< array of configuration parameters */
+	int32_t max_of_params;            /*!< Size of tab_of_param_ptr (number of registered parameters) */
+	const LiveObjectsD_Param_t** tab_of_param_ptr; /*!< array of configuration parameters */
 } LOMSetofUpdatedParams_t;
 
 /**
@@ -121,6 +177,7 @@ typedef struct {
 	const LiveObjectsD_Command_t* cmd_ptr;         /*!< Address of the first LiveObjects command element in array */
 	int cmd_nb;                                    /*!< Number of elements in array */
 	LiveObjectsD_CallbackCommand_t cmd_callback;   /*!< User callback function called to process the received command */
+	LOMNameIndex_t cmd_index;                      /*!< Index of the command names */
 } LOMSetofCommands_t;
 
 /**
@@ -159,21 +216,87 @@ typedef struct {
 
 } LOMSetOfUpdatedResource_t;
 
-const char* LO_msg_encode_status(uint8_t from, const LOMArrayOfData_t* p);
+/**
+ * @brief Ring of variable-length messages (bip buffer), built by the user threads
+ *        and published by the LiveObjects Client thread (see loc_msg_ring.c)
+ */
+typedef struct LOMRing_s LOMRing_t;
+
+/* Called by LO_msg_ring_reserve() when there is no room for len bytes (MSG_MUTEX locked, it can be
+ * released while waiting). Return 0 when messages are released and the reservation is to be retried. */
+typedef int (*LOMRingFull_t)(LOMRing_t* ring, uint32_t len, void* user);
 
-const char* LO_msg_encode_data(uint8_t from, const LOMSetOfData_t* p);
+struct LOMRing_s {
+	char* buf;          /*!< Storage (aligned on 8 bytes) */
+	uint32_t size;      /*!< Size of the storage */
+	uint32_t head;      /*!< Offset of the next message to be written */
+	uint32_t tail;      /*!< Offset of the oldest message not yet reclaimed */
+	uint32_t used;      /*!< Number of bytes between tail and head */
+	LOMRingFull_t full; /*!< Overflow handler (NULL: the reservation fails) */
+	void* full_user;    /*!< User context of the overflow handler */
+};
 
-const char* LO_msg_encode_resources(uint8_t from, const LOMSetOfResources_t* p);
+/* Init an empty ring, without overflow handler */
+int LO_msg_ring_init(LOMRing_t* ring, void* buf, uint32_t size);
 
-const char* LO_msg_encode_params_all(uint8_t from, const LOMArrayOfParams_t* p, int32_t cid);
+/* Reserve a message of max len bytes in the ring. MSG_MUTEX must be locked until commit. */
+char* LO_msg_ring_reserve(LOMRing_t* ring, uint32_t len);
 
-const char* LO_msg_encode_cmd_resp(uint8_t from, int32_t cid, const LiveObjectsD_Data_t* data_ptr, int data_nb);
+/* Return 1 if a message of max len bytes can be reserved now (MSG_MUTEX locked) */
+int LO_msg_ring_room(LOMRing_t* ring, uint32_t len);
 
-const char* LO_msg_encode_rsc_result(int32_t cid, LiveObjectsD_ResourceRespCode_t result);
+/* Commit the reserved message with its actual length */
+void LO_msg_ring_commit(LOMRing_t* ring, char* p_msg, uint32_t len);
 
-const char* LO_msg_encode_params_update(const LOMSetofUpdatedParams_t* p);
+/* Release a message of the ring (can be called by any thread, without lock) */
+void LO_msg_free(const char* p_msg);
 
-const char* LO_msg_encode_cmd_result(int32_t cid, int result);
+/*
+ * Encoding functions:
+ * - from = 0 (called by the LiveObjects Client thread): the JSON message is built in the given
+ *   buffer (buf_ptr, buf_len), i.e. the message buffer of the client instance.
+ * - otherwise (from = message type): the JSON message is built in the given message ring,
+ *   to be put in the message queue, and released by LO_msg_free(). The given buffer is not used.
+ * The length of the message is returned in p_len (if not NULL, from = 0).
+ * The 'status' and 'collected data' messages are built by the given encoder (NULL: JSON).
+ * A binary message of the ring has the type from | LOM_MSG_BIN.
+ */
+const char* LO_msg_encode_status(uint8_t from, char* buf_ptr, uint32_t buf_len, LOMRing_t* ring,
+		const LOMEncoder_t* enc, const LOMArrayOfData_t* p, uint32_t* p_len);
+
+/* Compile the JSON template of a set of data, to be called when the set is attached or changed.
+ * Return -1 if the template is not used (too short), the message is then fully encoded. */
+int LO_msg_data_tpl_compile(LOMSetOfData_t* p);
+
+#if LOM_STATUS_DELTA
+/* Compute the hash of the current value of each 'status' element (hash: LOM_STATUS_DELTA_NB elements),
+ * and return the number of elements to be published: changed since shadow, or all if shadow is NULL */
+int LO_msg_status_delta(const LOMArrayOfData_t* p, const uint32_t* shadow, uint32_t* hash);
+
+/* Encode only the elements returned by LO_msg_status_delta() (called by the LiveObjects Client thread) */
+const char* LO_msg_encode_status_delta(char* buf_ptr, uint32_t buf_len, const LOMEncoder_t* enc,
+		const LOMArrayOfData_t* p, const uint32_t* shadow, const uint32_t* hash, uint32_t* p_len);
+#endif
+
+const char* LO_msg_encode_data(uint8_t from, char* buf_ptr, uint32_t buf_len, LOMRing_t* ring,
+		const LOMEncoder_t* enc, const LOMSetOfData_t* p, uint32_t* p_len);
+
+const char* LO_msg_encode_resources(uint8_t from, char* buf_ptr, uint32_t buf_len, LOMRing_t* ring,
+		const LOMSetOfResources_t* p, uint32_t* p_len);
+
+const char* LO_msg_encode_params_all(uint8_t from, char* buf_ptr, uint32_t buf_len, LOMRing_t* ring,
+		const LOMArrayOfParams_t* p, int32_t cid, uint32_t* p_len);
+
+const char* LO_msg_encode_cmd_resp(uint8_t from, char* buf_ptr, uint32_t buf_len, LOMRing_t* ring, int32_t cid,
+		const LiveObjectsD_Data_t* data_ptr, int data_nb, uint32_t* p_len);
+
+const char* LO_msg_encode_rsc_result(char* buf_ptr, uint32_t buf_len, int32_t cid,
+		LiveObjectsD_ResourceRespCode_t result, uint32_t* p_len);
+
+const char* LO_msg_encode_params_update(char* buf_ptr, uint32_t buf_len, const LOMSetofUpdatedParams_t* p,
+		uint32_t* p_len);
+
+const char* LO_msg_encode_cmd_result(char* buf_ptr, uint32_t buf_len, int32_t cid, int result, uint32_t* p_len);
 
 LiveObjectsD_ResourceRespCode_t LO_msg_decode_rsc_req(const char* payload_data, uint32_t payload_len,
 		const LOMSetOfResources_t* p, LOMSetOfUpdatedResource_t* r, int32_t* cid);
@@ -187,6 +310,24 @@ int LO_msg_decode_params_req(const char* payload_data, uint32_t payload_len, con
 
 int LO_msg_decode_cmd_req(const char* payload_data, uint32_t payload_len, const LOMSetofCommands_t* p, int32_t* pCid);
 
+/* FNV-1a hash of 'len' bytes (initial value of h: LOM_HASH_INIT) */
+uint32_t LO_msg_hash(uint32_t h, const void* p, uint32_t len);
+
+#define LOM_HASH_INIT  2166136261U
+
+/**
+ * @brief Build the index of the names of a table of 'nb' elements ('stride' bytes each), the name
+ *        being the 'const char*' at 'offset' in an element. The previous index is released.
+ *        No index (linear search) for less than LOM_NAME_INDEX_MIN elements, or if allocation fails.
+ */
+int LO_msg_index_build(LOMNameIndex_t* idx, const void* table, uint32_t nb, uint32_t stride, uint32_t offset);
+
+void LO_msg_index_free(LOMNameIndex_t* idx);
+
+/* Return the position in the table of the first element named 'name' ('len' bytes), or -1 */
+int LO_msg_index_find(const LOMNameIndex_t* idx, const void* table, uint32_t nb, uint32_t stride, uint32_t offset,
+		const char* name, uint32_t len);
+
 #if defined(__cplusplus)
 }
 #endif
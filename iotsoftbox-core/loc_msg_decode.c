@@ -12,6 +12,7 @@
 
 #include "loc_msg.h"
 #include "loc_json_api.h"
+#include "loc_sys.h"
 
 #ifndef TRACE_GROUP
 #define TRACE_GROUP "JMSG"
@@ -21,6 +22,7 @@
 #include "jsmn/jsmn.h"
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -82,37 +84,6 @@ static jsmntype_t conv_objTypeTojsmntype(LOMObjType_t objType)
 }
 #endif
 
-/* --------------------------------------------------------------------------------- */
-/*  */
-static int check_token(const char* payload_json, const jsmntok_t* token, const char* name) {
-	if ((payload_json == NULL) || (token == NULL) || (name == NULL) || (*name == 0)) {
-		LOTRACE_ERR("Invalid parameters - payload=x%p token=x%p name=x%p (x%x)", payload_json, token, name,
-				(name) ? *name : 0xFFFF);
-		return -1;
-	}
-	if (token->type == JSMN_STRING) {
-#if (SANITY_CHECK)
-		int len = strlen(payload_json);
-		if ((token->start > token->end) || (token->end >= len)) {
-			LOTRACE_ERR("bad token - start=%d end=%d len=%d", token->start, token->end, len);
-			return -1;
-		}
-#endif
-		unsigned int tk_len = token->end - token->start;
-		const char* tk_ptr = payload_json + token->start;
-		if ((tk_len == strlen(name)) && !strncmp(tk_ptr, name, tk_len)) {
-			LOTRACE_DBG1("found %.*s", tk_len, tk_ptr);
-			return 1;
-		}
-		LOTRACE_ERR("%s not found - token is %.*s", name, tk_len, tk_ptr);
-	}
-	else {
-		LOTRACE_ERR("token type (%d %s) is not JSMN_STRING", token->type,
-				conv_jsmntypeToString(token->type));
-	}
-	return 0;
-}
-
 /* --------------------------------------------------------------------------------- */
 /*  */
 static int isValidTokenPrimitive(const char* from, const char* payload_json, const jsmntok_t* token) {
@@ -134,13 +105,15 @@ static int isValidTokenPrimitive(const char* from, const char* payload_json, con
 	return 0;
 }
 
+#define TOKEN_LEN(token)  ((uint32_t) ((token)->end - (token)->start))
+
 /* --------------------------------------------------------------------------------- */
 /*  */
 static int getValueINT32(int32_t* value, const char* payload_json, const jsmntok_t* token) {
 	if (isValidTokenPrimitive("getValueINT32", payload_json, token)) {
 		return -1;
 	}
-	if (1 != sscanf(payload_json + token->start, "%"PRIi32, value)) {
+	if (LO_json_atoi(payload_json + token->start, TOKEN_LEN(token), value)) {
 		LOTRACE_WARN("%s: Bad token value.", "getValueINT32");
 		return -1;
 	}
@@ -149,20 +122,24 @@ static int getValueINT32(int32_t* value, const char* payload_json, const jsmntok
 
 #ifdef SUPPORT_CMD_ARGS
 static int getValueINT16(int16_t* value, const char* payload_json, const jsmntok_t* token) {
+	int32_t v;
 	if (isValidTokenPrimitive("getValueINT16", payload_json, token)) return -1;
-	if (1 != sscanf(payload_json + token->start, "%"PRIi16, value)) {
+	if ((LO_json_atoi(payload_json + token->start, TOKEN_LEN(token), &v)) || (v < INT16_MIN) || (v > INT16_MAX)) {
 		LOTRACE_WARN("%s: Bad token value.", "getValueINT16");
 		return -1;
 	}
+	*value = (int16_t) v;
 	return 0;
 }
 
 static int getValueINT8(int8_t* value, const char* payload_json, const jsmntok_t* token) {
+	int32_t v;
 	if (isValidTokenPrimitive("getValueINT8", payload_json, token)) return -1;
-	if (1 != sscanf(payload_json + token->start, "%"PRIi8, value)) {
+	if ((LO_json_atoi(payload_json + token->start, TOKEN_LEN(token), &v)) || (v < INT8_MIN) || (v > INT8_MAX)) {
 		LOTRACE_WARN("%s: Bad token value.", "getValueINT8");
 		return -1;
 	}
+	*value = (int8_t) v;
 	return 0;
 }
 #endif
@@ -170,7 +147,7 @@ static int getValueINT8(int8_t* value, const char* payload_json, const jsmntok_t
 static int getValueUINT32(uint32_t* value, const char* payload_json, const jsmntok_t* token) {
 	if (isValidTokenPrimitive("getValueUINT32", payload_json, token))
 		return -1;
-	if (1 != sscanf(payload_json + token->start, "%"PRIu32, value)) {
+	if (LO_json_atou(payload_json + token->start, TOKEN_LEN(token), value)) {
 		LOTRACE_WARN("%s: Bad token value.", "getValueUINT32");
 		return -1;
 	}
@@ -179,20 +156,24 @@ static int getValueUINT32(uint32_t* value, const char* payload_json, const jsmnt
 
 #ifdef SUPPORT_CMD_ARGS
 static int getValueUINT16(uint16_t* value, const char* payload_json, const jsmntok_t* token) {
+	uint32_t v;
 	if (isValidTokenPrimitive("getValueUINT16", payload_json, token)) return -1;
-	if (1 != sscanf(payload_json + token->start, "%"PRIu16, value)) {
+	if ((LO_json_atou(payload_json + token->start, TOKEN_LEN(token), &v)) || (v > UINT16_MAX)) {
 		LOTRACE_WARN("%s: Bad token value.", "getValueUINT16");
 		return -1;
 	}
+	*value = (uint16_t) v;
 	return 0;
 }
 
 static int getValueUINT8(uint8_t* value, const char* payload_json, const jsmntok_t* token) {
+	uint32_t v;
 	if (isValidTokenPrimitive("getValueUINT8", payload_json, token)) return -1;
-	if (1 != sscanf(payload_json + token->start, "%"PRIu8, value)) {
+	if ((LO_json_atou(payload_json + token->start, TOKEN_LEN(token), &v)) || (v > UINT8_MAX)) {
 		LOTRACE_WARN("%s: Bad token value.", "getValueUINT8");
 		return -1;
 	}
+	*value = (uint8_t) v;
 	return 0;
 }
 #endif
@@ -201,16 +182,10 @@ static int getValueFLOAT(float* value, const char* payload_json, const jsmntok_t
 	if (isValidTokenPrimitive("getValueFLOAT", payload_json, token)) {
 		return -1;
 	}
-#ifdef ARDUINO
-	double df;
-	df = atof(payload_json + token->start);
-	*value = df;
-#else
-	if (1 != sscanf(payload_json + token->start, "%f", value)) {
+	if (LO_json_atof(payload_json + token->start, TOKEN_LEN(token), value)) {
 		LOTRACE_WARN("%s: Bad token value.", "getValueFLOAT");
 		return -1;
 	}
-#endif
 	return 0;
 }
 
@@ -218,18 +193,14 @@ static int getValueDOUBLE(double* value, const char* payload_json, const jsmntok
 	if (isValidTokenPrimitive("getValueDOUBLE", payload_json, token)) {
 		return -1;
 	}
-#ifdef ARDUINO
-	*value = atof(payload_json + token->start);
-#else
-	if (1 != sscanf(payload_json + token->start, "%lf", value)) {
+	if (LO_json_atod(payload_json + token->start, TOKEN_LEN(token), value)) {
 		LOTRACE_WARN("%s: Bad token value.", "getValueDOUBLE");
 		return -1;
 	}
-#endif
 	return 0;
-
 }
 
+#if LOC_FEATURE_LO_RESOURCES
 /* --------------------------------------------------------------------------------- */
 /*  */
 static int get_CorrelationId(int32_t* pCid, const char* payload_data, const jsmntok_t* tokens, int32_t token_cnt) {
@@ -269,12 +240,13 @@ static int get_CorrelationId(int32_t* pCid, const char* payload_data, const jsmn
 	}
 	return -1;
 }
+#endif
 
 /* --------------------------------------------------------------------------------- */
 /*  */
 #if LOC_FEATURE_LO_PARAMS
 static int updateCnfParam(const char* payload_json, const jsmntok_t* token, const LiveObjectsD_Param_t* param_ptr,
-		LiveObjectsD_CallbackParams_t cfgCB) {
+		LiveObjectsD_CallbackParams_t cfgCB, uint8_t apply) {
 	int ret;
 	if ((payload_json == NULL) || (token == NULL) || (param_ptr == NULL)) {
 		LOTRACE_ERR("Invalid parameters - payload=x%p token=x%p param_ptr=x%p", payload_json, token,
@@ -287,7 +259,7 @@ static int updateCnfParam(const char* payload_json, const jsmntok_t* token, cons
 			LOTRACE_ERR("bad token type  %d != %d (STRING)", token->type, JSMN_STRING);
 			return -1;
 		}
-		ret = cfgCB(param_ptr, (const void*) (payload_json + token->start), token->end - token->start);
+		ret = ((apply) && (cfgCB)) ? cfgCB(param_ptr, (const void*) (payload_json + token->start), token->end - token->start) : 0;
 	}
 	else {
 		if (token->type != JSMN_PRIMITIVE) {
@@ -299,8 +271,8 @@ static int updateCnfParam(const char* payload_json, const jsmntok_t* token, cons
 		if (param_ptr->parm_data.data_type == LOD_TYPE_UINT32) {
 			uint32_t value;
 			ret = getValueUINT32(&value, payload_json, token);
-			if ((ret == 0) && (param_ptr->parm_data.data_value)) {
-				ret = cfgCB(param_ptr, (const void*) &value, sizeof(uint32_t));
+			if ((ret == 0) && (apply) && (param_ptr->parm_data.data_value)) {
+				ret = (cfgCB) ? cfgCB(param_ptr, (const void*) &value, sizeof(uint32_t)) : 0;
 				if (ret == 0)
 					*((uint32_t*) param_ptr->parm_data.data_value) = value;
 			}
@@ -308,8 +280,8 @@ static int updateCnfParam(const char* payload_json, const jsmntok_t* token, cons
 		else if (param_ptr->parm_data.data_type == LOD_TYPE_INT32) {
 			int32_t value;
 			ret = getValueINT32(&value, payload_json, token);
-			if ((ret == 0) && (param_ptr->parm_data.data_value)) {
-				ret = cfgCB(param_ptr, (const void*) &value, sizeof(int32_t));
+			if ((ret == 0) && (apply) && (param_ptr->parm_data.data_value)) {
+				ret = (cfgCB) ? cfgCB(param_ptr, (const void*) &value, sizeof(int32_t)) : 0;
 				if (ret == 0)
 					*((int32_t*) param_ptr->parm_data.data_value) = value;
 			}
@@ -317,8 +289,8 @@ static int updateCnfParam(const char* payload_json, const jsmntok_t* token, cons
 		else if (param_ptr->parm_data.data_type == LOD_TYPE_FLOAT) {
 			float value;
 			ret = getValueFLOAT(&value, payload_json, token);
-			if ((ret == 0) && (param_ptr->parm_data.data_value)) {
-				ret = cfgCB(param_ptr, (const void*) &value, sizeof(float));
+			if ((ret == 0) && (apply) && (param_ptr->parm_data.data_value)) {
+				ret = (cfgCB) ? cfgCB(param_ptr, (const void*) &value, sizeof(float)) : 0;
 				if (ret == 0)
 					*((float*) param_ptr->parm_data.data_value) = value;
 			}
@@ -326,8 +298,8 @@ static int updateCnfParam(const char* payload_json, const jsmntok_t* token, cons
 		else if (param_ptr->parm_data.data_type == LOD_TYPE_DOUBLE) {
 			double value;
 			ret = getValueDOUBLE(&value, payload_json, token);
-			if ((ret == 0) && (param_ptr->parm_data.data_value)) {
-				ret = cfgCB(param_ptr, (const void*) &value, sizeof(double));
+			if ((ret == 0) && (apply) && (param_ptr->parm_data.data_value)) {
+				ret = (cfgCB) ? cfgCB(param_ptr, (const void*) &value, sizeof(double)) : 0;
 				if (ret == 0)
 					*((double*) param_ptr->parm_data.data_value) = value;
 			}
@@ -344,7 +316,7 @@ static int updateCnfParam(const char* payload_json, const jsmntok_t* token, cons
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-#if (MSG_DUMP)
+#if (MSG_DUMP) && LOC_FEATURE_LO_RESOURCES
 static void dump_json_msg(const char* from, const char* payload_data, const jsmntok_t* tokens, int32_t token_cnt) {
 	int idx;
 	int len;
@@ -570,7 +542,8 @@ LiveObjectsD_ResourceRespCode_t LO_msg_decode_rsc_req(const char* payload_data,
 							val_ptr[len] = 0;
 						}
 						else if (val_type == 3) {
-							if (1 != sscanf(payload_data + tokens[idx + 1].start, "%"PRIu32, (uint32_t*) val_ptr)) {
+							if (LO_json_atou(payload_data + tokens[idx + 1].start,
+									(uint32_t) (tokens[idx + 1].end - tokens[idx + 1].start), (uint32_t*) val_ptr)) {
 								LOTRACE_ERR("TK[%d] %.*s , bad value", idx + 1,
 										tokens[idx + 1].end - tokens[idx + 1].start,
 										payload_data + tokens[idx + 1].start);
@@ -679,184 +652,510 @@ LiveObjectsD_ResourceRespCode_t LO_msg_decode_rsc_req(const char* payload_data,
 }
 #endif /* LOC_FEATURE_LO_RESOURCES */
 
-/* --------------------------------------------------------------------------------- */
-/* Decode a received JSON message to update configuration parameters
+#if LOC_FEATURE_LO_PARAMS || LOC_FEATURE_LO_COMMANDS
+/* ================================================================================= */
+/* Single-pass JSON scanner (dev/cfg/upd and dev/cmd requests)
+ * -----------------------------------------------------------
+ * The members of an object are read one after the other, and each value is given as
+ * a jsmn token (type and position in the payload): the keys are dispatched as they are
+ * read, without token array, so there is no limit on the size of a request and the
+ * stack is constant. A value which is not used (object or array) is skipped.
  */
-#if LOC_FEATURE_LO_PARAMS
-int LO_msg_decode_params_req(const char* payload_data, uint32_t payload_len, const LOMSetOfParams_t* pSetCfg,
-		LOMSetofUpdatedParams_t* pSetCfgUpdate) {
-#ifndef LOC_MAX_OF_PARSED_PARAMS
-#warning "LOC_MAX_OF_PARSED_PARAMS not defined -> set to 5"
-#define LOC_MAX_OF_PARSED_PARAMS   5
-#endif
-#define NB_TK_FOR_PARMS    (5+6*LOC_MAX_OF_PARSED_PARAMS+1)  //  6 tokens by parameter
-	int ret;
-	int token_cnt;
-	jsmn_parser parser;
-	jsmntok_t tokens[NB_TK_FOR_PARMS];
-	int idx;
-	int size;
-	const char* pc;
-	int len;
+#define JS_MAX_DEPTH    32          /* Max depth of a skipped value (one bit per level) */
 
-	if ((pSetCfg == NULL) || (payload_data == NULL) || (payload_len == 0) || (pSetCfgUpdate == NULL)) {
-		LOTRACE_ERR("Invalid parameters, pSetCfg=x%p payload_data=x%p (%"PRIu32") pSetCfgUpdate=x%p",
-				pSetCfg, payload_data, payload_len, pSetCfgUpdate);
-		return -1;
+typedef struct {
+	const char* json;               /* Payload */
+	int pos;                        /* Current position */
+	int len;                        /* Length of the payload */
+} LOMJsonScan_t;
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void js_init(LOMJsonScan_t* s, const char* json, uint32_t len) {
+	s->json = json;
+	s->pos = 0;
+	s->len = (int) len;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Skip the white spaces, and return the next character (0 at the end of the payload) */
+static char js_peek(LOMJsonScan_t* s) {
+	while (s->pos < s->len) {
+		char c = s->json[s->pos];
+		if ((c != ' ') && (c != '\t') && (c != '\r') && (c != '\n')) {
+			return c;
+		}
+		s->pos++;
 	}
+	return 0;
+}
 
-	pSetCfgUpdate->cid = 0;
-	pSetCfgUpdate->nb_of_params = 0;
+/* --------------------------------------------------------------------------------- */
+/* Read a string (the escape sequences are kept, as jsmn) */
+static int js_string(LOMJsonScan_t* s, jsmntok_t* tk) {
+	tk->type = JSMN_STRING;
+	tk->start = ++s->pos;
+	tk->size = 0;
+	while (s->pos < s->len) {
+		char c = s->json[s->pos];
+		if (c == '"') {
+			tk->end = s->pos++;
+			return 0;
+		}
+		s->pos += (c == '\\') ? 2 : 1;
+	}
+	LOTRACE_ERR("Bad JSON format - unterminated string at %d", tk->start - 1);
+	return -1;
+}
 
-	memset(&tokens, 0, sizeof(tokens));
-	jsmn_init(&parser);
-	token_cnt = jsmn_parse(&parser, payload_data, payload_len, tokens, NB_TK_FOR_PARMS);
-	if (token_cnt < 0) {
-		LOTRACE_ERR("ERROR %d returned by jsmn_parse (max params=%u)", token_cnt, LOC_MAX_OF_PARSED_PARAMS);
-		LOTRACE_ERR("'%s'", payload_data);
+/* --------------------------------------------------------------------------------- */
+/* Read a value: string, primitive, or object/array (skipped) */
+static int js_value(LOMJsonScan_t* s, jsmntok_t* tk) {
+	char c = js_peek(s);
+	tk->start = s->pos;
+	tk->size = 0;
+	if (c == '"') {
+		return js_string(s, tk);
+	}
+	if ((c == '{') || (c == '[')) {
+		/* Nesting: one bit per level (1: object), to check the closing brackets */
+		uint32_t kinds = 0;
+		int depth = 0;
+		tk->type = (c == '{') ? JSMN_OBJECT : JSMN_ARRAY;
+		while (s->pos < s->len) {
+			jsmntok_t str;
+			c = s->json[s->pos];
+			if (c == '"') {
+				if (js_string(s, &str)) {
+					return -1;
+				}
+				continue;
+			}
+			if ((c == '{') || (c == '[')) {
+				if (depth == JS_MAX_DEPTH) {
+					break;
+				}
+				kinds = (kinds << 1) | (c == '{');
+				depth++;
+			}
+			else if ((c == '}') || (c == ']')) {
+				if ((kinds & 1) != (c == '}')) {
+					break;
+				}
+				kinds >>= 1;
+				if (--depth == 0) {
+					tk->end = ++s->pos;
+					return 0;
+				}
+			}
+			s->pos++;
+		}
+		LOTRACE_ERR("Bad JSON format - object/array at %d", tk->start);
 		return -1;
 	}
-#undef NB_TK_FOR_PARMS
-	if (token_cnt == 0) {
-		LOTRACE_ERR("EMPTY !!");
-		return 0;
+	/* Primitive: number, true, false or null */
+	if ((c != '-') && ((c < '0') || (c > '9')) && (c != 't') && (c != 'f') && (c != 'n')) {
+		LOTRACE_ERR("Bad JSON format - unexpected '%c' at %d", c ? c : ' ', s->pos);
+		return -1;
 	}
+	tk->type = JSMN_PRIMITIVE;
+	while (s->pos < s->len) {
+		c = s->json[s->pos];
+		if ((c == ',') || (c == '}') || (c == ']') || (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n')
+				|| (c == 0)) {
+			break;
+		}
+		s->pos++;
+	}
+	tk->end = s->pos;
+	return 0;
+}
 
-#if (MSG_DUMP)
-	dump_json_msg("decode_cfg", payload_data, tokens, token_cnt);
-#endif
-
-	if (token_cnt < 2) {
-		LOTRACE_ERR("Bad format - token_cnt=%d < 2 too short !!", token_cnt);
+/* --------------------------------------------------------------------------------- */
+/* Enter an object */
+static int js_begin(LOMJsonScan_t* s) {
+	if (js_peek(s) != '{') {
 		return -1;
 	}
+	s->pos++;
+	return 0;
+}
 
-	if ((tokens[0].type != JSMN_OBJECT) || (tokens[0].size <= 0)) {
-		LOTRACE_ERR("Bad format - %d [0]=(%d,%d)", token_cnt, tokens[0].type, tokens[0].size);
+/* --------------------------------------------------------------------------------- */
+/* Read the key of the next member of the current object (*n: number of members already read).
+ * Return 1 (the value is to be read), 0 at the end of the object, or -1 on error. */
+static int js_member(LOMJsonScan_t* s, int* n, jsmntok_t* key) {
+	char c = js_peek(s);
+	if (c == '}') {
+		s->pos++;
+		return 0;
+	}
+	if (*n) {
+		if (c != ',') {
+			LOTRACE_ERR("Bad JSON format - ',' expected at %d", s->pos);
+			return -1;
+		}
+		s->pos++;
+		c = js_peek(s);
+	}
+	if ((c != '"') || js_string(s, key)) {
+		LOTRACE_ERR("Bad JSON format - key expected at %d", s->pos);
 		return -1;
 	}
-
-	// Get the Correlation Id
-	ret = get_CorrelationId(&pSetCfgUpdate->cid, payload_data, &tokens[1], token_cnt);
-	if (ret) {
-		LOTRACE_ERR("Error to get the correlation id");
+	if (js_peek(s) != ':') {
+		LOTRACE_ERR("Bad JSON format - ':' expected at %d", s->pos);
 		return -1;
 	}
+	s->pos++;
+	(*n)++;
+	return 1;
+}
 
-	if ((tokens[1].type != JSMN_STRING) || (tokens[1].size != 1) // should be 'cfg'
-			|| (tokens[2].type != JSMN_OBJECT) || (tokens[2].size < 0)) // should be {
-			{
-		LOTRACE_ERR("Bad header format - [1]=(%d,%d) [2]=(%d,%d)", tokens[1].type, tokens[1].size,
-				tokens[2].type, tokens[2].size);
-		return -1;
+/* --------------------------------------------------------------------------------- */
+/*  */
+static int js_isKey(const char* payload_json, const jsmntok_t* key, const char* name) {
+	int len = key->end - key->start;
+	return (len == (int) strlen(name)) && !memcmp(payload_json + key->start, name, len);
+}
+#endif /* LOC_FEATURE_LO_PARAMS || LOC_FEATURE_LO_COMMANDS */
+
+#if LOC_FEATURE_LO_PARAMS || LOC_FEATURE_LO_COMMANDS
+/* ================================================================================= */
+/* Index of the names of an attached table
+ * ---------------------------------------
+ * Built once when the table is attached, then only read by the decoder: the received
+ * name is hashed, and only the elements with the same hash tag are compared.
+ * The table, its number of elements and its index are replaced together under MSG_MUTEX,
+ * which the decoder also locks while it looks up a name.
+ */
+#define LOM_INDEX_POS_MASK    0xFFFFU     /* Position + 1 of the element in a slot */
+#define LOM_INDEX_TAG(h)      ((h) & ~LOM_INDEX_POS_MASK)
+
+#define LOM_INDEX_NAME(table, i, stride, offset) \
+	(*(const char* const*) ((const char*) (table) + (i) * (stride) + (offset)))
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_msg_index_free(LOMNameIndex_t* idx) {
+	if (idx->slot) {
+		MEM_FREE(idx->slot);
+		idx->slot = NULL;
 	}
+	idx->mask = 0;
+}
 
-	ret = check_token(payload_data, &tokens[1], "cfg");
-	if (ret <= 0) {
-		LOTRACE_ERR("Bad format, expected 'cfg'");
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_msg_index_build(LOMNameIndex_t* idx, const void* table, uint32_t nb, uint32_t stride, uint32_t offset) {
+	uint32_t* slot;
+	uint32_t nb_slots;
+	uint32_t i;
+
+	LO_msg_index_free(idx);
+
+	if ((table == NULL) || (nb < LOM_NAME_INDEX_MIN) || (nb >= LOM_INDEX_POS_MASK)) {
+		return 0;
+	}
+	/* Load factor <= 0.5 */
+	nb_slots = 4;
+	while (nb_slots < 2 * nb) {
+		nb_slots <<= 1;
+	}
+	slot = (uint32_t*) MEM_ALLOC(nb_slots * sizeof(uint32_t));
+	if (slot == NULL) {
+		LOTRACE_WARN("nb=%"PRIu32" - MEM_ALLOC ERROR, len=%"PRIu32" - linear search", nb,
+				(uint32_t) (nb_slots * sizeof(uint32_t)));
 		return -1;
 	}
-	// skip the first tokens '{ "cfg" : {'
-	idx = 3;
-	token_cnt -= 3;
-
-	// Get the number of parameters
-	size = tokens[2].size;
-	LOTRACE_DBG1("%d parameters (token_cnt=%d) ...", size, token_cnt);
-
-	// Now, get each configuration parameter
-	while (size > 0) {
-		if ((token_cnt < 6) || (tokens[idx].type != JSMN_STRING) // 0: should be the Parameter Name
-				|| (tokens[idx + 1].type != JSMN_OBJECT) // 1: should be {
-				|| (tokens[idx + 2].type != JSMN_STRING) // 2: Should be equal to "t"
-				|| (tokens[idx + 3].type != JSMN_STRING) // 3: Should be the parameter type : "u32" , "u16", ...
-				|| (tokens[idx + 4].type != JSMN_STRING) // 4: Should be equal to "v"
-														 // 5: Value : either JSMN_PRIMITIVE or JSMN_STRING
-				|| !((tokens[idx + 5].type == JSMN_PRIMITIVE) || (tokens[idx + 5].type == JSMN_STRING))) {
-			LOTRACE_ERR("Bad param format, at idx=%d (param[%d] token_cnt=%d)", idx, tokens[2].size - size,
-					token_cnt);
-			return -2;
+	memset(slot, 0, nb_slots * sizeof(uint32_t));
+
+	/* Inserted in order: the first element of a duplicated name is found first */
+	for (i = 0; i < nb; i++) {
+		const char* name = LOM_INDEX_NAME(table, i, stride, offset);
+		uint32_t h;
+		uint32_t k;
+		if (name == NULL) {
+			continue;
 		}
-
-		ret = check_token(payload_data, &tokens[idx + 2], "t");
-		if (ret <= 0) {
-			LOTRACE_ERR("Bad param format at idx=%d - expected 't'", idx + 2);
-			return -2;
+		h = LO_msg_hash(LOM_HASH_INIT, name, strlen(name));
+		k = h & (nb_slots - 1);
+		while (slot[k]) {
+			k = (k + 1) & (nb_slots - 1);
 		}
+		slot[k] = LOM_INDEX_TAG(h) | (i + 1);
+	}
+	idx->slot = slot;
+	idx->mask = nb_slots - 1;
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_msg_index_find(const LOMNameIndex_t* idx, const void* table, uint32_t nb, uint32_t stride, uint32_t offset,
+		const char* name, uint32_t len) {
+	const char* pn;
+	uint32_t i;
 
-		ret = check_token(payload_data, &tokens[idx + 4], "v");
-		if (ret <= 0) {
-			LOTRACE_NOTICE("Bad param format at idx=%d - expected 'v'", idx + 4);
-			return -2;
+	if (table == NULL) {
+		return -1;
+	}
+	if (idx->slot) {
+		uint32_t h = LO_msg_hash(LOM_HASH_INIT, name, len);
+		uint32_t k = h & idx->mask;
+		uint32_t v;
+		while ((v = idx->slot[k]) != 0) {
+			if (LOM_INDEX_TAG(v) == LOM_INDEX_TAG(h)) {
+				i = (v & LOM_INDEX_POS_MASK) - 1;
+				if (i < nb) {
+					pn = LOM_INDEX_NAME(table, i, stride, offset);
+					if ((strlen(pn) == len) && (!memcmp(pn, name, len))) {
+						return (int) i;
+					}
+				}
+			}
+			k = (k + 1) & idx->mask;
+		}
+		return -1;
+	}
+	for (i = 0; i < nb; i++) {
+		pn = LOM_INDEX_NAME(table, i, stride, offset);
+		if ((pn) && (strlen(pn) == len) && (!memcmp(pn, name, len))) {
+			return (int) i;
 		}
+	}
+	return -1;
+}
+#endif /* LOC_FEATURE_LO_PARAMS || LOC_FEATURE_LO_COMMANDS */
 
-		// Parameter Name
-		len = tokens[idx].end - tokens[idx].start;
-		pc = payload_data + tokens[idx].start;
+/* --------------------------------------------------------------------------------- */
+/* Decode the member "<param name>": { "t": "<type>", "v": <value> } of the "cfg" object.
+ * When apply is 0, only check that the value of a registered parameter can be converted;
+ * otherwise update the parameter and add it to the set of updated parameters.
+ * Return -1 on a JSON error, -2 if this parameter is malformed (the next ones can be read). */
+#if LOC_FEATURE_LO_PARAMS
+static int decode_param(LOMJsonScan_t* s, const jsmntok_t* name, const LOMSetOfParams_t* pSetCfg,
+		LOMSetofUpdatedParams_t* pSetCfgUpdate, uint8_t apply) {
+	const LiveObjectsD_Param_t* param_ptr = NULL;
+	jsmntok_t key, val, tk_type, tk_value;
+	const char* payload_data = s->json;
+	const char* pc = payload_data + name->start;
+	int len = name->end - name->start;
+	int n = 0;
+	int ret;
+	int i;
 
 #if (MSG_DBG > 1)
-		if (len > 0) {
-			LOTRACE_PRINTF("   *** param name = %.*s\r\n", len, pc);
-		}
+	if (len > 0) {
+		LOTRACE_PRINTF("   *** param name = %.*s\r\n", len, pc);
+	}
 #endif
 
-		if (pSetCfg->param_set.param_nb) {
-			int i;
-			const LiveObjectsD_Param_t* param_ptr = pSetCfg->param_set.param_ptr;
-			for (i = 0; i < pSetCfg->param_set.param_nb; i++, param_ptr++) {
-				int param_name_len = strlen(param_ptr->parm_data.data_name);
-				if ((len == param_name_len) && (!strncmp(pc, param_ptr->parm_data.data_name, param_name_len))) {
-					// Config Parameter Name is found in the user list
-					// Get the type of this config parameter
-					LiveObjectsD_Type_t type = LO_getDataTypeFromStrL(payload_data + tokens[idx + 3].start,
-							tokens[idx + 3].end - tokens[idx + 3].start);
-					if (type == LOD_TYPE_UNKNOWN) {
-						LOTRACE_NOTICE("param %s - Unknown received type",
-								param_ptr->parm_data.data_name);
-					}
-					else if (type != param_ptr->parm_data.data_type) {
-						LOTRACE_NOTICE("param %s - bad type - received %d != expected %d",
-								param_ptr->parm_data.data_name, type, param_ptr->parm_data.data_type);
-					}
-					else if ((type == LOD_TYPE_STRING_C) && (tokens[idx + 5].type != JSMN_STRING)) {
-						LOTRACE_NOTICE("param %s - string type with unexpected jsmntype %d != %d",
-								param_ptr->parm_data.data_name, tokens[idx + 5].type, JSMN_STRING);
-					}
-					else {
+	tk_type.type = JSMN_UNDEFINED;
+	tk_value.type = JSMN_UNDEFINED;
+	if (js_peek(s) != '{') {
+		LOTRACE_ERR("Bad param format (%.*s) - expected '{'", len, pc);
+		return (js_value(s, &val)) ? -1 : -2;
+	}
+	js_begin(s);
+	while ((ret = js_member(s, &n, &key)) > 0) {
+		if (js_value(s, &val)) {
+			return -1;
+		}
+		if (js_isKey(payload_data, &key, "t")) {
+			tk_type = val;
+		}
+		else if (js_isKey(payload_data, &key, "v")) {
+			tk_value = val;
+		}
+	}
+	if (ret < 0) {
+		return -1;
+	}
+	if ((tk_type.type != JSMN_STRING) || ((tk_value.type != JSMN_PRIMITIVE) && (tk_value.type != JSMN_STRING))) {
+		LOTRACE_ERR("Bad param format (%.*s) - expected 't' and 'v'", len, pc);
+		return -2;
+	}
+
+	MSG_MUTEX_LOCK();
+	i = LO_msg_index_find(&pSetCfg->param_index, pSetCfg->param_set.param_ptr, pSetCfg->param_set.param_nb,
+			sizeof(LiveObjectsD_Param_t), offsetof(LiveObjectsD_Param_t, parm_data.data_name), pc, len);
+	if (i >= 0) {
+		param_ptr = &pSetCfg->param_set.param_ptr[i];
+	}
+	MSG_MUTEX_UNLOCK();
+	if (param_ptr) {
+		// Config Parameter Name is found in the user list
+		// Get the type of this config parameter
+		LiveObjectsD_Type_t type = LO_getDataTypeFromStrL(payload_data + tk_type.start,
+				tk_type.end - tk_type.start);
+		if (type == LOD_TYPE_UNKNOWN) {
+			if (!apply)
+				LOTRACE_NOTICE("param %s - Unknown received type", param_ptr->parm_data.data_name);
+		}
+		else if (type != param_ptr->parm_data.data_type) {
+			if (!apply)
+				LOTRACE_NOTICE("param %s - bad type - received %d != expected %d", param_ptr->parm_data.data_name,
+						type, param_ptr->parm_data.data_type);
+		}
+		else if ((type == LOD_TYPE_STRING_C) && (tk_value.type != JSMN_STRING)) {
+			if (!apply)
+				LOTRACE_NOTICE("param %s - string type with unexpected jsmntype %d != %d",
+						param_ptr->parm_data.data_name, tk_value.type, JSMN_STRING);
+		}
+		else if (!apply) {
+			if (updateCnfParam(payload_data, &tk_value, param_ptr, NULL, 0)) {
+				LOTRACE_ERR("param %s - bad value %.*s", param_ptr->parm_data.data_name,
+						tk_value.end - tk_value.start, payload_data + tk_value.start);
+				return -2;
+			}
+		}
+		else {
 #if (MSG_DBG > 1)
-						LOTRACE_PRINTF("   *** param value = %.*s\r\n", tokens[idx + 5].end - tokens[idx + 5].start,
-								payload_data + tokens[idx + 5].start);
+			LOTRACE_PRINTF("   *** param value = %.*s\r\n", tk_value.end - tk_value.start,
+					payload_data + tk_value.start);
 #endif
-						ret = updateCnfParam(payload_data, &tokens[idx + 5], param_ptr, pSetCfg->param_callback);
+			updateCnfParam(payload_data, &tk_value, param_ptr, pSetCfg->param_callback, 1);
 
-						if (pSetCfgUpdate->nb_of_params < LOC_MAX_OF_PARSED_PARAMS) {
-							pSetCfgUpdate->tab_of_param_ptr[pSetCfgUpdate->nb_of_params++] = param_ptr;
-						}
-					}
+			for (i = 0; i < pSetCfgUpdate->nb_of_params; i++) {
+				if (pSetCfgUpdate->tab_of_param_ptr[i] == param_ptr)
 					break;
+			}
+			if ((i == pSetCfgUpdate->nb_of_params) && (i < pSetCfgUpdate->max_of_params)) {
+				pSetCfgUpdate->tab_of_param_ptr[pSetCfgUpdate->nb_of_params++] = param_ptr;
+			}
+		}
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Scan a received JSON message to update configuration parameters:
+ *   { "cfg": { "<name>": { "t": "<type>", "v": <value> }, ... }, "cid": <correlation id> }
+ * in one pass, the members in any order. The parameters are updated only when apply is set.
+ */
+static int decode_params(const char* payload_data, uint32_t payload_len, const LOMSetOfParams_t* pSetCfg,
+		LOMSetofUpdatedParams_t* pSetCfgUpdate, int32_t* pCid, uint8_t apply) {
+	LOMJsonScan_t s;
+	jsmntok_t key, val;
+	uint8_t cfg_found = 0;
+	int bad = 0;               /* A parameter is malformed */
+	int n = 0;
+	int ret;
+
+	js_init(&s, payload_data, payload_len);
+	if (js_begin(&s)) {
+		LOTRACE_ERR("Bad format - object expected");
+		return -1;
+	}
+
+	while ((ret = js_member(&s, &n, &key)) > 0) {
+		if (js_isKey(payload_data, &key, "cfg")) {
+			int np = 0;
+			if (js_begin(&s)) {
+				LOTRACE_ERR("Bad format, expected 'cfg' object");
+				return -1;
+			}
+			while ((ret = js_member(&s, &np, &key)) > 0) {
+				ret = decode_param(&s, &key, pSetCfg, pSetCfgUpdate, apply);
+				if (ret == -1) {
+					break;
+				}
+				if (ret) {
+					bad = ret;
 				}
 			}
+			if (ret < 0) {
+				return -1;
+			}
+			LOTRACE_DBG1("%d parameters", np);
+			cfg_found = 1;
 		}
-		size--;
-		token_cnt -= 6;
-		idx += 6;
+		else if (js_value(&s, &val)) {
+			return -1;
+		}
+		else if (js_isKey(payload_data, &key, "cid")) {
+			if (getValueINT32(pCid, payload_data, &val)) {
+				LOTRACE_ERR("Error to get the correlation id");
+				return -1;
+			}
+		}
+	}
+	if (ret < 0) {
+		return -1;
 	}
+	if (*pCid == 0) {
+		LOTRACE_ERR("Error to get the correlation id");
+		return -1;
+	}
+	if (!cfg_found) {
+		LOTRACE_ERR("Bad format, expected 'cfg'");
+		return -1;
+	}
+	return bad;
+}
 
-	return 0;
+/* --------------------------------------------------------------------------------- */
+/* Decode a received JSON message to update configuration parameters.
+ * The whole message is checked first, and the parameters are updated only if it is valid:
+ * a request is applied completely or not at all (return -1 or -2, and no response).
+ */
+int LO_msg_decode_params_req(const char* payload_data, uint32_t payload_len, const LOMSetOfParams_t* pSetCfg,
+		LOMSetofUpdatedParams_t* pSetCfgUpdate) {
+	int32_t cid = 0;
+	int ret;
+
+	if ((pSetCfg == NULL) || (payload_data == NULL) || (payload_len == 0) || (pSetCfgUpdate == NULL)) {
+		LOTRACE_ERR("Invalid parameters, pSetCfg=x%p payload_data=x%p (%"PRIu32") pSetCfgUpdate=x%p",
+				pSetCfg, payload_data, payload_len, pSetCfgUpdate);
+		return -1;
+	}
+
+	pSetCfgUpdate->cid = 0;
+	pSetCfgUpdate->nb_of_params = 0;
+
+	{
+		LOMJsonScan_t s;
+		js_init(&s, payload_data, payload_len);
+		if (js_peek(&s) == 0) {
+			LOTRACE_ERR("EMPTY !!");
+			return 0;
+		}
+	}
+
+	ret = decode_params(payload_data, payload_len, pSetCfg, pSetCfgUpdate, &cid, 0);
+	if (ret) {
+		LOTRACE_ERR("cid=%"PRIi32" - request rejected, no parameter is updated", cid);
+		return ret;
+	}
+	cid = 0;
+	ret = decode_params(payload_data, payload_len, pSetCfg, pSetCfgUpdate, &cid, 1);
+	if (ret == 0) {
+		pSetCfgUpdate->cid = cid;
+	}
+	return ret;
 }
 #endif /* LOC_FEATURE_LO_PARAMS */
 
 /* --------------------------------------------------------------------------------- */
-/*  */
+/* Decode a received JSON message to process a command:
+ *   { "req": "<command name>", "arg": { "<name>": <value>, ... }, "cid": <correlation id> }
+ * in one pass, the members in any order. The arguments (string or primitive values) are
+ * counted while they are read, and then copied in the request block given to the user.
+ */
 #if LOC_FEATURE_LO_COMMANDS
 int LO_msg_decode_cmd_req(const char* payload_data, uint32_t payload_len, const LOMSetofCommands_t* pSetCmd,
 		int32_t* pCid) {
+	LOMJsonScan_t s;
+	jsmntok_t key, val;
+	jsmntok_t req;
+	int arg_pos = -1;          /* Position of the "arg" object */
+	int arg_nb = 0;            /* Number of arguments */
+	int arg_sz = 0;            /* Size of their names and values */
+	int bad = 0;               /* Format not supported (but JSON text well-formed) */
 	int ret;
-	int token_cnt;
-	jsmn_parser parser;
-	jsmntok_t tokens[20];
 	int idx;
 	int size;
+	int n = 0;
 	const LiveObjectsD_Command_t* cmd_ptr;
 
 	if ((pSetCmd == NULL) || (payload_data == NULL) || (pCid == NULL)) {
@@ -867,174 +1166,146 @@ int LO_msg_decode_cmd_req(const char* payload_data, uint32_t payload_len, const
 
 	*pCid = 0;
 
-	memset(&tokens, 0, sizeof(tokens));
-	jsmn_init(&parser);
-	token_cnt = jsmn_parse(&parser, payload_data, payload_len, tokens, 20);
-	if (token_cnt < 0) {
-		LOTRACE_ERR("ERROR %d returned by jsmn_parse", token_cnt);
-		LOTRACE_ERR("'%.*s'", (int) payload_len, payload_data);
-		return -1;
-	}
-	if (token_cnt == 0) {
+	js_init(&s, payload_data, payload_len);
+	if (js_peek(&s) == 0) {
 		LOTRACE_NOTICE("EMPTY !!");
 		return 0;
 	}
-
-#if (MSG_DUMP)
-	dump_json_msg("decode_cmd", payload_data, tokens, token_cnt);
-#endif
-
-	if (token_cnt < 5) {
-		LOTRACE_ERR("Bad format - token_cnt=%d < 5 too short !! ", token_cnt);
+	if (js_begin(&s)) {
+		LOTRACE_ERR("Bad format: object expected");
 		return -1;
 	}
 
-	if ((tokens[0].type != JSMN_OBJECT) || (tokens[0].size <= 0)) {
-		LOTRACE_ERR("Bad format: Empty !!  %d [0]=(%d,%d)", token_cnt, tokens[0].type, tokens[0].size);
-		return -1;
+	memset(&req, 0, sizeof(req));
+	req.type = JSMN_UNDEFINED;
+	while ((ret = js_member(&s, &n, &key)) > 0) {
+		if ((js_isKey(payload_data, &key, "arg")) && (js_peek(&s) == '{')) {
+			int na = 0;
+			arg_pos = s.pos;
+			js_begin(&s);
+			while ((ret = js_member(&s, &na, &key)) > 0) {
+				if (js_value(&s, &val)) {
+					ret = -1;
+					break;
+				}
+				if ((val.type != JSMN_STRING) && (val.type != JSMN_PRIMITIVE)) {
+					LOTRACE_ERR("format not supported for arg \"%.*s\" (%s)", key.end - key.start,
+							payload_data + key.start, conv_jsmntypeToString(val.type));
+					bad = 1;
+				}
+				arg_sz += (key.end - key.start) + (val.end - val.start) + 2;
+			}
+			if (ret < 0) {
+				break;
+			}
+			arg_nb = na;
+		}
+		else if (js_value(&s, &val)) {
+			ret = -1;
+			break;
+		}
+		else if (js_isKey(payload_data, &key, "req")) {
+			req = val;
+		}
+		else if (js_isKey(payload_data, &key, "arg")) {
+			LOTRACE_ERR("Bad format - \"arg\" object was expected");
+			bad = 1;
+		}
+		else if (js_isKey(payload_data, &key, "cid")) {
+			if (getValueINT32(pCid, payload_data, &val)) {
+				*pCid = 0;
+			}
+		}
 	}
 
-	// Get the Correlation Id.
-	ret = get_CorrelationId(pCid, payload_data, &tokens[1], token_cnt - 1);
-	if (ret) {
+	if (*pCid == 0) {
 		LOTRACE_ERR("Error to get the correlation id (cid)");
 		return -1;
 	}
-
-	// Now, Check the first tokens
-	// Note: suppose that token[1]= "req" and token[3]= "arg", and so cid at the end !!
-	if ((tokens[0].type != JSMN_OBJECT) || (tokens[0].size < 3) // at least 3 items : "req", "arg" and "cid"
-			|| (tokens[1].type != JSMN_STRING) || (tokens[1].size != 1) // expected : "req"
-			|| (tokens[2].type != JSMN_STRING) || (tokens[2].size != 0) // expected : name of request
-			) {
-		LOTRACE_ERR("Bad format (cid=%"PRIi32") - %d [0]=(%d,%d) [1]=(%d,%d) [2]=(%d,%d)", *pCid, token_cnt,
-				tokens[0].type, tokens[0].size, tokens[1].type, tokens[1].size, tokens[2].type, tokens[2].size);
-		//pCid = 0; // set cid=0 => no response, otherwise LiveObjects platform will send again this malformed command !!
+	if ((ret < 0) || (bad)) {
+		LOTRACE_ERR("Bad format (cid=%"PRIi32")", *pCid);
 		return -2;
 	}
-
-	ret = check_token(payload_data, &tokens[1], "req");
-	if (ret <= 0) {
+	if (req.type != JSMN_STRING) {
 		LOTRACE_ERR("Bad format (cid=%"PRIi32") - expected=req", *pCid);
 		return -2;
 	}
 
 	// Is it registered by user ?
 	cmd_ptr = NULL;
-	size = tokens[2].end - tokens[2].start;
-	LOTRACE_INF("command \"%.*s\"  (NumberOfCommands=%d) ..", size, payload_data + tokens[2].start,
-			pSetCmd->cmd_nb);
-	for (idx = 0; idx < pSetCmd->cmd_nb; idx++) {
-		LOTRACE_DBG1("   [%d] %s ?", idx, pSetCmd->cmd_ptr[idx].cmd_name);
-		if ((size == (int) strlen(pSetCmd->cmd_ptr[idx].cmd_name))
-				&& !strncmp(pSetCmd->cmd_ptr[idx].cmd_name, payload_data + tokens[2].start, size)) {
-			cmd_ptr = &pSetCmd->cmd_ptr[idx];
-			break;
-		}
+	size = req.end - req.start;
+	LOTRACE_INF("command \"%.*s\"  (NumberOfCommands=%d) ..", size, payload_data + req.start, pSetCmd->cmd_nb);
+	MSG_MUTEX_LOCK();
+	idx = LO_msg_index_find(&pSetCmd->cmd_index, pSetCmd->cmd_ptr, pSetCmd->cmd_nb, sizeof(LiveObjectsD_Command_t),
+			offsetof(LiveObjectsD_Command_t, cmd_name), payload_data + req.start, size);
+	if (idx >= 0) {
+		cmd_ptr = &pSetCmd->cmd_ptr[idx];
 	}
+	MSG_MUTEX_UNLOCK();
 	if (cmd_ptr == NULL) { // not found in the set of commands
-		LOTRACE_ERR("cid=%"PRIi32" - command \"%.*s\" not registered ", *pCid, size,
-				payload_data + tokens[2].start);
+		LOTRACE_ERR("cid=%"PRIi32" - command \"%.*s\" not registered ", *pCid, size, payload_data + req.start);
 		return -3;
 	}
 	if (pSetCmd->cmd_callback == NULL) { // No callback function !!
 		LOTRACE_ERR("cid=%"PRIi32" - command \"%.*s\" - No function to process command", *pCid, size,
-				payload_data + tokens[2].start);
+				payload_data + req.start);
 		return -4;
 	}
-	// Check the second token :  "arg" : { ... }
-	// TODO: position of 'arg' should be anywhere. (after or before 'cid')
-	if ((tokens[3].type != JSMN_STRING) || (tokens[3].size != 1) // expected : "arg"
-			|| (tokens[4].type != JSMN_OBJECT)  // expected :  ': {'
-			) {
-		LOTRACE_ERR("Bad format - [3]=(%d,%d) [4]=(%d,%d)", tokens[3].type, tokens[3].size, tokens[4].type,
-				tokens[4].size);
-		return -2;
-	}
-	ret = check_token(payload_data, &tokens[3], "arg");
-	if (ret <= 0) {
-		LOTRACE_ERR("Bad format - \"arg\" was expected");
-		return -2;
-	}
-
-	// Get the number of arguments
-	size = tokens[4].size;
 
-	LOTRACE_DBG1("cid=%"PRIi32" - command \"%.*s\" with %d parameters ...", *pCid,
-			tokens[2].end - tokens[2].start, payload_data + tokens[2].start, size);
+	LOTRACE_DBG1("cid=%"PRIi32" - command \"%.*s\" with %d parameters ...", *pCid, size, payload_data + req.start,
+			arg_nb);
 
-	// Now, get each argument. Support only simple type - "name" : string or primitive value
-	idx = 5;
-	token_cnt -= 5;
-	if (size > 0) {
+	if (arg_nb > 0) {
 		char* pm;
 		LiveObjectsD_CommandRequestBlock_t* pReqBlkWithArgs;
 		LiveObjectsD_CommandArg_t* pArgs;
 		char* pLine;
 
-		int len = sizeof(LiveObjectsD_CommandRequestBlock_t) + (size - 1) * sizeof(LiveObjectsD_CommandArg_t)
-				+ tokens[idx + (size * 2) + 1].end - tokens[idx].start + 1;
+		int len = sizeof(LiveObjectsD_CommandRequestBlock_t) + (arg_nb - 1) * sizeof(LiveObjectsD_CommandArg_t)
+				+ arg_sz;
 		pm = (char*) MEM_ALLOC(len);
 		if (pm == NULL) {
-			LOTRACE_ERR("nb_params=%d args_sz=%d - MEM_ALLOC ERROR, len=%d", size,
-					tokens[idx + (size * 2) + 1].end - tokens[idx].start, len);
+			LOTRACE_ERR("nb_params=%d args_sz=%d - MEM_ALLOC ERROR, len=%d", arg_nb, arg_sz, len);
 			return -6;
 		}
 
-		LOTRACE_NOTICE("nb_params=%d args_sz=%d - MEM_ALLOC %p len=%d", size,
-				tokens[idx + (size * 2) + 1].end - tokens[idx].start, pm, len);
-
-		//memset(pm, 0, len);
+		LOTRACE_NOTICE("nb_params=%d args_sz=%d - MEM_ALLOC %p len=%d", arg_nb, arg_sz, pm, len);
 
 		pReqBlkWithArgs = (LiveObjectsD_CommandRequestBlock_t*) pm;
 		pArgs = (LiveObjectsD_CommandArg_t*) pReqBlkWithArgs->args_array;
 		pLine = (char*) (pm + sizeof(LiveObjectsD_CommandRequestBlock_t)
-				+ (size - 1) * sizeof(LiveObjectsD_CommandArg_t));
+				+ (arg_nb - 1) * sizeof(LiveObjectsD_CommandArg_t));
 
 		pReqBlkWithArgs->hd.cmd_blk_len = len;
 		pReqBlkWithArgs->hd.cmd_ptr = cmd_ptr;
 		pReqBlkWithArgs->hd.cmd_cid = *pCid;
 		pReqBlkWithArgs->hd.cmd_args_nb = 0;
 
-		while ((token_cnt >= 2) && (size > 0)) {
-			if ((tokens[idx].type != JSMN_STRING) || (tokens[idx].size != 1) || (tokens[idx + 1].size != 0)
-					|| ((tokens[idx + 1].type != JSMN_STRING) && (tokens[idx + 1].type != JSMN_PRIMITIVE))) {
-				LOTRACE_ERR("format not supported for arg[%d]= (%d,%d):(%d,%d)", idx, tokens[idx].type,
-						tokens[idx].size, tokens[idx + 1].type, tokens[idx + 1].size);
-				return -2;
-			}
-			LOTRACE_INF("arg \"%.*s\" = (%s) %.*s", tokens[idx].end - tokens[idx].start,
-					payload_data + tokens[idx].start, conv_jsmntypeToString(tokens[idx + 1].type),
-					tokens[idx + 1].end - tokens[idx + 1].start, payload_data + tokens[idx + 1].start);
-
-			{
-				pArgs->arg_name = pLine;
-				memcpy(pLine, payload_data + tokens[idx].start, tokens[idx].end - tokens[idx].start);
-				pLine += tokens[idx].end - tokens[idx].start;
-				*pLine++ = 0;
-
-				pArgs->arg_value = pLine;
-				memcpy(pLine, payload_data + tokens[idx + 1].start, tokens[idx + 1].end - tokens[idx + 1].start);
-				pLine += tokens[idx + 1].end - tokens[idx + 1].start;
-				*pLine++ = 0;
-
-				pArgs->arg_type = (tokens[idx + 1].type == JSMN_STRING) ? 1 : 0;
-
-				pArgs++;
-				pReqBlkWithArgs->hd.cmd_args_nb++;
-			}
-			size--;
-			idx += 2;
-			token_cnt -= 2;
-		}
-
-		if (size) {
-			LOTRACE_ERR("Bad JSON format - remain= %d != 0 - arg_nb=%d  token_cnt=%d", size,
-					tokens[4].size, token_cnt);
-			return -2;
+		// Copy the arguments (already checked): back to the "arg" object
+		s.pos = arg_pos;
+		n = 0;
+		js_begin(&s);
+		while (js_member(&s, &n, &key) > 0) {
+			js_value(&s, &val);
+			LOTRACE_INF("arg \"%.*s\" = (%s) %.*s", key.end - key.start, payload_data + key.start,
+					conv_jsmntypeToString(val.type), val.end - val.start, payload_data + val.start);
+
+			pArgs->arg_name = pLine;
+			memcpy(pLine, payload_data + key.start, key.end - key.start);
+			pLine += key.end - key.start;
+			*pLine++ = 0;
+
+			pArgs->arg_value = pLine;
+			memcpy(pLine, payload_data + val.start, val.end - val.start);
+			pLine += val.end - val.start;
+			*pLine++ = 0;
+
+			pArgs->arg_type = (val.type == JSMN_STRING) ? 1 : 0;
+
+			pArgs++;
+			pReqBlkWithArgs->hd.cmd_args_nb++;
 		}
 
-		//TODO: Must be fixed - How to pass arguments to user ?
 #if (MSG_DBG > 1)
 		{
 			int i;
@@ -9,12 +9,18 @@
 /**
  * @file  loc_msg_encode.c
  * @brief Encode JSON messages to be published
+ *
+ * The 'status' and 'collected data' messages are built by an encoder (LOMEncoder_t):
+ * JSON, or CBOR (LOC_FEATURE_CBOR) selected per client instance.
  */
 
 #include "liveobjects-client/LiveObjectsClient_Config.h"
 
 #include "loc_msg.h"
 #include "loc_json_api.h"
+#if LOC_FEATURE_CBOR
+#include "loc_cbor_api.h"
+#endif
 #include "loc_sys.h"
 
 #ifndef TRACE_GROUP
@@ -29,121 +35,372 @@
 #include "liveobjects-sys/LiveObjectsClient_Platform.h"
 #include "platform_default.h"
 
+#define LOC_MQTT_USER_NAME            "json+device"
+
 /* --------------------------------------------------------------------------------- */
 /*  */
-static const char* LO_msg_encode_status_buf(char* buf_ptr, uint32_t buf_len, const LOMArrayOfData_t* pObjSet) {
-	int ret, i;
-	const LiveObjectsD_Data_t* data_ptr;
-	ret = LO_json_begin_section(buf_ptr, buf_len, "info");
-	if (ret) {
-		LOTRACE_ERR("failed (LO_json_begin)");
-		return NULL;
+static void LO_msg_json_add_loc(LOJsonWriter_t* w, const char* name, double lat, double lon) {
+	char msg[80];
+	snprintf(msg, sizeof(msg) - 1, "%3.6f,%3.6f", lat, lon);
+	LO_json_add_name_array(w, name, msg);
+}
+
+const LOMEncoder_t LO_msg_enc_json = {
+	"json", LOC_MQTT_USER_NAME, 0,
+	LO_json_result,
+	LO_json_begin, LO_json_end,
+	LO_json_begin_section, LO_json_end_section,
+	LO_json_add_section_start, LO_json_add_section_end,
+	LO_json_add_name_str, LO_json_add_name_array, LO_msg_json_add_loc,
+	LO_json_add_item
+};
+
+#if LOC_FEATURE_CBOR
+const LOMEncoder_t LO_msg_enc_cbor = {
+	"cbor", LOC_MQTT_USER_NAME_CBOR, 1,
+	LO_cbor_result,
+	LO_cbor_begin, LO_cbor_end,
+	LO_cbor_begin_section, LO_cbor_end_section,
+	LO_cbor_add_section_start, LO_cbor_add_section_end,
+	LO_cbor_add_name_str, LO_cbor_add_name_array, LO_cbor_add_name_loc,
+	LO_cbor_add_item
+};
+#endif
+
+/* --------------------------------------------------------------------------------- */
+/* Return the built message and its length */
+static const char* LO_msg_result(const LOMEncoder_t* enc, LOJsonWriter_t* w, uint32_t* p_len) {
+	const char* p_msg = enc->result(w);
+	if ((p_msg) && (p_len)) {
+		*p_len = w->len;
 	}
+	return p_msg;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Encode the 'status' elements. Delta mode (shadow != NULL): only the elements whose hash changed */
+static const char* LO_msg_encode_status_buf(char* buf_ptr, uint32_t buf_len, const LOMEncoder_t* enc,
+		const LOMArrayOfData_t* pObjSet, const uint32_t* shadow, const uint32_t* hash, uint32_t* p_len) {
+	LOJsonWriter_t w;
+	int i;
+	const LiveObjectsD_Data_t* data_ptr;
+
+	LO_json_init(&w, buf_ptr, buf_len);
+	enc->begin_section(&w, "info");
 	data_ptr = pObjSet->data_ptr;
-	for (i = 0; i < pObjSet->data_nb; i++) {
+	for (i = 0; i < pObjSet->data_nb; i++, data_ptr++) {
+#if LOM_STATUS_DELTA
+		if ((shadow) && (i < LOM_STATUS_DELTA_NB) && (hash[i] == shadow[i])) {
+			continue;
+		}
+#else
+		(void) shadow;
+		(void) hash;
+#endif
 		LOTRACE_DBG1("[%d] - data_type=%d=%s data_name=%s", i, data_ptr->data_type,
 				LO_getDataTypeToStr(data_ptr->data_type), data_ptr->data_name);
-		ret = LO_json_add_item(data_ptr, buf_ptr, buf_len);
-		if (ret) {
-			LOTRACE_ERR("failed (LO_json_add_item)");
+		if (enc->add_item(&w, data_ptr)) {
+			LOTRACE_ERR("failed (%s add_item)", enc->name);
 			return NULL;
 		}
-		data_ptr++;
 	}
-	ret = LO_json_end_section(buf_ptr, buf_len);
-	if (ret) {
-		LOTRACE_ERR("failed (LO_json_end)");
-		return NULL;
+	enc->end_section(&w);
+	return LO_msg_result(enc, &w, p_len);
+}
+
+/* --------------------------------------------------------------------------------- */
+/* FNV-1a */
+uint32_t LO_msg_hash(uint32_t h, const void* p, uint32_t len) {
+	const uint8_t* b = (const uint8_t*) p;
+	while (len--) {
+		h ^= *b++;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+#if LOM_STATUS_DELTA
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static uint32_t LO_msg_value_hash(const LiveObjectsD_Data_t* data_ptr) {
+	uint32_t h = LOM_HASH_INIT;
+	uint32_t sz;
+
+	if ((data_ptr->data_value == NULL) || (data_ptr->data_dim <= 0)) {
+		return h;
+	}
+	switch (data_ptr->data_type) {
+	case LOD_TYPE_INT32:
+	case LOD_TYPE_UINT32:
+	case LOD_TYPE_FLOAT:
+		sz = 4;
+		break;
+	case LOD_TYPE_INT16:
+	case LOD_TYPE_UINT16:
+		sz = 2;
+		break;
+	case LOD_TYPE_INT8:
+	case LOD_TYPE_UINT8:
+	case LOD_TYPE_BOOL:
+		sz = 1;
+		break;
+	case LOD_TYPE_DOUBLE:
+		sz = 8;
+		break;
+	case LOD_TYPE_STRING_C:
+		if (data_ptr->data_dim > 1) {
+			/* Array of pointers */
+			const char* const * str_ptr = (const char* const *) data_ptr->data_value;
+			int i;
+			for (i = 0; i < data_ptr->data_dim; i++) {
+				h = LO_msg_hash(h, str_ptr[i], strlen(str_ptr[i]) + 1);
+			}
+			return h;
+		}
+		return LO_msg_hash(h, data_ptr->data_value, strlen((const char*) data_ptr->data_value));
+	default:
+		return h;
+	}
+	return LO_msg_hash(h, data_ptr->data_value, sz * data_ptr->data_dim);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_msg_status_delta(const LOMArrayOfData_t* pObjSet, const uint32_t* shadow, uint32_t* hash) {
+	int i;
+	int nb = 0;
+	const LiveObjectsD_Data_t* data_ptr = pObjSet->data_ptr;
+
+	for (i = 0; i < pObjSet->data_nb; i++, data_ptr++) {
+		if (i < LOM_STATUS_DELTA_NB) {
+			hash[i] = LO_msg_value_hash(data_ptr);
+			if ((shadow) && (hash[i] == shadow[i])) {
+				continue;
+			}
+		}
+		nb++;
 	}
-	return buf_ptr;
+	return nb;
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
+const char* LO_msg_encode_status_delta(char* buf_ptr, uint32_t buf_len, const LOMEncoder_t* enc,
+		const LOMArrayOfData_t* pObjSet, const uint32_t* shadow, const uint32_t* hash, uint32_t* p_len) {
+	if ((pObjSet == NULL) || (pObjSet->data_nb == 0) || (pObjSet->data_ptr == NULL)) {
+		LOTRACE_ERR("failed, invalid parameters pObjSet=%p", pObjSet);
+		return NULL;
+	}
+	return LO_msg_encode_status_buf(buf_ptr, buf_len, (enc) ? enc : &LO_msg_enc_json, pObjSet, shadow, hash,
+			p_len);
+}
+#endif /* LOM_STATUS_DELTA */
+
 #if LOC_FEATURE_LO_DATA
-static const char* LO_msg_encode_data_buf(char* buf_ptr, uint32_t buf_len, const LOMSetOfData_t* pSetData) {
-	int ret;
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LO_msg_add_gps(const LOMEncoder_t* enc, LOJsonWriter_t* w, const LiveObjectsD_GpsFix_t* gps_ptr) {
+	if ((gps_ptr) && (gps_ptr->gps_valid)) {
+		enc->add_name_loc(w, "loc", gps_ptr->gps_lat, gps_ptr->gps_long);
+	}
+}
+
+#if (LOM_SETOFDATA_TPL_SZ > 0)
+/*
+ * JSON template of a set of data.
+ * Only the values, the timestamp and the GPS position change between two pushes of a same set:
+ * the other parts of the message are encoded once, as literal runs (one length byte + text):
+ *   {"s":"<stream_id>",                      + optional "ts":"<timestamp>",
+ *   "m":"<model>",                           + optional "loc":[<lat>,<long>],
+ *   "v": {"<name 1>":                        + value(s) of data 1
+ *   "<name 2>":                              + value(s) of data 2
+ *   ...
+ *   "t":[<tags>],                            after the end of the "v" section
+ */
+
+/* --------------------------------------------------------------------------------- */
+/* Start a literal run: its length byte is set by LO_msg_tpl_run_end() */
+static uint32_t LO_msg_tpl_run_begin(LOJsonWriter_t* w) {
+	LO_json_add_raw(w, "", 1);
+	return w->len - 1;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static void LO_msg_tpl_run_end(LOJsonWriter_t* w, uint32_t run) {
+	uint32_t len = w->len - run - 1;
+	if (len > 255) {
+		w->overflow = 1;
+	}
+	if (!w->overflow) {
+		w->buf[run] = (char) len;
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Append a literal run of the template, and return the next one */
+static const char* LO_msg_tpl_put(LOJsonWriter_t* w, const char* run) {
+	uint32_t len = (uint8_t) *run++;
+	LO_json_add_raw(w, run, len);
+	return run + len;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+static const char* LO_msg_encode_data_tpl(char* buf_ptr, uint32_t buf_len, const LOMSetOfData_t* pSetData,
+		uint32_t* p_len) {
+	LOJsonWriter_t w;
+	int i;
+	const char* run = pSetData->tpl;
+	const LiveObjectsD_Data_t* data_ptr;
 
-	ret = LO_json_begin(buf_ptr, buf_len);
-	if (ret) {
-		LOTRACE_ERR("failed (LO_json_begin)");
+	LO_json_init(&w, buf_ptr, buf_len);
+
+	run = LO_msg_tpl_put(&w, run);
+	if (pSetData->timestamp[0]) {
+		LO_json_add_name_str(&w, "ts", pSetData->timestamp);
 	}
+	run = LO_msg_tpl_put(&w, run);
+	LO_msg_add_gps(&LO_msg_enc_json, &w, pSetData->gps_ptr);
 
-	if (ret == 0) {
-		// stream id
-		ret = LO_json_add_name_str("s", pSetData->stream_id, buf_ptr, buf_len);
-		if (ret) {
-			LOTRACE_ERR("failed (stream_id)");
+	data_ptr = pSetData->data_set.data_ptr;
+	for (i = 0; i < pSetData->data_set.data_nb; i++) {
+		run = LO_msg_tpl_put(&w, run);
+		if (LO_json_add_value(&w, data_ptr)) {
+			LOTRACE_ERR("failed (LO_json_add_value)");
+			return NULL;
 		}
+		data_ptr++;
 	}
+	LO_json_add_section_end(&w);
 
-	// timestamp
-	if ((ret == 0) && (pSetData->timestamp[0])) {
-		ret = LO_json_add_name_str("ts", pSetData->timestamp, buf_ptr, buf_len);
-		if (ret)
-			LOTRACE_ERR("failed (timestamp)");
+	LO_msg_tpl_put(&w, run);
+	LO_json_end(&w);
+	return LO_msg_result(&LO_msg_enc_json, &w, p_len);
+}
+#endif /* LOM_SETOFDATA_TPL_SZ */
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_msg_data_tpl_compile(LOMSetOfData_t* pSetData) {
+#if (LOM_SETOFDATA_TPL_SZ > 0)
+	LOJsonWriter_t w;
+	uint32_t run;
+	int i;
+	const LiveObjectsD_Data_t* data_ptr;
+
+	pSetData->tpl_valid = 0;
+	if ((pSetData->data_set.data_ptr == NULL) || (pSetData->data_set.data_nb <= 0)) {
+		return -1;
 	}
 
+	LO_json_init(&w, pSetData->tpl, sizeof(pSetData->tpl));
+
+	run = LO_msg_tpl_run_begin(&w);
+	LO_json_begin(&w);
+	LO_json_add_name_str(&w, "s", pSetData->stream_id);
+	LO_msg_tpl_run_end(&w, run);
+
+	run = LO_msg_tpl_run_begin(&w);
 #if (LOM_SETOFDATA_MODEL_SZ > 0)
-	if (ret == 0) {
-		// model
-		ret = LO_json_add_name_str("m", pSetData->model, buf_ptr, buf_len);
-		if (ret)
-			LOTRACE_ERR("failed (model)");
-	}
+	LO_json_add_name_str(&w, "m", pSetData->model);
 #endif
+	LO_msg_tpl_run_end(&w, run);
 
-	// Add GPS localization
-	if ((ret == 0) && (pSetData->gps_ptr) && (pSetData->gps_ptr->gps_valid)) {
-		char msg[80];
-		snprintf(msg, sizeof(msg) - 1, "%3.6f,%3.6f", pSetData->gps_ptr->gps_lat, pSetData->gps_ptr->gps_long);
-		ret = LO_json_add_name_array("loc", msg, buf_ptr, buf_len);
+	data_ptr = pSetData->data_set.data_ptr;
+	for (i = 0; i < pSetData->data_set.data_nb; i++) {
+		if (data_ptr->data_name == NULL) {
+			return -1;
+		}
+		run = LO_msg_tpl_run_begin(&w);
+		if (i == 0) {
+			LO_json_add_section_start(&w, "v");
+		}
+		LO_json_add_raw(&w, "\"", 1);
+		LO_json_add_raw(&w, data_ptr->data_name, strlen(data_ptr->data_name));
+		LO_json_add_raw(&w, "\":", 2);
+		LO_msg_tpl_run_end(&w, run);
+		data_ptr++;
 	}
 
-	if (ret == 0) {
-		ret = LO_json_add_section_start("v", buf_ptr, buf_len);
-		if (ret)
-			LOTRACE_ERR("failed (add section v)");
+	run = LO_msg_tpl_run_begin(&w);
+#if (LOM_SETOFDATA_TAGS_SZ > 0)
+	if (pSetData->tags[0]) {
+		LO_json_add_name_array(&w, "t", pSetData->tags);
 	}
+#endif
+	LO_msg_tpl_run_end(&w, run);
 
-	if (ret == 0) {
-		int i;
-		const LiveObjectsD_Data_t* data_ptr = pSetData->data_set.data_ptr;
-		for (i = 0; i < pSetData->data_set.data_nb; i++) {
-			LOTRACE_DBG1("[%d] - data_type=%d=%s data_name=%s", i, data_ptr->data_type,
-					LO_getDataTypeToStr(data_ptr->data_type), data_ptr->data_name);
-			ret = LO_json_add_item(data_ptr, buf_ptr, buf_len);
-			if (ret) {
-				LOTRACE_ERR("failed (LO_json_add_item)");
-				break;
-			}
-			data_ptr++;
-		}
+	if (w.overflow) {
+		LOTRACE_WARN("stream %s: template not used, LOM_SETOFDATA_TPL_SZ=%d too short",
+				pSetData->stream_id, LOM_SETOFDATA_TPL_SZ);
+		return -1;
 	}
+	pSetData->tpl_valid = 1;
+	LOTRACE_DBG1("stream %s: template %"PRIu32" bytes", pSetData->stream_id, w.len);
+	return 0;
+#else
+	(void) pSetData;
+	return -1;
+#endif
+}
 
-	if (ret == 0) {
-		ret = LO_json_add_section_end(buf_ptr, buf_len);
-		if (ret) {
-			LOTRACE_ERR("failed (end section v)");
-		}
+/* --------------------------------------------------------------------------------- */
+/*  */
+static const char* LO_msg_encode_data_buf(char* buf_ptr, uint32_t buf_len, const LOMEncoder_t* enc,
+		const LOMSetOfData_t* pSetData, uint32_t* p_len) {
+	LOJsonWriter_t w;
+	int i;
+	const LiveObjectsD_Data_t* data_ptr;
+
+#if (LOM_SETOFDATA_TPL_SZ > 0)
+	/* The template is a JSON one */
+	if ((pSetData->tpl_valid) && (enc == &LO_msg_enc_json)) {
+		return LO_msg_encode_data_tpl(buf_ptr, buf_len, pSetData, p_len);
 	}
+#endif
 
-#if (LOM_SETOFDATA_TAGS_SZ > 0)
-	if ((ret == 0) && (pSetData->tags[0])) {
-		ret = LO_json_add_name_array("t", pSetData->tags, buf_ptr, buf_len);
-		if (ret)
-			LOTRACE_ERR("failed (LO_json_add_name_str(\"t\", ...)");
+	LO_json_init(&w, buf_ptr, buf_len);
+	enc->begin(&w);
+
+	// stream id
+	enc->add_name_str(&w, "s", pSetData->stream_id);
+
+	// timestamp
+	if (pSetData->timestamp[0]) {
+		enc->add_name_str(&w, "ts", pSetData->timestamp);
 	}
+
+#if (LOM_SETOFDATA_MODEL_SZ > 0)
+	// model
+	enc->add_name_str(&w, "m", pSetData->model);
 #endif
 
-	if (ret == 0) {
-		ret = LO_json_end(buf_ptr, buf_len);
-		if (ret) {
-			LOTRACE_ERR("failed (LO_json_end)");
+	// Add GPS localization
+	LO_msg_add_gps(enc, &w, pSetData->gps_ptr);
+
+	enc->add_section_start(&w, "v");
+	data_ptr = pSetData->data_set.data_ptr;
+	for (i = 0; i < pSetData->data_set.data_nb; i++) {
+		LOTRACE_DBG1("[%d] - data_type=%d=%s data_name=%s", i, data_ptr->data_type,
+				LO_getDataTypeToStr(data_ptr->data_type), data_ptr->data_name);
+		if (enc->add_item(&w, data_ptr)) {
+			LOTRACE_ERR("failed (%s add_item)", enc->name);
+			return NULL;
 		}
+		data_ptr++;
 	}
+	enc->add_section_end(&w);
+
+#if (LOM_SETOFDATA_TAGS_SZ > 0)
+	if (pSetData->tags[0]) {
+		enc->add_name_array(&w, "t", pSetData->tags);
+	}
+#endif
 
-	return (ret == 0) ? buf_ptr : NULL;
+	enc->end(&w);
+	return LO_msg_result(enc, &w, p_len);
 }
 #endif /* LOC_FEATURE_LO_DATA */
 
@@ -151,49 +408,28 @@ static const char* LO_msg_encode_data_buf(char* buf_ptr, uint32_t buf_len, const
 /*  */
 #if LOC_FEATURE_LO_RESOURCES
 static const char* LO_msg_encode_resources_buf(char* buf_ptr, uint32_t buf_len,
-		const LOMSetOfResources_t* pSetResources) {
-	int ret, i;
+		const LOMSetOfResources_t* pSetResources, uint32_t* p_len) {
+	LOJsonWriter_t w;
+	int i;
 	const LiveObjectsD_Resource_t* rsc_ptr;
 
-	ret = LO_json_begin_section(buf_ptr, buf_len, "rsc");
-	if (ret) {
-		LOTRACE_ERR("failed (LO_json_begin)");
-		return NULL;
-	}
+	LO_json_init(&w, buf_ptr, buf_len);
+	LO_json_begin_section(&w, "rsc");
 	rsc_ptr = pSetResources->rsc_ptr;
 	for (i = 0; i < pSetResources->rsc_nb; i++) {
 		LOTRACE_DBG1("[%d] - rsc_name=%s version=%s", i, rsc_ptr->rsc_name, rsc_ptr->rsc_version_ptr);
-		if (ret == 0) {
-			ret = LO_json_add_section_start(rsc_ptr->rsc_name, buf_ptr, buf_len);
-		}
-		if (ret == 0) {
-			ret = LO_json_add_name_str("v", rsc_ptr->rsc_version_ptr, buf_ptr, buf_len);
-		}
+		LO_json_add_section_start(&w, rsc_ptr->rsc_name);
+		LO_json_add_name_str(&w, "v", rsc_ptr->rsc_version_ptr);
 
 		// metadata section: empty
-		if (ret == 0) {
-			ret = LO_json_add_section_start("m", buf_ptr, buf_len);
-		}
-		if (ret == 0) {
-			ret = LO_json_add_section_end(buf_ptr, buf_len);
-		}
+		LO_json_add_section_start(&w, "m");
+		LO_json_add_section_end(&w);
 
-		if (ret == 0) {
-			ret = LO_json_add_section_end(buf_ptr, buf_len);
-		}
-		if (ret) {
-			LOTRACE_ERR("failed (rsc[%d] - rsc_name=%s version=%s)", i, rsc_ptr->rsc_name,
-					rsc_ptr->rsc_version_ptr);
-			return NULL;
-		}
+		LO_json_add_section_end(&w);
 		rsc_ptr++;
 	}
-	ret = LO_json_end_section(buf_ptr, buf_len);
-	if (ret) {
-		LOTRACE_ERR("failed (LO_json_end)");
-		return NULL;
-	}
-	return buf_ptr;
+	LO_json_end_section(&w);
+	return LO_msg_result(&LO_msg_enc_json, &w, p_len);
 }
 #endif
 
@@ -201,21 +437,18 @@ static const char* LO_msg_encode_resources_buf(char* buf_ptr, uint32_t buf_len,
 /*  */
 #if LOC_FEATURE_LO_PARAMS
 const char* LO_msg_encode_params_all_buf(char* buf_ptr, uint32_t buf_len, const LOMArrayOfParams_t* params_array,
-		int32_t cid) {
-	int ret, i;
+		int32_t cid, uint32_t* p_len) {
+	LOJsonWriter_t w;
+	int i;
 	const LiveObjectsD_Param_t* param_ptr;
 
-	ret = LO_json_begin_section(buf_ptr, buf_len, "cfg");
-	if (ret) {
-		LOTRACE_ERR("failed (LO_json_begin)");
-		return NULL;
-	}
+	LO_json_init(&w, buf_ptr, buf_len);
+	LO_json_begin_section(&w, "cfg");
 	param_ptr = params_array->param_ptr;
 	for (i = 0; i < params_array->param_nb; i++) {
 		LOTRACE_DBG1("[%d] - data_type=%d=%s data_name=%s ...", i, param_ptr->parm_data.data_type,
 				LO_getDataTypeToStr(param_ptr->parm_data.data_type), param_ptr->parm_data.data_name);
-		ret = LO_json_add_param(&param_ptr->parm_data, buf_ptr, buf_len);
-		if (ret) {
+		if (LO_json_add_param(&w, &param_ptr->parm_data)) {
 			LOTRACE_ERR("failed (LO_json_add_param)");
 			return NULL;
 		}
@@ -223,34 +456,14 @@ const char* LO_msg_encode_params_all_buf(char* buf_ptr, uint32_t buf_len, const
 	}
 
 	if (cid) {
-		if (ret == 0) {
-			ret = LO_json_add_section_end(buf_ptr, buf_len);
-			if (ret) {
-				LOTRACE_ERR("failed (LO_json_end_section)");
-			}
-		}
-
-		if (ret == 0) {
-			ret = LO_json_add_name_int("cid", cid, buf_ptr, buf_len);
-			if (ret) {
-				LOTRACE_ERR("failed while adding cid=%"PRIi32", rc=%d", cid, ret);
-			}
-		}
-		if (ret == 0) {
-			ret = LO_json_end(buf_ptr, buf_len);
-			if (ret) {
-				LOTRACE_ERR("failed (LO_json_end)");
-			}
-		}
+		LO_json_add_section_end(&w);
+		LO_json_add_name_int(&w, "cid", cid);
+		LO_json_end(&w);
 	}
 	else {
-		ret = LO_json_end_section(buf_ptr, buf_len);
-		if (ret) {
-			LOTRACE_ERR("failed (LO_json_end)");
-			return NULL;
-		}
+		LO_json_end_section(&w);
 	}
-	return buf_ptr;
+	return LO_msg_result(&LO_msg_enc_json, &w, p_len);
 }
 #endif /* LOC_FEATURE_LO_PARAMS */
 
@@ -258,63 +471,40 @@ const char* LO_msg_encode_params_all_buf(char* buf_ptr, uint32_t buf_len, const
 /*  */
 #if LOC_FEATURE_LO_COMMANDS
 static const char* LO_msg_encode_cmd_resp_buf(char* buf_ptr, uint32_t buf_len, int32_t cid,
-		const LiveObjectsD_Data_t* data_ptr, int data_nb) {
-	int ret;
+		const LiveObjectsD_Data_t* data_ptr, int data_nb, uint32_t* p_len) {
+	LOJsonWriter_t w;
 
 	if (cid == 0) {
 		LOTRACE_ERR("failed, invalid parameters cid=%"PRIu32, cid);
 		return NULL;
 	}
 
-	ret = LO_json_begin_section(buf_ptr, buf_len, "res");
-	if (ret) {
-		LOTRACE_ERR("failed (LO_json_begin)");
-	}
+	LO_json_init(&w, buf_ptr, buf_len);
+	LO_json_begin_section(&w, "res");
 
-	if ((ret == 0) && (data_ptr) &&(data_nb > 0)) {
+	if ((data_ptr) &&(data_nb > 0)) {
 		int i;
 		const LiveObjectsD_Data_t* p_data = data_ptr;
 		for (i = 0; i < data_nb; i++) {
 			LOTRACE_DBG1("[%d] - data_type=%d=%s data_name=%s", i, p_data->data_type,
 					LO_getDataTypeToStr(p_data->data_type), p_data->data_name);
-			ret = LO_json_add_item(p_data, buf_ptr, buf_len);
-			if (ret) {
+			if (LO_json_add_item(&w, p_data)) {
 				LOTRACE_ERR("failed (LO_json_add_item)");
-				break;
+				return NULL;
 			}
 			p_data++;
 		}
 	}
 
-	if (ret == 0) {
-		ret = LO_json_add_section_end(buf_ptr, buf_len);
-		if (ret)
-			LOTRACE_ERR("failed (LO_json_end_section)");
-	}
-
-	if (ret == 0) {
-		ret = LO_json_add_name_int("cid", cid, buf_ptr, buf_len);
-		if (ret)
-			LOTRACE_ERR("failed while adding cid=%"PRIi32", rc=%d", cid, ret);
-	}
-
-	if (ret == 0) {
-		ret = LO_json_end(buf_ptr, buf_len);
-		if (ret) {
-			LOTRACE_ERR("failed (LO_json_end)");
-		}
-	}
-	return (ret == 0) ? buf_ptr : NULL;
+	LO_json_add_section_end(&w);
+	LO_json_add_name_int(&w, "cid", cid);
+	LO_json_end(&w);
+	return LO_msg_result(&LO_msg_enc_json, &w, p_len);
 }
 #endif /* LOC_FEATURE_LO_COMMANDS */
 
 /* ================================================================================= */
 
-/* --------------------------------------------------------------------------------- */
-/*  */
-
-static char _LO_msg_buf[LOM_JSON_BUF_SZ];
-
 /* --------------------------------------------------------------------------------- */
 /*  */
 #if LOC_FEATURE_LO_RESOURCES
@@ -328,55 +518,38 @@ static const char* lib_rsc_res[] = {
 	"BUSY"
 };
 
-const char* LO_msg_encode_rsc_result(int32_t cid, LiveObjectsD_ResourceRespCode_t result) {
-	int ret;
+const char* LO_msg_encode_rsc_result(char* buf_ptr, uint32_t buf_len, int32_t cid,
+		LiveObjectsD_ResourceRespCode_t result, uint32_t* p_len) {
+	LOJsonWriter_t w;
+	int res_idx = result;
 
 	if (cid == 0) {
 		LOTRACE_ERR("failed, invalid parameters cid=%"PRIu32, cid);
 		return NULL;
 	}
 
-	ret = LO_json_begin(_LO_msg_buf, LOM_JSON_BUF_SZ);
-	if (ret) {
-		LOTRACE_ERR("failed (LO_json_begin)");
-	}
+	if ((res_idx < 0) || (res_idx >= RCP_RSP_MAX))
+		res_idx = RSC_RSP_ERR_INTERNAL_ERROR;
+	LOTRACE_INF("cid=%"PRIi32", result=%d -> %d res=%s", cid, result, res_idx,
+			lib_rsc_res[res_idx]);
 
-	if (ret == 0) {
-		int res_idx = result;
-		if ((res_idx < 0) || (res_idx >= RCP_RSP_MAX))
-			res_idx = RSC_RSP_ERR_INTERNAL_ERROR;
-		LOTRACE_INF("cid=%"PRIi32", result=%d -> %d res=%s", cid, result, res_idx,
-				lib_rsc_res[res_idx]);
-		ret = LO_json_add_name_str("res", lib_rsc_res[res_idx], _LO_msg_buf,
-		LOM_JSON_BUF_SZ);
-		if (ret) {
-			LOTRACE_ERR("failed while adding res=%d %d %s, rc=%d", result, res_idx,
-					lib_rsc_res[res_idx], ret);
-		}
-	}
-
-	if (ret == 0) {
-		ret = LO_json_add_name_int("cid", cid, _LO_msg_buf, LOM_JSON_BUF_SZ);
-		if (ret) {
-			LOTRACE_ERR("failed while adding cid=%"PRIi32", rc=%d", cid, ret);
-		}
-	}
-
-	if (ret == 0) {
-		ret = LO_json_end(_LO_msg_buf, LOM_JSON_BUF_SZ);
-		if (ret) {
-			LOTRACE_ERR("failed (LO_json_end)");
-		}
-	}
-	return (ret == 0) ? _LO_msg_buf : NULL;
+	LO_json_init(&w, buf_ptr, buf_len);
+	LO_json_begin(&w);
+	LO_json_add_name_str(&w, "res", lib_rsc_res[res_idx]);
+	LO_json_add_name_int(&w, "cid", cid);
+	LO_json_end(&w);
+	return LO_msg_result(&LO_msg_enc_json, &w, p_len);
 }
 #endif /* LOC_FEATURE_LO_RESOURCES */
 
 /* --------------------------------------------------------------------------------- */
 /*  */
 #if LOC_FEATURE_LO_PARAMS
-const char* LO_msg_encode_params_update(const LOMSetofUpdatedParams_t* pParamUpdateSet) {
-	int ret;
+const char* LO_msg_encode_params_update(char* buf_ptr, uint32_t buf_len, const LOMSetofUpdatedParams_t* pParamUpdateSet,
+		uint32_t* p_len) {
+	LOJsonWriter_t w;
+	int i;
+	const LiveObjectsD_Param_t* param_ptr;
 
 	if (pParamUpdateSet == NULL) {
 		LOTRACE_ERR("failed, invalid parameters pParamUpdateSet=%p", pParamUpdateSet);
@@ -393,52 +566,26 @@ const char* LO_msg_encode_params_update(const LOMSetofUpdatedParams_t* pParamUpd
 		return NULL;
 	}
 
-	ret = LO_json_begin_section(_LO_msg_buf, LOM_JSON_BUF_SZ, "cfg");
-	if (ret) {
-		LOTRACE_ERR("failed (LO_json_begin)");
-	}
-
-	if (ret == 0) {
-		int i;
-		const LiveObjectsD_Param_t* param_ptr;
-		for (i = 0; i < pParamUpdateSet->nb_of_params; i++) {
-			param_ptr = pParamUpdateSet->tab_of_param_ptr[i];
-			if (param_ptr == NULL) {
-				LOTRACE_ERR("failed while getting next param object [%d/%"PRIi32"]", i,
-						pParamUpdateSet->nb_of_params);
-				break;
-			}
-			LOTRACE_DBG1("[%d] - data_type=%d=%s data_name=%s ...", i, param_ptr->parm_data.data_type,
-					LO_getDataTypeToStr(param_ptr->parm_data.data_type), param_ptr->parm_data.data_name);
-			ret = LO_json_add_param(&param_ptr->parm_data, _LO_msg_buf, LOM_JSON_BUF_SZ);
-			if (ret) {
-				LOTRACE_ERR("failed (LO_json_add_param)");
-				break;
-			}
-		}
-	}
-	if (ret == 0) {
-		ret = LO_json_add_section_end(_LO_msg_buf, LOM_JSON_BUF_SZ);
-		if (ret) {
-			LOTRACE_ERR("failed (LO_json_end_section)");
-		}
-	}
-
-	if (ret == 0) {
-		ret = LO_json_add_name_int("cid", pParamUpdateSet->cid, _LO_msg_buf,
-		LOM_JSON_BUF_SZ);
-		if (ret) {
-			LOTRACE_ERR("failed while adding cid=%"PRIi32", rc=%d", pParamUpdateSet->cid, ret);
+	LO_json_init(&w, buf_ptr, buf_len);
+	LO_json_begin_section(&w, "cfg");
+	for (i = 0; i < pParamUpdateSet->nb_of_params; i++) {
+		param_ptr = pParamUpdateSet->tab_of_param_ptr[i];
+		if (param_ptr == NULL) {
+			LOTRACE_ERR("failed while getting next param object [%d/%"PRIi32"]", i,
+					pParamUpdateSet->nb_of_params);
+			return NULL;
 		}
-	}
-
-	if (ret == 0) {
-		ret = LO_json_end(_LO_msg_buf, LOM_JSON_BUF_SZ);
-		if (ret) {
-			LOTRACE_ERR("failed (LO_json_end)");
+		LOTRACE_DBG1("[%d] - data_type=%d=%s data_name=%s ...", i, param_ptr->parm_data.data_type,
+				LO_getDataTypeToStr(param_ptr->parm_data.data_type), param_ptr->parm_data.data_name);
+		if (LO_json_add_param(&w, &param_ptr->parm_data)) {
+			LOTRACE_ERR("failed (LO_json_add_param)");
+			return NULL;
 		}
 	}
-	return (ret == 0) ? _LO_msg_buf : NULL;
+	LO_json_add_section_end(&w);
+	LO_json_add_name_int(&w, "cid", pParamUpdateSet->cid);
+	LO_json_end(&w);
+	return LO_msg_result(&LO_msg_enc_json, &w, p_len);
 }
 #endif /* LOC_FEATURE_LO_PARAMS */
 
@@ -452,63 +599,36 @@ static const char* lib_res[] = {
 	"Not processed"
 };
 
-const char* LO_msg_encode_cmd_result(int32_t cid, int result) {
-	int ret;
+const char* LO_msg_encode_cmd_result(char* buf_ptr, uint32_t buf_len, int32_t cid, int result, uint32_t* p_len) {
+	LOJsonWriter_t w;
 
 	if (cid == 0) {
 		LOTRACE_ERR("failed, invalid parameters cid=%"PRIu32, cid);
 		return NULL;
 	}
 
-	ret = LO_json_begin_section(_LO_msg_buf, LOM_JSON_BUF_SZ, "res");
-	if (ret) {
-		LOTRACE_ERR("failed (LO_json_begin)");
-	}
-
-	if (ret == 0) {
-		if (result < 0) {
-			int err_idx = -result - 1;
-			LOTRACE_WARN("ERROR result=%d  err_idx=%d", result, err_idx);
-			ret = LO_json_add_name_int("lom_err_code", result, _LO_msg_buf,
-			LOM_JSON_BUF_SZ);
-			if (ret) {
-				LOTRACE_ERR("failed (LO_json_end_section)");
-			}
+	LO_json_init(&w, buf_ptr, buf_len);
+	LO_json_begin_section(&w, "res");
 
-			if ((ret == 0) && (err_idx >= 0) && (err_idx < 4)) {
-				ret = LO_json_add_name_str("lom_error", lib_res[err_idx], _LO_msg_buf,
-				LOM_JSON_BUF_SZ);
-			}
-		}
-		else if (result > 0) { // User code
-			ret = LO_json_add_name_int("result", result, _LO_msg_buf, LOM_JSON_BUF_SZ);
-		}
-		else { /* result == 0,  Not called => pending request; Delayed response procssed by user. */
-			; /* ret = LO_json_add_name_str("status", "pending", _LO_msg_buf, LOM_JSON_BUF_SZ); */
+	if (result < 0) {
+		int err_idx = -result - 1;
+		LOTRACE_WARN("ERROR result=%d  err_idx=%d", result, err_idx);
+		LO_json_add_name_int(&w, "lom_err_code", result);
+		if ((err_idx >= 0) && (err_idx < 4)) {
+			LO_json_add_name_str(&w, "lom_error", lib_res[err_idx]);
 		}
 	}
-
-	if (ret == 0) {
-		ret = LO_json_add_section_end(_LO_msg_buf, LOM_JSON_BUF_SZ);
-		if (ret) {
-			LOTRACE_ERR("failed (LO_json_end_section)");
-		}
+	else if (result > 0) { // User code
+		LO_json_add_name_int(&w, "result", result);
 	}
-
-	if (ret == 0) {
-		ret = LO_json_add_name_int("cid", cid, _LO_msg_buf, LOM_JSON_BUF_SZ);
-		if (ret) {
-			LOTRACE_ERR("failed while adding cid=%"PRIi32", rc=%d", cid, ret);
-		}
+	else { /* result == 0,  Not called => pending request; Delayed response procssed by user. */
+		; /* LO_json_add_name_str(&w, "status", "pending"); */
 	}
 
-	if (ret == 0) {
-		ret = LO_json_end(_LO_msg_buf, LOM_JSON_BUF_SZ);
-		if (ret) {
-			LOTRACE_ERR("failed (LO_json_end)");
-		}
-	}
-	return (ret == 0) ? _LO_msg_buf : NULL;
+	LO_json_add_section_end(&w);
+	LO_json_add_name_int(&w, "cid", cid);
+	LO_json_end(&w);
+	return LO_msg_result(&LO_msg_enc_json, &w, p_len);
 }
 #endif /* LOC_FEATURE_LO_COMMANDS */
 
@@ -518,7 +638,6 @@ const char* LO_msg_encode_cmd_result(int32_t cid, int result) {
 /*  */
 #if LOM_MQUEUE && (LOM_JSON_BUF_USER_SZ > 0) && (LOC_FEATURE_LO_STATUS || LOC_FEATURE_LO_PARAMS || LOC_FEATURE_LO_DATA || LOC_FEATURE_LO_COMMANDS || LOC_FEATURE_LO_RESOURCES)
 #define LOM_ENCODE_MQUEUE 1
-static char _LO_msg_buf_user[LOM_JSON_BUF_USER_SZ];
 #else
 #define LOM_ENCODE_MQUEUE 0
 #endif
@@ -526,46 +645,77 @@ static char _LO_msg_buf_user[LOM_JSON_BUF_USER_SZ];
 /* --------------------------------------------------------------------------------- */
 /*  */
 #if LOM_ENCODE_MQUEUE
-static const char* LO_msg_alloc(uint8_t from, const char* p_msg) {
-	char* p = NULL;
-	int len = strlen(p_msg);
-	if (len > 0) {
-		len += 3;
-		p = (char*) MEM_ALLOC(len);
-		if (p) {
-			LOTRACE_DBG1("LO_msg_alloc(from %x) - MEM_ALLOC %p len=%d", from, p, len);
-			*p = from;            /* First byte is used to indicate the type of message */
-			strcpy(p + 1, p_msg); /* And copy JSON msg in this allocated buffer */
-		}
-		else {
-			LOTRACE_ERR("LO_msg_alloc(from %x): ERROR MEM_ALLOC(len=%d)", from, len);
-		}
+/* Reserve a message in the ring: MSG_MUTEX is locked if successful.
+ * Then the JSON message is built at p + 1 (max LOM_JSON_BUF_USER_SZ bytes) */
+static char* LO_msg_begin(LOMRing_t* ring) {
+	char* p;
+	if (ring == NULL) {
+		return NULL;
 	}
+	if (MSG_MUTEX_LOCK()) {
+		LOTRACE_ERR("Error to lock mutex");
+		return NULL;
+	}
+	p = LO_msg_ring_reserve(ring, 1 + LOM_JSON_BUF_USER_SZ);
+	if (p == NULL) {
+		MSG_MUTEX_UNLOCK();
+	}
+	return p;
+}
+
+/* Commit the built message (or cancel if p_json is NULL), and unlock MSG_MUTEX */
+static const char* LO_msg_end(LOMRing_t* ring, uint8_t from, char* p, const char* p_json) {
+	if (p_json) {
+		*p = from;            /* First byte is used to indicate the type of message */
+		LO_msg_ring_commit(ring, p, 1 + strlen(p_json) + 1);
+		LOTRACE_DBG1("LO_msg_end(from %x) - %p", from, p);
+	}
+	else {
+		p = NULL;
+	}
+	MSG_MUTEX_UNLOCK();
 	return p;
 }
+
+#if LOC_FEATURE_LO_STATUS || LOC_FEATURE_LO_DATA
+/* Header of a message built by an encoder: type (+ length of a binary payload) */
+#define LO_msg_hdr_sz(enc)      (((enc)->binary) ? 5 : 1)
+
+/* Same as LO_msg_end(), for a message built by an encoder at p + LO_msg_hdr_sz(enc) */
+static const char* LO_msg_end_enc(LOMRing_t* ring, uint8_t from, char* p, const LOMEncoder_t* enc,
+		const char* p_enc, uint32_t len) {
+	if ((p_enc == NULL) || (!enc->binary)) {
+		return LO_msg_end(ring, from, p, p_enc);
+	}
+	*p = from | LOM_MSG_BIN;
+	memcpy(p + 1, &len, 4);
+	LO_msg_ring_commit(ring, p, 5 + len);
+	LOTRACE_DBG1("LO_msg_end(from %x, %s len=%"PRIu32") - %p", from, enc->name, len, p);
+	MSG_MUTEX_UNLOCK();
+	return p;
+}
+#endif
 #endif /* LOM_MQUEUE */
 
 /* --------------------------------------------------------------------------------- */
 /*  */
 #if LOC_FEATURE_LO_COMMANDS
-const char* LO_msg_encode_cmd_resp(uint8_t from, int32_t cid, const LiveObjectsD_Data_t* data_ptr, int data_nb) {
+const char* LO_msg_encode_cmd_resp(uint8_t from, char* buf_ptr, uint32_t buf_len, LOMRing_t* ring, int32_t cid,
+		const LiveObjectsD_Data_t* data_ptr, int data_nb, uint32_t* p_len) {
 
 	const char *p_msg;
 	if (from == 0) { /* Called by the LOM Client Thread. */
-		p_msg = LO_msg_encode_cmd_resp_buf(_LO_msg_buf, LOM_JSON_BUF_SZ, cid, data_ptr, data_nb);
+		p_msg = LO_msg_encode_cmd_resp_buf(buf_ptr, buf_len, cid, data_ptr, data_nb, p_len);
 	}
 	else {
 #if LOM_ENCODE_MQUEUE
-		/* Use a local buffer to build JSON message */
-		if (MSG_MUTEX_LOCK()) {
-			LOTRACE_ERR("Error to lock mutex");
+		/* Build the JSON message directly in the message ring */
+		char* p = LO_msg_begin(ring);
+		if (p == NULL) {
 			return NULL;
 		}
-		p_msg = LO_msg_encode_cmd_resp_buf(_LO_msg_buf_user, LOM_JSON_BUF_USER_SZ, cid, data_ptr, data_nb);
-		if (p_msg) {
-			p_msg = LO_msg_alloc(from, p_msg);
-		}
-		MSG_MUTEX_UNLOCK();
+		p_msg = LO_msg_end(ring, from, p, LO_msg_encode_cmd_resp_buf(p + 1, LOM_JSON_BUF_USER_SZ, cid, data_ptr, data_nb,
+				NULL));
 #else
 		LOTRACE_ERR("ERROR - Not supported");
 		p_msg = NULL;
@@ -578,9 +728,14 @@ const char* LO_msg_encode_cmd_resp(uint8_t from, int32_t cid, const LiveObjectsD
 /* --------------------------------------------------------------------------------- */
 /*  */
 #if LOC_FEATURE_LO_STATUS
-const char* LO_msg_encode_status(uint8_t from, const LOMArrayOfData_t* pObjSet) {
+const char* LO_msg_encode_status(uint8_t from, char* buf_ptr, uint32_t buf_len, LOMRing_t* ring,
+		const LOMEncoder_t* enc, const LOMArrayOfData_t* pObjSet, uint32_t* p_len) {
 	const char *p_msg;
 
+	if (enc == NULL) {
+		enc = &LO_msg_enc_json;
+	}
+
 	if (pObjSet == NULL) {
 		LOTRACE_ERR("failed, invalid parameters pObjSet=%p", pObjSet);
 		return NULL;
@@ -591,20 +746,20 @@ const char* LO_msg_encode_status(uint8_t from, const LOMArrayOfData_t* pObjSet)
 	}
 
 	if (from == 0) { /* Called by the LiveObjects Client Thread. */
-		p_msg = LO_msg_encode_status_buf(_LO_msg_buf, LOM_JSON_BUF_SZ, pObjSet);
+		p_msg = LO_msg_encode_status_buf(buf_ptr, buf_len, enc, pObjSet, NULL, NULL, p_len);
 	}
 	else {
 #if LOM_ENCODE_MQUEUE
-		/* Use a local buffer to build JSON message */
-		if (MSG_MUTEX_LOCK()) {
-			LOTRACE_ERR("Error to lock mutex");
+		/* Build the message directly in the message ring */
+		uint32_t len = 0;
+		const char* p_enc;
+		char* p = LO_msg_begin(ring);
+		if (p == NULL) {
 			return NULL;
 		}
-		p_msg = LO_msg_encode_status_buf(_LO_msg_buf_user, LOM_JSON_BUF_USER_SZ, pObjSet);
-		if (p_msg) {
-			p_msg = LO_msg_alloc(from, p_msg);
-		}
-		MSG_MUTEX_UNLOCK();
+		p_enc = LO_msg_encode_status_buf(p + LO_msg_hdr_sz(enc), LOM_JSON_BUF_USER_SZ + 1 - LO_msg_hdr_sz(enc), enc,
+				pObjSet, NULL, NULL, &len);
+		p_msg = LO_msg_end_enc(ring, from, p, enc, p_enc, len);
 #else
 		LOTRACE_ERR("ERROR - Not supported");
 		p_msg = NULL;
@@ -617,9 +772,14 @@ const char* LO_msg_encode_status(uint8_t from, const LOMArrayOfData_t* pObjSet)
 /* --------------------------------------------------------------------------------- */
 /*  */
 #if LOC_FEATURE_LO_DATA
-const char* LO_msg_encode_data(uint8_t from, const LOMSetOfData_t* pSetData) {
+const char* LO_msg_encode_data(uint8_t from, char* buf_ptr, uint32_t buf_len, LOMRing_t* ring,
+		const LOMEncoder_t* enc, const LOMSetOfData_t* pSetData, uint32_t* p_len) {
 	const char *p_msg;
 
+	if (enc == NULL) {
+		enc = &LO_msg_enc_json;
+	}
+
 	if ((pSetData == NULL) || (pSetData->stream_id[0] == 0)) {
 		LOTRACE_ERR("failed, invalid parameters pDataSet=%p", pSetData);
 		return NULL;
@@ -630,20 +790,20 @@ const char* LO_msg_encode_data(uint8_t from, const LOMSetOfData_t* pSetData) {
 		return NULL;
 	}
 	if (from == 0) { // Called by the LiveObjects Client Thread.
-		p_msg = LO_msg_encode_data_buf(_LO_msg_buf, LOM_JSON_BUF_SZ, pSetData);
+		p_msg = LO_msg_encode_data_buf(buf_ptr, buf_len, enc, pSetData, p_len);
 	}
 	else {
 #if LOM_ENCODE_MQUEUE
-		// Use a local buffer to build JSON message
-		if (MSG_MUTEX_LOCK()) {
-			LOTRACE_ERR("Error to lock mutex");
+		/* Build the message directly in the message ring */
+		uint32_t len = 0;
+		const char* p_enc;
+		char* p = LO_msg_begin(ring);
+		if (p == NULL) {
 			return NULL;
 		}
-		p_msg = LO_msg_encode_data_buf(_LO_msg_buf_user, LOM_JSON_BUF_USER_SZ, pSetData);
-		if (p_msg) {
-			p_msg = LO_msg_alloc(from, p_msg);
-		}
-		MSG_MUTEX_UNLOCK();
+		p_enc = LO_msg_encode_data_buf(p + LO_msg_hdr_sz(enc), LOM_JSON_BUF_USER_SZ + 1 - LO_msg_hdr_sz(enc), enc,
+				pSetData, &len);
+		p_msg = LO_msg_end_enc(ring, from, p, enc, p_enc, len);
 #else
 		LOTRACE_ERR("ERROR - Not supported");
 		p_msg = NULL;
@@ -656,7 +816,8 @@ const char* LO_msg_encode_data(uint8_t from, const LOMSetOfData_t* pSetData) {
 /* --------------------------------------------------------------------------------- */
 /*  */
 #if LOC_FEATURE_LO_RESOURCES
-const char* LO_msg_encode_resources(uint8_t from, const LOMSetOfResources_t* pSetResources) {
+const char* LO_msg_encode_resources(uint8_t from, char* buf_ptr, uint32_t buf_len, LOMRing_t* ring,
+		const LOMSetOfResources_t* pSetResources, uint32_t* p_len) {
 	const char *p_msg;
 
 	if (pSetResources == NULL) {
@@ -669,20 +830,17 @@ const char* LO_msg_encode_resources(uint8_t from, const LOMSetOfResources_t* pSe
 	}
 
 	if (from == 0) { // Called by the LiveObjects Client Thread.
-		p_msg = LO_msg_encode_resources_buf(_LO_msg_buf, LOM_JSON_BUF_SZ, pSetResources);
+		p_msg = LO_msg_encode_resources_buf(buf_ptr, buf_len, pSetResources, p_len);
 	}
 	else {
 #if LOM_ENCODE_MQUEUE
-		// Use a local buffer to build JSON message
-		if (MSG_MUTEX_LOCK()) {
-			LOTRACE_ERR("Error to lock mutex");
+		/* Build the JSON message directly in the message ring */
+		char* p = LO_msg_begin(ring);
+		if (p == NULL) {
 			return NULL;
 		}
-		p_msg = LO_msg_encode_resources_buf(_LO_msg_buf_user, LOM_JSON_BUF_USER_SZ, pSetResources);
-		if (p_msg) {
-			p_msg = LO_msg_alloc(from, p_msg);
-		}
-		MSG_MUTEX_UNLOCK();
+		p_msg = LO_msg_end(ring, from, p, LO_msg_encode_resources_buf(p + 1, LOM_JSON_BUF_USER_SZ, pSetResources,
+				NULL));
 #else
 		LOTRACE_ERR("ERROR - Not supported");
 		p_msg = NULL;
@@ -695,7 +853,8 @@ const char* LO_msg_encode_resources(uint8_t from, const LOMSetOfResources_t* pSe
 /* --------------------------------------------------------------------------------- */
 /*  */
 #if LOC_FEATURE_LO_PARAMS
-const char* LO_msg_encode_params_all(uint8_t from, const LOMArrayOfParams_t* params_array, int32_t cid) {
+const char* LO_msg_encode_params_all(uint8_t from, char* buf_ptr, uint32_t buf_len, LOMRing_t* ring,
+		const LOMArrayOfParams_t* params_array, int32_t cid, uint32_t* p_len) {
 	const char *p_msg;
 	if (params_array == NULL) {
 		LOTRACE_ERR("encode_params_all: failed, invalid parameters params_array=%p", params_array);
@@ -706,20 +865,17 @@ const char* LO_msg_encode_params_all(uint8_t from, const LOMArrayOfParams_t* par
 		return NULL;
 	}
 	if (from == 0) { // Called by the LiveObjects Client Thread.
-		p_msg = LO_msg_encode_params_all_buf(_LO_msg_buf, LOM_JSON_BUF_SZ, params_array, cid);
+		p_msg = LO_msg_encode_params_all_buf(buf_ptr, buf_len, params_array, cid, p_len);
 	}
 	else {
 #if LOM_ENCODE_MQUEUE
-		// Use a local buffer to build JSON message
-		if (MSG_MUTEX_LOCK()) {
-			LOTRACE_ERR("Error to lock mutex");
+		/* Build the JSON message directly in the message ring */
+		char* p = LO_msg_begin(ring);
+		if (p == NULL) {
 			return NULL;
 		}
-		p_msg = LO_msg_encode_params_all_buf(_LO_msg_buf_user, LOM_JSON_BUF_USER_SZ, params_array, cid);
-		if (p_msg) {
-			p_msg = LO_msg_alloc(from, p_msg);
-		}
-		MSG_MUTEX_UNLOCK();
+		p_msg = LO_msg_end(ring, from, p, LO_msg_encode_params_all_buf(p + 1, LOM_JSON_BUF_USER_SZ, params_array, cid,
+				NULL));
 #else
 		LOTRACE_ERR("ERROR - Not supported");
 		p_msg = NULL;
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  loc_msg_ring.c
+ * @brief Ring of variable-length messages (bip buffer)
+ *
+ * Messages built by the user threads are written in place in the ring of the
+ * client instance, and published by the LiveObjects Client thread directly from
+ * the ring: no allocation and no copy.
+ *
+ * Each message is preceded by a small header (length and state). The producers
+ * (serialized by MSG_MUTEX) reserve the largest possible message, build it, and
+ * commit its actual length. A message is released by only setting its state to
+ * FREE (any thread, any order). The producers reclaim the released messages,
+ * from the oldest one, when they need space.
+ *
+ * Also used (by the LiveObjects Client thread only) to keep the QoS 1 messages
+ * of the in-flight window until they are acknowledged (LOC_MQTT_INFLIGHT).
+ */
+
+#include "liveobjects-client/LiveObjectsClient_Config.h"
+
+#if LOM_MQUEUE || LOC_MQTT_INFLIGHT
+
+#include <stdint.h>
+#include <string.h>
+
+#include "loc_msg.h"
+
+#include "liveobjects-sys/loc_trace.h"
+#include "liveobjects-sys/LiveObjectsClient_Platform.h"
+#include "platform_default.h"
+
+#define LOM_REC_BUSY             1  /* Message in use (queued or being published) */
+#define LOM_REC_FREE             2  /* Released */
+#define LOM_REC_SKIP             3  /* Unused space at the end of the ring */
+
+typedef struct {
+	uint32_t len;                   /* Length of the record: header + message, aligned */
+	uint32_t state;                 /* LOM_REC_xxx */
+} LOMRecHdr_t;
+
+#define LOM_REC_ALIGN(n)         (((n) + sizeof(LOMRecHdr_t) - 1) & ~((uint32_t) sizeof(LOMRecHdr_t) - 1))
+
+#define LOM_REC_HDR(p_msg)       ((LOMRecHdr_t*) ((char*) (p_msg) - sizeof(LOMRecHdr_t)))
+
+#if defined(__GNUC__)
+#define LOM_REC_STATE_GET(h)     __atomic_load_n(&(h)->state, __ATOMIC_ACQUIRE)
+#define LOM_REC_STATE_SET(h, s)  __atomic_store_n(&(h)->state, (s), __ATOMIC_RELEASE)
+#else
+#define LOM_REC_STATE_GET(h)     (*(volatile uint32_t*) &(h)->state)
+#define LOM_REC_STATE_SET(h, s)  (*(volatile uint32_t*) &(h)->state = (s))
+#endif
+
+/* --------------------------------------------------------------------------------- */
+/* Advance the tail over the released records */
+static void LO_msg_ring_reclaim(LOMRing_t* ring) {
+	while (ring->used) {
+		LOMRecHdr_t* hdr = (LOMRecHdr_t*) (ring->buf + ring->tail);
+		if (LOM_REC_STATE_GET(hdr) == LOM_REC_BUSY) {
+			break;
+		}
+		ring->tail += hdr->len;
+		if (ring->tail >= ring->size) {
+			ring->tail = 0;
+		}
+		ring->used -= hdr->len;
+	}
+	if (ring->used == 0) {
+		/* Empty: restart at the beginning to have the largest contiguous space */
+		ring->head = ring->tail = 0;
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Find the place of a record of 'need' bytes: return its offset, or -1 if there is no room.
+ * skip is set when the end of the ring must be skipped (record at offset 0). */
+static int32_t LO_msg_ring_find(LOMRing_t* ring, uint32_t need, uint8_t* skip) {
+	*skip = 0;
+	if (ring->used == ring->size) {
+		return -1;
+	}
+	if (ring->head >= ring->tail) {
+		/* Free space: [head, size[ and [0, tail[ */
+		if (need <= ring->size - ring->head) {
+			return (int32_t) ring->head;
+		}
+		if (need <= ring->tail) {
+			*skip = 1;
+			return 0;
+		}
+		return -1;
+	}
+	/* Free space: [head, tail[ */
+	return (need <= ring->tail - ring->head) ? (int32_t) ring->head : -1;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_msg_ring_init(LOMRing_t* ring, void* buf, uint32_t size) {
+	if ((ring == NULL) || (buf == NULL) || (((uintptr_t) buf) & (sizeof(LOMRecHdr_t) - 1))) {
+		return -1;
+	}
+	ring->buf = (char*) buf;
+	ring->size = size & ~((uint32_t) sizeof(LOMRecHdr_t) - 1);
+	ring->head = ring->tail = ring->used = 0;
+	ring->full = NULL;
+	ring->full_user = NULL;
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+char* LO_msg_ring_reserve(LOMRing_t* ring, uint32_t len) {
+	uint32_t need = LOM_REC_ALIGN(sizeof(LOMRecHdr_t) + len);
+	LOMRecHdr_t* hdr;
+	int32_t offset;
+	uint8_t skip;
+
+	if (need > ring->size) {
+		LOTRACE_WARN("Too large (len=%"PRIu32" ring size=%"PRIu32")", len, ring->size);
+		return NULL;
+	}
+	for (;;) {
+		LO_msg_ring_reclaim(ring);
+		offset = LO_msg_ring_find(ring, need, &skip);
+		if (offset >= 0) {
+			break;
+		}
+		/* Overflow: the handler can release messages (or wait for it) */
+		if ((ring->full == NULL) || (ring->full(ring, len, ring->full_user))) {
+			LOTRACE_WARN("Ring full (len=%"PRIu32" used=%"PRIu32"/%"PRIu32")", len, ring->used, ring->size);
+			return NULL;
+		}
+	}
+	if (skip) {
+		/* Skip the end of the ring */
+		hdr = (LOMRecHdr_t*) (ring->buf + ring->head);
+		hdr->len = ring->size - ring->head;
+		LOM_REC_STATE_SET(hdr, LOM_REC_SKIP);
+		ring->used += hdr->len;
+		ring->head = 0;
+	}
+	hdr = (LOMRecHdr_t*) (ring->buf + offset);
+	return (char*) (hdr + 1);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int LO_msg_ring_room(LOMRing_t* ring, uint32_t len) {
+	uint32_t need = LOM_REC_ALIGN(sizeof(LOMRecHdr_t) + len);
+	uint8_t skip;
+	LO_msg_ring_reclaim(ring);
+	return ((need <= ring->size) && (LO_msg_ring_find(ring, need, &skip) >= 0)) ? 1 : 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_msg_ring_commit(LOMRing_t* ring, char* p_msg, uint32_t len) {
+	LOMRecHdr_t* hdr = LOM_REC_HDR(p_msg);
+	hdr->len = LOM_REC_ALIGN(sizeof(LOMRecHdr_t) + len);
+	hdr->state = LOM_REC_BUSY;
+	ring->head += hdr->len;
+	if (ring->head >= ring->size) {
+		ring->head = 0;
+	}
+	ring->used += hdr->len;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+void LO_msg_free(const char* p_msg) {
+	if (p_msg) {
+		LOM_REC_STATE_SET(LOM_REC_HDR(p_msg), LOM_REC_FREE);
+	}
+}
+
+#endif /* LOM_MQUEUE || LOC_MQTT_INFLIGHT */
@@ -21,7 +21,7 @@
 extern "C" {
 #endif
 
-#define LO_SYS_MUTEX_NB    2
+#define LO_SYS_MUTEX_NB    3
 
 #define MQ_MUTEX_LOCK()     LO_sys_mutex_lock(0)
 #define MQ_MUTEX_UNLOCK()   LO_sys_mutex_unlock(0)
@@ -29,6 +29,9 @@ extern "C" {
 #define MSG_MUTEX_LOCK()    LO_sys_mutex_lock(1)
 #define MSG_MUTEX_UNLOCK()  LO_sys_mutex_unlock(1)
 
+#define NETW_MUTEX_LOCK()   LO_sys_mutex_lock(2)
+#define NETW_MUTEX_UNLOCK() LO_sys_mutex_unlock(2)
+
 void    LO_sys_init(void);
 
 void    LO_sys_threadRun(void);
@@ -33,6 +33,7 @@ extern "C" {
 #define  NETW_ERR_NET_CONN_RESET         MBEDTLS_ERR_NET_CONN_RESET
 #define  NETW_ERR_NET_SEND_FAILED        MBEDTLS_ERR_NET_SEND_FAILED
 #define  NETW_ERR_NET_RECV_FAILED        MBEDTLS_ERR_NET_RECV_FAILED
+#define  NETW_ERR_NET_UNKNOWN_HOST       MBEDTLS_ERR_NET_UNKNOWN_HOST
 
 #define  NETW_ERR_SSL_WANT_READ          MBEDTLS_ERR_SSL_WANT_READ
 #define  NETW_ERR_SSL_WANT_WRITE         MBEDTLS_ERR_SSL_WANT_WRITE
@@ -44,6 +45,7 @@ extern "C" {
 #define  NETW_ERR_NET_CONN_RESET         -2
 #define  NETW_ERR_NET_SEND_FAILED        -3
 #define  NETW_ERR_NET_RECV_FAILED        -4
+#define  NETW_ERR_NET_UNKNOWN_HOST       -8
 
 #define  NETW_ERR_SSL_WANT_READ          -5
 #define  NETW_ERR_SSL_WANT_WRITE         -6
@@ -61,6 +63,7 @@ int f_netw_sock_setup(Network *pNetwork);
 
 int f_netw_sock_close(Network *pNetwork);
 
+/* Return 0, NETW_ERR_NET_UNKNOWN_HOST if the host name is not resolved, or another error */
 int f_netw_sock_connect(Network *pNetwork, const char* RemoteHostAddress, uint16_t RemoteHostPort, uint32_t tmo_ms);
 
 /*
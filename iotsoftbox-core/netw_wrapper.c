@@ -20,9 +20,24 @@
 
 #include "netw_wrapper.h"
 #include "netw_sock.h"
+#include "loc_sys.h"
+
+#include "paho-mqttclient-embedded-c/MQTTClient.h"
 
 #include "liveobjects-client/LiveObjectsClient_Config.h"
 
+#if LOC_FEATURE_EVLOOP || LOC_FEATURE_WAKEUP
+#include <poll.h>
+#include <errno.h>
+#include <sys/uio.h>
+#endif
+#if LOC_FEATURE_EVLOOP
+#include <stdio.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#endif
+
 #include "liveobjects-sys/loc_trace.h"
 #include "liveobjects-sys/LiveObjectsClient_Platform.h"
 #include "platform_default.h"
@@ -51,6 +66,7 @@ void LOCC_mqtt_dump_msg(const unsigned char* p_buf);
 
 #define MBEDTLS_VERIFY      1
 #define MBEDTLS_TIMER       0
+#define MBEDTLS_RESUME      1   // Resume the last TLS session (abbreviated handshake) at the next connection
 #define MBEDTLS_DTLS_TIMER  0
 
 #if MBEDTLS_DTLS_TIMER && defined(MBEDTLS_SSL_PROTO_DTLS)
@@ -85,22 +101,9 @@ void LOCC_mqtt_dump_msg(const unsigned char* p_buf);
 
 #endif /* LOC_FEATURE_MBEDTLS */
 
-static uint8_t _netw_tls_enabled;
-
 #if LOC_FEATURE_MBEDTLS
 static const char* _netw_passwd = "";
 
-static uint8_t _netw_tls_run;
-static bool _netw_ssl_verify = false;
-static mbedtls_ssl_config _netw_conf;
-static mbedtls_ssl_context _netw_ssl;
-static mbedtls_entropy_context _netw_entropy;
-static mbedtls_ctr_drbg_context _netw_ctr_drbg;
-
-static mbedtls_x509_crt _netw_cacert;
-static mbedtls_x509_crt _netw_clicert;
-static mbedtls_pk_context _netw_pkey;
-
 #if MBEDTLS_TIMER
 static struct {
 	uint8_t timer_cancelled;
@@ -204,64 +207,194 @@ int f_timing_get_delay( void *data )
 
 #endif
 
+#if LOC_FEATURE_MBEDTLS
+/* --------------------------------------------------------------------------------- */
+/* Receive callback of the SSL/TLS layer, with the read timeout of this instance
+ * (the read timeout of the shared SSL/TLS configuration is not used) */
+static int netw_recvTimeout(void *pNetwork, unsigned char *buf, size_t len, uint32_t tmo) {
+	LiveObjectsNetCtx_t *pNetw = (LiveObjectsNetCtx_t*) pNetwork;
+	(void) tmo;
+#if LOC_FEATURE_EVLOOP
+	if (pNetw->nonblock) {
+		/* Stepped handshake: never wait, the caller waits for the socket to be readable */
+		struct pollfd pfd;
+		pfd.fd = (int) pNetw->net.my_socket;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, 0) == 0) {
+			return MBEDTLS_ERR_SSL_WANT_READ;
+		}
+		return f_netw_sock_recv(pNetwork, buf, len);
+	}
+#endif
+	return f_netw_sock_recv_timeout(pNetwork, buf, len, pNetw->read_tmo);
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Forget the saved TLS session: the next handshake is a full one */
+static void netw_sessionClear(LiveObjectsNetCtx_t *pNetw) {
+	if (pNetw->session_ok) {
+		mbedtls_ssl_session_free(&pNetw->session);
+		mbedtls_ssl_session_init(&pNetw->session);
+		pNetw->session_ok = 0;
+	}
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Save the TLS session just negotiated (or resumed), and return 1 if it is the saved one (resumed) */
+static int netw_sessionSave(LiveObjectsNetCtx_t *pNetw) {
+	int resumed = 0;
+#if MBEDTLS_RESUME && defined(MBEDTLS_SSL_CLI_C)
+	mbedtls_ssl_session session;
+	int ret;
+
+	mbedtls_ssl_session_init(&session);
+	ret = mbedtls_ssl_get_session(&pNetw->ssl, &session);
+	if (ret) {
+		LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_get_session");
+		mbedtls_ssl_session_free(&session);
+		netw_sessionClear(pNetw);
+		return 0;
+	}
+	/* Same master secret: resumed. The session ID is not kept with a ticket (new random ID
+	 * offered by the client, echoed by the server) */
+	if ((pNetw->session_ok) && (memcmp(session.master, pNetw->session.master, sizeof(session.master)) == 0)) {
+		resumed = 1;
+	}
+	netw_sessionClear(pNetw);
+	pNetw->session = session;
+	pNetw->session_ok = 1;
+#endif
+	return resumed;
+}
+#endif /* LOC_FEATURE_MBEDTLS */
+
 /* --------------------------------------------------------------------------------- */
 /*  */
-void netw_disconnect(Network *pNetwork, int mode) {
-	if (f_netw_sock_isOpen(pNetwork)) {
+void netw_disconnect(LiveObjectsNetCtx_t *pNetw, int mode) {
+	if (f_netw_sock_isOpen(&pNetw->net)) {
 #if LOC_FEATURE_MBEDTLS
-		if (_netw_tls_run) {
+		if (pNetw->tls_run) {
 			int ret;
 			LOTRACE_INF("mbedtls_ssl_close_notify ...");
 			do {
-				ret = mbedtls_ssl_close_notify(&_netw_ssl);
+				ret = mbedtls_ssl_close_notify(&pNetw->ssl);
 			} while (ret == MBEDTLS_ERR_SSL_WANT_WRITE);
 			LOTRACE_INF("mbedtls_ssl_close_notify ret=%d", ret);
 		}
-		if (_netw_tls_enabled) {
+		if (pNetw->tls_enabled) {
 			LOTRACE_INF("SSL RESET ...");
-			mbedtls_ssl_session_reset(&_netw_ssl);
+			mbedtls_ssl_session_reset(&pNetw->ssl);
 		}
 #endif
-		f_netw_sock_close(pNetwork);
+		f_netw_sock_close(&pNetw->net);
 	}
 	LOTRACE_INF("RESET");
+#if LOC_NETW_RCV_BUF_SZ > 0
+	pNetw->rcv_pos = pNetw->rcv_len = 0;
+#endif
+#if LOC_FEATURE_EVLOOP
+	pNetw->tcp_wait = 0;
+#endif
 #if LOC_FEATURE_MBEDTLS
-	_netw_tls_run = 0;
+	pNetw->tls_run = 0;
+#if LOC_FEATURE_EVLOOP
+	pNetw->nonblock = 0;
+#endif
 #endif
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-unsigned char netw_isLost(Network *pNetwork) {
-	if (pNetwork) {
-		return f_netw_sock_isLost(pNetwork);
+unsigned char netw_isLost(LiveObjectsNetCtx_t *pNetw) {
+	if (pNetw) {
+		return f_netw_sock_isLost(&pNetw->net);
 	}
 	return 0;
 }
 
+/* --------------------------------------------------------------------------------- */
+/*  */
+int netw_pending(LiveObjectsNetCtx_t *pNetw) {
+	int n = 0;
+	if (pNetw == NULL) {
+		return 0;
+	}
+#if LOC_NETW_RCV_BUF_SZ > 0
+	n = (int) (pNetw->rcv_len - pNetw->rcv_pos);
+#endif
+#if LOC_FEATURE_MBEDTLS
+	if (pNetw->tls_run) {
+		n += (int) mbedtls_ssl_get_bytes_avail(&pNetw->ssl);
+	}
+#endif
+	return n;
+}
+
+#if LOC_FEATURE_EVLOOP || LOC_FEATURE_WAKEUP
+/* --------------------------------------------------------------------------------- */
+/*  */
+int netw_getFd(LiveObjectsNetCtx_t *pNetw) {
+	if ((pNetw) && (f_netw_sock_isOpen(&pNetw->net))) {
+		return (int) pNetw->net.my_socket;
+	}
+	return -1;
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int netw_readable(LiveObjectsNetCtx_t *pNetw) {
+	struct pollfd pfd;
+	if (netw_pending(pNetw) > 0) {
+		return 1;
+	}
+	pfd.fd = netw_getFd(pNetw);
+	if (pfd.fd < 0) {
+		return 0;
+	}
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	return (poll(&pfd, 1, 0) > 0) ? 1 : 0;
+}
+#endif
+
+#if LOC_FEATURE_MBEDTLS
+/* --------------------------------------------------------------------------------- */
+/* Write all the bytes on the SSL/TLS layer: return len, or an error */
+static int netw_sslWrite(LiveObjectsNetCtx_t *pNetw, const unsigned char *buf, int len) {
+	int written;
+	int frags;
+	int ret;
+	for (written = 0, frags = 0; written < len; written += ret, frags++) {
+		while ((ret = mbedtls_ssl_write(&pNetw->ssl, buf + written, len - written)) <= 0) {
+			if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+				LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_write");
+				return ret;
+			}
+			LOTRACE_DBG1("(%d): ret=%d  -> continue, frags=%d ...", len, ret, frags);
+		}
+	}
+	return written;
+}
+#endif
+
 /* --------------------------------------------------------------------------------- */
 /*  */
 int netw_mqtt_write(Network *pNetwork, unsigned char *pMsg, int len, int timeout_ms) {
+	LiveObjectsNetCtx_t *pNetw = (LiveObjectsNetCtx_t*) pNetwork;
 	int written = 0;
 	LOTRACE_DBG1("(%p/%p, len=%d,timeout_ms=%d, tsl=%d) ...", pNetwork, pNetwork->my_socket, len,
-			timeout_ms, _netw_tls_enabled);
+			timeout_ms, pNetw->tls_enabled);
 
 #if (LOC_MQTT_DUMP_MSG & 0x02)
 	LOCC_mqtt_dump_msg(pMsg);
 #endif
 
-	if (_netw_tls_enabled) {
+	if (pNetw->tls_enabled) {
 #if LOC_FEATURE_MBEDTLS
-		int frags;
-		int ret;
-		for (written = 0, frags = 0; written < len; written += ret, frags++) {
-			while ((ret = mbedtls_ssl_write(&_netw_ssl, pMsg + written, len - written)) <= 0) {
-				if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
-					LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_write");
-					return ret;
-				}
-				LOTRACE_DBG1("(%d): ret=%d  -> continue, frags=%d ...", len, ret, frags);
-			}
+		written = netw_sslWrite(pNetw, pMsg, len);
+		if (written < 0) {
+			return written;
 		}
 #else
 		LOTRACE_ERR("Error while writting bytes: TLS required but not supported");
@@ -280,66 +413,191 @@ int netw_mqtt_write(Network *pNetwork, unsigned char *pMsg, int len, int timeout
 }
 
 /* --------------------------------------------------------------------------------- */
-/*  */
-int netw_mqtt_read(Network *pNetwork, unsigned char *pMsg, int len, int timeout_ms) {
-	int ret = -1;
-
-	/* LOTRACE_DBG_VERBOSE("(%p/%p, len=%d,timeout_ms=%d, tsl=%d) ...",  pNetwork, pNetwork->my_socket, len, timeout_ms, _netw_tls_enabled); */
+/* Vectored write (scatter-gather publish): return the number of bytes written, or an error.
+ * TCP: one writev() of the elements. SSL/TLS: the elements are coalesced in snd_buf, so that
+ * the fixed header, the topic and the beginning of the payload are sent in one record,
+ * and the rest of a large payload is written directly (not copied in snd_buf).
+ * As netw_mqtt_write(), the socket is blocking: timeout_ms is not used. */
+int netw_mqtt_writev(Network *pNetwork, MQTTIoVec *iov, int iovcnt, int timeout_ms) {
+	LiveObjectsNetCtx_t *pNetw = (LiveObjectsNetCtx_t*) pNetwork;
+	int written = 0;
+	int i;
+	(void) timeout_ms;
+	LOTRACE_DBG1("(%p/%p, iovcnt=%d,timeout_ms=%d, tsl=%d) ...", pNetwork, pNetwork->my_socket, iovcnt,
+			timeout_ms, pNetw->tls_enabled);
 
-	if (_netw_tls_enabled) {
+	if (pNetw->tls_enabled) {
 #if LOC_FEATURE_MBEDTLS
-		int rxLen = 0;
-		bool isErrorFlag = false;
-		bool isCompleteFlag = false;
-
-		if (timeout_ms >= 0) {
-			mbedtls_ssl_conf_read_timeout(&_netw_conf, timeout_ms);
-		}
-
-		LOTRACE_DBG_VERBOSE("(len=%d,timeout_ms=%d) ...", len, timeout_ms);
-
-		do {
-			ret = mbedtls_ssl_read(&_netw_ssl, pMsg, len);
-			if (ret > 0) {
-				rxLen += ret;
-			}
-			else if (ret == MBEDTLS_ERR_SSL_WANT_READ) {
-				LOTRACE_DBG_VERBOSE("(len=%d,timeout_ms=%d) - ret=x%X = MBEDTLS_ERR_SSL_WANT_READ", len,
-						timeout_ms, ret);
-				isErrorFlag = true;
+		int n = 0;
+		int ret;
+		for (i = 0; i < iovcnt; i++) {
+			const unsigned char *p = iov[i].base;
+			int len = iov[i].len;
+			while (len > 0) {
+				if ((n == 0) && (len >= (int) sizeof(pNetw->snd_buf))) {
+					ret = netw_sslWrite(pNetw, p, len);
+					if (ret < 0) {
+						return ret;
+					}
+					written += len;
+					break;
+				}
+				ret = (int) sizeof(pNetw->snd_buf) - n;
+				if (ret > len) {
+					ret = len;
+				}
+				memcpy(pNetw->snd_buf + n, p, ret);
+				n += ret;
+				p += ret;
+				len -= ret;
+				if (n == (int) sizeof(pNetw->snd_buf)) {
+					if ((ret = netw_sslWrite(pNetw, pNetw->snd_buf, n)) < 0) {
+						return ret;
+					}
+					written += n;
+					n = 0;
+				}
 			}
-			else if (ret == MBEDTLS_ERR_SSL_TIMEOUT) {
-				LOTRACE_DBG_VERBOSE("(len=%d,timeout_ms=%d) - ret=x%X = MBEDTLS_ERR_SSL_TIMEOUT", len,
-						timeout_ms, ret);
-				isErrorFlag = true;
+		}
+		if (n > 0) {
+			if ((ret = netw_sslWrite(pNetw, pNetw->snd_buf, n)) < 0) {
+				return ret;
 			}
-			else {
-				LOTRACE_DBG1("(len=%d,timeout_ms=%d) - ret= x%X", len, timeout_ms, ret);
-				LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_read");
-				isErrorFlag = true;
+			written += n;
+		}
+#else
+		LOTRACE_ERR("Error while writting bytes: TLS required but not supported");
+		written = -1;
+#endif
+	}
+	else {
+#if LOC_FEATURE_EVLOOP || LOC_FEATURE_WAKEUP
+		struct iovec vec[NETW_IOV_MAX];
+		if (iovcnt > NETW_IOV_MAX) {
+			iovcnt = NETW_IOV_MAX;
+		}
+		for (i = 0; i < iovcnt; i++) {
+			vec[i].iov_base = (void*) iov[i].base;
+			vec[i].iov_len = (size_t) iov[i].len;
+		}
+		while (((written = (int) writev((int) pNetw->net.my_socket, vec, iovcnt)) < 0) && (errno == EINTR)) {
+		}
+		if (written < 0) {
+			LOTRACE_ERR("(iovcnt=%d,timeout_ms=%d) writev ERROR %d", iovcnt, timeout_ms, errno);
+			return NETW_ERR_NET_SEND_FAILED;
+		}
+#else
+		int ret;
+		for (i = 0; i < iovcnt; i++) {
+			ret = f_netw_sock_send(pNetwork, iov[i].base, iov[i].len);
+			if (ret < 0) {
+				LOTRACE_ERR("(iovcnt=%d,timeout_ms=%d) ERROR %d", iovcnt, timeout_ms, ret);
+				return (written > 0) ? written : ret;
 			}
-			if (rxLen >= len) {
-				isCompleteFlag = true;
+			written += ret;
+			if (ret < iov[i].len) {
+				break;
 			}
-		} while (!isErrorFlag && !isCompleteFlag);
+		}
+#endif
+	}
+	LOTRACE_DBG1("(iovcnt=%d,timeout_ms=%d) -> written=%d", iovcnt, timeout_ms, written);
+	return written;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* One read of the network (or of the SSL/TLS layer): return the number of received bytes (max len),
+ * 0 if the connection is closed, or an error */
+static int netw_recvSome(LiveObjectsNetCtx_t *pNetw, unsigned char *buf, int len, int timeout_ms) {
+	int ret;
 
+	if (pNetw->tls_enabled) {
+#if LOC_FEATURE_MBEDTLS
+		if (timeout_ms >= 0) {
+			pNetw->read_tmo = (uint32_t) timeout_ms;
+		}
+		ret = mbedtls_ssl_read(&pNetw->ssl, buf, len);
+		if (ret == MBEDTLS_ERR_SSL_WANT_READ) {
+			LOTRACE_DBG_VERBOSE("(len=%d,timeout_ms=%d) - ret=x%X = MBEDTLS_ERR_SSL_WANT_READ", len, timeout_ms, ret);
+		}
+		else if (ret == MBEDTLS_ERR_SSL_TIMEOUT) {
+			LOTRACE_DBG_VERBOSE("(len=%d,timeout_ms=%d) - ret=x%X = MBEDTLS_ERR_SSL_TIMEOUT", len, timeout_ms, ret);
+		}
+		else if (ret <= 0) {
+			LOTRACE_DBG1("(len=%d,timeout_ms=%d) - ret= x%X", len, timeout_ms, ret);
+			LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_read");
+		}
 #else
 		LOTRACE_ERR("Error while reading bytes: TLS required but not supported");
 		ret = -1;
 #endif
 	}
 	else {
-		ret = f_netw_sock_recv_timeout(pNetwork, pMsg, len, timeout_ms);
-		if (ret < 0) {
-			if ((ret != NETW_ERR_SSL_WANT_READ) && (ret != NETW_ERR_SSL_TIMEOUT))
-				LOTRACE_ERR("f_netw_sock_recv_timeout(len=%d) -> ERROR %d x%x", len, ret, ret);
+		ret = f_netw_sock_recv_timeout(&pNetw->net, buf, len, timeout_ms);
+		if ((ret < 0) && (ret != NETW_ERR_SSL_WANT_READ) && (ret != NETW_ERR_SSL_TIMEOUT)) {
+			LOTRACE_ERR("f_netw_sock_recv_timeout(len=%d) -> ERROR %d x%x", len, ret, ret);
+		}
+	}
+	return ret;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Read the MQTT stream. The MQTT client reads a packet with several small reads (header,
+ * remaining length byte per byte, then the rest): they are served from the receive buffer,
+ * filled with as much as is available in one read of the network. */
+int netw_mqtt_read(Network *pNetwork, unsigned char *pMsg, int len, int timeout_ms) {
+	LiveObjectsNetCtx_t *pNetw = (LiveObjectsNetCtx_t*) pNetwork;
+	int rxLen = 0;
+	int ret;
+
+	/* LOTRACE_DBG_VERBOSE("(%p/%p, len=%d,timeout_ms=%d, tsl=%d) ...",  pNetwork, pNetwork->my_socket, len, timeout_ms, pNetw->tls_enabled); */
+
+#if LOC_NETW_RCV_BUF_SZ > 0
+	if (len <= (int) sizeof(pNetw->rcv_buf)) {
+		uint32_t avail = pNetw->rcv_len - pNetw->rcv_pos;
+		if (avail < (uint32_t) len) {
+			/* Not enough: keep the received bytes (not consumed if this read fails), and fill */
+			if (pNetw->rcv_pos) {
+				memmove(pNetw->rcv_buf, pNetw->rcv_buf + pNetw->rcv_pos, avail);
+				pNetw->rcv_pos = 0;
+				pNetw->rcv_len = avail;
+			}
+			while (avail < (uint32_t) len) {
+				ret = netw_recvSome(pNetw, pNetw->rcv_buf + pNetw->rcv_len,
+						(int) (sizeof(pNetw->rcv_buf) - pNetw->rcv_len), timeout_ms);
+				if (ret <= 0) {
+					return ret;
+				}
+				pNetw->rcv_len += ret;
+				avail += ret;
+			}
+		}
+		memcpy(pMsg, pNetw->rcv_buf + pNetw->rcv_pos, len);
+		pNetw->rcv_pos += len;
+		if (pNetw->rcv_pos == pNetw->rcv_len) {
+			pNetw->rcv_pos = pNetw->rcv_len = 0;
+		}
+		LOTRACE_DBG_VERBOSE("netw_mqtt_read(len=%d,timeout_ms=%d) ret=%d", len, timeout_ms, len);
+		return len;
+	}
+
+	/* Large read: the buffered bytes, then directly in the destination */
+	rxLen = (int) (pNetw->rcv_len - pNetw->rcv_pos);
+	memcpy(pMsg, pNetw->rcv_buf + pNetw->rcv_pos, rxLen);
+	pNetw->rcv_pos = pNetw->rcv_len = 0;
+#endif
+
+	while (rxLen < len) {
+		ret = netw_recvSome(pNetw, pMsg + rxLen, len - rxLen, timeout_ms);
+		if (ret <= 0) {
 			return ret;
 		}
+		rxLen += ret;
 	}
 
-	LOTRACE_DBG_VERBOSE("netw_mqtt_read(len=%d,timeout_ms=%d) ret=%d", len, timeout_ms, ret);
+	LOTRACE_DBG_VERBOSE("netw_mqtt_read(len=%d,timeout_ms=%d) ret=%d", len, timeout_ms, rxLen);
 
-	return ret;
+	return rxLen;
 }
 
 /* --------------------------------------------------------------------------------- */
@@ -350,7 +608,7 @@ void netw_mqtt_disconnect(Network *pNetwork)
 #if LOC_FEATURE_MBEDTLS
 	int ret;
 	do {
-		ret = mbedtls_ssl_close_notify(&_netw_ssl);
+		ret = mbedtls_ssl_close_notify(&pNetw->ssl);
 	}while (ret == MBEDTLS_ERR_SSL_WANT_WRITE);
 #endif
 }
@@ -408,34 +666,35 @@ static int myCertVerify(void *data, mbedtls_x509_crt *crt, int depth, uint32_t *
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int netw_init(Network *pNetwork, void* net_iface_handler) {
-#if LOC_FEATURE_MBEDTLS
-	int ret;
-	const char *pers = "lom_tls_wrapper";
-#endif
+int netw_init(LiveObjectsNetCtx_t *pNetw, void* net_iface_handler) {
+	LOTRACE_DBG1("netw_init(%p,%p)", pNetw, net_iface_handler);
 
-	LOTRACE_DBG1("netw_init(%p,%p)", pNetwork, net_iface_handler);
+	f_netw_sock_init(&pNetw->net, net_iface_handler);
 
-	f_netw_sock_init(pNetwork, net_iface_handler);
-
-	_netw_tls_enabled = 0;
+	pNetw->tls_enabled = 0;
+#if LOC_NETW_RCV_BUF_SZ > 0
+	pNetw->rcv_pos = pNetw->rcv_len = 0;
+#endif
+#if LOC_FEATURE_EVLOOP
+	pNetw->tcp_wait = 0;
+	pNetw->addr_len = 0;
+#endif
 
 #if LOC_FEATURE_MBEDTLS
-	_netw_tls_run = 0;
-	_netw_ssl_verify = false;
+	pNetw->tls_run = 0;
+	pNetw->read_tmo = 0;
+#if LOC_FEATURE_EVLOOP
+	pNetw->nonblock = 0;
+#endif
+	pNetw->profile = NULL;
 
 #if defined(MBEDTLS_DEBUG_C)
 	mbedtls_debug_set_threshold(0);
 #endif
 
-	mbedtls_ssl_init(&_netw_ssl);
-	mbedtls_ssl_config_init(&_netw_conf);
-	mbedtls_x509_crt_init(&_netw_cacert);
-	mbedtls_x509_crt_init(&_netw_clicert);
-	mbedtls_pk_init(&_netw_pkey);
-
-	mbedtls_ctr_drbg_init(&_netw_ctr_drbg);
-	mbedtls_entropy_init(&_netw_entropy);
+	mbedtls_ssl_init(&pNetw->ssl);
+	mbedtls_ssl_session_init(&pNetw->session);
+	pNetw->session_ok = 0;
 
 #if defined(MBEDTLS_CONFIG_NAME)
 	LOTRACE_ERR("netw_init:  MBEDTLS_CONFIG_NAME = " MBEDTLS_CONFIG_NAME);
@@ -444,44 +703,60 @@ int netw_init(Network *pNetwork, void* net_iface_handler) {
 #if defined(MBEDTLS_DEBUG_C) && (NETW_MBEDTLS_DBG > 0)
 	mbedtls_debug_set_threshold(NETW_MBEDTLS_DBG);
 	LOTRACE_ERR("netw_init: SET MBEDTLS_DEBUG threshold=%d !!", NETW_MBEDTLS_DBG);
-	mbedtls_ssl_conf_dbg(&_netw_conf, netw_mbedtls_debug, &_netw_conf);
 #endif
-
-	ret = mbedtls_ctr_drbg_seed(&_netw_ctr_drbg, mbedtls_entropy_func, &_netw_entropy, (const unsigned char *) pers,
-			strlen(pers));
-	if (ret != 0) {
-		LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ctr_drbg_seed");
-		return -1;
-	}
 #endif /* LOC_FEATURE_MBEDTLS */
 
 	LOTRACE_DBG1("netw_init: OK");
 
-	if (pNetwork) {
-		pNetwork->my_socket = SOCKETHANDLE_NULL;
-		pNetwork->mqttread = netw_mqtt_read;
-		pNetwork->mqttwrite = netw_mqtt_write;
-		/* pNetwork->disconnect = netw_mqtt_disconnect; */
-	}
+	pNetw->net.my_socket = SOCKETHANDLE_NULL;
+	pNetw->net.mqttread = netw_mqtt_read;
+	pNetw->net.mqttwrite = netw_mqtt_write;
+	/* pNetw->net.disconnect = netw_mqtt_disconnect; */
 
 	return 0;
 }
 
+#if LOC_FEATURE_MBEDTLS
+/* Security profiles shared by the client instances (list protected by NETW_MUTEX) */
+static LiveObjectsNetTlsProfile_t* _netw_profiles = NULL;
+
+/* --------------------------------------------------------------------------------- */
+/* RNG of the SSL/TLS configuration: the DRBG of a profile is shared by the client instances */
+static int netw_profileRandom(void *p_rng, unsigned char *output, size_t output_len) {
+	LiveObjectsNetTlsProfile_t* prof = (LiveObjectsNetTlsProfile_t*) p_rng;
+	int ret;
+	NETW_MUTEX_LOCK();
+	ret = mbedtls_ctr_drbg_random(&prof->ctr_drbg, output, output_len);
+	NETW_MUTEX_UNLOCK();
+	return ret;
+}
+
 /* --------------------------------------------------------------------------------- */
 /*  */
-int netw_setSecurity(Network *pNetwork, const LiveObjectsSecurityParams_t* params) {
-#if LOC_FEATURE_MBEDTLS
+static void netw_profileFree(LiveObjectsNetTlsProfile_t* prof) {
+	mbedtls_x509_crt_free(&prof->clicert);
+	mbedtls_x509_crt_free(&prof->cacert);
+	mbedtls_pk_free(&prof->pkey);
+	mbedtls_ssl_config_free(&prof->conf);
+	mbedtls_ctr_drbg_free(&prof->ctr_drbg);
+	mbedtls_entropy_free(&prof->entropy);
+	MEM_FREE(prof);
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Load the certificates and the private key, and set up the SSL/TLS configuration of a profile */
+static int netw_profileLoad(LiveObjectsNetTlsProfile_t* prof, const LiveObjectsSecurityParams_t* params) {
 	int ret;
 
 	if (params->rootCA.pLoc) {
 		LOTRACE_DBG1("Loading the CA Certificate ...");
 		if (!params->rootCA.type) {
-			ret = mbedtls_x509_crt_parse(&_netw_cacert, (const unsigned char*) params->rootCA.pLoc,
+			ret = mbedtls_x509_crt_parse(&prof->cacert, (const unsigned char*) params->rootCA.pLoc,
 					strlen(params->rootCA.pLoc) + 1);
 		}
 		else {
 #if defined(MBEDTLS_FS_IO)
-			ret = mbedtls_x509_crt_parse_file(&_netw_cacert, params->rootCA.pLoc);
+			ret = mbedtls_x509_crt_parse_file(&prof->cacert, params->rootCA.pLoc);
 #else
 			LOTRACE_ERR("mbedtls_x509_crt_parse_file (CA Certificate): NOT SUPPORTED !");
 			return -1;
@@ -500,12 +775,12 @@ int netw_setSecurity(Network *pNetwork, const LiveObjectsSecurityParams_t* param
 	if ((params->deviceCert.pLoc) && (params->devicePrivateKey.pLoc)) {
 		LOTRACE_DBG1("Loading the Client Certificate ...");
 		if (!params->deviceCert.type) {
-			ret = mbedtls_x509_crt_parse(&_netw_clicert, (const unsigned char*) params->deviceCert.pLoc,
+			ret = mbedtls_x509_crt_parse(&prof->clicert, (const unsigned char*) params->deviceCert.pLoc,
 					strlen(params->deviceCert.pLoc) + 1);
 		}
 		else {
 #if defined(MBEDTLS_FS_IO)
-			ret = mbedtls_x509_crt_parse_file(&_netw_clicert, params->deviceCert.pLoc);
+			ret = mbedtls_x509_crt_parse_file(&prof->clicert, params->deviceCert.pLoc);
 #else
 			LOTRACE_ERR("mbedtls_x509_crt_parse_file (Client Certificate): NOT SUPPORTED !");
 			return -1;
@@ -519,14 +794,14 @@ int netw_setSecurity(Network *pNetwork, const LiveObjectsSecurityParams_t* param
 
 		LOTRACE_DBG1("Loading the Client Key...");
 		if (!params->devicePrivateKey.type) {
-			ret = mbedtls_pk_parse_key(&_netw_pkey, (const unsigned char*) params->devicePrivateKey.pLoc,
+			ret = mbedtls_pk_parse_key(&prof->pkey, (const unsigned char*) params->devicePrivateKey.pLoc,
 					strlen(params->devicePrivateKey.pLoc) + 1, (const unsigned char*) _netw_passwd,
 					strlen(_netw_passwd));
 
 		}
 		else {
 #if defined(MBEDTLS_FS_IO)
-			ret = mbedtls_pk_parse_keyfile(&_netw_pkey, params->devicePrivateKey.pLoc, _netw_passwd);
+			ret = mbedtls_pk_parse_keyfile(&prof->pkey, params->devicePrivateKey.pLoc, _netw_passwd);
 #else
 			LOTRACE_ERR("mbedtls_pk_parse_keyfile (Private Key): NOT SUPPORTED !");
 			return -1;
@@ -539,7 +814,7 @@ int netw_setSecurity(Network *pNetwork, const LiveObjectsSecurityParams_t* param
 		LOTRACE_INF("Client Key loaded: OK");
 	}
 	LOTRACE_DBG1("Setting up the SSL/TLS structure...");
-	if ((ret = mbedtls_ssl_config_defaults(&_netw_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+	if ((ret = mbedtls_ssl_config_defaults(&prof->conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
 			MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
 		LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_config_defaults");
 		return ret;
@@ -550,167 +825,481 @@ int netw_setSecurity(Network *pNetwork, const LiveObjectsSecurityParams_t* param
 		int authmode;
 		if (params->serverVerificationMode) {
 			LOTRACE_INF("ssl authmode: REQUIRED (%d)", params->serverVerificationMode);
-			_netw_ssl_verify = true;
+			prof->ssl_verify = true;
 			//authmode = MBEDTLS_SSL_VERIFY_OPTIONAL;
 			authmode = MBEDTLS_SSL_VERIFY_REQUIRED;
 			if (params->serverVerificationMode != 2) {
 				LOTRACE_INF("ssl authmode: + myCertVerify");
-				mbedtls_ssl_conf_verify(&_netw_conf, myCertVerify, NULL);
+				mbedtls_ssl_conf_verify(&prof->conf, myCertVerify, NULL);
 			}
 		}
 		else {
 			LOTRACE_WARN("ssl authmode: NONE");
-			_netw_ssl_verify = false;
+			prof->ssl_verify = false;
 			authmode = MBEDTLS_SSL_VERIFY_NONE;
 		}
-		mbedtls_ssl_conf_authmode(&_netw_conf, authmode);
+		mbedtls_ssl_conf_authmode(&prof->conf, authmode);
 	}
 #else  /* MBEDTLS_VERIFY */
 	LOTRACE_WARN("ssl authmode: NONE (MBEDTLS_VERIFY=0)");
-	_netw_ssl_verify = false;
-	mbedtls_ssl_conf_authmode(&_netw_conf, MBEDTLS_SSL_VERIFY_NONE);
+	prof->ssl_verify = false;
+	mbedtls_ssl_conf_authmode(&prof->conf, MBEDTLS_SSL_VERIFY_NONE);
 #endif /* MBEDTLS_VERIFY */
 
-	mbedtls_ssl_conf_rng(&_netw_conf, mbedtls_ctr_drbg_random, &_netw_ctr_drbg);
+	mbedtls_ssl_conf_rng(&prof->conf, netw_profileRandom, prof);
+
 
+	mbedtls_ssl_conf_ca_chain(&prof->conf, &prof->cacert, NULL);
 
-	mbedtls_ssl_conf_ca_chain(&_netw_conf, &_netw_cacert, NULL);
+#if MBEDTLS_RESUME && defined(MBEDTLS_SSL_SESSION_TICKETS)
+	mbedtls_ssl_conf_session_tickets(&prof->conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
 
 #if 1
-	if ((_netw_ssl_verify) &&(params->deviceCert.pLoc) && (params->devicePrivateKey.pLoc)) {
-		if (0 != (ret = mbedtls_ssl_conf_own_cert(&_netw_conf, &_netw_clicert, &_netw_pkey))) {
+	if ((prof->ssl_verify) &&(params->deviceCert.pLoc) && (params->devicePrivateKey.pLoc)) {
+		if (0 != (ret = mbedtls_ssl_conf_own_cert(&prof->conf, &prof->clicert, &prof->pkey))) {
 			LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_conf_own_cert");
 			return ret;
 		}
 	}
 #endif
 
-	if ((ret = mbedtls_ssl_setup(&_netw_ssl, &_netw_conf)) != 0) {
+#if defined(MBEDTLS_DEBUG_C) && (NETW_MBEDTLS_DBG > 0)
+	mbedtls_ssl_conf_dbg(&prof->conf, netw_mbedtls_debug, &prof->conf);
+#endif
+
+#if MBEDTLS_DTLS_TIMER && defined(MBEDTLS_SSL_PROTO_DTLS)
+	mbedtls_ssl_conf_handshake_timeout(&prof->conf, MBEDTLS_DTLS_TIMER_MIN, MBEDTLS_DTLS_TIMER_MAX);
+#endif
+
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Create a security profile: seed the DRBG, load the certificates and the private key,
+ * and set up the SSL/TLS configuration */
+static LiveObjectsNetTlsProfile_t* netw_profileCreate(const LiveObjectsSecurityParams_t* params) {
+	LiveObjectsNetTlsProfile_t* prof;
+	const char *pers = "lom_tls_wrapper";
+	int ret;
+
+	prof = (LiveObjectsNetTlsProfile_t*) MEM_ALLOC(sizeof(LiveObjectsNetTlsProfile_t));
+	if (prof == NULL) {
+		LOTRACE_ERR("Failed to allocate the security profile");
+		return NULL;
+	}
+	memset(prof, 0, sizeof(LiveObjectsNetTlsProfile_t));
+	prof->params = params;
+
+	mbedtls_ssl_config_init(&prof->conf);
+	mbedtls_x509_crt_init(&prof->cacert);
+	mbedtls_x509_crt_init(&prof->clicert);
+	mbedtls_pk_init(&prof->pkey);
+	mbedtls_ctr_drbg_init(&prof->ctr_drbg);
+	mbedtls_entropy_init(&prof->entropy);
+
+	ret = mbedtls_ctr_drbg_seed(&prof->ctr_drbg, mbedtls_entropy_func, &prof->entropy, (const unsigned char *) pers,
+			strlen(pers));
+	if (ret != 0) {
+		LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ctr_drbg_seed");
+		netw_profileFree(prof);
+		return NULL;
+	}
+
+	ret = netw_profileLoad(prof, params);
+	if (ret) {
+		netw_profileFree(prof);
+		return NULL;
+	}
+	return prof;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Get (and reference) the security profile of these parameters, created by the first user */
+static LiveObjectsNetTlsProfile_t* netw_profileGet(const LiveObjectsSecurityParams_t* params) {
+	LiveObjectsNetTlsProfile_t* prof;
+
+	NETW_MUTEX_LOCK();
+	for (prof = _netw_profiles; prof; prof = prof->next) {
+		if (prof->params == params) {
+			break;
+		}
+	}
+	if (prof == NULL) {
+		LOTRACE_INF("Create the security profile ...");
+		prof = netw_profileCreate(params);
+		if (prof) {
+			prof->next = _netw_profiles;
+			_netw_profiles = prof;
+		}
+	}
+	if (prof) {
+		prof->ref++;
+		LOTRACE_DBG1("Security profile %p, ref=%"PRIu32, prof, prof->ref);
+	}
+	NETW_MUTEX_UNLOCK();
+	return prof;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Release a security profile, freed by the last user */
+static void netw_profileRelease(LiveObjectsNetTlsProfile_t* prof) {
+	LiveObjectsNetTlsProfile_t** pp;
+
+	NETW_MUTEX_LOCK();
+	if (--prof->ref == 0) {
+		for (pp = &_netw_profiles; *pp; pp = &(*pp)->next) {
+			if (*pp == prof) {
+				*pp = prof->next;
+				break;
+			}
+		}
+		LOTRACE_INF("Free the security profile %p", prof);
+		netw_profileFree(prof);
+	}
+	NETW_MUTEX_UNLOCK();
+}
+#endif /* LOC_FEATURE_MBEDTLS */
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int netw_setSecurity(LiveObjectsNetCtx_t *pNetw, const LiveObjectsSecurityParams_t* params) {
+#if LOC_FEATURE_MBEDTLS
+	int ret;
+
+	if (pNetw->profile) {
+		netw_sessionClear(pNetw);
+		mbedtls_ssl_free(&pNetw->ssl);
+		mbedtls_ssl_init(&pNetw->ssl);
+		netw_profileRelease(pNetw->profile);
+		pNetw->profile = NULL;
+		pNetw->tls_enabled = 0;
+	}
+
+	pNetw->profile = netw_profileGet(params);
+	if (pNetw->profile == NULL) {
+		return -1;
+	}
+
+	if ((ret = mbedtls_ssl_setup(&pNetw->ssl, &pNetw->profile->conf)) != 0) {
 		LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_setup");
 		return ret;
 	}
 
 	if ((params->rootCertificateCommonName) && (*params->rootCertificateCommonName)) {
-		if ((ret = mbedtls_ssl_set_hostname(&_netw_ssl, params->rootCertificateCommonName)) != 0) {
+		if ((ret = mbedtls_ssl_set_hostname(&pNetw->ssl, params->rootCertificateCommonName)) != 0) {
 			LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_set_hostname");
 			return ret;
 		}
 	}
 
-	_netw_tls_enabled = 1;
+	pNetw->tls_enabled = 1;
 
 	return 0;
 #else  /* LOC_FEATURE_MBEDTLS */
-	_netw_tls_enabled = 0;
+	pNetw->tls_enabled = 0;
 	return -1;
 #endif /* LOC_FEATURE_MBEDTLS */
 }
 
 /* --------------------------------------------------------------------------------- */
-/*  */
-int netw_connect(Network* pNetwork, LiveObjectsNetConnectParams_t* params) {
+/* Continue the SSL/TLS handshake, and verify the server certificate when done */
+static int netw_tlsStep(LiveObjectsNetCtx_t *pNetw) {
+#if LOC_FEATURE_MBEDTLS
 	int ret;
-	LOTRACE_INF("Connecting to server %s:%d tmo=%u ...", params->RemoteHostAddress, params->RemoteHostPort,
-			params->TimeoutMs);
 
-	if (f_netw_sock_isOpen(pNetwork)) {
-		netw_disconnect(pNetwork, 0);
+	ret = mbedtls_ssl_handshake(&pNetw->ssl);
+	if (ret == MBEDTLS_ERR_SSL_WANT_READ) {
+		return NETW_CONN_WANT_READ;
+	}
+	if (ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+		return NETW_CONN_WANT_WRITE;
 	}
-#if LOC_FEATURE_MBEDTLS
-	_netw_tls_run = 0;
-#endif
-	ret = f_netw_sock_connect(pNetwork, params->RemoteHostAddress, params->RemoteHostPort, params->TimeoutMs);
 	if (ret) {
-		LOTRACE_ERR("Failed to create TCP socket");
-		return -1;
+		LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_handshake");
+		netw_disconnect(pNetw, 0);
+		netw_sessionClear(pNetw);
+		return NETW_CONN_ERR_TLS;
 	}
-	LOTRACE_INF("Connected to server %s:%d OK", params->RemoteHostAddress, params->RemoteHostPort);
+#if LOC_FEATURE_EVLOOP
+	pNetw->nonblock = 0;
+#endif
+	LOTRACE_INF(" SSL/TLS handshake: OK");
 
-	ret = 0;
+	LOTRACE_DBG1("[ Protocol is %s ]", mbedtls_ssl_get_version(&pNetw->ssl));
+	LOTRACE_DBG1("[ Ciphersuite is %s ]", mbedtls_ssl_get_ciphersuite(&pNetw->ssl));
+	if ((ret = mbedtls_ssl_get_record_expansion(&pNetw->ssl)) >= 0) {
+		LOTRACE_DBG1("[ Record expansion is %d ]", ret);
+	}
+	else {
+		LOTRACE_DBG1("[ Record expansion is unknown (compression) ]");
+	}
+
+	if (pNetw->profile->ssl_verify) {
+		uint32_t ssl_flags;
+		LOTRACE_INF("Verifying peer X.509 Certificate...");
+		if (0 != (ssl_flags = mbedtls_ssl_get_verify_result(&pNetw->ssl))) {
+			char vrfy_buf[512];
+			mbedtls_x509_crt_verify_info(vrfy_buf, sizeof(vrfy_buf), "  ! ", ssl_flags);
+			LOTRACE_WARN("failed ssl_flags=0X%X\n%s", ssl_flags, vrfy_buf);
+			netw_disconnect(pNetw, 0);
+			netw_sessionClear(pNetw);
+			return NETW_CONN_ERR_TLS;
+		}
+		else {
+			LOTRACE_INF("Certificate Verification: OK");
+		}
+	}
+	else {
+		LOTRACE_INF("peer X.509 Certificate Verification skipped");
+	}
+
+	if (netw_sessionSave(pNetw)) {
+		LOTRACE_INF(" SSL/TLS session resumed");
+	}
+
+	pNetw->tls_run = 1;
+
+	f_netw_sock_setup(&pNetw->net);
+	return 0;
+#else  /* LOC_FEATURE_MBEDTLS */
+	(void) pNetw;
+	return NETW_CONN_ERR_TLS;
+#endif /* LOC_FEATURE_MBEDTLS */
+}
+
+/* --------------------------------------------------------------------------------- */
+/* The socket is connected: start the SSL/TLS handshake, if configured */
+static int netw_tlsStart(LiveObjectsNetCtx_t *pNetw, uint8_t nonblock) {
 #if LOC_FEATURE_MBEDTLS
-	if (_netw_tls_enabled) {
+	int ret;
+	if (pNetw->tls_enabled) {
 		LOTRACE_INF("Set SSL/TLS ...");
 
-		//mbedtls_ssl_conf_read_timeout(&conf, params.timeout_ms);
-		mbedtls_ssl_conf_read_timeout(&_netw_conf, 60000);
-
-#if MBEDTLS_DTLS_TIMER && defined(MBEDTLS_SSL_PROTO_DTLS)
-		mbedtls_ssl_conf_handshake_timeout( &_netw_conf, MBEDTLS_DTLS_TIMER_MIN, MBEDTLS_DTLS_TIMER_MAX );
+		/* The SSL/TLS context is set up (with the shared configuration) once by netw_setSecurity() */
+		if ((ret = mbedtls_ssl_session_reset(&pNetw->ssl)) != 0) {
+			LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_session_reset");
+			netw_disconnect(pNetw, 0);
+			return NETW_CONN_ERR_TLS;
+		}
+		pNetw->read_tmo = 60000;
+#if LOC_FEATURE_EVLOOP
+		pNetw->nonblock = nonblock;
 #endif
 
-		mbedtls_ssl_conf_rng(&_netw_conf, mbedtls_ctr_drbg_random, &_netw_ctr_drbg);
+		mbedtls_ssl_set_bio(&pNetw->ssl, (void*) &pNetw->net, f_netw_sock_send, f_netw_sock_recv, netw_recvTimeout);
 
-		if ((ret = mbedtls_ssl_setup(&_netw_ssl, &_netw_conf)) != 0) {
-			LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_setup");
-			netw_disconnect(pNetwork, 0);
-			return ret;
+		if (pNetw->session_ok) {
+			/* Offer the last session: if the server does not resume it, this is a full handshake */
+			if ((ret = mbedtls_ssl_set_session(&pNetw->ssl, &pNetw->session)) != 0) {
+				LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_set_session");
+				netw_sessionClear(pNetw);
+			}
 		}
 
-		mbedtls_ssl_set_bio(&_netw_ssl, (void*) pNetwork, f_netw_sock_send, f_netw_sock_recv, f_netw_sock_recv_timeout);
-
 #if MBEDTLS_TIMER
 		LOTRACE_INF("Set timer callbacks ...");
-		mbedtls_ssl_set_timer_cb( &_netw_ssl, &_netw_timer, f_timing_set_delay, f_timing_get_delay );
+		mbedtls_ssl_set_timer_cb( &pNetw->ssl, &_netw_timer, f_timing_set_delay, f_timing_get_delay );
 #endif
 
 		LOTRACE_INF("Performing the SSL/TLS handshake...");
-		while ((ret = mbedtls_ssl_handshake(&_netw_ssl)) != 0) {
-			if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
-				LOTRACE_MBEDTLS_ERR(ret, "mbedtls_ssl_handshake");
-				netw_disconnect(pNetwork, 0);
-				return ret;
-			}
-		}
-		LOTRACE_INF(" SSL/TLS handshake: OK");
+		return netw_tlsStep(pNetw);
+	}
+#endif /* LOC_FEATURE_MBEDTLS */
+	(void) nonblock;
 
-		LOTRACE_DBG1("[ Protocol is %s ]", mbedtls_ssl_get_version(&_netw_ssl));
-		LOTRACE_DBG1("[ Ciphersuite is %s ]", mbedtls_ssl_get_ciphersuite(&_netw_ssl));
-		if ((ret = mbedtls_ssl_get_record_expansion(&_netw_ssl)) >= 0) {
-			LOTRACE_DBG1("[ Record expansion is %d ]", ret);
-		}
-		else {
-			LOTRACE_DBG1("[ Record expansion is unknown (compression) ]");
-		}
+	f_netw_sock_setup(&pNetw->net);
 
-		ret = 0;
-		if (_netw_ssl_verify) {
-			uint32_t ssl_flags;
-			LOTRACE_INF("Verifying peer X.509 Certificate...");
-			if (0 != (ssl_flags = mbedtls_ssl_get_verify_result(&_netw_ssl))) {
-				char vrfy_buf[512];
-				mbedtls_x509_crt_verify_info(vrfy_buf, sizeof(vrfy_buf), "  ! ", ssl_flags);
-				LOTRACE_WARN("failed ssl_flags=0X%X\n%s", ssl_flags, vrfy_buf);
-				netw_disconnect(pNetwork, 0);
-				return -1;
-			}
-			else {
-				LOTRACE_INF("Certificate Verification: OK");
-			}
-		}
-		else {
-			LOTRACE_INF("peer X.509 Certificate Verification skipped");
-		}
+	return 0;
+}
 
-		_netw_tls_run = 1;
+#if LOC_FEATURE_EVLOOP
+/* --------------------------------------------------------------------------------- */
+/* Resolve the address of the server, unless it is the one of the last connection */
+static int netw_resolve(LiveObjectsNetCtx_t *pNetw, const LiveObjectsNetConnectParams_t* params) {
+	struct addrinfo hints;
+	struct addrinfo *res = NULL;
+	char port[8];
+	int ret;
+
+	if ((pNetw->addr_len) && (pNetw->addr_port == params->RemoteHostPort)
+			&& (strcmp(pNetw->addr_host, params->RemoteHostAddress) == 0)) {
+		return 0;
 	}
-#endif /* LOC_FEATURE_MBEDTLS */
+	pNetw->addr_len = 0;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	snprintf(port, sizeof(port), "%u", (unsigned) params->RemoteHostPort);
+	ret = getaddrinfo(params->RemoteHostAddress, port, &hints, &res);
+	if ((ret) || (res == NULL)) {
+		LOTRACE_ERR("Failed to resolve %s, ret=%d", params->RemoteHostAddress, ret);
+		return NETW_CONN_ERR_DNS;
+	}
+	memcpy(&pNetw->addr, res->ai_addr, res->ai_addrlen);
+	pNetw->addr_len = res->ai_addrlen;
+	freeaddrinfo(res);
+
+	/* Not kept for the next connection if the name is too long */
+	pNetw->addr_port = params->RemoteHostPort;
+	if (strlen(params->RemoteHostAddress) < sizeof(pNetw->addr_host)) {
+		strcpy(pNetw->addr_host, params->RemoteHostAddress);
+	}
+	else {
+		pNetw->addr_host[0] = 0;
+	}
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* The TCP connection failed: close the socket, and resolve the host name again at the next attempt */
+static int netw_tcpFailed(LiveObjectsNetCtx_t *pNetw, int err) {
+	LOTRACE_ERR("TCP connection failed, errno=%d", err);
+	f_netw_sock_close(&pNetw->net);
+	pNetw->tcp_wait = 0;
+	pNetw->addr_len = 0;
+	return NETW_CONN_ERR_TCP;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* The TCP connection is established: the socket is blocking again (the SSL/TLS handshake
+ * does not wait for the server when it is stepped, see netw_recvTimeout) */
+static int netw_tcpConnected(LiveObjectsNetCtx_t *pNetw) {
+	int fd = (int) pNetw->net.my_socket;
+	int flags = fcntl(fd, F_GETFL, 0);
+	if ((flags < 0) || (fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) < 0)) {
+		return netw_tcpFailed(pNetw, errno);
+	}
+	LOTRACE_INF("TCP connection: OK");
+	return 0;
+}
+
+/* --------------------------------------------------------------------------------- */
+/* Start the TCP connection on a non-blocking socket: return 0 (connected), NETW_CONN_WANT_WRITE
+ * (in progress), or NETW_CONN_ERR_xxx */
+static int netw_tcpStart(LiveObjectsNetCtx_t *pNetw, const LiveObjectsNetConnectParams_t* params) {
+	int flags;
+	int fd;
+	int ret;
+
+	ret = netw_resolve(pNetw, params);
+	if (ret) {
+		return ret;
+	}
+	fd = socket(pNetw->addr.ss_family, SOCK_STREAM, IPPROTO_TCP);
+	if (fd < 0) {
+		LOTRACE_ERR("Failed to create TCP socket, errno=%d", errno);
+		return NETW_CONN_ERR_TCP;
+	}
+	pNetw->net.my_socket = fd;
+
+	flags = fcntl(fd, F_GETFL, 0);
+	if ((flags < 0) || (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)) {
+		return netw_tcpFailed(pNetw, errno);
+	}
+	if (connect(fd, (struct sockaddr*) &pNetw->addr, pNetw->addr_len) == 0) {
+		return netw_tcpConnected(pNetw);
+	}
+	if ((errno == EINPROGRESS) || (errno == EINTR)) {
+		/* Writable when done */
+		pNetw->tcp_wait = 1;
+		return NETW_CONN_WANT_WRITE;
+	}
+	return netw_tcpFailed(pNetw, errno);
+}
+
+/* --------------------------------------------------------------------------------- */
+/* The socket of the TCP connection in progress is writable: result of the connection */
+static int netw_tcpStep(LiveObjectsNetCtx_t *pNetw) {
+	socklen_t len = sizeof(int);
+	int err = 0;
+	int ret;
+
+	pNetw->tcp_wait = 0;
+	if (getsockopt((int) pNetw->net.my_socket, SOL_SOCKET, SO_ERROR, &err, &len) < 0) {
+		err = errno;
+	}
+	if (err) {
+		return netw_tcpFailed(pNetw, err);
+	}
+	ret = netw_tcpConnected(pNetw);
+	if (ret) {
+		return ret;
+	}
+	return netw_tlsStart(pNetw, 1);
+}
+#endif /* LOC_FEATURE_EVLOOP */
 
-	f_netw_sock_setup(pNetwork);
+/* --------------------------------------------------------------------------------- */
+/*  */
+int netw_connectStep(LiveObjectsNetCtx_t *pNetw) {
+#if LOC_FEATURE_EVLOOP
+	if (pNetw->tcp_wait) {
+		return netw_tcpStep(pNetw);
+	}
+#endif
+	return netw_tlsStep(pNetw);
+}
 
+/* --------------------------------------------------------------------------------- */
+/*  */
+int netw_connectStart(LiveObjectsNetCtx_t *pNetw, const LiveObjectsNetConnectParams_t* params, uint8_t nonblock) {
+	int ret;
+	LOTRACE_INF("Connecting to server %s:%d tmo=%u ...", params->RemoteHostAddress, params->RemoteHostPort,
+			params->TimeoutMs);
+
+	if (f_netw_sock_isOpen(&pNetw->net)) {
+		netw_disconnect(pNetw, 0);
+	}
+#if LOC_FEATURE_MBEDTLS
+	pNetw->tls_run = 0;
+#endif
+#if LOC_FEATURE_EVLOOP
+	if (nonblock) {
+		ret = netw_tcpStart(pNetw, params);
+		return (ret) ? ret : netw_tlsStart(pNetw, nonblock);
+	}
+#endif
+	ret = f_netw_sock_connect(&pNetw->net, params->RemoteHostAddress, params->RemoteHostPort, params->TimeoutMs);
+	if (ret) {
+		if (ret == NETW_ERR_NET_UNKNOWN_HOST) {
+			LOTRACE_ERR("Failed to resolve %s", params->RemoteHostAddress);
+			return NETW_CONN_ERR_DNS;
+		}
+		LOTRACE_ERR("Failed to create TCP socket");
+		return NETW_CONN_ERR_TCP;
+	}
+	LOTRACE_INF("Connected to server %s:%d OK", params->RemoteHostAddress, params->RemoteHostPort);
+
+	return netw_tlsStart(pNetw, nonblock);
+}
+
+/* --------------------------------------------------------------------------------- */
+/*  */
+int netw_connect(LiveObjectsNetCtx_t *pNetw, const LiveObjectsNetConnectParams_t* params) {
+	int ret = netw_connectStart(pNetw, params, 0);
+	while ((ret == NETW_CONN_WANT_READ) || (ret == NETW_CONN_WANT_WRITE)) {
+		ret = netw_connectStep(pNetw);
+	}
 	return ret;
 }
 
 /* --------------------------------------------------------------------------------- */
 /*  */
-int netw_tls_destroy(Network *pNetwork) {
+int netw_tls_destroy(LiveObjectsNetCtx_t *pNetw) {
 #if LOC_FEATURE_MBEDTLS
-	mbedtls_x509_crt_free(&_netw_clicert);
-	mbedtls_x509_crt_free(&_netw_cacert);
-	mbedtls_pk_free(&_netw_pkey);
-	mbedtls_ssl_free(&_netw_ssl);
-	mbedtls_ssl_config_free(&_netw_conf);
-	mbedtls_ctr_drbg_free(&_netw_ctr_drbg);
-	mbedtls_entropy_free(&_netw_entropy);
+	netw_sessionClear(pNetw);
+	mbedtls_ssl_free(&pNetw->ssl);
+	mbedtls_ssl_init(&pNetw->ssl);
+	if (pNetw->profile) {
+		netw_profileRelease(pNetw->profile);
+		pNetw->profile = NULL;
+	}
+	pNetw->tls_enabled = 0;
+#else
+	(void) pNetw;
 #endif /* LOC_FEATURE_MBEDTLS */
 	return 0;
 }
@@ -14,10 +14,27 @@
 #ifndef __netw_wrapper_H_
 #define __netw_wrapper_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "liveobjects-client/LiveObjectsClient_Config.h"
 #include "liveobjects-client/LiveObjectsClient_Security.h"
 
 #include "liveobjects-sys/mqtt_network_interface.h"
 
+#if LOC_FEATURE_EVLOOP
+#include <sys/socket.h>
+#endif
+
+#if LOC_FEATURE_MBEDTLS
+#include "mbedtls/config.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#endif
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
@@ -28,15 +45,118 @@ typedef struct {
 	unsigned int TimeoutMs;
 } LiveObjectsNetConnectParams_t;
 
-unsigned char netw_isLost(Network *pNetwork);
+#if LOC_FEATURE_MBEDTLS
+/**
+ * @brief Security profile: parsed certificates and private key, SSL/TLS configuration and DRBG.
+ *
+ * Immutable once created, and shared (reference counted) by all the client instances
+ * using the same security parameters: each instance only has its own SSL/TLS context.
+ */
+typedef struct LiveObjectsNetTlsProfile {
+	struct LiveObjectsNetTlsProfile* next;
+	const LiveObjectsSecurityParams_t* params;  /*!< Security parameters of the profile */
+	uint32_t ref;                               /*!< Number of client instances using the profile */
+	bool ssl_verify;                            /*!< Verify the server certificate */
+	mbedtls_ssl_config conf;
+	mbedtls_entropy_context entropy;
+	mbedtls_ctr_drbg_context ctr_drbg;          /*!< Shared DRBG, used under NETW_MUTEX */
+	mbedtls_x509_crt cacert;
+	mbedtls_x509_crt clicert;
+	mbedtls_pk_context pkey;
+} LiveObjectsNetTlsProfile_t;
+#endif
+
+#if LOC_FEATURE_EVLOOP
+/* Max length of a host name whose resolved address is kept (non-blocking connection) */
+#define NETW_HOST_MAX    64
+#endif
+
+/**
+ * @brief Network context of one LiveObjects Client instance
+ *
+ * The MQTT client only knows the Network interface, so it must be the first member:
+ * the network callbacks get back this context from the Network pointer.
+ */
+typedef struct {
+	Network net;                        /*!< Network interface given to the MQTT client */
+	uint8_t tls_enabled;                /*!< SSL/TLS is configured on this network */
+#if LOC_NETW_RCV_BUF_SZ > 0
+	uint32_t rcv_pos;                   /*!< First byte not yet read in rcv_buf */
+	uint32_t rcv_len;                   /*!< Number of bytes in rcv_buf */
+	unsigned char rcv_buf[LOC_NETW_RCV_BUF_SZ]; /*!< Bytes received, not yet read by the MQTT client */
+#endif
+#if LOC_FEATURE_EVLOOP
+	uint8_t tcp_wait;                   /*!< Non-blocking TCP connection in progress */
+	uint16_t addr_port;                 /*!< Port of the resolved address */
+	socklen_t addr_len;                 /*!< Length of the resolved address, 0: not resolved */
+	struct sockaddr_storage addr;       /*!< Address of the server, resolved at the first connection */
+	char addr_host[NETW_HOST_MAX];      /*!< Host name of the resolved address */
+#endif
+#if LOC_FEATURE_MBEDTLS
+	uint8_t tls_run;                    /*!< SSL/TLS session is established */
+	uint32_t read_tmo;                  /*!< Read timeout (ms) of the SSL/TLS layer, 0: blocking */
+	unsigned char snd_buf[LOC_NETW_SND_BUF_SZ]; /*!< Vectored write: elements coalesced in one SSL/TLS record */
+#if LOC_FEATURE_EVLOOP
+	uint8_t nonblock;                   /*!< Stepped handshake: the SSL/TLS layer never waits for data */
+#endif
+	LiveObjectsNetTlsProfile_t* profile;/*!< Shared security profile (NULL: SSL/TLS not configured) */
+	mbedtls_ssl_context ssl;
+	mbedtls_ssl_session session;        /*!< Last negotiated session (ID or ticket), offered at the next connection */
+	uint8_t session_ok;                 /*!< session is saved */
+#endif
+} LiveObjectsNetCtx_t;
+
+unsigned char netw_isLost(LiveObjectsNetCtx_t *pNetw);
+
+/* Max number of elements written at once by netw_mqtt_writev() */
+#define NETW_IOV_MAX    8
+
+struct MQTTIoVec;
+
+/* Vectored write hook of the MQTT client (MQTTClient.mqttwritev, scatter-gather publish) */
+int netw_mqtt_writev(Network *pNetwork, struct MQTTIoVec *iov, int iovcnt, int timeout_ms);
+
+/* Number of received bytes already buffered (receive buffer and TLS layer, not visible on the socket) */
+int netw_pending(LiveObjectsNetCtx_t *pNetw);
+
+#if LOC_FEATURE_EVLOOP || LOC_FEATURE_WAKEUP
+/* File descriptor of the connected socket, or -1 */
+int netw_getFd(LiveObjectsNetCtx_t *pNetw);
+
+/* Return 1 if received bytes are buffered (see netw_pending) or readable on the socket, without waiting */
+int netw_readable(LiveObjectsNetCtx_t *pNetw);
+#endif
+
+int netw_init(LiveObjectsNetCtx_t *pNetw, void* net_iface_handler);
+
+int netw_setSecurity(LiveObjectsNetCtx_t *pNetw, const LiveObjectsSecurityParams_t* params);
+
+/* Errors of netw_connect() */
+#define NETW_CONN_ERR_TCP        -1     /* TCP connection failed (or network not ready) */
+#define NETW_CONN_ERR_DNS        -2     /* Host name not resolved */
+#define NETW_CONN_ERR_TLS        -3     /* SSL/TLS setup, handshake or certificate verification failed */
+
+/* Returns of netw_connectStart() and netw_connectStep(): the TCP connection or the SSL/TLS handshake
+ * is in progress, call netw_connectStep() when the socket (netw_getFd) is readable / writable */
+#define NETW_CONN_WANT_READ      1
+#define NETW_CONN_WANT_WRITE     2
+
+/* Connect (blocking), return 0 or NETW_CONN_ERR_xxx */
+int netw_connect(LiveObjectsNetCtx_t *pNetw, const LiveObjectsNetConnectParams_t* params);
 
-int netw_init(Network *pNetwork, void* net_iface_handler);
+/* Connect the socket (blocking, with the timeout of params) and start the SSL/TLS handshake.
+ * With 'nonblock' (LOC_FEATURE_EVLOOP), neither the TCP connection nor the handshake waits for the
+ * server. The host name is only resolved (blocking) at the first connection, or after a failure.
+ * Return 0 (connected), NETW_CONN_WANT_xxx, or NETW_CONN_ERR_xxx */
+int netw_connectStart(LiveObjectsNetCtx_t *pNetw, const LiveObjectsNetConnectParams_t* params, uint8_t nonblock);
 
-int netw_setSecurity(Network *pNetwork, const LiveObjectsSecurityParams_t* params);
+/* Continue the TCP connection or the SSL/TLS handshake, return 0 (connected), NETW_CONN_WANT_xxx,
+ * or NETW_CONN_ERR_xxx */
+int netw_connectStep(LiveObjectsNetCtx_t *pNetw);
 
-int netw_connect(Network *pNetwork, LiveObjectsNetConnectParams_t* params);
+void netw_disconnect(LiveObjectsNetCtx_t *pNetw, int cause);
 
-void netw_disconnect(Network *pNetwork, int cause);
+int netw_tls_destroy(LiveObjectsNetCtx_t *pNetw);
 
 int get_mac(char* iface, char* buf);
 
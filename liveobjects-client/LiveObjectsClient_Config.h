@@ -17,6 +17,14 @@
  * - LOC_FEATURE_LO_DATA      'Collected Data' feature.
  * - LOC_FEATURE_LO_COMMANDS  'Commands' feature.
  * - LOC_FEATURE_LO_RESOURCES 'Resources' feature.
+ * - LOC_FEATURE_EVLOOP       Event loop (epoll) to run many client instances in one thread (default: 1 on Linux, 0 otherwise)
+ * - LOC_FEATURE_WAKEUP       Wake up the client loop (eventfd) when a message is to be published,
+ *                            instead of polling every 100 ms (default: 1 on Linux, 0 otherwise)
+ * - LOC_FEATURE_CBOR         CBOR encoding of the 'status' and 'collected data' messages,
+ *                            selected per client instance (LiveObjectsClient_SetEncoding) (default: 0)
+ * - LOC_FEATURE_JOURNAL      Persistent journal (POSIX, mmap) of the messages published while disconnected,
+ *                            replayed after the reconnection (LiveObjectsClient_SetJournal) (default: 0)
+ * - LOC_FEATURE_LZ4          LZ4 compression (liblz4) of the sealed segments of the journal (default: 0)
  * And
  *  - LOC_MQTT_DUMP_MSG        Dump MQTT message - set to 1 = text only, 2 = hexa only, 3 = text+hexa
  *
@@ -27,14 +35,22 @@
  * - LOC_MQTT_DEF_COMMAND_TIMEOUT  Timeout in milliseconds to wait for a MQTT ACK/NACK response after sending MQTT request
  * - LOC_MQTT_DEF_SND_SZ  Size(in bytes) of static MQTT buffer used to send a MQTT message (default: 2 K bytes)
  * - LOC_MQTT_DEF_RCV_SZ  Size(in bytes) of static MQTT buffer used to receive a MQTT message (default: 2 K bytes)
+ * - LOC_NETW_RCV_BUF_SZ  Size(in bytes) of the network receive buffer of a client instance, 0 to read the network
+ *                        for each read of the MQTT client (default: 1 K bytes)
+ * - LOC_NETW_SND_BUF_SZ  Size(in bytes) of the buffer used to send the header and the beginning of the payload
+ *                        of a message in one SSL/TLS record (default: 512 bytes)
  * - LOC_MQTT_DEF_TOPIC_NAME_SZ  Max Size(in bytes) of MQTT Topic name (default: 40 bytes)
  * - LOC_MQTT_DEF_DEV_ID_SZ  Max Size(in bytes) of Device Identifier (default: 20 bytes)
  * - LOC_MQTT_DEF_NAME_SPACE_SZ  Max Size(in bytes) o Name Space (default: 20 bytes)
  * - LOC_MQTT_DEF_PENDING_MSG_MAX  Max Number of pending MQTT Publish messages (default: 5 messages)
+ *                                 Default size of the queue, can be changed by LiveObjectsClient_SetQueue()
+ * - LOC_MQTT_INFLIGHT boolean to enable the QoS 1 publication with a pipelined in-flight window
+ *                     (LiveObjectsClient_SetPublishWindow) (default: 0)
+ * - LOC_MQTT_COALESCE boolean to send the pending QoS 0 messages back-to-back, coalesced in the MQTT send buffer,
+ *                     in one write (one SSL/TLS record) (default: 1). Not used when the in-flight window is enabled.
  * - LOC_MAX_OF_COMMAND_ARGS  Max Number of arguments in command (default: 5 arguments)
  * - LOC_MAX_OF_DATA_SET  Max Number of collected data streams (or also named 'data sets')  (default: 5 data streams)
  * - LOC_MAX_OF_STATUS_SET  Max Number of status/info sets (default: 1 status set)
- * - LOC_MAX_OF_PARSED_PARAMS Max Number of parsed parameters in a same received update param request (default: 5)
  * - LOM_JSON_BUF_SZ  Size (in bytes) of static JSON buffer used to encode the JSON payload to be sent (default: 1 K bytes)
  * - LOM_JSON_BUF_USER_SZ  Size (in bytes) of static JSON buffer used to encode a user JSON payload (default: 200 bytes)
  *
@@ -42,9 +58,39 @@
  * - LOM_SETOFDATA_STREAM_ID_SZ Max Size(in bytes) of Data Stream Id (default: 80 bytes)
  * - LOM_SETOFDATA_MODEL_SZ Max Size(in bytes) of Data Model field (default: 80 bytes). It can be set to 0 : disabled.
  * - LOM_SETOFDATA_TAGS_SZ Max Size(in bytes) of Data Tag field (default: 80 bytes). It can be set to 0 : disabled.
+ * - LOM_SETOFDATA_TPL_SZ Size (in bytes) of the precompiled JSON template of a Data Set (default: 256 bytes).
+ *                         It can be set to 0 : disabled.
  *
  * - LOM_PUSH_ASYNC boolean to enable or not the asynchronous push call
+ * - LOM_STATUS_DELTA boolean to publish only the changed 'status' elements (default: 0 : disabled).
+ *                    The 'status' sets are then published by the LiveObjects Client thread (as with LOM_PUSH_ASYNC),
+ *                    and fully published on each (re)connection and every LOM_STATUS_DELTA_REFRESH publications.
+ * - LOM_STATUS_DELTA_REFRESH Number of delta publications of a 'status' set between two full publications
+ *                    (default: 10). It can be set to 0 : only on (re)connection.
+ * - LOM_STATUS_DELTA_NB Max number of tracked elements per 'status' set (default: 32), the next ones are always published.
+ * - LOM_DATA_BATCH boolean to enable the batching of 'collected data' samples (LiveObjectsClient_SetDataBatch) (default: 0)
+ * - LOM_NAME_INDEX_MIN Min number of attached configuration parameters or commands to look them up
+ *                    with a hash index instead of a linear search (default: 8)
  * - LOM_MQUEUE boolean to use or not a message queue to publish message between user application and iotsoftbox-mqtt library.
+ * - LOM_MQUEUE_LOCKFREE boolean to use a lock-free queue (atomic operations) instead of a mutex (default: 1 with gcc/clang)
+ * - LOM_MQUEUE_RING_SZ  Size (in bytes) of the ring where the queued messages are built, per client instance,
+ *                       for a queue of LOC_MQTT_DEF_PENDING_MSG_MAX messages (in proportion for a larger queue)
+ *                       (default: (LOC_MQTT_DEF_PENDING_MSG_MAX + 1) * (LOM_JSON_BUF_USER_SZ + 16) bytes)
+ * - LOC_CACHE_LINE_SZ  Size of a CPU cache line, used to avoid false sharing (default: 64 bytes)
+ *
+ * - LOC_EVLOOP_MAX_EVENTS  Max Number of epoll events processed in one wait (default: 64)
+ * - LOC_EVLOOP_TICK_MS  Period (in milliseconds) to check pending work of a connected instance
+ *                        when the wakeup is not available (default: 100 ms)
+ * - LOC_EVLOOP_CONNECT_BURST  Max Number of connection attempts in one loop iteration (default: 8)
+ * - LOC_EVLOOP_HANDSHAKE_MS  Max duration (in milliseconds) of the connection (TCP, SSL/TLS handshake, CONNACK) of a session (default: 60 seconds)
+ *
+ * - LOC_JOURNAL_REPLAY_BURST  Max Number of journal messages replayed in one cycle of the client (default: 32)
+ *
+ * - LOC_RECONNECT_FIRST_MS  Delay (in milliseconds) of the first connection attempt after the loss of a session (default: 0)
+ * - LOC_RECONNECT_BASE_MS  Base delay (in milliseconds) of the exponential backoff of the connection attempts (default: 1 second)
+ * - LOC_RECONNECT_CAP_MS  Max delay (in milliseconds) between two connection attempts (default: 60 seconds)
+ * - LOC_RECONNECT_REFUSED_MS  Min delay (in milliseconds) after a connection refused by the platform (default: 60 seconds)
+ * - LOC_RECONNECT_STABLE_MS  Min duration (in milliseconds) of a session to restart the backoff when it is lost (default: 30 seconds)
  *
  */
 
@@ -78,6 +124,34 @@
 #ifndef LOC_FEATURE_LO_RESOURCES
 #define LOC_FEATURE_LO_RESOURCES             1
 #endif
+#ifndef LOC_FEATURE_EVLOOP
+#if defined(__linux__)
+#define LOC_FEATURE_EVLOOP                   1
+#else
+#define LOC_FEATURE_EVLOOP                   0
+#endif
+#endif
+#ifndef LOC_FEATURE_WAKEUP
+#if defined(__linux__)
+#define LOC_FEATURE_WAKEUP                   1
+#else
+#define LOC_FEATURE_WAKEUP                   0
+#endif
+#endif
+#ifndef LOC_FEATURE_CBOR
+#define LOC_FEATURE_CBOR                     0
+#endif
+#ifndef LOC_FEATURE_JOURNAL
+#define LOC_FEATURE_JOURNAL                  0
+#endif
+#ifndef LOC_FEATURE_LZ4
+#define LOC_FEATURE_LZ4                      0
+#endif
+
+/** MQTT user name of a client instance using the CBOR encoding: the content mode of the connection */
+#ifndef LOC_MQTT_USER_NAME_CBOR
+#define LOC_MQTT_USER_NAME_CBOR              "cbor+device"
+#endif
 
 /** Connection Timeout in milliseconds */
 #ifndef LOC_SERV_TIMEOUT
@@ -101,6 +175,14 @@
 #define LOC_MQTT_DEF_RCV_SZ                  (1024*2)
 #endif
 
+#ifndef LOC_NETW_RCV_BUF_SZ
+#define LOC_NETW_RCV_BUF_SZ                  1024
+#endif
+
+#ifndef LOC_NETW_SND_BUF_SZ
+#define LOC_NETW_SND_BUF_SZ                  512
+#endif
+
 #ifndef LOC_MQTT_DEF_TOPIC_NAME_SZ
 #define LOC_MQTT_DEF_TOPIC_NAME_SZ           40
 #endif
@@ -117,6 +199,14 @@
 #define LOC_MQTT_DEF_PENDING_MSG_MAX         5
 #endif
 
+#ifndef LOC_MQTT_INFLIGHT
+#define LOC_MQTT_INFLIGHT                    0
+#endif
+
+#ifndef LOC_MQTT_COALESCE
+#define LOC_MQTT_COALESCE                    1
+#endif
+
 #ifndef LOC_MAX_OF_COMMAND_ARGS
 #define LOC_MAX_OF_COMMAND_ARGS              5
 #endif
@@ -129,11 +219,6 @@
 #define LOC_MAX_OF_STATUS_SET                1
 #endif
 
-#ifndef LOC_MAX_OF_PARSED_PARAMS
-#define LOC_MAX_OF_PARSED_PARAMS             5
-#endif
-
-
 #ifndef LOM_JSON_BUF_SZ
 #define LOM_JSON_BUF_SZ                      1024
 #endif
@@ -146,6 +231,24 @@
 #define LOM_PUSH_ASYNC                       0
 #endif
 
+#ifndef LOM_STATUS_DELTA
+#define LOM_STATUS_DELTA                     0
+#endif
+#ifndef LOM_STATUS_DELTA_REFRESH
+#define LOM_STATUS_DELTA_REFRESH             10
+#endif
+#ifndef LOM_STATUS_DELTA_NB
+#define LOM_STATUS_DELTA_NB                  32
+#endif
+
+#ifndef LOM_DATA_BATCH
+#define LOM_DATA_BATCH                       0
+#endif
+
+#ifndef LOM_NAME_INDEX_MIN
+#define LOM_NAME_INDEX_MIN                   8
+#endif
+
 #ifndef LOM_SETOFDATA_STREAM_ID_SZ
 #define LOM_SETOFDATA_STREAM_ID_SZ            80
 #endif
@@ -155,6 +258,9 @@
 #ifndef LOM_SETOFDATA_TAGS_SZ
 #define LOM_SETOFDATA_TAGS_SZ                 80
 #endif
+#ifndef LOM_SETOFDATA_TPL_SZ
+#define LOM_SETOFDATA_TPL_SZ                  256
+#endif
 
 
 #ifndef LOM_MQUEUE
@@ -165,4 +271,63 @@
 #endif
 #endif
 
+#ifndef LOM_MQUEUE_LOCKFREE
+#if defined(__GNUC__)
+#define LOM_MQUEUE_LOCKFREE                    1
+#else
+#define LOM_MQUEUE_LOCKFREE                    0
+#endif
+#endif
+
+#ifndef LOM_MQUEUE_RING_SZ
+#define LOM_MQUEUE_RING_SZ                     ((LOC_MQTT_DEF_PENDING_MSG_MAX + 1) * (LOM_JSON_BUF_USER_SZ + 16))
+#endif
+
+#ifndef LOC_CACHE_LINE_SZ
+#define LOC_CACHE_LINE_SZ                      64
+#endif
+
+/* Event loop parameters */
+#ifndef LOC_EVLOOP_MAX_EVENTS
+#define LOC_EVLOOP_MAX_EVENTS                64
+#endif
+
+#ifndef LOC_EVLOOP_TICK_MS
+#define LOC_EVLOOP_TICK_MS                   100
+#endif
+
+#ifndef LOC_EVLOOP_CONNECT_BURST
+#define LOC_EVLOOP_CONNECT_BURST             8
+#endif
+
+#ifndef LOC_EVLOOP_HANDSHAKE_MS
+#define LOC_EVLOOP_HANDSHAKE_MS              60000
+#endif
+
+/* Journal parameters */
+#ifndef LOC_JOURNAL_REPLAY_BURST
+#define LOC_JOURNAL_REPLAY_BURST             32
+#endif
+
+/* Reconnection parameters (default policy) */
+#ifndef LOC_RECONNECT_FIRST_MS
+#define LOC_RECONNECT_FIRST_MS               0
+#endif
+
+#ifndef LOC_RECONNECT_BASE_MS
+#define LOC_RECONNECT_BASE_MS                1000
+#endif
+
+#ifndef LOC_RECONNECT_CAP_MS
+#define LOC_RECONNECT_CAP_MS                 60000
+#endif
+
+#ifndef LOC_RECONNECT_REFUSED_MS
+#define LOC_RECONNECT_REFUSED_MS             60000
+#endif
+
+#ifndef LOC_RECONNECT_STABLE_MS
+#define LOC_RECONNECT_STABLE_MS              30000
+#endif
+
 #endif /* __LiveObjectsClient_Config_H_ */
@@ -34,6 +34,15 @@ typedef enum {
 	LOTRACE_LEVEL_MAX
 } lotrace_level_t;
 
+/**
+ * @brief Opaque context of one LiveObjects Client instance (device).
+ *
+ * The LiveObjectsClient_xxx() functions use a default instance.
+ * The LiveObjectsClient_xxxEx() functions work on a given instance,
+ * so that several devices can be managed in a same process.
+ */
+typedef struct LiveObjectsClient_Ctx LiveObjectsClient_Ctx;
+
 /* ================================================================== */
 /**
  * * \addtogroup Init  Initialization
@@ -59,7 +68,7 @@ int LiveObjectsClient_CheckApiKey(const char* apikey);
 void LiveObjectsClient_InitDbgTrace(lotrace_level_t level);
 
 /**
- * @brief Initialize the LiveObjects Client Instance (only one instance on board)
+ * @brief Initialize the default LiveObjects Client Instance
  *        This should always be called first.
  *
  * @return 0 if successful, otherwise a negative value when occur occurs.
@@ -116,6 +125,125 @@ int LiveObjectsClient_DnsResolve(void);
  */
 int LiveObjectsClient_DnsSetFQDN(const char* domain_name, const char* ip_address);
 
+/**
+ * @brief Set the size and the overflow policy of the queue of messages
+ *        to be published (messages built by the other threads).
+ *        This should be called after LiveObjectsClient_Init() and before the
+ *        LiveObjectsClient_Connect() function. Pending messages are released.
+ *
+ * @param size        Max number of messages in queue (default: LOC_MQTT_DEF_PENDING_MSG_MAX).
+ * @param policy      Policy applied when the queue is full (default: MQ_POLICY_REJECT).
+ * @param block_ms    With MQ_POLICY_BLOCK, max time (in milliseconds) to wait for a free place.
+ *
+ * @note Only available when LOM_MQUEUE is enabled.
+ * @note The message ring is sized with the queue (see LOM_MQUEUE_RING_SZ). When it is full, the same
+ *       policy is applied (and the high watermark callback is called if the message is refused).
+ *
+ * @return 0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_SetQueue(uint32_t size, LiveObjectsD_QueuePolicy_t policy, uint32_t block_ms);
+
+/**
+ * @brief Set the watermarks of the queue of messages to be published.
+ *        The user callback is called when the number of messages reaches the high watermark,
+ *        and then when it goes down to the low watermark.
+ *
+ * @param high        High watermark (<= queue size), 0 to disable.
+ * @param low         Low watermark (< high).
+ * @param callback    User callback function.
+ * @param user_ctx    User context given to the callback function.
+ *
+ * @return 0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_SetQueueWatermarks(uint32_t high, uint32_t low, LiveObjectsD_CallbackQueueLevel_t callback,
+		void* user_ctx);
+
+/**
+ * @brief Set the encoding of the 'status' and 'collected data' messages.
+ *        This should be called before the LiveObjectsClient_Connect() function:
+ *        the encoding is given to the server by the MQTT user name of the connection
+ *        ("json+device", or LOC_MQTT_USER_NAME_CBOR).
+ *
+ * @param encoding    LOD_ENCODING_JSON (default) or LOD_ENCODING_CBOR.
+ *
+ * @note LOD_ENCODING_CBOR is only available when LOC_FEATURE_CBOR is enabled,
+ *       and the server must accept this content mode.
+ * @note The other messages (configuration parameters, commands, resources) are always JSON.
+ *
+ * @return 0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_SetEncoding(LiveObjectsD_Encoding_t encoding);
+
+/**
+ * @brief Publish the messages with QoS 1 through an in-flight window:
+ *        up to 'window' messages are sent without waiting for their PUBACK.
+ *        The messages are kept until their PUBACK is received, and retransmitted
+ *        (with the DUP flag) after a reconnection.
+ *        This should be called before the LiveObjectsClient_Connect() function.
+ *
+ * @param window      Max number of unacknowledged messages, 0 to disable (messages published with QoS 0).
+ * @param max_bytes   Size (in bytes) of the buffer keeping the unacknowledged MQTT packets.
+ * @param callback    User callback function called when a message is acknowledged
+ *                    (status 0), or dropped (status -1), may be NULL.
+ * @param user_ctx    User context given to the callback function.
+ *
+ * @note Only available when LOC_MQTT_INFLIGHT is enabled.
+ * @note When the window is full, the publication waits for acknowledges
+ *       (max LOC_MQTT_DEF_COMMAND_TIMEOUT).
+ *
+ * @return 0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_SetPublishWindow(uint32_t window, uint32_t max_bytes, LiveObjectsD_CallbackPublished_t callback,
+		void* user_ctx);
+
+/**
+ * @brief Keep the messages published while disconnected in a persistent journal,
+ *        and replay them in order after the reconnection:
+ *        'collected data', user messages, and the messages still in the queue when the connection is lost.
+ *        The messages of a previous run found in the directory are also replayed.
+ *        This should be called before the LiveObjectsClient_Connect() function.
+ *
+ * @param dir          Directory of the journal (created if needed), NULL to disable the journal.
+ * @param segment_sz   Size (in bytes) of a journal segment (memory-mapped file), at least 1 K bytes.
+ * @param quota        Max size (in bytes) of the journal on disk (>= 2 segments).
+ *                     When reached, the oldest segment is removed (oldest messages dropped first).
+ * @param compress     1 to compress the full segments (LZ4).
+ * @param replay_rate  Max number of replayed messages per second, 0: no limit.
+ *
+ * @note Only available when LOC_FEATURE_JOURNAL is enabled (POSIX platforms), and the compression
+ *       when LOC_FEATURE_LZ4 is enabled.
+ * @note The messages are replayed with QoS 1 (through the window of LiveObjectsClient_SetPublishWindow if set),
+ *       and removed from the journal only when acknowledged: at least once, a message may be replayed again
+ *       after a loss of the connection or a crash.
+ *
+ * @return 0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_SetJournal(const char* dir, uint32_t segment_sz, uint64_t quota, uint8_t compress,
+		uint32_t replay_rate);
+
+/**
+ * @brief Set the policy of the delays between the connection attempts of the LiveObjects Client
+ *        (see LiveObjectsD_ReconnectPolicy_t): first retry after the loss of a stable session,
+ *        exponential backoff with jitter and cap, min delay after a refused connection.
+ *        This should be called before the LiveObjectsClient_Connect() function.
+ *
+ * @param policy  Reconnection policy, NULL to restore the default one (LOC_RECONNECT_xxx).
+ *
+ * @return 0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_SetReconnectPolicy(const LiveObjectsD_ReconnectPolicy_t* policy);
+
+/**
+ * @brief Get the class and the code of the error of the last connection attempt, the number of
+ *        failed attempts and the delay before the next one. To be called when the state
+ *        CSTATE_WAITING is notified.
+ *
+ * @param info  Returned reconnection state.
+ *
+ * @return 0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_GetReconnectInfo(LiveObjectsD_ReconnectInfo_t* info);
+
 /* @} group end : Init */
 
 /* ================================================================== */
@@ -152,6 +280,9 @@ void LiveObjectsClient_SetDbgMsgDump(uint16_t mode);
  * @param param_nb    Number of elements in this array.
  * @param callback    User callback function, called to check the parameter to be updated.
  *
+ * @note The parameter names are indexed (from LOM_NAME_INDEX_MIN parameters): they must not be
+ *       changed while the array is attached.
+ *
  * @return 0 if successful, otherwise a negative value when occur occurs.
  */
 int LiveObjectsClient_AttachCfgParams(const LiveObjectsD_Param_t* param_ptr,
@@ -200,6 +331,9 @@ int LiveObjectsClient_AttachData(uint8_t prefix, const char* stream_id,
  * @param cmd_nb      Number of elements in this array.
  * @param callback    User callback function, called when a command is received from LiveObjects server.
  *
+ * @note The command names are indexed (from LOM_NAME_INDEX_MIN commands): they must not be
+ *       changed while the array is attached.
+ *
  * @return an handle value >= 0  if successful, otherwise a negative value when occur occurs.
  */
 int LiveObjectsClient_AttachCommands(const LiveObjectsD_Command_t* cmd_ptr,
@@ -258,6 +392,27 @@ int LiveObjectsClient_RemoveData(int handle);
 int LiveObjectsClient_ChangeDataStreamId(uint8_t prefix, int handle,
 		const char* stream_id);
 
+/**
+ * @brief Enable/disable the batching of a collect data set.
+ *        Each LiveObjectsClient_PushData() then captures a timestamped sample (tbx_GetDateTimeStr)
+ *        in the batch buffer, and the samples are published together, in one network write,
+ *        when the max number of samples, the byte budget or the max latency is reached.
+ *        This should be called after LiveObjectsClient_AttachData() and before the
+ *        LiveObjectsClient_Connect() function.
+ *
+ * @param handle          Collected data handle (returned by LiveObjectsClient_AttachData)
+ * @param max_samples     Max number of samples in a batch (max 65535), 0 to disable the batching.
+ * @param max_bytes       Byte budget of a batch (MQTT packets of the samples).
+ * @param max_latency_ms  Max time (in milliseconds) between the capture of the first sample and the publication.
+ *
+ * @note Only available when LOM_DATA_BATCH is enabled. The samples are published with QoS0.
+ *       Two buffers of max_bytes are allocated.
+ *
+ * @return  0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_SetDataBatch(int handle, uint32_t max_samples, uint32_t max_bytes,
+		uint32_t max_latency_ms);
+
 /**
  * @brief Remove a set of user commands
  *
@@ -267,6 +422,21 @@ int LiveObjectsClient_ChangeDataStreamId(uint8_t prefix, int handle,
  */
 int LiveObjectsClient_RemoveCommands(void);
 
+/**
+ * @brief Get the value of a command argument received as a JSON number
+ *        (to be called from the command callback).
+ *
+ * @param arg     Pointer to a command argument (args_array of the command request block)
+ * @param value   Pointer to the value to be set
+ *
+ * @return  0 if successful, otherwise a negative value (not a number, not an integer or out of range).
+ */
+int LiveObjectsClient_GetCommandArgInt32(const LiveObjectsD_CommandArg_t* arg, int32_t* value);
+
+int LiveObjectsClient_GetCommandArgUInt32(const LiveObjectsD_CommandArg_t* arg, uint32_t* value);
+
+int LiveObjectsClient_GetCommandArgDouble(const LiveObjectsD_CommandArg_t* arg, double* value);
+
 /**
  * @brief Remove a set of user resources
  *
@@ -360,6 +530,9 @@ int LiveObjectsClient_Yield(int timeout_ms);
  * - processing all pending message to be sent
  * - and then calling LiveObjectsClient_Yield
  *
+ * @note With LOC_FEATURE_WAKEUP, the wait ends as soon as a message is put
+ *       to be published by another thread.
+ *
  * @param timeout_ms   Time in milliseconds to wait for message sent/published by LiveObjects platform
  *
  * @return 0 if successful, otherwise a negative value when occur occurs.
@@ -381,6 +554,9 @@ int LiveObjectsClient_Cycle(int timeout_ms);
 /**
  * @brief Request to publish one set of 'status' to LiveObjects server.
  *
+ * @note With LOM_STATUS_DELTA, only the elements changed since the last publication
+ *       are published (by the LiveObjects Client thread).
+ *
  * @param handle      Handle of user status set
  *
  * @return 0 if successful, otherwise a negative value when occur occurs.
@@ -457,8 +633,159 @@ int LiveObjectsClient_CommandResponse(int32_t cid,
  */
 int LiveObjectsClient_Publish(const char* topic_name, const char* payload_data);
 
+/**
+ * @brief Publish a binary payload onto the topic toward a LiveObjects platform.
+ *        The payload length is given (no strlen), the payload can contain any byte.
+ *        Called by the LiveObjects Client thread, the message is published immediately,
+ *        otherwise it is put in the queue of messages.
+ *
+ * @param topic_name   Pointer to a c-string specifying the MQTT topic.
+ * @param payload_ptr  Pointer to the payload.
+ * @param payload_len  Length (in bytes) of the payload.
+ * @param qos          MQTT QoS: 0 or 1
+ *
+ * @return 0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_PublishBin(const char* topic_name, const void* payload_ptr, uint32_t payload_len,
+		uint8_t qos);
+
 /* @} group end : Async */
 
+/* ================================================================== */
+/**
+ * \addtogroup  MultiInstance  Multi-instance Operations
+ *
+ * This section describes functions to manage several LiveObjects Client instances
+ * (i.e. several devices) in a same process.
+ * Each LiveObjectsClient_xxxEx() function does the same as LiveObjectsClient_xxx(),
+ * but on the given client instance.
+ *
+ * @note A client instance must be processed (LiveObjectsClient_RunEx or
+ *       LiveObjectsClient_CycleEx) by only one thread.
+ * @note Only one resource download is done at a time: other instances wait for it.
+ * @{
+ */
+
+/**
+ * @brief Create a new LiveObjects Client instance.
+ *        Then LiveObjectsClient_InitEx() must be called.
+ *
+ * @return Pointer to the new client instance, or NULL if error.
+ */
+LiveObjectsClient_Ctx* LiveObjectsClient_CtxCreate(void);
+
+/**
+ * @brief Destroy a LiveObjects Client instance created by LiveObjectsClient_CtxCreate().
+ *        The device is disconnected if necessary. The instance must not be running.
+ *
+ * @param ctx         Client instance.
+ *
+ * @return 0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_CtxDestroy(LiveObjectsClient_Ctx* ctx);
+
+/**
+ * @brief Return the default LiveObjects Client instance,
+ *        used by the LiveObjectsClient_xxx() functions.
+ *
+ * @return Pointer to the default client instance.
+ */
+LiveObjectsClient_Ctx* LiveObjectsClient_CtxDefault(void);
+
+int LiveObjectsClient_InitEx(LiveObjectsClient_Ctx* ctx, void* network_itf_handle,
+		unsigned long long apikey_p1, unsigned long long apikey_p2);
+
+int LiveObjectsClient_SetDevIdEx(LiveObjectsClient_Ctx* ctx, const char* dev_id);
+
+int LiveObjectsClient_SetNameSpaceEx(LiveObjectsClient_Ctx* ctx, const char* name_space);
+
+int LiveObjectsClient_SetQueueEx(LiveObjectsClient_Ctx* ctx, uint32_t size, LiveObjectsD_QueuePolicy_t policy,
+		uint32_t block_ms);
+
+int LiveObjectsClient_SetQueueWatermarksEx(LiveObjectsClient_Ctx* ctx, uint32_t high, uint32_t low,
+		LiveObjectsD_CallbackQueueLevel_t callback, void* user_ctx);
+
+int LiveObjectsClient_SetEncodingEx(LiveObjectsClient_Ctx* ctx, LiveObjectsD_Encoding_t encoding);
+
+int LiveObjectsClient_SetPublishWindowEx(LiveObjectsClient_Ctx* ctx, uint32_t window, uint32_t max_bytes,
+		LiveObjectsD_CallbackPublished_t callback, void* user_ctx);
+
+int LiveObjectsClient_SetJournalEx(LiveObjectsClient_Ctx* ctx, const char* dir, uint32_t segment_sz, uint64_t quota,
+		uint8_t compress, uint32_t replay_rate);
+
+int LiveObjectsClient_SetReconnectPolicyEx(LiveObjectsClient_Ctx* ctx, const LiveObjectsD_ReconnectPolicy_t* policy);
+
+int LiveObjectsClient_GetReconnectInfoEx(LiveObjectsClient_Ctx* ctx, LiveObjectsD_ReconnectInfo_t* info);
+
+int LiveObjectsClient_AttachCfgParamsEx(LiveObjectsClient_Ctx* ctx, const LiveObjectsD_Param_t* param_ptr,
+		int32_t param_nb, LiveObjectsD_CallbackParams_t callback);
+
+int LiveObjectsClient_AttachStatusEx(LiveObjectsClient_Ctx* ctx, const LiveObjectsD_Data_t* status_ptr,
+		int32_t status_nb);
+
+int LiveObjectsClient_AttachDataEx(LiveObjectsClient_Ctx* ctx, uint8_t prefix, const char* stream_id,
+		const char* model, const char* tags,
+		const LiveObjectsD_GpsFix_t* gps_ptr,
+		const LiveObjectsD_Data_t* data_ptr, int32_t data_nb);
+
+int LiveObjectsClient_AttachCommandsEx(LiveObjectsClient_Ctx* ctx, const LiveObjectsD_Command_t* cmd_ptr,
+		int32_t cmd_nb, LiveObjectsD_CallbackCommand_t callback);
+
+int LiveObjectsClient_AttachResourcesEx(LiveObjectsClient_Ctx* ctx, const LiveObjectsD_Resource_t* rsc_ptr,
+		int32_t rsc_nb, LiveObjectsD_CallbackResourceNotify_t ntfyCB,
+		LiveObjectsD_CallbackResourceData_t dataCB);
+
+int LiveObjectsClient_ControlCommandsEx(LiveObjectsClient_Ctx* ctx, bool enable);
+
+int LiveObjectsClient_ControlResourcesEx(LiveObjectsClient_Ctx* ctx, bool enable);
+
+int LiveObjectsClient_RemoveDataEx(LiveObjectsClient_Ctx* ctx, int handle);
+
+int LiveObjectsClient_ChangeDataStreamIdEx(LiveObjectsClient_Ctx* ctx, uint8_t prefix, int handle,
+		const char* stream_id);
+
+int LiveObjectsClient_SetDataBatchEx(LiveObjectsClient_Ctx* ctx, int handle, uint32_t max_samples,
+		uint32_t max_bytes, uint32_t max_latency_ms);
+
+int LiveObjectsClient_RemoveCommandsEx(LiveObjectsClient_Ctx* ctx);
+
+int LiveObjectsClient_RemoveResourcesEx(LiveObjectsClient_Ctx* ctx);
+
+int8_t LiveObjectsClient_ThreadStateEx(LiveObjectsClient_Ctx* ctx);
+
+void LiveObjectsClient_RunEx(LiveObjectsClient_Ctx* ctx, LiveObjectsD_CallbackState_t callback);
+
+int LiveObjectsClient_StopEx(LiveObjectsClient_Ctx* ctx);
+
+int LiveObjectsClient_ConnectEx(LiveObjectsClient_Ctx* ctx);
+
+int LiveObjectsClient_DisconnectEx(LiveObjectsClient_Ctx* ctx);
+
+int LiveObjectsClient_YieldEx(LiveObjectsClient_Ctx* ctx, int timeout_ms);
+
+int LiveObjectsClient_CycleEx(LiveObjectsClient_Ctx* ctx, int timeout_ms);
+
+int LiveObjectsClient_PushStatusEx(LiveObjectsClient_Ctx* ctx, int handle);
+
+int LiveObjectsClient_PushDataEx(LiveObjectsClient_Ctx* ctx, int handle);
+
+int LiveObjectsClient_PushCfgParamsEx(LiveObjectsClient_Ctx* ctx);
+
+int LiveObjectsClient_PushResourcesEx(LiveObjectsClient_Ctx* ctx);
+
+int LiveObjectsClient_RscGetChunckEx(LiveObjectsClient_Ctx* ctx, const LiveObjectsD_Resource_t* rsc_ptr,
+		char* data_ptr, int data_len);
+
+int LiveObjectsClient_CommandResponseEx(LiveObjectsClient_Ctx* ctx, int32_t cid,
+	const LiveObjectsD_Data_t* data_ptr, int data_nb);
+
+int LiveObjectsClient_PublishEx(LiveObjectsClient_Ctx* ctx, const char* topic_name, const char* payload_data);
+
+int LiveObjectsClient_PublishBinEx(LiveObjectsClient_Ctx* ctx, const char* topic_name,
+		const void* payload_ptr, uint32_t payload_len, uint8_t qos);
+
+/* @} group end : MultiInstance */
+
 #if defined(__cplusplus)
 }
 #endif
@@ -139,7 +139,8 @@ typedef enum {
 	CSTATE_DISCONNECTED = 0,  /*!< Client is disconnected to the  LiveObjects platform */
 	CSTATE_CONNECTING,        /*!< Client is trying to establish a connection to the LiveObjects platform */
 	CSTATE_CONNECTED,         /*!< Client is connected to the  LiveObjects platform */
-	CSTATE_DOWN               /*!< Client Thread is down or stopped */
+	CSTATE_DOWN,              /*!< Client Thread is down or stopped */
+	CSTATE_WAITING            /*!< Client is waiting before the next connection attempt (see LiveObjectsClient_GetReconnectInfo) */
 } LiveObjectsD_State_t;
 
 /**
@@ -149,6 +150,93 @@ typedef enum {
  */
 typedef void (*LiveObjectsD_CallbackState_t)(LiveObjectsD_State_t state);
 
+/**
+ * @brief  Class of the error of the last connection attempt (or of the end of the last session)
+ */
+typedef enum {
+	LOD_CONN_ERR_NONE = 0,  /*!< No error (connected) */
+	LOD_CONN_ERR_DNS,       /*!< Host name of the LiveObjects platform not resolved */
+	LOD_CONN_ERR_TCP,       /*!< TCP connection failed */
+	LOD_CONN_ERR_TLS,       /*!< SSL/TLS handshake or certificate verification failed */
+	LOD_CONN_ERR_MQTT,      /*!< No (or bad) CONNACK, or server unavailable */
+	LOD_CONN_ERR_REFUSED,   /*!< Connection refused by the LiveObjects platform (bad identifier or api key, not authorized) */
+	LOD_CONN_ERR_LOST       /*!< The established session has been lost (or closed) */
+} LiveObjectsD_ConnError_t;
+
+/**
+ * @brief  Policy of the delays between the connection attempts.
+ *
+ * The first attempt after the loss of a session which stayed up at least 'stable_ms' is done
+ * after 'first_ms', and the backoff restarts. Otherwise (including the loss of a shorter session)
+ * the delay before the attempt n is a random value in [0, min(cap_ms, base_ms * 2^(n-1))] (full
+ * jitter), so that the devices disconnected at the same time don't reconnect at the same time.
+ * After a refusal of the LiveObjects platform (which will not change by itself), the delay
+ * is at least 'refused_ms'. After a SSL/TLS error, the delay is at least 'base_ms'.
+ */
+typedef struct {
+	uint32_t first_ms;    /*!< Delay of the first attempt after the loss of a session (0: immediate) */
+	uint32_t base_ms;     /*!< Base of the exponential backoff */
+	uint32_t cap_ms;      /*!< Max delay */
+	uint32_t refused_ms;  /*!< Min delay after a refused connection */
+	uint32_t stable_ms;   /*!< Min duration of a session to restart the backoff when it is lost */
+} LiveObjectsD_ReconnectPolicy_t;
+
+/**
+ * @brief  State of the reconnection: error of the last attempt and delay before the next one.
+ */
+typedef struct {
+	LiveObjectsD_ConnError_t error;  /*!< Class of the last error */
+	int rc;                          /*!< Error code (network error, or CONNACK return code) */
+	uint32_t attempt;                /*!< Number of failed attempts (or short sessions) since the last stable session */
+	uint32_t delay_ms;               /*!< Delay before the next attempt */
+} LiveObjectsD_ReconnectInfo_t;
+
+/**
+ * @brief  Policy applied when the queue of messages to be published is full
+ */
+typedef enum {
+	MQ_POLICY_REJECT = 0,   /*!< The new message is refused: the publish function returns an error (default) */
+	MQ_POLICY_DROP_NEWEST,  /*!< The new message is dropped, the publish function returns OK */
+	MQ_POLICY_DROP_OLDEST,  /*!< The oldest message in queue is dropped to put the new one */
+	MQ_POLICY_BLOCK         /*!< Wait (with a timeout) for a free place. Never in the LiveObjects Client thread. */
+} LiveObjectsD_QueuePolicy_t;
+
+/**
+ * @brief  Prototype of a user callback function called when a message published with QoS 1
+ *         (in-flight window) is acknowledged by the LiveObjects platform, or dropped.
+ *
+ * @note Called by the LiveObjects Client thread: it must not block.
+ *
+ * @param topic        Topic of the message
+ * @param payload      Payload of the message
+ * @param payload_len  Length of the payload
+ * @param status       0: acknowledged, -1: dropped (window disabled or client instance destroyed)
+ * @param user_ctx     User context
+ */
+typedef void (*LiveObjectsD_CallbackPublished_t)(const char* topic, const void* payload, uint32_t payload_len,
+		int status, void* user_ctx);
+
+/**
+ * @brief  Encoding of the 'status' and 'collected data' messages published by a client instance
+ */
+typedef enum {
+	LOD_ENCODING_JSON = 0,  /*!< JSON (default) */
+	LOD_ENCODING_CBOR       /*!< CBOR (RFC 7049), same structure as the JSON messages. Needs LOC_FEATURE_CBOR. */
+} LiveObjectsD_Encoding_t;
+
+/**
+ * @brief  Prototype of a user callback function called when the number of messages in queue
+ *         reaches the high watermark (producers should slow down), and then when it goes down
+ *         to the low watermark.
+ *
+ * @note Called by the producer thread (high) or by the LiveObjects Client thread (low).
+ *
+ * @param high      1: high watermark is reached, 0: low watermark is reached
+ * @param count     Number of messages in queue
+ * @param user_ctx  User context
+ */
+typedef void (*LiveObjectsD_CallbackQueueLevel_t)(uint8_t high, uint32_t count, void* user_ctx);
+
 /**
  * @brief  Type of a user callback function linked to a set of configuration parameters.
  *         This function will be called when user configuration parameter must be
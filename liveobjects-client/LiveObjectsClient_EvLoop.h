@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2016 Orange
+ *
+ * This software is distributed under the terms and conditions of the 'BSD-3-Clause'
+ * license which can be found in the file 'LICENSE.txt' in this package distribution
+ * or at 'https://opensource.org/licenses/BSD-3-Clause'.
+ */
+
+/**
+ * @file  LiveObjectsClient_EvLoop.h
+ * @brief Live Objects Client Interface : event loop to run several client instances in one thread
+ *
+ * @note Only available when LOC_FEATURE_EVLOOP is enabled (linux, epoll).
+ */
+
+#ifndef __LiveObjectsClient_EvLoop_H_
+#define __LiveObjectsClient_EvLoop_H_
+
+#include <stdint.h>
+
+#include "liveobjects-client/LiveObjectsClient_Config.h"
+#include "liveobjects-client/LiveObjectsClient_Core.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#if LOC_FEATURE_EVLOOP
+
+/**
+ * @brief Opaque context of an event loop.
+ */
+typedef struct LiveObjectsClient_EvLoop LiveObjectsClient_EvLoop;
+
+/**
+ * @brief  Prototype of a user callback function called to notify the state changes
+ *         of a client instance managed by an event loop.
+ *
+ * @param ctx       Client instance
+ * @param state     LiveObjects Client State
+ * @param user_ctx  User context given to LiveObjectsClient_EvLoopAdd()
+ */
+typedef void (*LiveObjectsClient_EvCallback_t)(LiveObjectsClient_Ctx* ctx, LiveObjectsD_State_t state,
+		void* user_ctx);
+
+/* ================================================================== */
+/**
+ * * \addtogroup EvLoop  Event Loop Operations
+ *
+ * This section describes functions to run several LiveObjects Client instances
+ * in one thread, instead of one LiveObjectsClient_RunEx() thread per instance.
+ * The loop waits (epoll) for the sockets of all the instances and for the
+ * nearest timer (keepalive, reconnection), and for the wakeup of an instance
+ * when a message is to be published by another thread.
+ *
+ * @note The client instances must be initialized (LiveObjectsClient_InitEx, ...)
+ *       before being added. They are connected by the loop: the TCP connections, SSL/TLS
+ *       handshakes and MQTT CONNACK of the instances proceed concurrently (max
+ *       LOC_EVLOOP_HANDSHAKE_MS each).
+ * @note LiveObjectsClient_EvLoopAdd() and LiveObjectsClient_EvLoopRemove() must be called
+ *       from the loop thread (i.e. in a state callback) or when the loop is not running.
+ * @{
+ */
+
+/**
+ * @brief Create an event loop.
+ *
+ * @return Pointer to the new event loop, or NULL if error.
+ */
+LiveObjectsClient_EvLoop* LiveObjectsClient_EvLoopCreate(void);
+
+/**
+ * @brief Destroy an event loop. The loop must not be running.
+ *        The client instances still attached are disconnected (not destroyed).
+ *
+ * @param loop        Event loop.
+ */
+void LiveObjectsClient_EvLoopDestroy(LiveObjectsClient_EvLoop* loop);
+
+/**
+ * @brief Add a client instance to the event loop.
+ *
+ * @param loop        Event loop.
+ * @param ctx         Client instance (not already managed by a loop or a thread).
+ * @param callback    Optional, user callback function called on state changes.
+ * @param user_ctx    User context given to the callback function.
+ *
+ * @return 0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_EvLoopAdd(LiveObjectsClient_EvLoop* loop, LiveObjectsClient_Ctx* ctx,
+		LiveObjectsClient_EvCallback_t callback, void* user_ctx);
+
+/**
+ * @brief Remove a client instance from the event loop.
+ *        The client instance is disconnected.
+ *
+ * @param loop        Event loop.
+ * @param ctx         Client instance.
+ *
+ * @return 0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_EvLoopRemove(LiveObjectsClient_EvLoop* loop, LiveObjectsClient_Ctx* ctx);
+
+/**
+ * @brief Run the event loop in the current thread,
+ *        until LiveObjectsClient_EvLoopStop() is called.
+ *
+ * @param loop        Event loop.
+ *
+ * @return 0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_EvLoopRun(LiveObjectsClient_EvLoop* loop);
+
+/**
+ * @brief Request to stop the event loop (can be called from any thread).
+ *        The loop is woken up (LOC_FEATURE_WAKEUP), otherwise it is stopped
+ *        within LOC_EVLOOP_TICK_MS milliseconds.
+ *
+ * @param loop        Event loop.
+ *
+ * @return 0 if successful, otherwise a negative value when occur occurs.
+ */
+int LiveObjectsClient_EvLoopStop(LiveObjectsClient_EvLoop* loop);
+
+/* @} group end : EvLoop */
+
+#endif /* LOC_FEATURE_EVLOOP */
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __LiveObjectsClient_EvLoop_H_ */
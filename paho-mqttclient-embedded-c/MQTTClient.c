@@ -19,19 +19,28 @@
  *   - Disable Timer to send MQTT Packet
  *   - Add a few traces
  *   - Patch in MQTTSubscribe function to define qos as integer
+ *   - Give the MQTT client in MessageData (several clients in a same process)
+ *   - Add MQTTKeepalive() to send a PINGREQ without reading the network (event loop)
+ *   - Add MQTTPublishBegin()/MQTTPublishEnd() to build the payload in place in the send buffer
+ *   - Add MQTTPublishPackets() to send a batch of QoS0 PUBLISH packets in one write
+ *   - Add a PUBACK handler and MQTTGetNextPacketId() (QoS1 in-flight window of the caller)
+ *   - Add a vectored write hook (mqttwritev) and MQTTPublishVec() (scatter-gather publish)
  * Note: keep the source code as it (dont't suppress /replace tab, end space, ..)
  */
 
 #include "paho-mqttclient-embedded-c/MQTTClient.h"
 
+#include <string.h> //OAB: strlen, memcpy (zero-copy publish)
+
 // LiveObjects Client: Add some logs  (search pattern LOTRACE_ ) ...
 #include "liveobjects-sys/loc_trace.h"
 
 
 
-static void NewMessageData(MessageData* md, MQTTString* aTopicName, MQTTMessage* aMessage) {
+static void NewMessageData(MessageData* md, MQTTClient* c, MQTTString* aTopicName, MQTTMessage* aMessage) {
     md->topicName = aTopicName;
     md->message = aMessage;
+    md->client = c; //OAB: give the client to the message handler
 }
 
 
@@ -40,14 +49,22 @@ static int getNextPacketId(MQTTClient *c) {
 }
 
 
-static int sendPacket(MQTTClient* c, int length, Timer* timer)
+//OAB: packet id of a QoS1 PUBLISH packet serialized by the caller (in-flight window)
+int MQTTGetNextPacketId(MQTTClient* c)
+{
+    return getNextPacketId(c);
+}
+
+
+//OAB: send packets from any buffer (zero-copy publish, batch of publish packets)
+static int sendBuffer(MQTTClient* c, unsigned char* buf, int length, Timer* timer)
 {
     int rc = FAILURE, 
         sent = 0;
     
     while (sent < length ) // && !TimerIsExpired(timer)) //OAB: Disable timer to send a packet.
     {
-        rc = c->ipstack->mqttwrite(c->ipstack, &c->buf[sent], length, TimerLeftMS(timer));
+        rc = c->ipstack->mqttwrite(c->ipstack, &buf[sent], length - sent, TimerLeftMS(timer)); //OAB: length - sent
         if (rc < 0)  // there was an error writing the data
             break;
         sent += rc;
@@ -63,6 +80,59 @@ static int sendPacket(MQTTClient* c, int length, Timer* timer)
 }
 
 
+//OAB: send a packet starting at an offset in the send buffer (zero-copy publish)
+static int sendPacketAt(MQTTClient* c, int offset, int length, Timer* timer)
+{
+    return sendBuffer(c, &c->buf[offset], length, timer);
+}
+
+
+static int sendPacket(MQTTClient* c, int length, Timer* timer)
+{
+    return sendPacketAt(c, 0, length, timer);
+}
+
+
+//OAB: send the elements of an iovec (scatter-gather publish), with the vectored write hook if any
+static int sendVector(MQTTClient* c, MQTTIoVec* iov, int iovcnt, Timer* timer)
+{
+    int rc = FAILURE;
+
+    while (iovcnt > 0 && iov->len == 0)
+    {
+        iov++;
+        iovcnt--;
+    }
+    while (iovcnt > 0)
+    {
+        if (c->mqttwritev == NULL)
+        {
+            if ((rc = sendBuffer(c, (unsigned char*)iov->base, iov->len, timer)) != SUCCESS)
+                return rc;
+            iov++;
+            iovcnt--;
+            continue;
+        }
+        rc = c->mqttwritev(c->ipstack, iov, iovcnt, TimerLeftMS(timer));
+        if (rc < 0)  // there was an error writing the data
+            return FAILURE;
+        while (iovcnt > 0 && rc >= iov->len) // skip the elements written, then the part written of the next one
+        {
+            rc -= iov->len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0)
+        {
+            iov->base += rc;
+            iov->len -= rc;
+        }
+    }
+    TimerCountdown(&c->ping_timer, c->keepAliveInterval); // record the fact that we have successfully sent the packet
+    return SUCCESS;
+}
+
+
 void MQTTClientInit(MQTTClient* c, Network* network, unsigned int command_timeout_ms,
 		unsigned char* sendbuf, size_t sendbuf_size, unsigned char* readbuf, size_t readbuf_size)
 {
@@ -79,6 +149,8 @@ void MQTTClientInit(MQTTClient* c, Network* network, unsigned int command_timeou
     c->isconnected = 0;
     c->ping_outstanding = 0;
     c->defaultMessageHandler = NULL;
+    c->pubackHandler = NULL; //OAB
+    c->mqttwritev = NULL; //OAB
 	c->next_packetid = 1;
     TimerInit(&c->ping_timer);
 #if defined(MQTT_TASK)
@@ -189,7 +261,7 @@ int deliverMessage(MQTTClient* c, MQTTString* topicName, MQTTMessage* message)
             if (c->messageHandlers[i].fp != NULL)
             {
                 MessageData md;
-                NewMessageData(&md, topicName, message);
+                NewMessageData(&md, c, topicName, message);
                 c->messageHandlers[i].fp(&md);
                 rc = SUCCESS;
             }
@@ -199,7 +271,7 @@ int deliverMessage(MQTTClient* c, MQTTString* topicName, MQTTMessage* message)
     if (rc == FAILURE && c->defaultMessageHandler != NULL) 
     {
         MessageData md;
-        NewMessageData(&md, topicName, message);
+        NewMessageData(&md, c, topicName, message);
         c->defaultMessageHandler(&md);
         rc = SUCCESS;
     }   
@@ -249,8 +321,17 @@ int cycle(MQTTClient* c, Timer* timer)
 
     switch (packet_type)
     {
-        case CONNACK:
         case PUBACK:
+            if (c->pubackHandler) //OAB: acknowledge of a QoS1 message of the in-flight window
+            {
+                unsigned short mypacketid;
+                unsigned char dup, type;
+                if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) == 1)
+                    c->pubackHandler(c, mypacketid);
+            }
+            LOTRACE_DBG1("cycle: PUBACK packet_type=%d x%x", packet_type, packet_type);
+            break;
+        case CONNACK:
         case SUBACK:
             LOTRACE_DBG1("cycle: xxxACK packet_type=%d x%x", packet_type, packet_type);
             break;
@@ -330,6 +411,27 @@ int MQTTYield(MQTTClient* c, int timeout_ms)
 }
 
 
+//OAB: keepalive without reading the network (used by an external event loop)
+int MQTTKeepalive(MQTTClient* c)
+{
+    if (c->keepAliveInterval == 0 || c->ping_outstanding || !TimerIsExpired(&c->ping_timer))
+        return SUCCESS;
+    return keepalive(c);
+}
+
+
+//OAB: handle one packet without waiting for it (used by an external event loop, when bytes are already
+// received). The rest of a packet is read within timeout_ms.
+int MQTTCycle(MQTTClient* c, int timeout_ms)
+{
+    Timer timer;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, timeout_ms);
+    return cycle(c, &timer);
+}
+
+
 void MQTTRun(void* parm)
 {
 	Timer timer;
@@ -374,12 +476,36 @@ int waitfor(MQTTClient* c, int packet_type, Timer* timer)
 }
 
 
+static int connectSend(MQTTClient* c, MQTTPacket_connectData* options, Timer* timer)
+{
+    MQTTPacket_connectData default_options = MQTTPacket_connectData_initializer;
+    int len = 0;
+
+    if (options == 0)
+        options = &default_options; /* set default options if none were supplied */
+    
+    c->keepAliveInterval = options->keepAliveInterval;
+    TimerCountdown(&c->ping_timer, c->keepAliveInterval);
+    if ((len = MQTTSerialize_connect(c->buf, c->buf_size, options)) <= 0)
+        return FAILURE;
+    return sendPacket(c, len, timer);  // send the connect packet
+}
+
+
+static int connackResult(MQTTClient* c)
+{
+    unsigned char connack_rc = 255;
+    unsigned char sessionPresent = 0;
+    if (MQTTDeserialize_connack(&sessionPresent, &connack_rc, c->readbuf, c->readbuf_size) == 1)
+        return connack_rc;
+    return FAILURE;
+}
+
+
 int MQTTConnect(MQTTClient* c, MQTTPacket_connectData* options)
 {
     Timer connect_timer;
     int rc = FAILURE;
-    MQTTPacket_connectData default_options = MQTTPacket_connectData_initializer;
-    int len = 0;
 
 #if defined(MQTT_TASK)
 	MutexLock(&c->mutex);
@@ -390,26 +516,12 @@ int MQTTConnect(MQTTClient* c, MQTTPacket_connectData* options)
     TimerInit(&connect_timer);
     TimerCountdownMS(&connect_timer, c->command_timeout_ms);
 
-    if (options == 0)
-        options = &default_options; /* set default options if none were supplied */
-    
-    c->keepAliveInterval = options->keepAliveInterval;
-    TimerCountdown(&c->ping_timer, c->keepAliveInterval);
-    if ((len = MQTTSerialize_connect(c->buf, c->buf_size, options)) <= 0)
-        goto exit;
-    if ((rc = sendPacket(c, len, &connect_timer)) != SUCCESS)  // send the connect packet
+    if ((rc = connectSend(c, options, &connect_timer)) != SUCCESS)
         goto exit; // there was a problem
     
     // this will be a blocking call, wait for the connack
     if (waitfor(c, CONNACK, &connect_timer) == CONNACK)
-    {
-        unsigned char connack_rc = 255;
-        unsigned char sessionPresent = 0;
-        if (MQTTDeserialize_connack(&sessionPresent, &connack_rc, c->readbuf, c->readbuf_size) == 1)
-            rc = connack_rc;
-        else
-            rc = FAILURE;
-    }
+        rc = connackResult(c);
     else
         rc = FAILURE;
     
@@ -425,6 +537,35 @@ exit:
 }
 
 
+//OAB: send the connect packet, without waiting for the connack (read by MQTTConnackRead)
+int MQTTConnectSend(MQTTClient* c, MQTTPacket_connectData* options)
+{
+    Timer timer;
+
+    if (c->isconnected) /* don't send connect packet again if we are already connected */
+        return FAILURE;
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, c->command_timeout_ms);
+    return connectSend(c, options, &timer);
+}
+
+
+//OAB: read the connack of MQTTConnectSend (its first byte is already received)
+int MQTTConnackRead(MQTTClient* c, int timeout_ms)
+{
+    Timer timer;
+    int rc = FAILURE;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, timeout_ms);
+    if (readPacket(c, &timer) == CONNACK)
+        rc = connackResult(c);
+    if (rc == SUCCESS)
+        c->isconnected = 1;
+    return rc;
+}
+
+
 int MQTTSubscribe(MQTTClient* c, const char* topicFilter, enum QoS qos, messageHandler messageHandler)
 { 
     int rc = FAILURE;  
@@ -520,6 +661,39 @@ exit:
 }
 
 
+//OAB: wait for the acknowledge of a QoS 1 or 2 publish (shared by MQTTPublish and MQTTPublishEnd)
+static int waitPublishAck(MQTTClient* c, MQTTMessage* message, Timer* timer)
+{
+    int rc = SUCCESS;
+
+    if (message->qos == QOS1)
+    {
+        if (waitfor(c, PUBACK, timer) == PUBACK)
+        {
+            unsigned short mypacketid;
+            unsigned char dup, type;
+            if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) != 1)
+                rc = FAILURE;
+        }
+        else
+            rc = FAILURE;
+    }
+    else if (message->qos == QOS2)
+    {
+        if (waitfor(c, PUBCOMP, timer) == PUBCOMP)
+        {
+            unsigned short mypacketid;
+            unsigned char dup, type;
+            if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) != 1)
+                rc = FAILURE;
+        }
+        else
+            rc = FAILURE;
+    }
+    return rc;
+}
+
+
 int MQTTPublish(MQTTClient* c, const char* topicName, MQTTMessage* message)
 {
     int rc = FAILURE;
@@ -547,30 +721,7 @@ int MQTTPublish(MQTTClient* c, const char* topicName, MQTTMessage* message)
     if ((rc = sendPacket(c, len, &timer)) != SUCCESS) // send the subscribe packet
         goto exit; // there was a problem
     
-    if (message->qos == QOS1)
-    {
-        if (waitfor(c, PUBACK, &timer) == PUBACK)
-        {
-            unsigned short mypacketid;
-            unsigned char dup, type;
-            if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) != 1)
-                rc = FAILURE;
-        }
-        else
-            rc = FAILURE;
-    }
-    else if (message->qos == QOS2)
-    {
-        if (waitfor(c, PUBCOMP, &timer) == PUBCOMP)
-        {
-            unsigned short mypacketid;
-            unsigned char dup, type;
-            if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) != 1)
-                rc = FAILURE;
-        }
-        else
-            rc = FAILURE;
-    }
+    rc = waitPublishAck(c, message, &timer);
     
 exit:
 #if defined(MQTT_TASK)
@@ -580,6 +731,152 @@ exit:
 }
 
 
+#if !defined(MQTT_TASK)
+//OAB: zero-copy publish. The room for the fixed header (max size), the topic and the packet id
+// is reserved at the beginning of the send buffer, and the payload is written in place just after.
+// The fixed header is back-patched by MQTTPublishEnd(), just before the topic.
+#define MQTT_PUBLISH_HDR_MAX    5   /* 1 byte + max 4 bytes of remaining length */
+
+static int publishPayloadOffset(const char* topicName, enum QoS qos)
+{
+    return MQTT_PUBLISH_HDR_MAX + 2 + (int)strlen(topicName) + ((qos == QOS0) ? 0 : 2);
+}
+
+
+unsigned char* MQTTPublishBegin(MQTTClient* c, const char* topicName, enum QoS qos, int* maxlen)
+{
+    int offset = publishPayloadOffset(topicName, qos);
+    unsigned char* ptr;
+    MQTTString topic = MQTTString_initializer;
+    topic.cstring = (char *)topicName;
+
+    if (!c->isconnected || offset >= (int)c->buf_size)
+        return NULL;
+
+    ptr = c->buf + MQTT_PUBLISH_HDR_MAX;
+    writeMQTTString(&ptr, topic);
+    *maxlen = (int)c->buf_size - offset;
+    return c->buf + offset;
+}
+
+
+int MQTTPublishEnd(MQTTClient* c, const char* topicName, MQTTMessage* message)
+{
+    int rc = FAILURE;
+    int offset = publishPayloadOffset(topicName, message->qos);
+    int rem_len = offset - MQTT_PUBLISH_HDR_MAX + (int)message->payloadlen;
+    unsigned char rem_buf[4];
+    unsigned char* ptr;
+    MQTTHeader header = {0};
+    Timer timer;
+    int n;
+
+    if (!c->isconnected || offset > (int)c->buf_size || message->payloadlen > c->buf_size - (size_t)offset)
+        goto exit;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, c->command_timeout_ms);
+
+    if (message->qos == QOS1 || message->qos == QOS2)
+    {
+        message->id = getNextPacketId(c);
+        ptr = c->buf + offset - 2;
+        writeInt(&ptr, message->id);
+    }
+
+    header.bits.type = PUBLISH;
+    header.bits.dup = 0;
+    header.bits.qos = message->qos;
+    header.bits.retain = message->retained;
+    n = MQTTPacket_encode(rem_buf, rem_len);
+    ptr = c->buf + MQTT_PUBLISH_HDR_MAX - 1 - n;
+    *ptr = header.byte;
+    memcpy(ptr + 1, rem_buf, n);
+
+    if ((rc = sendPacketAt(c, MQTT_PUBLISH_HDR_MAX - 1 - n, 1 + n + rem_len, &timer)) != SUCCESS)
+        goto exit;
+
+    rc = waitPublishAck(c, message, &timer);
+
+exit:
+    return rc;
+}
+
+
+//OAB: scatter-gather publish. Only the fixed header, the topic and the packet id are written in
+// the send buffer. They are sent with the payload, not copied, as an iovec (see mqttwritev).
+int MQTTPublishVec(MQTTClient* c, const char* topicName, MQTTMessage* message)
+{
+    int rc = FAILURE;
+    int offset = publishPayloadOffset(topicName, message->qos);
+    int rem_len = offset - MQTT_PUBLISH_HDR_MAX + (int)message->payloadlen;
+    unsigned char rem_buf[4];
+    unsigned char* ptr;
+    MQTTHeader header = {0};
+    MQTTString topic = MQTTString_initializer;
+    MQTTIoVec iov[2];
+    Timer timer;
+    int n;
+
+    if (!c->isconnected || offset > (int)c->buf_size || message->payloadlen > 268435455 || rem_len > 268435455)
+        goto exit;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, c->command_timeout_ms);
+
+    topic.cstring = (char *)topicName;
+    ptr = c->buf + MQTT_PUBLISH_HDR_MAX;
+    writeMQTTString(&ptr, topic);
+    if (message->qos == QOS1 || message->qos == QOS2)
+    {
+        message->id = getNextPacketId(c);
+        writeInt(&ptr, message->id);
+    }
+
+    header.bits.type = PUBLISH;
+    header.bits.dup = 0;
+    header.bits.qos = message->qos;
+    header.bits.retain = message->retained;
+    n = MQTTPacket_encode(rem_buf, rem_len);
+    ptr = c->buf + MQTT_PUBLISH_HDR_MAX - 1 - n;
+    *ptr = header.byte;
+    memcpy(ptr + 1, rem_buf, n);
+
+    iov[0].base = ptr;
+    iov[0].len = offset - (MQTT_PUBLISH_HDR_MAX - 1 - n);
+    iov[1].base = (const unsigned char*)message->payload;
+    iov[1].len = (int)message->payloadlen;
+    if ((rc = sendVector(c, iov, 2, &timer)) != SUCCESS)
+        goto exit;
+
+    rc = waitPublishAck(c, message, &timer);
+
+exit:
+    return rc;
+}
+
+
+//OAB: send a buffer of PUBLISH packets already serialized by the caller (batch of messages,
+// in-flight QoS1 message), in one write (i.e. one TLS record when the buffer fits in it)
+int MQTTPublishPackets(MQTTClient* c, const unsigned char* packets, int len)
+{
+    int rc = FAILURE;
+    Timer timer;
+
+    if (!c->isconnected || packets == NULL || len <= 0)
+        goto exit;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, c->command_timeout_ms);
+
+    rc = sendBuffer(c, (unsigned char*)packets, len, &timer);
+
+exit:
+    return rc;
+}
+#endif
+
+
 int MQTTDisconnect(MQTTClient* c)
 {  
     int rc = FAILURE;
@@ -98,10 +98,18 @@ typedef struct MessageData
 {
     MQTTMessage* message;
     MQTTString* topicName;
+    struct MQTTClient* client; //OAB: client delivering the message (multi-instance)
 } MessageData;
 
 typedef void (*messageHandler)(MessageData*);
 
+//OAB: element of a vectored write (scatter-gather publish)
+typedef struct MQTTIoVec
+{
+    const unsigned char* base;
+    int len;
+} MQTTIoVec;
+
 typedef struct MQTTClient
 {
     unsigned int next_packetid,
@@ -122,6 +130,12 @@ typedef struct MQTTClient
 
     void (*defaultMessageHandler) (MessageData*);
 
+    void (*pubackHandler) (struct MQTTClient*, unsigned short); //OAB: PUBACK received (in-flight window)
+
+    /* OAB: vectored write of the network: return the number of bytes written (maybe less than the
+     * total length of the iovec), or a negative value on error. NULL: one mqttwrite per element. */
+    int (*mqttwritev) (Network*, MQTTIoVec*, int, int);
+
     Network* ipstack;
     Timer ping_timer;
 #if defined(MQTT_TASK)
@@ -150,6 +164,20 @@ DLLExport void MQTTClientInit(MQTTClient* client, Network* network, unsigned int
  */
 DLLExport int MQTTConnect(MQTTClient* client, MQTTPacket_connectData* options);
 
+//OAB: connection in two steps, without waiting for the Connack (used by an external event loop)
+/** MQTT Connect Send - send an MQTT connect packet down the network, the Connack is read by MQTTConnackRead()
+ *  @param options - connect options
+ *  @return success code
+ */
+DLLExport int MQTTConnectSend(MQTTClient* client, MQTTPacket_connectData* options);
+
+/** MQTT Connack Read - read the Connack, whose first byte is already received
+ *  @param client - the client object to use
+ *  @param timeout_ms - the time, in milliseconds, to read the rest of the packet
+ *  @return success code (connected), the Connack return code if refused, or FAILURE
+ */
+DLLExport int MQTTConnackRead(MQTTClient* client, int timeout_ms);
+
 /** MQTT Publish - send an MQTT publish packet and wait for all acks to complete for all QoSs
  *  @param client - the client object to use
  *  @param topic - the topic to publish to
@@ -186,6 +214,69 @@ DLLExport int MQTTDisconnect(MQTTClient* client);
  */
 DLLExport int MQTTYield(MQTTClient* client, int time);
 
+//OAB: keepalive without reading the network (used by an external event loop)
+/** MQTT Keepalive - send a PINGREQ if the keepalive period is expired
+ *  @param client - the client object to use
+ *  @return success code
+ */
+DLLExport int MQTTKeepalive(MQTTClient* client);
+
+//OAB: one read of the network (used by an external event loop)
+/** MQTT Cycle - read and handle one packet, whose first byte is already received
+ *  @param client - the client object to use
+ *  @param timeout_ms - the time, in milliseconds, to read the rest of the packet
+ *  @return the packet type (not a valid one if nothing is read), or FAILURE
+ */
+DLLExport int MQTTCycle(MQTTClient* client, int timeout_ms);
+
+#if !defined(MQTT_TASK)
+//OAB: zero-copy publish (the payload is written in place in the send buffer)
+/** MQTT Publish Begin - reserve the header and write the topic in the send buffer
+ *  @param client - the client object to use
+ *  @param topicName - the topic to publish to
+ *  @param qos - the QoS of the message
+ *  @param maxlen - returned max length of the payload
+ *  @return pointer where the payload is to be written, or NULL if not connected
+ */
+DLLExport unsigned char* MQTTPublishBegin(MQTTClient* client, const char* topicName, enum QoS qos, int* maxlen);
+
+/** MQTT Publish End - back-patch the header and send the message built in place
+ *  @param client - the client object to use
+ *  @param topicName - the topic given to MQTTPublishBegin()
+ *  @param message - the message (qos, retained, payloadlen), the payload is already in the send buffer
+ *  @return success code
+ */
+DLLExport int MQTTPublishEnd(MQTTClient* client, const char* topicName, MQTTMessage* message);
+
+//OAB: scatter-gather publish (the payload is not copied in the send buffer)
+/** MQTT Publish Vec - send an MQTT publish packet, and wait for all acks to complete for all QoSs.
+ *  Only the header and the topic are written in the send buffer: the payload size is not limited
+ *  by the size of this buffer. They are given with the payload to client->mqttwritev.
+ *  @param client - the client object to use
+ *  @param topicName - the topic to publish to
+ *  @param message - the message to send
+ *  @return success code
+ */
+DLLExport int MQTTPublishVec(MQTTClient* client, const char* topicName, MQTTMessage* message);
+
+//OAB: batch of messages, QoS1 in-flight window
+/** MQTT Publish Packets - send PUBLISH packets already serialized by the caller, in one write.
+ *  The acknowledges of the QoS1 packets are given to client->pubackHandler.
+ *  @param client - the client object to use
+ *  @param packets - the PUBLISH packets (fixed header, topic, payload), one after the other
+ *  @param len - the total length of the packets
+ *  @return success code
+ */
+DLLExport int MQTTPublishPackets(MQTTClient* client, const unsigned char* packets, int len);
+#endif
+
+//OAB: QoS1 in-flight window
+/** MQTT Get Next Packet Id - packet id of a QoS1 PUBLISH packet serialized by the caller
+ *  @param client - the client object to use
+ *  @return the packet id
+ */
+DLLExport int MQTTGetNextPacketId(MQTTClient* client);
+
 #if defined(MQTT_TASK)
 /** MQTT start background thread for a client.  After this, MQTTYield should not be called.
 *  @param client - the client object to use